@@ -0,0 +1,155 @@
+#ifndef FILE_WATCH_H
+#define FILE_WATCH_H
+
+// 监视文件的修改, 用于热重载
+//
+//   FileWatcher watcher;
+//   watcher.watch("banana.obj");
+//   // 定时器 / idle 中:
+//   std::vector<FileChange> changes;
+//   if (watcher.poll(changes)) { 重新读取 changes[i].path; }
+//
+// - Linux 使用 inotify, 监视文件所在的目录而不是文件本身: 导出工具常常先写临时文件再改名覆盖,
+//   只监视原文件的 inode 会丢失这类修改 (IN_MOVED_TO / IN_CREATE 能捕获)
+// - 其他平台 (macOS) 每次 poll 时 stat 比较修改时间和大小, 每个文件一次系统调用
+// - 去抖动: 最后一次变化之后 settleMs 毫秒内没有新的变化才报告, 避免读到写了一半的文件;
+//   FileChange::firstSeen 是第一次察觉变化的时间, 用来统计从保存到画面更新的延迟
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <climits>
+#endif
+
+struct FileChange {
+    std::string path;
+    std::chrono::steady_clock::time_point firstSeen;
+};
+
+class FileWatcher {
+public:
+    int settleMs;   // 变化停止多久之后才报告
+
+#ifdef __linux__
+    FileWatcher() : settleMs(150), fd_(-1) {}
+    ~FileWatcher() { if (fd_ >= 0) close(fd_); }
+#else
+    FileWatcher() : settleMs(150) {}
+#endif
+
+    static const char* backend() {
+#ifdef __linux__
+        return "inotify";
+#else
+        return "stat 轮询";
+#endif
+    }
+
+    /**
+     * @brief 开始监视 path; 失败时返回 false (文件所在目录不存在等)
+     */
+    bool watch(const std::string& path) {
+        Entry e;
+        e.path = path;
+        size_t slash = path.find_last_of('/');
+        e.dir = slash == std::string::npos ? "." : path.substr(0, slash == 0 ? 1 : slash);
+        e.name = slash == std::string::npos ? path : path.substr(slash + 1);
+        e.wd = -1;
+        e.pending = false;
+        statFile(path, e.mtime, e.size);
+#ifdef __linux__
+        if (fd_ < 0) {
+            fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (fd_ < 0) { std::cerr << "警告: inotify 初始化失败, 不能监视 " << path << std::endl; return false; }
+        }
+        e.wd = inotify_add_watch(fd_, e.dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_MODIFY);
+        if (e.wd < 0) { std::cerr << "警告: 无法监视目录 " << e.dir << std::endl; return false; }
+#endif
+        entries_.push_back(e);
+        return true;
+    }
+
+    /**
+     * @brief 不阻塞; 把已经稳定下来的修改追加到 changes, 有修改时返回 true
+     */
+    bool poll(std::vector<FileChange>& changes) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+#ifdef __linux__
+        // 每个事件是 inotify_event 加上变长的文件名
+        alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+        for (;;) {
+            ssize_t n = fd_ >= 0 ? read(fd_, buffer, sizeof(buffer)) : -1;
+            if (n <= 0) break;
+            for (char* p = buffer; p < buffer + n;) {
+                const inotify_event* ev = (const inotify_event*)p;
+                p += sizeof(inotify_event) + ev->len;
+                if (ev->len == 0) continue;
+                for (size_t i = 0; i < entries_.size(); ++i)
+                    if (entries_[i].wd == ev->wd && entries_[i].name == ev->name) touch(entries_[i], now);
+            }
+        }
+#endif
+        bool any = false;
+        for (size_t i = 0; i < entries_.size(); ++i) {
+            Entry& e = entries_[i];
+            long long mtime, size;
+            bool exists = statFile(e.path, mtime, size);
+#ifndef __linux__
+            if (exists && (mtime != e.mtime || size != e.size)) touch(e, now);
+#endif
+            if (exists && (mtime != e.mtime || size != e.size)) {
+                // 仍在写入: 推迟报告
+                e.mtime = mtime;
+                e.size = size;
+                e.lastEvent = now;
+            }
+            if (!e.pending || !exists) continue;
+            if (std::chrono::duration<double, std::milli>(now - e.lastEvent).count() < settleMs) continue;
+            e.pending = false;
+            FileChange c = { e.path, e.firstSeen };
+            changes.push_back(c);
+            any = true;
+        }
+        return any;
+    }
+
+private:
+    struct Entry {
+        std::string path, dir, name;
+        int wd;
+        long long mtime, size;
+        bool pending;
+        std::chrono::steady_clock::time_point firstSeen, lastEvent;
+    };
+
+    static bool statFile(const std::string& path, long long& mtime, long long& size) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) { mtime = size = -1; return false; }
+#ifdef __APPLE__
+        mtime = (long long)st.st_mtimespec.tv_sec * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+        mtime = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+        size = (long long)st.st_size;
+        return true;
+    }
+
+    static void touch(Entry& e, std::chrono::steady_clock::time_point now) {
+        if (!e.pending) e.firstSeen = now;
+        e.pending = true;
+        e.lastEvent = now;
+    }
+
+    std::vector<Entry> entries_;
+#ifdef __linux__
+    int fd_;   // inotify 实例
+#endif
+};
+
+#endif
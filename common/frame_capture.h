@@ -0,0 +1,400 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+// 把窗口画面录制为图像序列 (PNG / PPM), 不阻塞渲染
+//
+//   ./viewer --capture frames/demo                 启动后立即录制, 写出 frames/demo_000000.png ...
+//   ./viewer --capture demo --capture-format ppm   PPM 不压缩, 编码最快
+//   --capture-lag N     回读延迟的帧数 (PBO 个数), 默认 3
+//   --capture-queue N   等待编码的帧数上限, 默认 8; 超过时丢弃新帧, 保证帧率
+//   --capture-wait      队列满时等待而不是丢帧 (配合 --replay 离线录制, 每一帧都保留)
+//
+// 用法: glutInit 之后调用 captureParseArgs, display() 中 glutSwapBuffers 之前调用 captureFrame(),
+// captureToggle() 用于按键开始/停止录制 (没有 --capture 时使用前缀 "capture")
+//
+// - 第 N 帧的 glReadPixels 写入一个像素缓冲对象 (GL_PIXEL_PACK_BUFFER), 调用立即返回, 由 GPU 异步复制;
+//   第 N + lag 帧再映射这个 PBO, 此时复制早已完成, 映射不需要等待 GPU
+// - 映射后只做一次 memcpy 到空闲的帧缓冲, 格式转换 (BGRA 自下而上 -> RGB 自上而下)、编码和写文件
+//   都在后台线程池中进行
+// - 没有空闲帧缓冲 (编码跟不上) 时直接丢弃这一帧, 不映射 PBO; 统计丢帧数和编码队列深度
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "image_write.h"
+#include "parallel_for.h"
+#include "trace.h"
+
+enum CaptureFormat { CAPTURE_PNG, CAPTURE_PPM };
+
+// 统计 (每 CAPTURE_REPORT_FRAMES 帧输出一次并清零)
+struct CaptureStats {
+    int frames;          // 发出回读的帧数
+    int saved;           // 交给编码线程的帧数
+    int dropped;         // 编码队列已满而丢弃的帧数
+    int maxQueue;        // 编码队列的最大深度 (等待中 + 正在编码)
+    double readbackMs;   // GL 线程上映射 PBO + 复制的时间
+    double encodeMs;     // 编码线程上转换 + 编码 + 写文件的时间 (所有线程之和)
+    size_t bytes;        // 写出的文件字节数
+
+    CaptureStats() { reset(); }
+    void reset() {
+        frames = saved = dropped = maxQueue = 0;
+        readbackMs = encodeMs = 0.0;
+        bytes = 0;
+    }
+};
+
+const int CAPTURE_REPORT_FRAMES = 120;
+
+class FrameCapture {
+public:
+    FrameCapture() : prefix("capture"), format(CAPTURE_PNG), lag(3), queueLimit(8), waitWhenFull(false),
+                     active_(false), width_(0), height_(0), frame_(0), nextIndex_(0),
+                     queued_(0), quit_(false), writeFailed_(false) {}
+
+    // 选项 (开始录制之前设置, 见 captureParseArgs)
+    std::string prefix;
+    CaptureFormat format;
+    int lag;
+    int queueLimit;
+    bool waitWhenFull;
+
+    bool active() const { return active_; }
+
+    /**
+     * @brief 开始录制; PBO 在第一次 frame() 时才创建, 因此可以在 GL 上下文创建之前调用
+     */
+    void start() {
+        if (active_) return;
+        if (workers_.empty()) {
+            int threads = std::max(1, std::min(4, hardwareThreads() - 1));
+            buffers_.resize(queueLimit);
+            for (int i = 0; i < queueLimit; ++i) freeBuffers_.push_back(i);
+            for (int i = 0; i < threads; ++i) workers_.push_back(std::thread(&FrameCapture::workerLoop, this));
+        }
+        active_ = true;
+        periodStart_ = std::chrono::steady_clock::now();
+        std::cout << "开始录制: " << prefix << "_NNNNNN." << extension() << " (回读延迟 " << lag << " 帧, "
+                  << workers_.size() << " 个编码线程, 队列上限 " << queueLimit << " 帧"
+                  << (waitWhenFull ? ", 队列满时等待" : "") << ")" << std::endl;
+    }
+
+    /**
+     * @brief 停止录制: 取回还在 PBO 中的帧, 等待编码队列清空
+     */
+    void stop() {
+        if (!active_) return;
+        TRACE_ZONE("FrameCapture::stop");
+        flushPending();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            idle_.wait(lock, [this]() { return queued_ == 0; });
+        }
+        report();
+        active_ = false;
+        std::cout << "录制结束: 共写出 " << nextIndex_ << " 帧" << std::endl;
+    }
+
+    /**
+     * @brief 程序退出时调用: 停止录制并结束编码线程
+     */
+    void shutdown() {
+        stop();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i) workers_[i].join();
+        workers_.clear();
+        if (!pbos_.empty()) glDeleteBuffers((GLsizei)pbos_.size(), &pbos_[0]);
+        pbos_.clear();
+    }
+
+    /**
+     * @brief 回读当前的后台缓冲; 在绘制完成之后、glutSwapBuffers 之前调用
+     */
+    void frame() {
+        if (!active_) return;
+        TRACE_ZONE("FrameCapture::frame");
+        int w = glutGet(GLUT_WINDOW_WIDTH), h = glutGet(GLUT_WINDOW_HEIGHT);
+        if (w <= 0 || h <= 0) return;
+        if (w != width_ || h != height_ || (int)pbos_.size() != lag) resize(w, h);
+
+        // 这个 PBO 的回读是 lag 帧之前发出的, 先取回
+        int slot = (int)(frame_ % (unsigned)lag);
+        if (pending_[slot]) retire(slot, waitWhenFull);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+        glReadBuffer(GL_BACK);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        // BGRA + 8_8_8_8_REV 与帧缓冲的内部格式一致, 驱动可以直接 DMA, 不需要 CPU 转换
+        glReadPixels(0, 0, width_, height_, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pending_[slot] = true;
+        ++frame_;
+        ++stats_.frames;
+        if (stats_.frames >= CAPTURE_REPORT_FRAMES) report();
+    }
+
+    const char* extension() const { return format == CAPTURE_PNG ? "png" : "ppm"; }
+
+private:
+    struct Job {
+        int buffer;
+        int width, height;
+        unsigned index;
+    };
+
+    // 窗口大小改变: 先取回旧尺寸的帧, 再重新分配 PBO
+    void resize(int w, int h) {
+        flushPending();
+        if (pbos_.empty() || (int)pbos_.size() != lag) {
+            if (!pbos_.empty()) glDeleteBuffers((GLsizei)pbos_.size(), &pbos_[0]);
+            pbos_.assign(lag, 0);
+            glGenBuffers(lag, &pbos_[0]);
+        }
+        width_ = w;
+        height_ = h;
+        for (int i = 0; i < lag; ++i) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)w * h * 4, NULL, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        pending_.assign(lag, false);
+        frame_ = 0;
+    }
+
+    // 按发出顺序取回所有未完成的回读 (停止录制或改变尺寸时), 不丢帧
+    void flushPending() {
+        for (int i = 0; i < (int)pending_.size(); ++i) {
+            int slot = (int)((frame_ + i) % pending_.size());
+            if (pending_[slot]) retire(slot, true);
+        }
+    }
+
+    // 取回一个 PBO: 取得空闲帧缓冲 (没有时丢帧或等待), 映射并复制, 交给编码线程
+    void retire(int slot, bool wait) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        pending_[slot] = false;
+        int buffer = -1;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (wait) idle_.wait(lock, [this]() { return !freeBuffers_.empty(); });
+            if (freeBuffers_.empty()) {
+                ++stats_.dropped;
+                return;
+            }
+            buffer = freeBuffers_.back();
+            freeBuffers_.pop_back();
+        }
+        std::vector<uint8_t>& pixels = buffers_[buffer];   // 空闲的缓冲只有 GL 线程访问
+        pixels.resize((size_t)width_ * height_ * 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos_[slot]);
+        const void* mapped = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (mapped) {
+            memcpy(&pixels[0], mapped, pixels.size());
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!mapped) {
+                freeBuffers_.push_back(buffer);
+                ++stats_.dropped;
+                return;
+            }
+            Job job = { buffer, width_, height_, nextIndex_++ };
+            jobs_.push_back(job);
+            ++queued_;
+            stats_.maxQueue = std::max(stats_.maxQueue, queued_);
+            ++stats_.saved;
+            stats_.readbackMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        }
+        wake_.notify_one();
+    }
+
+    void workerLoop() {
+        TRACE_THREAD_NAME("capture encoder");
+        std::vector<uint8_t> rgb, png;
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this]() { return quit_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;
+                job = jobs_.front();
+                jobs_.pop_front();
+            }
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            size_t bytes = encode(job, rgb, png);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                freeBuffers_.push_back(job.buffer);
+                --queued_;
+                stats_.encodeMs += ms;
+                stats_.bytes += bytes;
+            }
+            idle_.notify_all();
+        }
+    }
+
+    // BGRA 自下而上 -> RGB 自上而下, 编码并写出; 返回写出的字节数
+    size_t encode(const Job& job, std::vector<uint8_t>& rgb, std::vector<uint8_t>& png) {
+        TRACE_ZONE("FrameCapture::encode");
+        const std::vector<uint8_t>& pixels = buffers_[job.buffer];
+        rgb.resize((size_t)job.width * job.height * 3);
+        for (int y = 0; y < job.height; ++y) {
+            const uint8_t* src = &pixels[(size_t)(job.height - 1 - y) * job.width * 4];
+            uint8_t* dst = &rgb[(size_t)y * job.width * 3];
+            for (int x = 0; x < job.width; ++x, src += 4, dst += 3) {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+            }
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "_%06u.", job.index);
+        std::string path = prefix + name + extension();
+        bool ok;
+        size_t bytes;
+        if (format == CAPTURE_PNG) {
+            png.clear();
+            encodePNG(&rgb[0], job.width, job.height, png);
+            std::ofstream file(path.c_str(), std::ios::binary);
+            file.write((const char*)&png[0], (std::streamsize)png.size());
+            ok = (bool)file;
+            bytes = png.size();
+        } else {
+            ok = writePPM(path, &rgb[0], job.width, job.height);
+            bytes = rgb.size() + 16;
+        }
+        if (!ok) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!writeFailed_) std::cerr << "录制: 无法写入 " << path << " (目录是否存在?)" << std::endl;
+            writeFailed_ = true;
+            return 0;
+        }
+        return bytes;
+    }
+
+    void report() {
+        CaptureStats s;
+        int queued;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            s = stats_;
+            queued = queued_;
+            stats_.reset();
+        }
+        if (s.frames == 0 && s.saved == 0) return;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - periodStart_).count();
+        periodStart_ = std::chrono::steady_clock::now();
+        int frames = std::max(s.frames, 1);
+        std::cout << "录制: " << s.frames / seconds << " fps, 保存 " << s.saved << " 帧, 丢弃 " << s.dropped
+                  << " 帧, 编码队列 " << queued << " (峰值 " << s.maxQueue << " / " << queueLimit << "), GL 线程回读 "
+                  << s.readbackMs / frames << " ms/帧, 编码 " << (s.saved ? s.encodeMs / s.saved : 0.0) << " ms/帧";
+        if (s.bytes) std::cout << ", 写出 " << s.bytes / (1024.0 * 1024.0) << " MB";
+        std::cout << std::endl;
+    }
+
+    bool active_;
+    int width_, height_;
+    unsigned frame_;                       // 当前尺寸下发出回读的帧数, 决定使用哪个 PBO
+    unsigned nextIndex_;                   // 下一个写出的文件编号 (丢弃的帧不占编号, 序列保持连续)
+    std::vector<GLuint> pbos_;
+    std::vector<bool> pending_;            // PBO 中有尚未取回的回读
+    std::chrono::steady_clock::time_point periodStart_;
+
+    // 以下由 mutex_ 保护 (buffers_ 的内容除外: 空闲时归 GL 线程, 排队后归编码线程)
+    std::vector<std::vector<uint8_t> > buffers_;
+    std::vector<int> freeBuffers_;
+    std::deque<Job> jobs_;
+    int queued_;                           // 等待中 + 正在编码的帧数
+    bool quit_;
+    bool writeFailed_;
+    CaptureStats stats_;
+    std::mutex mutex_;
+    std::condition_variable wake_;         // 有新任务或需要退出
+    std::condition_variable idle_;         // 有帧缓冲被释放
+    std::vector<std::thread> workers_;
+};
+
+inline FrameCapture& frameCapture() {
+    static FrameCapture capture;
+    return capture;
+}
+
+inline void captureShutdown() {
+    frameCapture().shutdown();
+}
+
+inline void captureStart() {
+    static bool registered = false;
+    if (!registered) {
+        atexit(captureShutdown); // 按键退出 (exit) 时 GL 上下文仍然有效, 可以取回最后几帧
+        registered = true;
+    }
+    frameCapture().start();
+}
+
+/**
+ * @brief 解析并移除命令行中的 --capture <前缀> / --capture-format <png|ppm> / --capture-lag <N> /
+ *        --capture-queue <N> / --capture-wait; 指定了 --capture 时第一帧开始录制
+ */
+inline void captureParseArgs(int& argc, char** argv) {
+    FrameCapture& c = frameCapture();
+    bool startNow = false;
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--capture") && i + 1 < argc) {
+            c.prefix = argv[++i];
+            startNow = true;
+        } else if (!strcmp(argv[i], "--capture-format") && i + 1 < argc) {
+            c.format = !strcmp(argv[++i], "ppm") ? CAPTURE_PPM : CAPTURE_PNG;
+        } else if (!strcmp(argv[i], "--capture-lag") && i + 1 < argc) {
+            c.lag = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--capture-queue") && i + 1 < argc) {
+            c.queueLimit = std::max(1, atoi(argv[++i]));
+        } else if (!strcmp(argv[i], "--capture-wait")) {
+            c.waitWhenFull = true;
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+    if (startNow) captureStart();
+}
+
+/**
+ * @brief 按键切换录制状态
+ */
+inline void captureToggle() {
+    if (frameCapture().active()) frameCapture().stop();
+    else captureStart();
+}
+
+/**
+ * @brief 在 display() 中 glutSwapBuffers 之前调用
+ */
+inline void captureFrame() {
+    frameCapture().frame();
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+// 两级帧流水线: 工作线程准备第 N+1 帧的绘制列表, 同时 GL 线程提交第 N 帧
+//
+//   display() {
+//       double prepareMs;
+//       Frame* frame = pipeline.wait(&prepareMs); // 取出上一次 submit 准备好的帧 (第 N 帧) 及其准备耗时
+//       pipeline.submit(input);           // 工作线程开始准备第 N+1 帧, 写入另一块缓冲
+//       ... 用 frame 发出 GL 命令 ...
+//   }
+//
+// 两块 Frame 缓冲轮流使用: 工作线程只写后台缓冲, GL 线程只读前台缓冲;
+// wait() 返回之前工作线程已经写完, 下一次 wait() 之前 GL 线程已经读完, 因此不需要更细的锁.
+// 准备函数只能读取 Input 中的快照和只属于工作线程的数据, 不能调用 GL.
+// setAsync(false) 时 submit 在调用线程上同步执行准备函数, 便于对比.
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+#include "trace.h"
+
+template <typename Input, typename Frame>
+class FramePipeline {
+public:
+    typedef std::function<void(const Input&, Frame&)> PrepareFn;
+
+    FramePipeline() : prepare_(), front_(0), target_(0), pending_(false), done_(false), quit_(false), async_(true),
+                      lastWaitMs_(0.0), prepareMs_(0.0) {}
+    ~FramePipeline() { stop(); }
+
+    void start(PrepareFn prepare) {
+        prepare_ = prepare;
+        worker_ = std::thread(&FramePipeline::workerLoop, this);
+    }
+
+    void stop() {
+        if (!worker_.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            quit_ = true;
+        }
+        wake_.notify_one();
+        worker_.join();
+    }
+
+    void setAsync(bool async) { async_ = async; }
+    bool async() const { return async_; }
+
+    /**
+     * @brief 开始准备下一帧 (写入后台缓冲); 调用前必须已经 wait() 过上一次的结果
+     */
+    void submit(const Input& input) {
+        if (!async_ || !worker_.joinable()) {
+            TRACE_ZONE("FramePipeline::prepare");
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            prepare_(input, frames_[1 - front_]);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::lock_guard<std::mutex> lock(mutex_);
+            prepareMs_ = ms;
+            pending_ = true;
+            done_ = true;
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            input_ = input;
+            target_ = &frames_[1 - front_];
+            pending_ = true;
+            done_ = false;
+        }
+        wake_.notify_one();
+    }
+
+    /**
+     * @brief 等待上一次 submit 的帧准备完成, 交换前后台缓冲并返回它; 没有待完成的帧时返回 0
+     * prepareMs 非空时写入该帧准备函数的耗时 (在锁内读取, 工作线程只在锁内写)
+     */
+    Frame* wait(double* prepareMs = 0) {
+        TRACE_ZONE("FramePipeline::wait");
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (!pending_) return 0;
+            finished_.wait(lock, [this] { return done_; });
+            pending_ = false;
+            if (prepareMs) *prepareMs = prepareMs_;
+        }
+        lastWaitMs_ = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        front_ = 1 - front_;
+        return &frames_[front_];
+    }
+
+    double lastWaitMs() const { return lastWaitMs_; } // GL 线程在 wait() 中阻塞的时间 (只在 GL 线程上读写)
+
+private:
+    void workerLoop() {
+        TRACE_THREAD_NAME("frame pipeline");
+        for (;;) {
+            Input input;
+            Frame* target;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return quit_ || (pending_ && !done_); });
+                if (quit_) return;
+                input = input_;
+                target = target_;
+            }
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            {
+                TRACE_ZONE("FramePipeline::prepare");
+                prepare_(input, *target);
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                prepareMs_ = ms;
+                done_ = true;
+            }
+            finished_.notify_one();
+        }
+    }
+
+    PrepareFn prepare_;
+    Frame frames_[2];
+    int front_;               // GL 线程正在使用的缓冲
+    Input input_;
+    Frame* target_;           // 工作线程正在写的缓冲
+    bool pending_, done_, quit_, async_;
+    double lastWaitMs_;
+    double prepareMs_;        // 最近一次准备的耗时, 受 mutex_ 保护
+    std::thread worker_;
+    std::mutex mutex_;
+    std::condition_variable wake_, finished_;
+};
+
+#endif
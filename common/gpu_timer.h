@@ -0,0 +1,131 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+// GPU 计时: 用 GL_EXT_timer_query 的 GL_TIME_ELAPSED 查询测量一段命令在 GPU 上的耗时, 不需要 glFinish
+//
+//   GpuTimer timer;
+//   timer.init();                     // 需要 GL 上下文
+//   timer.begin(); ...绘制...; timer.end();
+//   double ms; int n = timer.collect(ms);   // 取出已经完成的结果 (n 个样本的耗时之和)
+//
+//   timer.begin(mode); ...; timer.end();   // 或者给每次测量一个标签 (例如当时的绘制模式)
+//   int tag; while (timer.poll(ms, tag)) ...      // 逐个取出结果和它的标签; 结果晚几帧才到, 模式可能已经切换
+//
+//   timer.begin(mode); n = draw(); timer.end(n, area);   // 绘制的图元数等数据也随查询保存,
+//   GpuTimerSample s; while (timer.poll(s)) ...          // 取出时与结果对应, 而不是用当前帧的值
+//
+// - 查询结果要等 GPU 执行到那里才可用; GPU_TIMER_QUERIES 个查询轮流使用, collect 只读取已经可用的结果
+//   (通常是两三帧之前的), CPU 不会等待 GPU
+// - 所有查询都还没有结果时 begin 跳过这一次测量, 不阻塞
+// - 同一时刻只能有一个 GL_TIME_ELAPSED 查询处于活动状态, 所以 begin / end 不能嵌套
+// - 不支持扩展时 supported() 为 false, begin / end 什么也不做
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+
+const int GPU_TIMER_QUERIES = 4;
+
+// 一次测量的结果, 以及发出查询时记录的数据
+struct GpuTimerSample {
+    double ms;
+    int tag;          // begin(tag)
+    size_t count;     // end(count): 例如这次绘制的图元数
+    float value;      // end(count, value): 其他需要与这次测量对应的数值
+};
+
+class GpuTimer {
+public:
+    typedef GpuTimerSample Sample;
+
+    GpuTimer() : supported_(false), active_(false), oldest_(0), pending_(0) {}
+
+    void init() {
+        supported_ = glutExtensionSupported("GL_EXT_timer_query") || glutExtensionSupported("GL_ARB_timer_query");
+        if (supported_) glGenQueries(GPU_TIMER_QUERIES, queries_);
+    }
+
+    bool supported() const { return supported_; }
+
+    void begin(int tag = 0) {
+        if (!supported_ || active_) return;
+        if (pending_ == GPU_TIMER_QUERIES) {
+            double ms;
+            collect(ms);
+            if (pending_ == GPU_TIMER_QUERIES) return;   // GPU 落后太多, 这一次不测
+        }
+        int slot = (oldest_ + pending_) % GPU_TIMER_QUERIES;
+        samples_[slot].tag = tag;
+        samples_[slot].count = 0;
+        samples_[slot].value = 0.0f;
+        glBeginQuery(GL_TIME_ELAPSED_EXT, queries_[slot]);
+        active_ = true;
+    }
+
+    /**
+     * @brief 结束测量; count / value 与这次查询一起保存, poll 取出结果时原样返回
+     */
+    void end(size_t count = 0, float value = 0.0f) {
+        if (!active_) return;
+        int slot = (oldest_ + pending_) % GPU_TIMER_QUERIES;
+        samples_[slot].count = count;
+        samples_[slot].value = value;
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        active_ = false;
+        ++pending_;
+    }
+
+    /**
+     * @brief 取出最早发出的一个结果和发出时记录的数据; 还没有可用的结果时返回 false
+     */
+    bool poll(GpuTimerSample& sample) {
+        if (pending_ == 0) return false;
+        GLuint query = queries_[oldest_];
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+        GLuint64EXT ns = 0;
+        glGetQueryObjectui64vEXT(query, GL_QUERY_RESULT, &ns);
+        sample = samples_[oldest_];
+        sample.ms = ns / 1000000.0;
+        oldest_ = (oldest_ + 1) % GPU_TIMER_QUERIES;
+        --pending_;
+        return true;
+    }
+
+    /**
+     * @brief 取出最早发出的一个结果和它的标签; 还没有可用的结果时返回 false
+     */
+    bool poll(double& ms, int& tag) {
+        GpuTimerSample sample;
+        if (!poll(sample)) return false;
+        ms = sample.ms;
+        tag = sample.tag;
+        return true;
+    }
+
+    /**
+     * @brief 按发出的顺序取出所有已经可用的结果, totalMs 为它们的耗时之和, 返回个数
+     */
+    int collect(double& totalMs) {
+        totalMs = 0.0;
+        int count = 0, tag;
+        double ms;
+        while (poll(ms, tag)) {
+            totalMs += ms;
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    bool supported_, active_;
+    GLuint queries_[GPU_TIMER_QUERIES];
+    GpuTimerSample samples_[GPU_TIMER_QUERIES];   // 每个查询发出时记录的标签和数据
+    int oldest_, pending_;   // 等待结果的查询: queries_[oldest_] 起连续 pending_ 个
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef IMAGE_WRITE_H
+#define IMAGE_WRITE_H
+
+// 把 8 位 RGB 图像写为 PPM (P6) 或 PNG, 不依赖 zlib / libpng
+//
+//   writePPM("frame.ppm", rgb, width, height);
+//   writePNG("frame.png", rgb, width, height);   // rgb: 自上而下逐行, 每像素 3 字节
+//
+// PNG 的压缩部分是一个简化的 deflate 编码器:
+// - 每行按 "绝对值之和最小" 从 None / Sub / Up / Paeth 中选择滤波器 (与 libpng 的启发式相同)
+// - LZ77 只保留每个哈希桶最近的一个位置 (没有哈希链), 贪心匹配
+// - 整幅图像一个固定 Huffman 块 (BTYPE = 01), 不需要构造和写出码表
+// 压缩率不如 zlib 默认级别, 但速度快得多; 渲染画面的大面积纯色和渐变区域仍能压缩到原大小的几分之一
+
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * @brief 写出二进制 PPM (P6); 失败时返回 false
+ */
+inline bool writePPM(const std::string& filename, const uint8_t* rgb, int width, int height) {
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file) return false;
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write((const char*)rgb, (std::streamsize)width * height * 3);
+    return (bool)file;
+}
+
+// --- deflate (固定 Huffman) ---
+
+struct DeflateBitWriter {
+    std::vector<uint8_t>& out;
+    uint32_t bits;
+    int count;
+
+    explicit DeflateBitWriter(std::vector<uint8_t>& o) : out(o), bits(0), count(0) {}
+
+    // 低位在前写入 n 位 (n <= 16)
+    void put(uint32_t value, int n) {
+        bits |= value << count;
+        count += n;
+        while (count >= 8) {
+            out.push_back((uint8_t)bits);
+            bits >>= 8;
+            count -= 8;
+        }
+    }
+
+    // Huffman 码按高位在前的顺序写入
+    void putCode(uint32_t code, int n) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < n; ++i) reversed |= ((code >> i) & 1) << (n - 1 - i);
+        put(reversed, n);
+    }
+
+    void flush() {
+        if (count > 0) out.push_back((uint8_t)bits);
+        bits = 0;
+        count = 0;
+    }
+};
+
+inline void deflateLiteral(DeflateBitWriter& w, unsigned symbol) {
+    if (symbol < 144) w.putCode(0x30 + symbol, 8);
+    else if (symbol < 256) w.putCode(0x190 + symbol - 144, 9);
+    else if (symbol < 280) w.putCode(symbol - 256, 7);
+    else w.putCode(0xC0 + symbol - 280, 8);
+}
+
+inline void deflateMatch(DeflateBitWriter& w, unsigned length, unsigned distance) {
+    static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                             35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                             3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                           257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                           7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    int l = 28;
+    while (lengthBase[l] > length) --l;
+    deflateLiteral(w, 257 + l);
+    w.put(length - lengthBase[l], lengthExtra[l]);
+    int d = 29;
+    while (distBase[d] > distance) --d;
+    w.putCode(d, 5);
+    w.put(distance - distBase[d], distExtra[d]);
+}
+
+/**
+ * @brief 把 data 压缩为 zlib 流 (RFC 1950 包装的单个固定 Huffman deflate 块), 追加到 out
+ */
+inline void zlibCompress(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    const int HASH_BITS = 15;
+    const size_t WINDOW = 32768, MAX_MATCH = 258;
+    out.push_back(0x78);
+    out.push_back(0x01);
+    DeflateBitWriter w(out);
+    w.put(1, 1);   // BFINAL
+    w.put(1, 2);   // BTYPE = 01 (固定 Huffman)
+
+    std::vector<int64_t> head((size_t)1 << HASH_BITS, -1);
+    size_t i = 0;
+    while (i < n) {
+        size_t bestLength = 0, bestDistance = 0;
+        if (i + 3 <= n) {
+            uint32_t key = (uint32_t)data[i] | (uint32_t)data[i + 1] << 8 | (uint32_t)data[i + 2] << 16;
+            uint32_t h = (key * 2654435761u) >> (32 - HASH_BITS);
+            int64_t candidate = head[h];
+            head[h] = (int64_t)i;
+            if (candidate >= 0 && i - (size_t)candidate <= WINDOW) {
+                const uint8_t* a = data + candidate;
+                const uint8_t* b = data + i;
+                size_t limit = std::min(MAX_MATCH, n - i), length = 0;
+                while (length < limit && a[length] == b[length]) ++length;
+                if (length >= 3) { bestLength = length; bestDistance = i - (size_t)candidate; }
+            }
+        }
+        if (bestLength) {
+            deflateMatch(w, (unsigned)bestLength, (unsigned)bestDistance);
+            // 匹配区间内部只登记少量位置, 保持速度
+            size_t end = i + bestLength;
+            for (size_t j = i + 1; j + 3 <= n && j < end; j += 4) {
+                uint32_t key = (uint32_t)data[j] | (uint32_t)data[j + 1] << 8 | (uint32_t)data[j + 2] << 16;
+                head[(key * 2654435761u) >> (32 - HASH_BITS)] = (int64_t)j;
+            }
+            i = end;
+        } else {
+            deflateLiteral(w, data[i]);
+            ++i;
+        }
+    }
+    deflateLiteral(w, 256);   // 块结束
+    w.flush();
+
+    uint32_t s1 = 1, s2 = 0;
+    for (size_t k = 0; k < n;) {
+        size_t block = std::min<size_t>(n - k, 5552);   // 5552 字节内 s2 不会溢出
+        for (size_t e = k + block; k < e; ++k) { s1 += data[k]; s2 += s1; }
+        s1 %= 65521;
+        s2 %= 65521;
+    }
+    uint32_t adler = s2 << 16 | s1;
+    for (int s = 24; s >= 0; s -= 8) out.push_back((uint8_t)(adler >> s));
+}
+
+// --- PNG ---
+
+struct PngCrcTable {
+    uint32_t entries[256];
+    PngCrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+inline uint32_t pngCrc(const uint8_t* data, size_t n, uint32_t crc = 0) {
+    static const PngCrcTable table;   // C++11 保证局部静态变量的初始化是线程安全的
+    crc = ~crc;
+    for (size_t i = 0; i < n; ++i) crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+inline void pngChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t n) {
+    for (int s = 24; s >= 0; s -= 8) out.push_back((uint8_t)(n >> s));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    if (n) out.insert(out.end(), data, data + n);
+    uint32_t crc = pngCrc(&out[start], n + 4);
+    for (int s = 24; s >= 0; s -= 8) out.push_back((uint8_t)(crc >> s));
+}
+
+inline uint8_t pngPaeth(int a, int b, int c) {
+    int p = a + b - c, pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+    return (uint8_t)(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+/**
+ * @brief 编码为 PNG (8 位 RGB) 并追加到 out
+ */
+inline void encodePNG(const uint8_t* rgb, int width, int height, std::vector<uint8_t>& out) {
+    size_t stride = (size_t)width * 3;
+    std::vector<uint8_t> filtered((stride + 1) * height);
+    std::vector<uint8_t> candidate(stride);
+    for (int y = 0; y < height; ++y) {
+        const uint8_t* row = rgb + y * stride;
+        const uint8_t* up = y > 0 ? row - stride : 0;
+        uint8_t* dst = &filtered[y * (stride + 1)];
+        uint64_t bestScore = UINT64_MAX;
+        for (int filter = 0; filter < 5; ++filter) {
+            if (filter == 3) continue;   // Average 很少胜出, 省掉
+            uint64_t score = 0;
+            for (size_t x = 0; x < stride; ++x) {
+                int a = x >= 3 ? row[x - 3] : 0, b = up ? up[x] : 0, c = up && x >= 3 ? up[x - 3] : 0;
+                uint8_t v = row[x];
+                if (filter == 1) v = (uint8_t)(v - a);
+                else if (filter == 2) v = (uint8_t)(v - b);
+                else if (filter == 4) v = (uint8_t)(v - pngPaeth(a, b, c));
+                candidate[x] = v;
+                score += (uint64_t)abs((int)(int8_t)v);
+            }
+            if (score < bestScore) {
+                bestScore = score;
+                dst[0] = (uint8_t)filter;
+                memcpy(dst + 1, &candidate[0], stride);
+            }
+        }
+    }
+
+    static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    out.insert(out.end(), signature, signature + 8);
+    uint8_t ihdr[13] = { (uint8_t)(width >> 24), (uint8_t)(width >> 16), (uint8_t)(width >> 8), (uint8_t)width,
+                         (uint8_t)(height >> 24), (uint8_t)(height >> 16), (uint8_t)(height >> 8), (uint8_t)height,
+                         8, 2, 0, 0, 0 };   // 8 位, RGB, deflate, 自适应滤波, 不隔行
+    pngChunk(out, "IHDR", ihdr, sizeof(ihdr));
+    std::vector<uint8_t> idat;
+    zlibCompress(&filtered[0], filtered.size(), idat);
+    pngChunk(out, "IDAT", &idat[0], idat.size());
+    pngChunk(out, "IEND", 0, 0);
+}
+
+/**
+ * @brief 写出 PNG; 失败时返回 false
+ */
+inline bool writePNG(const std::string& filename, const uint8_t* rgb, int width, int height) {
+    std::vector<uint8_t> bytes;
+    encodePNG(rgb, width, height, bytes);
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file) return false;
+    file.write((const char*)&bytes[0], (std::streamsize)bytes.size());
+    return (bool)file;
+}
+
+#endif
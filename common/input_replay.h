@@ -0,0 +1,258 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+// GLUT 输入的录制与回放, 用于在完全相同的交互轨迹上比较不同版本的帧时间
+//
+//   ./viewer --record trace.txt   正常交互, 鼠标/键盘事件连同时间戳写入 trace.txt
+//   ./viewer --replay trace.txt   忽略实际输入, 以固定的模拟时间步长 (每帧 1/60 秒)
+//                                 把事件按时间戳送回回调函数; 结束后输出每帧耗时统计
+//
+// 用法: glutInit 之后调用 replayParseArgs, 用 replayInstallInput / replayInstallIdle
+// 代替 glutMouseFunc / glutMotionFunc / glutKeyboardFunc / glutIdleFunc,
+// 动画使用 replayTime() 作为时钟, display() 末尾调用 replayFrameDone()
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+enum InputEventType { INPUT_MOUSE = 'm', INPUT_MOTION = 'v', INPUT_KEYBOARD = 'k' };
+enum ReplayMode { REPLAY_OFF, REPLAY_RECORD, REPLAY_PLAYBACK };
+
+struct InputEvent {
+    double time;          // 秒, 相对于录制开始
+    char type;
+    int button, state;    // 仅 INPUT_MOUSE
+    int x, y;
+    unsigned char key;    // 仅 INPUT_KEYBOARD
+};
+
+struct InputReplayState {
+    ReplayMode mode;
+    std::string path;
+    std::vector<InputEvent> events;
+    size_t nextEvent;
+
+    // 应用程序的回调
+    void (*mouse)(int, int, int, int);
+    void (*motion)(int, int);
+    void (*keyboard)(unsigned char, int, int);
+    void (*idle)();
+
+    // 时钟
+    std::chrono::steady_clock::time_point start;
+    double simTime;               // 回放时的模拟时间 (秒)
+    double frameStep;             // 每帧推进的模拟时间
+    double tailTime;              // 最后一个事件之后继续运行的时间, 让自动旋转等动画也被计入
+
+    // 帧耗时
+    std::chrono::steady_clock::time_point lastFrame;
+    bool haveLastFrame;
+    std::vector<double> frameMs;
+
+    InputReplayState() : mode(REPLAY_OFF), nextEvent(0), mouse(0), motion(0), keyboard(0), idle(0),
+                         simTime(0.0), frameStep(1.0 / 60.0), tailTime(2.0), haveLastFrame(false) {}
+};
+
+inline InputReplayState& inputReplay() {
+    static InputReplayState state;
+    return state;
+}
+
+inline double replayWallSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - inputReplay().start).count();
+}
+
+/**
+ * @brief 动画使用的时钟 (秒): 回放时为模拟时间, 否则为真实时间
+ */
+inline double replayTime() {
+    InputReplayState& r = inputReplay();
+    return r.mode == REPLAY_PLAYBACK ? r.simTime : replayWallSeconds();
+}
+
+// --- 录制 ---
+inline void replaySaveTrace() {
+    InputReplayState& r = inputReplay();
+    std::ofstream out(r.path.c_str());
+    if (!out) { std::cerr << "错误: 无法写入输入轨迹 " << r.path << std::endl; return; }
+    out << "# input-trace v1: m t button state x y | v t x y | k t key x y\n";
+    char line[128];
+    for (size_t i = 0; i < r.events.size(); ++i) {
+        const InputEvent& e = r.events[i];
+        if (e.type == INPUT_MOUSE) snprintf(line, sizeof(line), "m %.6f %d %d %d %d\n", e.time, e.button, e.state, e.x, e.y);
+        else if (e.type == INPUT_MOTION) snprintf(line, sizeof(line), "v %.6f %d %d\n", e.time, e.x, e.y);
+        else snprintf(line, sizeof(line), "k %.6f %d %d %d\n", e.time, (int)e.key, e.x, e.y);
+        out << line;
+    }
+    std::cout << "输入轨迹已保存: " << r.path << " (" << r.events.size() << " 个事件)" << std::endl;
+}
+
+inline void replayRecord(char type, int button, int state, int x, int y, unsigned char key) {
+    InputEvent e = { replayWallSeconds(), type, button, state, x, y, key };
+    inputReplay().events.push_back(e);
+}
+
+inline void replayMouseHook(int button, int state, int x, int y) {
+    InputReplayState& r = inputReplay();
+    if (r.mode == REPLAY_PLAYBACK) return; // 回放时忽略实际输入
+    if (r.mode == REPLAY_RECORD) replayRecord(INPUT_MOUSE, button, state, x, y, 0);
+    if (r.mouse) r.mouse(button, state, x, y);
+}
+
+inline void replayMotionHook(int x, int y) {
+    InputReplayState& r = inputReplay();
+    if (r.mode == REPLAY_PLAYBACK) return;
+    if (r.mode == REPLAY_RECORD) replayRecord(INPUT_MOTION, 0, 0, x, y, 0);
+    if (r.motion) r.motion(x, y);
+}
+
+inline void replayKeyboardHook(unsigned char key, int x, int y) {
+    InputReplayState& r = inputReplay();
+    if (r.mode == REPLAY_PLAYBACK) {
+        if (key == 27) exit(0); // 回放时只响应 ESC
+        return;
+    }
+    if (r.mode == REPLAY_RECORD) replayRecord(INPUT_KEYBOARD, 0, 0, x, y, key);
+    if (r.keyboard) r.keyboard(key, x, y);
+}
+
+// --- 回放 ---
+inline bool replayLoadTrace() {
+    InputReplayState& r = inputReplay();
+    std::ifstream in(r.path.c_str());
+    if (!in) { std::cerr << "错误: 无法打开输入轨迹 " << r.path << std::endl; return false; }
+    std::string line;
+    while (std::getline(in, line)) {
+        InputEvent e = { 0.0, 0, 0, 0, 0, 0, 0 };
+        int key = 0;
+        if (line.empty() || line[0] == '#') continue;
+        if (sscanf(line.c_str(), "m %lf %d %d %d %d", &e.time, &e.button, &e.state, &e.x, &e.y) == 5) e.type = INPUT_MOUSE;
+        else if (sscanf(line.c_str(), "v %lf %d %d", &e.time, &e.x, &e.y) == 3) e.type = INPUT_MOTION;
+        else if (sscanf(line.c_str(), "k %lf %d %d %d", &e.time, &key, &e.x, &e.y) == 4) { e.type = INPUT_KEYBOARD; e.key = (unsigned char)key; }
+        else continue;
+        r.events.push_back(e);
+    }
+    std::cout << "输入轨迹已加载: " << r.path << " (" << r.events.size() << " 个事件)" << std::endl;
+    return true;
+}
+
+/**
+ * @brief 输出每帧耗时统计, 并把原始数据写到 <轨迹文件>.frames.csv
+ */
+inline void replayReport() {
+    InputReplayState& r = inputReplay();
+    std::vector<double> sorted = r.frameMs;
+    if (sorted.empty()) return;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (size_t i = 0; i < sorted.size(); ++i) sum += sorted[i];
+    size_t n = sorted.size();
+    std::cout << "回放完成: " << n << " 帧, 平均 " << sum / n << " ms, p50 " << sorted[n / 2]
+              << " ms, p95 " << sorted[std::min(n - 1, n * 95 / 100)] << " ms, p99 " << sorted[std::min(n - 1, n * 99 / 100)]
+              << " ms, 最大 " << sorted[n - 1] << " ms" << std::endl;
+
+    std::string csv = r.path + ".frames.csv";
+    std::ofstream out(csv.c_str());
+    out << "frame,sim_time,ms\n";
+    for (size_t i = 0; i < r.frameMs.size(); ++i) out << i << "," << (i + 1) * r.frameStep << "," << r.frameMs[i] << "\n";
+    std::cout << "每帧耗时已写入 " << csv << std::endl;
+}
+
+/**
+ * @brief 回放模式的 idle: 派发到期的事件, 然后调用应用的 idle 并请求重绘
+ * 模拟时间只在 replayFrameDone 中推进, 因此每一帧看到的时间与机器快慢无关
+ */
+inline void replayIdleHook() {
+    InputReplayState& r = inputReplay();
+    if (r.mode == REPLAY_PLAYBACK) {
+        while (r.nextEvent < r.events.size() && r.events[r.nextEvent].time <= r.simTime) {
+            const InputEvent& e = r.events[r.nextEvent++];
+            if (e.type == INPUT_MOUSE && r.mouse) r.mouse(e.button, e.state, e.x, e.y);
+            else if (e.type == INPUT_MOTION && r.motion) r.motion(e.x, e.y);
+            else if (e.type == INPUT_KEYBOARD && r.keyboard) r.keyboard(e.key, e.x, e.y);
+        }
+    }
+    if (r.idle) r.idle();
+    else glutPostRedisplay();
+}
+
+/**
+ * @brief 解析并移除命令行中的 --record <文件> / --replay <文件>
+ */
+inline void replayParseArgs(int& argc, char** argv) {
+    InputReplayState& r = inputReplay();
+    r.start = std::chrono::steady_clock::now();
+    int out = 1;
+    for (int i = 1; i < argc; ++i) {
+        if ((!strcmp(argv[i], "--record") || !strcmp(argv[i], "--replay")) && i + 1 < argc) {
+            r.mode = !strcmp(argv[i], "--record") ? REPLAY_RECORD : REPLAY_PLAYBACK;
+            r.path = argv[++i];
+        } else {
+            argv[out++] = argv[i];
+        }
+    }
+    argc = out;
+
+    if (r.mode == REPLAY_RECORD) {
+        std::cout << "正在录制输入到 " << r.path << " (退出时保存)" << std::endl;
+        atexit(replaySaveTrace);
+    } else if (r.mode == REPLAY_PLAYBACK && !replayLoadTrace()) {
+        exit(1);
+    }
+}
+
+/**
+ * @brief 注册输入回调 (代替 glutMouseFunc / glutMotionFunc / glutKeyboardFunc), 参数可以为空
+ */
+inline void replayInstallInput(void (*mouse)(int, int, int, int), void (*motion)(int, int),
+                               void (*keyboard)(unsigned char, int, int)) {
+    InputReplayState& r = inputReplay();
+    r.mouse = mouse;
+    r.motion = motion;
+    r.keyboard = keyboard;
+    glutMouseFunc(replayMouseHook);
+    glutMotionFunc(replayMotionHook);
+    glutKeyboardFunc(replayKeyboardHook);
+}
+
+/**
+ * @brief 注册 idle 回调 (代替 glutIdleFunc), 可以为空
+ * 回放模式下总会安装 idle, 用来推进模拟时间
+ */
+inline void replayInstallIdle(void (*idle)()) {
+    InputReplayState& r = inputReplay();
+    r.idle = idle;
+    if (r.mode == REPLAY_PLAYBACK || idle) glutIdleFunc(replayIdleHook);
+}
+
+/**
+ * @brief 在 display() 末尾 (glutSwapBuffers 之后) 调用
+ * 回放时记录帧耗时并把模拟时间推进一帧; 用 glFinish 等待 GPU 完成, 让帧耗时包含 GPU 时间
+ */
+inline void replayFrameDone() {
+    InputReplayState& r = inputReplay();
+    if (r.mode != REPLAY_PLAYBACK) return;
+    glFinish();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (r.haveLastFrame) r.frameMs.push_back(std::chrono::duration<double, std::milli>(now - r.lastFrame).count());
+    r.lastFrame = now;
+    r.haveLastFrame = true;
+
+    r.simTime += r.frameStep;
+    double end = r.events.empty() ? r.tailTime : r.events.back().time + r.tailTime;
+    if (r.simTime > end) {
+        replayReport();
+        exit(0);
+    }
+}
+
+#endif
@@ -0,0 +1,254 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+// 工作窃取 (work stealing) 任务调度器, 整个程序共用一组工作线程
+//
+//   JobSystem& js = jobSystem();
+//   JobHandle a = js.run([]() { ... });
+//   JobHandle b = js.run([]() { ... });
+//   JobHandle c = js.run([]() { ... }, a, b);      // a 和 b 都完成之后才开始
+//   js.wait(c);                                      // 等待期间调用线程也执行任务
+//
+//   js.parallelFor(count, chunks, [](size_t begin, size_t end, int chunk) { ... });
+//
+// - 每个线程 (调用线程占第 0 个槽位) 一个双端队列: 自己从尾部放入和取出 (后进先出, 缓存友好),
+//   空闲的线程从其他队列的头部窃取 (先进先出, 偷到的通常是较大、较早拆分出的任务)
+// - 依赖: 任务记录尚未完成的前置任务数, 最后一个前置任务完成时才被放入队列, 等待中的任务不占用线程
+// - wait() 不会阻塞调用线程: 目标任务完成之前不断取出 (或窃取) 其他任务来执行,
+//   因此任务内部也可以嵌套 parallelFor / wait, 不会因为线程都在等待而死锁
+// - 工作线程没有任务时在条件变量上休眠, 新任务放入时唤醒一个
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+#include "trace.h"
+
+inline int hardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : (int)n;
+}
+
+struct JobState {
+    std::function<void()> fn;
+    std::atomic<int> blockers;                        // 未完成的前置任务数 + 1 (提交完成前的保护计数)
+    std::atomic<bool> finished;
+    std::mutex mutex;                                 // 保护 dependents
+    std::vector<std::shared_ptr<JobState> > dependents;
+
+    JobState() : blockers(1), finished(false) {}
+};
+
+typedef std::shared_ptr<JobState> JobHandle;
+
+class JobSystem {
+public:
+    explicit JobSystem(int threads = 0) : queued_(0), quit_(false) { start(threads > 0 ? threads : hardwareThreads()); }
+    ~JobSystem() { stop(); }
+
+    /**
+     * @brief 改变线程数 (包括调用线程); 只能在没有任务运行时调用, 用于测量扩展性
+     */
+    void setThreadCount(int threads) {
+        threads = std::max(1, threads);
+        if (threads == threadCount()) return;
+        stop();
+        start(threads);
+    }
+
+    int threadCount() const { return (int)queues_.size(); }
+
+    /**
+     * @brief 提交任务; 给出的前置任务 (可以为空) 全部完成后才会执行
+     */
+    JobHandle run(const std::function<void()>& fn, const JobHandle& a = JobHandle(), const JobHandle& b = JobHandle()) {
+        JobHandle deps[2] = { a, b };
+        return run(fn, deps, 2);
+    }
+
+    JobHandle run(const std::function<void()>& fn, const JobHandle* deps, size_t depCount) {
+        JobHandle job = std::make_shared<JobState>();
+        job->fn = fn;
+        for (size_t i = 0; i < depCount; ++i) {
+            if (!deps[i]) continue;
+            std::lock_guard<std::mutex> lock(deps[i]->mutex);
+            if (deps[i]->finished.load(std::memory_order_acquire)) continue;
+            job->blockers.fetch_add(1, std::memory_order_relaxed);
+            deps[i]->dependents.push_back(job);
+        }
+        release(job);   // 去掉保护计数; 没有未完成的前置任务时立即入队
+        return job;
+    }
+
+    /**
+     * @brief 等待任务完成; 期间调用线程执行队列中的任务
+     */
+    void wait(const JobHandle& job) {
+        if (!job) return;
+        while (!job->finished.load(std::memory_order_acquire)) {
+            if (!runOne()) std::this_thread::yield();
+        }
+    }
+
+    void wait(const std::vector<JobHandle>& jobs) {
+        for (size_t i = 0; i < jobs.size(); ++i) wait(jobs[i]);
+    }
+
+    /**
+     * @brief 把 [0, count) 均分为 chunks 段 (chunks <= 0 时为线程数的 4 倍), 每段一个任务, 等待全部完成
+     * fn(begin, end, chunk): chunk 是段号 (0 .. chunks-1), 同一时刻不会有两个任务使用同一段号,
+     * 可以用来索引每段独立的累加器
+     */
+    template <typename Fn>
+    void parallelFor(size_t count, int chunks, Fn fn) {
+        if (chunks <= 0) chunks = threadCount() * 4;
+        if ((size_t)chunks > count) chunks = count > 0 ? (int)count : 1;
+        if (chunks == 1 || threadCount() == 1) {
+            size_t per = (count + chunks - 1) / chunks;
+            for (int c = 0; c < chunks; ++c) fn(std::min(count, c * per), std::min(count, (c + 1) * per), c);
+            return;
+        }
+        size_t per = (count + chunks - 1) / chunks;
+        std::vector<JobHandle> jobs;
+        jobs.reserve(chunks - 1);
+        // 倒序放入, 本线程从队尾先取到第 1 段; 第 0 段直接在本线程执行
+        for (int c = chunks - 1; c >= 1; --c) {
+            size_t begin = std::min(count, c * per), end = std::min(count, begin + per);
+            jobs.push_back(run([fn, begin, end, c]() mutable {
+                TRACE_ZONE("parallelFor");
+                fn(begin, end, c);
+            }));
+        }
+        {
+            TRACE_ZONE("parallelFor");
+            fn((size_t)0, std::min(count, per), 0);
+        }
+        wait(jobs);
+    }
+
+    /**
+     * @brief 执行一个任务 (自己的队列优先, 然后窃取); 没有可执行的任务时返回 false
+     */
+    bool runOne() {
+        JobHandle job = take(workerIndex());
+        if (!job) return false;
+        execute(job);
+        return true;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+
+    // 当前线程在 queues_ 中的槽位; 不属于本调度器的线程 (包括主线程) 使用第 0 个
+    int& workerSlot() {
+        static thread_local int slot = 0;
+        return slot;
+    }
+    int workerIndex() {
+        int slot = workerSlot();
+        return slot < threadCount() ? slot : 0;
+    }
+
+    void start(int threads) {
+        quit_ = false;
+        queues_.clear();
+        for (int i = 0; i < threads; ++i) queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+        for (int i = 1; i < threads; ++i) workers_.push_back(std::thread(&JobSystem::workerLoop, this, i));
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+            quit_ = true;
+        }
+        wake_.notify_all();
+        for (size_t i = 0; i < workers_.size(); ++i) workers_[i].join();
+        workers_.clear();
+    }
+
+    void release(const JobHandle& job) {
+        if (job->blockers.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        Queue& q = *queues_[workerIndex()];
+        {
+            std::lock_guard<std::mutex> lock(q.mutex);
+            q.jobs.push_back(job);
+        }
+        queued_.fetch_add(1, std::memory_order_release);
+        if (!workers_.empty()) {
+            std::lock_guard<std::mutex> lock(sleepMutex_);   // 与 workerLoop 的检查-休眠互斥, 避免丢失唤醒
+        }
+        wake_.notify_one();
+    }
+
+    JobHandle take(int self) {
+        if (queued_.load(std::memory_order_acquire) == 0) return JobHandle();
+        int n = threadCount();
+        for (int k = 0; k < n; ++k) {
+            int victim = (self + k) % n;
+            Queue& q = *queues_[victim];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.jobs.empty()) continue;
+            JobHandle job;
+            if (victim == self) {
+                job = q.jobs.back();
+                q.jobs.pop_back();
+            } else {
+                job = q.jobs.front();
+                q.jobs.pop_front();
+            }
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+        return JobHandle();
+    }
+
+    void execute(const JobHandle& job) {
+        job->fn();
+        job->fn = std::function<void()>();   // 尽早释放捕获的资源
+        std::vector<JobHandle> ready;
+        {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->finished.store(true, std::memory_order_release);
+            ready.swap(job->dependents);
+        }
+        for (size_t i = 0; i < ready.size(); ++i) release(ready[i]);
+    }
+
+    void workerLoop(int index) {
+        workerSlot() = index;
+        TRACE_THREAD_NAME("job worker");
+        for (;;) {
+            if (runOne()) continue;
+            std::unique_lock<std::mutex> lock(sleepMutex_);
+            wake_.wait(lock, [this]() { return quit_ || queued_.load(std::memory_order_acquire) > 0; });
+            if (quit_) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<int> queued_;            // 所有队列中的任务总数
+    bool quit_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+};
+
+/**
+ * @brief 全局调度器 (第一次调用时按硬件线程数创建)
+ */
+inline JobSystem& jobSystem() {
+    static JobSystem system;
+    return system;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+// 最简单的并行循环: 把 [0, count) 均分为 threads 段, 每段是一段连续区间
+// fn(begin, end, threadIndex): threadIndex 是段号, 可以用来索引每段独立的缓冲
+//
+// 各段作为任务交给共用的工作窃取调度器 (job_system.h) 执行, 不再每次创建线程;
+// 实际并发数不超过调度器的线程数, 调用线程等待时也参与执行
+
+#include "job_system.h"
+#include "trace.h"
+
+template <typename Fn>
+void parallelFor(size_t count, int threads, Fn fn) {
+    if (threads <= 0) threads = jobSystem().threadCount();
+    if ((size_t)threads > count) threads = count > 0 ? (int)count : 1;
+    if (threads == 1) { fn((size_t)0, count, 0); return; }
+    jobSystem().parallelFor(count, threads, fn);
+}
+
+#endif
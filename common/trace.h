@@ -0,0 +1,219 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// CPU 时间线插桩, 输出 Chrome / Perfetto 可以直接打开的 trace JSON (chrome://tracing 或 ui.perfetto.dev)
+//
+//   int main(int argc, char** argv) {
+//       TRACE_INIT("viewer_trace.json");     // 程序退出时 (atexit) 自动写出
+//       ...
+//   }
+//   void display() {
+//       TRACE_FUNCTION();                     // 作用域结束时记录一段 "函数名" 区间
+//       { TRACE_ZONE("upload"); ... }
+//   }
+//   工作线程开头: TRACE_THREAD_NAME("worker");
+//
+// 只有定义了 ENABLE_TRACE (make TRACE=1) 时才生效, 否则所有宏展开为空语句, 没有任何开销
+//
+// 每个线程第一次记录时领取一块自己的缓冲, 之后写入不加锁: 事件写入当前块后用 release 存储发布计数,
+// 写出时只读取已发布的事件 (丢弃计数也是原子的), 因此可以在其他线程仍在运行时写出.
+// 线程结束时缓冲归还空闲池, 后来创建的线程复用它, 在时间线上显示为同一条轨道;
+// 任务调度器 (job_system.h) 的工作线程常驻, 每个工作线程始终对应一条轨道.
+// 区间名必须是字符串字面量或静态存储期的字符串 (只保存指针)
+
+#ifdef ENABLE_TRACE
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+
+const size_t TRACE_BLOCK_EVENTS = 8192;   // 每块的事件数
+const size_t TRACE_MAX_BLOCKS = 512;      // 每个线程最多的块数, 写满后丢弃新事件并计数
+
+struct TraceEvent {
+    const char* name;
+    uint64_t beginNs, endNs;
+};
+
+struct TraceBuffer {
+    int tid;
+    std::string name;
+    std::atomic<TraceEvent*> blocks[TRACE_MAX_BLOCKS];
+    std::atomic<size_t> count;     // 已发布的事件数
+    std::atomic<size_t> dropped;   // 缓冲写满后丢弃的事件数, 写出时可能有其他线程仍在累加
+
+    explicit TraceBuffer(int id) : tid(id), count(0), dropped(0) {
+        for (size_t i = 0; i < TRACE_MAX_BLOCKS; ++i) blocks[i].store(0, std::memory_order_relaxed);
+    }
+
+    // 只由拥有它的线程调用
+    void push(const char* eventName, uint64_t beginNs, uint64_t endNs) {
+        size_t n = count.load(std::memory_order_relaxed);
+        size_t block = n / TRACE_BLOCK_EVENTS;
+        if (block >= TRACE_MAX_BLOCKS) { dropped.fetch_add(1, std::memory_order_relaxed); return; }
+        TraceEvent* events = blocks[block].load(std::memory_order_relaxed);
+        if (!events) {
+            events = new TraceEvent[TRACE_BLOCK_EVENTS];
+            blocks[block].store(events, std::memory_order_release);
+        }
+        TraceEvent& e = events[n % TRACE_BLOCK_EVENTS];
+        e.name = eventName;
+        e.beginNs = beginNs;
+        e.endNs = endNs;
+        count.store(n + 1, std::memory_order_release);
+    }
+};
+
+struct TraceState {
+    std::mutex mutex;                     // 只在线程领取/归还缓冲和写出时使用
+    std::vector<TraceBuffer*> buffers;    // 所有缓冲, 从不释放
+    std::vector<TraceBuffer*> freeList;
+    std::string path;
+    std::chrono::steady_clock::time_point start;
+
+    TraceState() : start(std::chrono::steady_clock::now()) {}
+};
+
+inline TraceState& traceState() {
+    static TraceState* state = new TraceState();   // 不析构, 保证 atexit 和线程退出时仍然可用
+    return *state;
+}
+
+inline uint64_t traceNowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - traceState().start).count();
+}
+
+// 线程局部的缓冲句柄: 线程结束时把缓冲归还空闲池
+struct TraceThreadSlot {
+    TraceBuffer* buffer;
+
+    TraceThreadSlot() : buffer(0) {}
+    ~TraceThreadSlot() {
+        if (!buffer) return;
+        TraceState& state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.freeList.push_back(buffer);
+    }
+
+    TraceBuffer* get() {
+        if (buffer) return buffer;
+        TraceState& state = traceState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (!state.freeList.empty()) {
+            buffer = state.freeList.back();
+            state.freeList.pop_back();
+        } else {
+            buffer = new TraceBuffer((int)state.buffers.size() + 1);
+            buffer->name = state.buffers.empty() ? "main" : "thread " + std::to_string(state.buffers.size() + 1);
+            state.buffers.push_back(buffer);
+        }
+        return buffer;
+    }
+};
+
+inline TraceBuffer* traceThreadBuffer() {
+    static thread_local TraceThreadSlot slot;
+    return slot.get();
+}
+
+inline void traceSetThreadName(const char* name) {
+    TraceBuffer* buffer = traceThreadBuffer();
+    std::lock_guard<std::mutex> lock(traceState().mutex);
+    buffer->name = name;
+}
+
+/**
+ * @brief 把所有线程已发布的事件写成 Chrome trace JSON (可以多次调用, 每次写出完整的时间线)
+ */
+inline void traceFlush() {
+    TraceState& state = traceState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.path.empty()) return;
+    std::ofstream out(state.path.c_str());
+    if (!out) { std::cerr << "错误: 无法写入 trace 文件 " << state.path << std::endl; return; }
+
+    size_t total = 0, dropped = 0;
+    char line[512];
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    snprintf(line, sizeof(line), "{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"%s\"}}",
+             state.path.c_str());
+    out << line;
+    for (size_t b = 0; b < state.buffers.size(); ++b) {
+        TraceBuffer* buffer = state.buffers[b];
+        snprintf(line, sizeof(line), ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}",
+                 buffer->tid, buffer->name.c_str());
+        out << line;
+        size_t n = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; ++i) {
+            const TraceEvent& e = buffer->blocks[i / TRACE_BLOCK_EVENTS].load(std::memory_order_acquire)[i % TRACE_BLOCK_EVENTS];
+            // 时间单位为微秒; 区间名来自源代码中的标识符, 不需要转义
+            snprintf(line, sizeof(line), ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                     buffer->tid, e.name, e.beginNs / 1000.0, (e.endNs - e.beginNs) / 1000.0);
+            out << line;
+        }
+        total += n;
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    out << "\n]}\n";
+    std::cout << "trace: " << total << " 个事件 (" << state.buffers.size() << " 个线程) 写入 " << state.path;
+    if (dropped > 0) std::cout << ", 缓冲已满丢弃 " << dropped << " 个";
+    std::cout << std::endl;
+}
+
+inline void traceAtExit() { traceFlush(); }
+
+/**
+ * @brief 设置输出文件并在程序退出时自动写出; 同时把调用线程命名为 "main"
+ */
+inline void traceInit(const char* path) {
+    TraceState& state = traceState();
+    traceThreadBuffer();
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        bool first = state.path.empty();
+        state.path = path;
+        if (!first) return;
+    }
+    atexit(traceAtExit);
+}
+
+// RAII 区间: 构造时记下开始时间, 析构时写入一个完整事件
+class TraceZone {
+public:
+    explicit TraceZone(const char* name) : name_(name), begin_(traceNowNs()) {}
+    ~TraceZone() { traceThreadBuffer()->push(name_, begin_, traceNowNs()); }
+
+private:
+    TraceZone(const TraceZone&);
+    TraceZone& operator=(const TraceZone&);
+    const char* name_;
+    uint64_t begin_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CONCAT(traceZone_, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_ZONE(__FUNCTION__)
+#define TRACE_THREAD_NAME(name) traceSetThreadName(name)
+#define TRACE_INIT(path) traceInit(path)
+#define TRACE_FLUSH() traceFlush()
+
+#else
+
+#define TRACE_ZONE(name) ((void)0)
+#define TRACE_FUNCTION() ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#define TRACE_INIT(path) ((void)0)
+#define TRACE_FLUSH() ((void)0)
+
+#endif
+
+#endif
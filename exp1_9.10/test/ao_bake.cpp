@@ -0,0 +1,69 @@
+// 逐顶点环境光遮蔽的离线烘焙工具 (不需要窗口)
+//
+//   ./ao_bake banana.obj                 烘焙并写出 banana.obj.ao (banana_viewer 按 'a' 键或 --ao 时读取)
+//   ./ao_bake banana.obj --rays 256      每个顶点的射线数 (默认 64)
+//   ./ao_bake banana.obj --distance 0.1  最大遮挡距离, 相对于包围盒对角线 (默认 0.25)
+//   ./ao_bake banana.meshc --scaling     另外依次用 1, 2, 4, ... 个线程烘焙, 报告射线吞吐量和加速比
+//
+// 总是重新烘焙 (忽略已有的缓存); 结果与线程数无关, --scaling 时会检查各线程数的结果完全相同
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+#include "obj_reader.h"
+#include "mesh_codec.h"
+#include "ao_bake.h"
+#include "trace.h"
+
+int main(int argc, char** argv) {
+    TRACE_INIT("ao_bake_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    std::string modelPath;
+    AoOptions opt;
+    bool scaling = false;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--rays") && i + 1 < argc) opt.rays = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--distance") && i + 1 < argc) opt.maxDistance = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--scaling")) scaling = true;
+        else modelPath = argv[i];
+    }
+    if (modelPath.empty() || opt.rays <= 0 || opt.maxDistance <= 0.0f) {
+        std::cerr << "用法: " << argv[0] << " model.obj|model.meshc [--rays N] [--distance D] [--scaling]" << std::endl;
+        return 1;
+    }
+
+    ObjModel model;
+    bool compressed = modelPath.size() > 6 && modelPath.compare(modelPath.size() - 6, 6, ".meshc") == 0;
+    if (compressed ? !readMeshc(modelPath, model) : !readObj(modelPath, model)) return 1;
+
+    std::vector<float> ao;
+    AoStats stats;
+    bakeAo(model, opt, ao, stats);
+    double sum = 0.0;
+    for (size_t i = 0; i < ao.size(); ++i) sum += ao[i];
+    std::cout << stats.vertices << " 个顶点 x " << opt.rays << " 条射线: 建 BVH " << stats.buildMs << " ms, 烘焙 "
+              << stats.bakeMs << " ms (" << jobSystem().threadCount() << " 线程, " << stats.raysPerSecond() / 1e6
+              << " M 射线/秒), 平均 AO " << (ao.empty() ? 1.0 : sum / ao.size()) << std::endl;
+    std::string cacheFile = modelPath + ".ao";
+    if (!writeAoCache(cacheFile, aoMeshHash(model, opt), ao)) return 1;
+    std::cout << "已写入 " << cacheFile << std::endl;
+
+    if (scaling) {
+        double baseMs = 0.0;
+        for (int threads = 1;; threads = std::min(threads * 2, hardwareThreads())) {
+            jobSystem().setThreadCount(threads);
+            std::vector<float> other;
+            AoStats s;
+            bakeAo(model, opt, other, s);
+            if (threads == 1) baseMs = s.bakeMs;
+            bool same = other == ao;
+            std::cout << "  " << threads << " 线程: " << s.bakeMs << " ms, " << s.raysPerSecond() / 1e6 << " M 射线/秒, "
+                      << baseMs / s.bakeMs << " 倍" << (same ? "" : "  [错误: 结果与默认线程数不同]") << std::endl;
+            if (!same) return 1;
+            if (threads >= hardwareThreads()) break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,332 @@
+#ifndef AO_BAKE_H
+#define AO_BAKE_H
+
+// 逐顶点环境光遮蔽 (ambient occlusion) 烘焙, 结果缓存在模型旁边的 .ao 文件中
+//
+//   AoOptions opt;                  // 每个顶点的射线数, 最大遮挡距离
+//   std::vector<float> ao;          // 每个顶点一个值: 1 = 完全不被遮挡, 0 = 完全被遮挡
+//   AoStats stats;
+//   loadOrBakeAo("banana.obj.ao", model, opt, ao, stats);
+//
+// - 三角形组织成 BVH (与 scene.h 的 InstanceBVH 相同: 按最长轴中位数划分, 叶子最多 4 个), 射线只需要判断是否被遮挡
+// - 每个顶点沿法线方向的半球发射余弦加权的射线, 未被遮挡的比例即为 AO 值
+//   (余弦加权采样的简单平均就是按 cos 加权的可见度, 与漫反射光照的权重一致)
+// - 采样点为 Hammersley 序列, 每个顶点按编号的哈希做随机平移 (Cranley-Patterson), 结果与线程数无关
+// - 各顶点在共用调度器 (job_system.h) 上并行烘焙, 分段数取线程数的 16 倍, 平衡开阔和凹陷区域的耗时差异
+// - .ao 文件记录网格哈希 (顶点 + 索引 + 烘焙参数), 模型或参数变化后自动重新烘焙
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+#include "math3d.h"
+#include "obj_reader.h"
+#include "chunk_hash.h"
+#include "job_system.h"
+#include "trace.h"
+
+const char AO_MAGIC[4] = { 'A', 'O', 'B', 'K' };
+const uint32_t AO_VERSION = 1;
+
+struct AoOptions {
+    int rays;               // 每个顶点的射线数
+    float maxDistance;      // 最大遮挡距离, 相对于包围盒对角线长度
+    float bias;             // 射线起点沿法线的偏移, 相对于包围盒对角线长度 (避免与自身所在的面相交)
+
+    AoOptions() : rays(64), maxDistance(0.25f), bias(1e-4f) {}
+};
+
+struct AoStats {
+    size_t vertices;
+    uint64_t rays;
+    double buildMs, bakeMs;
+    bool fromCache;
+
+    AoStats() : vertices(0), rays(0), buildMs(0.0), bakeMs(0.0), fromCache(false) {}
+    double raysPerSecond() const { return bakeMs > 0.0 ? rays / (bakeMs / 1000.0) : 0.0; }
+};
+
+// --- 三角形 BVH ---
+struct TriangleBVH {
+    struct Node {
+        AABB bounds;
+        int left;   // 内部节点: 左孩子编号 (右孩子为 left + 1); 叶子节点: -1
+        int first;  // 叶子节点: 在 tris 中的起始位置
+        int count;  // 叶子节点: 三角形数量; 内部节点为 0
+    };
+    // 按叶子顺序存放, 预先算好两条边, 供 Möller-Trumbore 求交
+    struct Tri { Vec3 v0, e1, e2; };
+
+    std::vector<Node> nodes;
+    std::vector<Tri> tris;
+    static const int LEAF_SIZE = 4;
+
+    /**
+     * @brief 从交错顶点 (位置在前 3 个 float) 和三角形索引构建
+     */
+    void build(const float* vertices, int stride, const unsigned* indices, size_t triangleCount) {
+        TRACE_ZONE("TriangleBVH::build");
+        nodes.clear();
+        tris.clear();
+        if (triangleCount == 0) return;
+        std::vector<AABB> triBounds(triangleCount);
+        std::vector<Vec3> centers(triangleCount);
+        std::vector<int> items(triangleCount);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            AABB b = aabbEmpty();
+            for (int k = 0; k < 3; ++k) {
+                const float* p = vertices + (size_t)indices[t * 3 + k] * stride;
+                aabbExpand(b, vec3(p[0], p[1], p[2]));
+            }
+            triBounds[t] = b;
+            centers[t] = aabbCenter(b);
+            items[t] = (int)t;
+        }
+
+        nodes.reserve(2 * triangleCount / LEAF_SIZE + 1);
+        Node root = { aabbEmpty(), -1, 0, (int)triangleCount };
+        nodes.push_back(root);
+        std::vector<int> stack(1, 0);
+        while (!stack.empty()) {
+            int ni = stack.back();
+            stack.pop_back();
+            int first = nodes[ni].first, count = nodes[ni].count;
+
+            AABB box = aabbEmpty(), centerBox = aabbEmpty();
+            for (int i = first; i < first + count; ++i) {
+                aabbMerge(box, triBounds[items[i]]);
+                aabbExpand(centerBox, centers[items[i]]);
+            }
+            nodes[ni].bounds = box;
+            if (count <= LEAF_SIZE) continue;
+
+            Vec3 ext = centerBox.max - centerBox.min;
+            int axis = (ext.y > ext.x) ? 1 : 0;
+            if (ext.z > (&ext.x)[axis]) axis = 2;
+            int mid = first + count / 2;
+            std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count,
+                             [&centers, axis](int a, int b) { return (&centers[a].x)[axis] < (&centers[b].x)[axis]; });
+
+            int left = (int)nodes.size();
+            Node l = { aabbEmpty(), -1, first, mid - first };
+            Node r = { aabbEmpty(), -1, mid, first + count - mid };
+            nodes.push_back(l);
+            nodes.push_back(r);
+            nodes[ni].left = left;
+            nodes[ni].count = 0;
+            stack.push_back(left + 1);
+            stack.push_back(left);
+        }
+
+        tris.resize(triangleCount);
+        for (size_t i = 0; i < triangleCount; ++i) {
+            const unsigned* tri = indices + (size_t)items[i] * 3;
+            const float* a = vertices + (size_t)tri[0] * stride;
+            const float* b = vertices + (size_t)tri[1] * stride;
+            const float* c = vertices + (size_t)tri[2] * stride;
+            Vec3 v0 = vec3(a[0], a[1], a[2]);
+            Tri t = { v0, vec3(b[0], b[1], b[2]) - v0, vec3(c[0], c[1], c[2]) - v0 };
+            tris[i] = t;
+        }
+    }
+
+    /**
+     * @brief 射线 origin + t * dir (0 < t < tMax) 是否与任一三角形相交; 找到第一个交点即返回
+     */
+    bool occluded(const Vec3& origin, const Vec3& dir, float tMax) const {
+        if (nodes.empty()) return false;
+        Vec3 inv = vec3(1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z);
+        int stack[64];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node& node = nodes[stack[--top]];
+            if (!hitBox(node.bounds, origin, inv, tMax)) continue;
+            if (node.left >= 0) {
+                stack[top++] = node.left + 1;
+                stack[top++] = node.left;
+                continue;
+            }
+            for (int i = node.first; i < node.first + node.count; ++i)
+                if (hitTriangle(tris[i], origin, dir, tMax)) return true;
+        }
+        return false;
+    }
+
+    static bool hitBox(const AABB& b, const Vec3& o, const Vec3& inv, float tMax) {
+        float t0 = (b.min.x - o.x) * inv.x, t1 = (b.max.x - o.x) * inv.x;
+        float tNear = std::min(t0, t1), tFar = std::max(t0, t1);
+        t0 = (b.min.y - o.y) * inv.y; t1 = (b.max.y - o.y) * inv.y;
+        tNear = std::max(tNear, std::min(t0, t1)); tFar = std::min(tFar, std::max(t0, t1));
+        t0 = (b.min.z - o.z) * inv.z; t1 = (b.max.z - o.z) * inv.z;
+        tNear = std::max(tNear, std::min(t0, t1)); tFar = std::min(tFar, std::max(t0, t1));
+        return tNear <= tFar && tFar >= 0.0f && tNear <= tMax;
+    }
+
+    static bool hitTriangle(const Tri& tri, const Vec3& o, const Vec3& d, float tMax) {
+        Vec3 p = cross(d, tri.e2);
+        float det = dot(tri.e1, p);
+        if (std::fabs(det) < 1e-12f) return false;
+        float invDet = 1.0f / det;
+        Vec3 s = o - tri.v0;
+        float u = dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f) return false;
+        Vec3 q = cross(s, tri.e1);
+        float v = dot(d, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f) return false;
+        float t = dot(tri.e2, q) * invDet;
+        return t > 0.0f && t < tMax;
+    }
+};
+
+// --- 采样 ---
+
+inline float radicalInverse2(uint32_t bits) {
+    bits = (bits << 16) | (bits >> 16);
+    bits = ((bits & 0x55555555u) << 1) | ((bits & 0xAAAAAAAAu) >> 1);
+    bits = ((bits & 0x33333333u) << 2) | ((bits & 0xCCCCCCCCu) >> 2);
+    bits = ((bits & 0x0F0F0F0Fu) << 4) | ((bits & 0xF0F0F0F0u) >> 4);
+    bits = ((bits & 0x00FF00FFu) << 8) | ((bits & 0xFF00FF00u) >> 8);
+    return bits * 2.3283064365386963e-10f;
+}
+
+inline uint32_t aoVertexSeed(uint32_t i) {
+    i ^= i >> 16; i *= 0x7FEB352Du;
+    i ^= i >> 15; i *= 0x846CA68Bu;
+    return i ^ (i >> 16);
+}
+
+/**
+ * @brief 以单位向量 n 为 z 轴的正交基 (Duff 等人 2017 的无分支构造)
+ */
+inline void orthonormalBasis(const Vec3& n, Vec3& t, Vec3& b) {
+    float sign = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (sign + n.z);
+    float c = n.x * n.y * a;
+    t = vec3(1.0f + sign * n.x * n.x * a, sign * c, -sign * n.x);
+    b = vec3(c, sign + n.y * n.y * a, -n.y);
+}
+
+// --- 烘焙 ---
+
+/**
+ * @brief 网格和烘焙参数的哈希, 作为 .ao 缓存的键
+ */
+inline uint64_t aoMeshHash(const ObjModel& model, const AoOptions& opt) {
+    uint64_t h = hashChunk(model.vertices.empty() ? 0 : (const uint8_t*)&model.vertices[0], model.vertices.size() * sizeof(float));
+    uint64_t hi = hashChunk(model.indices.empty() ? 0 : (const uint8_t*)&model.indices[0], model.indices.size() * sizeof(unsigned));
+    float params[3] = { (float)opt.rays, opt.maxDistance, opt.bias };
+    uint64_t hp = hashChunk((const uint8_t*)params, sizeof(params));
+    return h ^ (hi * 0x9E3779B97F4A7C15ull) ^ (hp * 0xC2B2AE3D27D4EB4Full);
+}
+
+/**
+ * @brief 为每个顶点烘焙 AO, 结果写入 ao (与 model.vertexCount() 等长)
+ */
+inline void bakeAo(const ObjModel& model, const AoOptions& opt, std::vector<float>& ao, AoStats& stats) {
+    TRACE_FUNCTION();
+    size_t vertexCount = model.vertexCount();
+    ao.assign(vertexCount, 1.0f);
+    stats = AoStats();
+    stats.vertices = vertexCount;
+    if (vertexCount == 0 || model.indices.empty()) return;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    TriangleBVH bvh;
+    bvh.build(&model.vertices[0], OBJ_VERTEX_STRIDE, &model.indices[0], model.indices.size() / 3);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    stats.buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+
+    float diagonal = length(model.bounds.max - model.bounds.min);
+    float maxDistance = opt.maxDistance * diagonal, bias = opt.bias * diagonal;
+    int rays = std::max(1, opt.rays);
+    JobSystem& js = jobSystem();
+    js.parallelFor(vertexCount, js.threadCount() * 16, [&](size_t begin, size_t end, int) {
+        TRACE_ZONE("bakeAo::chunk");
+        for (size_t i = begin; i < end; ++i) {
+            const float* v = &model.vertices[i * OBJ_VERTEX_STRIDE];
+            Vec3 n = vec3(v[3], v[4], v[5]);
+            float len = length(n);
+            if (len <= 0.0f) continue;
+            n = n * (1.0f / len);
+            Vec3 t, b;
+            orthonormalBasis(n, t, b);
+            Vec3 origin = vec3(v[0], v[1], v[2]) + n * bias;
+            uint32_t seed = aoVertexSeed((uint32_t)i);
+            float shift1 = (seed & 0xFFFF) / 65536.0f, shift2 = (seed >> 16) / 65536.0f;
+            int open = 0;
+            for (int r = 0; r < rays; ++r) {
+                // 余弦加权: 单位圆盘上均匀取点再投影到半球
+                float u1 = (r + 0.5f) / rays + shift1, u2 = radicalInverse2((uint32_t)r) + shift2;
+                u1 -= std::floor(u1);
+                u2 -= std::floor(u2);
+                float radius = std::sqrt(u1), phi = 6.2831853f * u2;
+                float x = radius * std::cos(phi), y = radius * std::sin(phi), z = std::sqrt(std::max(0.0f, 1.0f - u1));
+                Vec3 dir = t * x + b * y + n * z;
+                if (!bvh.occluded(origin, dir, maxDistance)) ++open;
+            }
+            ao[i] = (float)open / rays;
+        }
+    });
+    stats.rays = (uint64_t)vertexCount * rays;
+    stats.bakeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+}
+
+// --- .ao 缓存文件: [magic 4][version u32][网格哈希 u64][顶点数 u32][每个顶点一个 float] ---
+
+inline bool readAoCache(const std::string& filename, uint64_t hash, size_t vertexCount, std::vector<float>& ao) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) return false;
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    uint64_t fileHash = 0;
+    file.read(magic, 4);
+    file.read((char*)&version, sizeof(version));
+    file.read((char*)&fileHash, sizeof(fileHash));
+    file.read((char*)&count, sizeof(count));
+    if (!file || memcmp(magic, AO_MAGIC, 4) != 0 || version != AO_VERSION || fileHash != hash || count != vertexCount) return false;
+    ao.resize(vertexCount);
+    if (vertexCount) file.read((char*)&ao[0], vertexCount * sizeof(float));
+    return (bool)file;
+}
+
+inline bool writeAoCache(const std::string& filename, uint64_t hash, const std::vector<float>& ao) {
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file) { std::cerr << "警告: 无法写入 AO 缓存 " << filename << std::endl; return false; }
+    uint32_t count = (uint32_t)ao.size();
+    file.write(AO_MAGIC, 4);
+    file.write((const char*)&AO_VERSION, sizeof(AO_VERSION));
+    file.write((const char*)&hash, sizeof(hash));
+    file.write((const char*)&count, sizeof(count));
+    if (count) file.write((const char*)&ao[0], count * sizeof(float));
+    return (bool)file;
+}
+
+/**
+ * @brief 缓存有效时直接读取, 否则烘焙并写出缓存
+ */
+inline void loadOrBakeAo(const std::string& cacheFile, const ObjModel& model, const AoOptions& opt,
+                         std::vector<float>& ao, AoStats& stats) {
+    TRACE_FUNCTION();
+    uint64_t hash = aoMeshHash(model, opt);
+    if (readAoCache(cacheFile, hash, model.vertexCount(), ao)) {
+        stats = AoStats();
+        stats.vertices = ao.size();
+        stats.fromCache = true;
+        std::cout << "AO: 读取缓存 " << cacheFile << " (" << ao.size() << " 个顶点)" << std::endl;
+        return;
+    }
+    bakeAo(model, opt, ao, stats);
+    std::cout << "AO: 烘焙 " << stats.vertices << " 个顶点 x " << opt.rays << " 条射线, 建 BVH " << stats.buildMs
+              << " ms, 烘焙 " << stats.bakeMs << " ms (" << jobSystem().threadCount() << " 线程, "
+              << stats.raysPerSecond() / 1e6 << " M 射线/秒)" << std::endl;
+    if (writeAoCache(cacheFile, hash, ao)) std::cout << "AO: 已写入缓存 " << cacheFile << std::endl;
+}
+
+#endif
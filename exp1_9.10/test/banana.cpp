@@ -1,36 +1,88 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
 
 #include <GLUT/glut.h>
 #include <OpenGL/gl.h>
 
-// --- 数据结构 ---
-struct Vec2 { float u, v; };
-struct Vec3 { float x, y, z; };
-
-// 新的Face结构, 存储顶点、纹理和法线索引
-struct Face {
-    int v_indices[3];
-    int vt_indices[3];
-    int vn_indices[3];
-};
+#include "obj_reader.h"
+#include "mesh_weld.h"
+#include "mesh_cleanup.h"
+#include "mesh_codec.h"
+#include "mesh_edges.h"
+#include "buffer_sync.h"
+#include "ao_bake.h"
+#include "point_splat.h"
+#include "input_replay.h"
+#include "frame_capture.h"
+#include "gpu_timer.h"
+#include "file_watch.h"
+#include "trace.h"
 
 // --- 全局变量 ---
-std::vector<Vec3> vertices;
-std::vector<Vec2> texcoords; // 新增：存储纹理坐标
-std::vector<Vec3> normals;
-std::vector<Face> faces;
+// 模型数据: 交错顶点 + 按材质分组的索引, 上传后保存在 VBO/IBO 中
+// 缓冲记录每块内容的哈希, 热重载时只上传变化的块 (见 buffer_sync.h)
+ObjModel model;
+SyncedBuffer modelVBO, modelIBO;
+const float BANANA_COLOR[3] = { 1.0f, 1.0f, 0.3f }; // 没有材质时给香蕉一个黄色
+// 唯一边线框: 全部边和折痕边各一个静态索引缓冲, 轮廓边每帧重新生成
+EdgeTable edgeTable;
+SyncedBuffer edgeIBO, creaseIBO;
+GLuint silhouetteIBO = 0;
+std::vector<unsigned> silhouetteIndices;
+WireFrameTimer wireTimer;
+float weldEpsilon = 0.0f; // --weld <epsilon>: 加载后焊接距离小于 epsilon 的重复顶点, 0 表示不焊接
+bool cleanupMesh = true;  // 加载后删除退化 / 重复三角形和没有被引用的顶点 (--no-cleanup 关闭)
+// 热重载: 模型文件被重新导出后自动重新读取, 视角和显示模式保持不变 (--no-watch 关闭, 'r' 键手动重新读取)
+std::string modelPath = "banana.obj";
+FileWatcher modelWatcher;
+bool reloadShown = true;                             // 重载后的第一帧是否已经画出
+std::chrono::steady_clock::time_point reloadSeen;    // 察觉文件变化的时间
+const int WATCH_INTERVAL_MS = 50;
+// 环境光遮蔽: 烘焙结果 (缓存在 <模型>.ao) 乘以材质颜色作为逐顶点颜色, 绘制时不增加任何计算 ('a' 键 / --ao 开启)
+bool aoEnabled = false;
+AoOptions aoOptions;
+std::vector<float> vertexAo;
+SyncedBuffer aoColorVBO;      // RGBA8, 每个顶点 4 字节
+// 点绘制: 三角形的平均投影面积小于 splatArea 像素时, 把顶点画成按局部密度确定大小的圆盘 (见 point_splat.h)
+// 'p' 键循环切换: 自动 / 总是三角形 / 总是点; 填充模式下才会使用
+enum { SPLAT_AUTO, SPLAT_OFF, SPLAT_ON, SPLAT_MODE_COUNT };
+int splatMode = SPLAT_AUTO;
+float splatArea = 1.0f;       // --splat-area <像素>: 自动切换的阈值, 高于阈值的 2 倍时才切换回三角形
+bool splatting = false;       // 上一帧是否使用了点绘制
+SplatOptions splatOptions;
+std::vector<float> splatRadii;
+float triangleArea = 0.0f;    // 三角形的平均面积 (世界空间)
+SyncedBuffer splatRadiusVBO, splatColorVBO;
+GLuint splatProgram = 0;
+float pointScale = 1.0f;      // 视口高度 / (2 tan(fovy / 2)): 世界空间长度 / 深度 -> 像素
+SplatFrameTimer splatTimer;
+GpuTimer gpuTimer;        // 各模式的绘制时间 (计时查询, 不需要 glFinish, 不影响录制的异步回读)
+const int TIMER_TAG_SPLATS = WIRE_MODE_COUNT;   // 计时查询的标签: 线框模式, 或者填充模式下的点绘制
 
 // 交互控制
 float rotateX = 75.0f, rotateY = 0.0f, zoom = -100.0f; // 调整了初始视角
 int lastMouseX, lastMouseY;
-bool isDragging = false, isWireframe = false;
+bool isDragging = false;
+int wireMode = WIRE_OFF; // 'w' 键循环切换: 填充 / glPolygonMode 线框 / 唯一边 / 折痕边 / 轮廓边
 
 // --- 函数声明 ---
-void loadOBJ(const std::string& filename);
+bool loadOBJ(const std::string& filename, ObjModel& target, EdgeTable& edges);
+BufferSyncStats uploadModel();
+void reloadModel(std::chrono::steady_clock::time_point seen);
+void watchTimer(int value);
+void updateAo();
+void buildVertexColors(const std::vector<float>* ao, std::vector<uint8_t>& colors);
+void updateSplats();
+void initSplatProgram();
+float projectedTriangleArea();
+size_t drawSplats();
+void drawSurface();
+size_t drawEdges();
 void init();
 void display();
 void reshape(int w, int h);
@@ -40,89 +92,199 @@ void keyboard(unsigned char key, int x, int y);
 
 
 int main(int argc, char** argv) {
+    TRACE_INIT("banana_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
     glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
+    captureParseArgs(argc, argv); // --capture <前缀>: 录制画面为图像序列
+    bool watch = true;
+    for (int i = 1; i < argc; ++i) { // 第一个非选项参数: .obj 或 .meshc (见 meshc 工具)
+        if (!strcmp(argv[i], "--weld") && i + 1 < argc) weldEpsilon = (float)atof(argv[++i]);
+        else if (!strcmp(argv[i], "--no-watch")) watch = false;
+        else if (!strcmp(argv[i], "--no-cleanup")) cleanupMesh = false;
+        else if (!strcmp(argv[i], "--ao")) aoEnabled = true;
+        else if (!strcmp(argv[i], "--ao-rays") && i + 1 < argc) aoOptions.rays = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--splat-area") && i + 1 < argc) splatArea = (float)atof(argv[++i]);
+        else modelPath = argv[i];
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutInitWindowPosition(200, 200);
     glutCreateWindow("OBJ Banana Viewer");
-    loadOBJ("banana.obj");
+    if (!loadOBJ(modelPath, model, edgeTable)) return 1;
     init();
+    uploadModel();
+    updateAo();
+    updateSplats();
+    if (watch && modelWatcher.watch(modelPath)) {
+        std::cout << "热重载: 正在监视 " << modelPath << " (" << FileWatcher::backend() << ")" << std::endl;
+        glutTimerFunc(WATCH_INTERVAL_MS, watchTimer, 0);
+    }
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
-    glutMouseFunc(mouseButton);
-    glutMotionFunc(mouseMove);
-    glutKeyboardFunc(keyboard);
+    replayInstallInput(mouseButton, mouseMove, keyboard); // 鼠标/键盘回调 (支持录制与回放)
+    replayInstallIdle(NULL);
     glutMainLoop();
     return 0;
 }
 
 /**
- * @brief [高级版] 从 .obj 文件加载数据
- * - 可以解析 "v", "vt", "vn"
- * - 可以解析 "f v/vt/vn" 格式
- * - 可以将四边形面 (Quads) 自动拆分为两个三角形
+ * @brief [材质版] 从 .obj 文件加载数据
+ * - 面支持 "v", "v/vt", "v//vn", "v/vt/vn" 以及任意边数的多边形, 支持负索引
+ * - 解析 mtllib / usemtl, 三角形按材质分组为连续的索引区间
+ * - 文件名以 .meshc 结尾时读取压缩格式, 材质和分组已经在文件中 (见 mesh_codec.h)
+ * - 指定 --weld <epsilon> 时合并重复顶点 (见 mesh_weld.h)
+ * - 删除退化三角形、重复三角形和没有被引用的顶点 (见 mesh_cleanup.h)
+ * - 最后建立边邻接表, 供线框模式使用 (见 mesh_edges.h)
+ * 读取失败时返回 false, target 和 edges 的内容不确定
+ */
+bool loadOBJ(const std::string& filename, ObjModel& target, EdgeTable& edges) {
+    TRACE_FUNCTION();
+    bool compressed = filename.size() > 6 && filename.compare(filename.size() - 6, 6, ".meshc") == 0;
+    if (compressed ? !readMeshc(filename, target) : !readObj(filename, target, BANANA_COLOR)) return false;
+    if (compressed) meshcBuildPositionIndex(target);   // 解码不重建 positionIndex; 线框边表和网格清理按位置建立邻接关系
+    if (weldEpsilon > 0.0f) {
+        WeldOptions opt;
+        opt.epsilon = weldEpsilon;
+        opt.matchNormals = true;   // 保留硬边和纹理接缝
+        opt.matchTexcoords = true;
+        WeldResult r = weldObjModel(target, opt);
+        std::cout << "顶点焊接 (epsilon = " << weldEpsilon << "): " << r.verticesBefore << " -> " << r.verticesAfter
+                  << " 个顶点, " << target.positionCount << " 个不同位置, 耗时 " << r.totalMs << " ms" << std::endl;
+    }
+    if (cleanupMesh) {
+        CleanupResult r = cleanupObjModel(target, CleanupOptions());
+        std::cout << "网格清理: " << r.trianglesBefore << " -> " << r.trianglesAfter << " 个三角面 (退化 " << r.degenerate
+                  << ", 重复 " << r.duplicates << "), " << r.verticesBefore << " -> " << r.verticesAfter << " 个顶点, 耗时 "
+                  << r.totalMs << " ms [退化 " << r.degenerateMs << ", 重复 " << r.duplicateMs << ", 压缩 " << r.compactMs << "]" << std::endl;
+    }
+    size_t triangles = target.indices.size() / 3;
+    buildEdgeTable(edges, target.indices.empty() ? 0 : &target.indices[0], triangles,
+                   target.vertices.empty() ? 0 : &target.vertices[0], OBJ_VERTEX_STRIDE,
+                   target.positionIndex.empty() ? 0 : &target.positionIndex[0]);
+    printEdgeStats(edges, triangles);
+    return true;
+}
+
+/**
+ * @brief 把顶点和索引上传到显存
+ * 第一次调用时创建缓冲并整体上传; 热重载时只上传与显存中内容不同的块
+ */
+BufferSyncStats uploadModel() {
+    TRACE_FUNCTION();
+    if (!modelVBO.id) {
+        modelVBO.create(GL_ARRAY_BUFFER);
+        modelIBO.create(GL_ELEMENT_ARRAY_BUFFER);
+        edgeIBO.create(GL_ELEMENT_ARRAY_BUFFER);
+        creaseIBO.create(GL_ELEMENT_ARRAY_BUFFER);
+        glGenBuffers(1, &silhouetteIBO);
+    }
+    BufferSyncStats s;
+    s.add(modelVBO.upload(model.vertices.empty() ? 0 : &model.vertices[0], model.vertices.size() * sizeof(float)));
+    s.add(modelIBO.upload(model.indices.empty() ? 0 : &model.indices[0], model.indices.size() * sizeof(unsigned)));
+    s.add(edgeIBO.upload(edgeTable.lineIndices.empty() ? 0 : &edgeTable.lineIndices[0], edgeTable.lineIndices.size() * sizeof(unsigned)));
+    s.add(creaseIBO.upload(edgeTable.creaseIndices.empty() ? 0 : &edgeTable.creaseIndices[0], edgeTable.creaseIndices.size() * sizeof(unsigned)));
+    return s;
+}
+
+/**
+ * @brief 重新读取模型文件并增量上传; 读取失败时保留当前模型
+ * 视角 (rotateX / rotateY / zoom) 和显示模式都是独立的全局变量, 不受影响
+ */
+void reloadModel(std::chrono::steady_clock::time_point seen) {
+    TRACE_FUNCTION();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    ObjModel next;
+    EdgeTable nextEdges;
+    if (!loadOBJ(modelPath, next, nextEdges)) {
+        std::cerr << "热重载: 读取 " << modelPath << " 失败, 继续显示原来的模型" << std::endl;
+        return;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::swap(model, next);
+    std::swap(edgeTable, nextEdges);
+    BufferSyncStats s = uploadModel();
+    updateAo();   // 缓存以网格哈希为键, 网格变化后重新烘焙
+    updateSplats();
+    size_t totalBytes = modelVBO.size + modelIBO.size + edgeIBO.size + creaseIBO.size;
+    std::cout << "热重载: 读取 " << loadMs << " ms, 哈希比较 " << s.hashMs << " ms, 上传 " << s.uploadMs << " ms; "
+              << s.dirtyChunks << " / " << s.chunks << " 块变化, 上传 " << s.uploadedBytes / 1024.0 << " / "
+              << totalBytes / 1024.0 << " KB (" << s.ranges << " 次 glBufferSubData"
+              << (s.reallocated ? ", 有缓冲变大而重新分配" : "") << ")" << std::endl;
+    reloadSeen = seen;
+    reloadShown = false;
+    glutPostRedisplay();
+}
+
+/**
+ * @brief 读取或烘焙 AO, 生成逐顶点颜色 = 材质漫反射颜色 x AO
+ * 顶点的材质取引用它的最后一个三角形的材质 (按材质分桶后, 不同材质很少共享同一个 (v, vt, vn) 顶点)
+ */
+void updateAo() {
+    TRACE_FUNCTION();
+    if (!aoEnabled) return;
+    AoStats stats;
+    loadOrBakeAo(modelPath + ".ao", model, aoOptions, vertexAo, stats);
+    std::vector<uint8_t> colors;
+    buildVertexColors(&vertexAo, colors);
+    if (!aoColorVBO.id) aoColorVBO.create(GL_ARRAY_BUFFER);
+    aoColorVBO.upload(colors.empty() ? 0 : &colors[0], colors.size());
+}
+
+/**
+ * @brief 逐顶点 RGBA8 颜色 = 材质漫反射颜色 (x AO, ao 不为空时)
  */
-void loadOBJ(const std::string& filename) {
-    std::ifstream file(filename.c_str());
-    if (!file) { std::cerr << "错误: 无法打开文件 " << filename << std::endl; exit(1); }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-
-        if (prefix == "v") {
-            Vec3 vertex;
-            ss >> vertex.x >> vertex.y >> vertex.z;
-            vertices.push_back(vertex);
-        } else if (prefix == "vt") {
-            Vec2 texcoord;
-            ss >> texcoord.u >> texcoord.v;
-            texcoords.push_back(texcoord);
-        } else if (prefix == "vn") {
-            Vec3 normal;
-            ss >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        } else if (prefix == "f") {
-            int v[4], vt[4], vn[4];
-            int count = sscanf(line.c_str(), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d", 
-                   &v[0], &vt[0], &vn[0], &v[1], &vt[1], &vn[1], 
-                   &v[2], &vt[2], &vn[2], &v[3], &vt[3], &vn[3]);
-
-            // 根据sscanf成功匹配的参数数量来判断是三角形还是四边形
-            int num_verts = count / 3;
-
-            // 第一个三角形 (对三角形和四边形都适用)
-            Face face1;
-            for(int i = 0; i < 3; ++i) {
-                face1.v_indices[i] = v[i] - 1;
-                face1.vt_indices[i] = vt[i] - 1;
-                face1.vn_indices[i] = vn[i] - 1;
-            }
-            faces.push_back(face1);
-
-            // 如果是四边形, 创建第二个三角形
-            if (num_verts == 4) {
-                Face face2;
-                int indices[] = {0, 2, 3}; // (v0, v2, v3) 构成第二个三角形
-                for(int i = 0; i < 3; ++i) {
-                    face2.v_indices[i] = v[indices[i]] - 1;
-                    face2.vt_indices[i] = vt[indices[i]] - 1;
-                    face2.vn_indices[i] = vn[indices[i]] - 1;
-                }
-                faces.push_back(face2);
-            }
+void buildVertexColors(const std::vector<float>* ao, std::vector<uint8_t>& colors) {
+    TRACE_FUNCTION();
+    colors.assign(model.vertexCount() * 4, 255);
+    for (size_t i = 0; i < model.ranges.size(); ++i) {
+        const ObjRange& range = model.ranges[i];
+        const ObjMaterial& mat = model.materials[range.material];
+        for (unsigned k = range.firstIndex; k < range.firstIndex + range.indexCount; ++k) {
+            unsigned v = model.indices[k];
+            float shade = ao ? (*ao)[v] : 1.0f;
+            for (int c = 0; c < 3; ++c) colors[v * 4 + c] = (uint8_t)(std::min(1.0f, mat.diffuse[c] * shade) * 255.0f + 0.5f);
+            colors[v * 4 + 3] = (uint8_t)(std::min(1.0f, mat.opacity) * 255.0f + 0.5f);
         }
     }
-    std::cout << "Banana模型加载成功: " << vertices.size() << " 个顶点, " << texcoords.size() << " 个纹理坐标, " << normals.size() << " 个法线, " << faces.size() << " 个三角面." << std::endl;
 }
 
 /**
- * @brief [高级版] 核心渲染函数
- * 现在会传递纹理坐标
+ * @brief 计算点绘制的半径 (并行 k 近邻) 和三角形平均面积, 上传半径和材质颜色
+ */
+void updateSplats() {
+    TRACE_FUNCTION();
+    SplatStats stats;
+    computeSplatRadii(model, splatOptions, splatRadii, stats);
+    triangleArea = meanTriangleArea(model);
+    std::vector<uint8_t> colors;
+    buildVertexColors(0, colors);
+    if (!splatRadiusVBO.id) {
+        splatRadiusVBO.create(GL_ARRAY_BUFFER);
+        splatColorVBO.create(GL_ARRAY_BUFFER);
+    }
+    splatRadiusVBO.upload(splatRadii.empty() ? 0 : &splatRadii[0], splatRadii.size() * sizeof(float));
+    splatColorVBO.upload(colors.empty() ? 0 : &colors[0], colors.size());
+    std::cout << "点绘制半径: " << stats.points << " 个点, " << stats.cells << " 个格子 (边长 " << stats.cellSize
+              << "), k = " << splatOptions.neighbors << ", 平均半径 " << stats.meanRadius << "; 建网格 " << stats.gridMs
+              << " ms, 近邻查找 " << stats.knnMs << " ms (" << jobSystem().threadCount() << " 线程)" << std::endl;
+}
+
+/**
+ * @brief 定时检查模型文件是否被修改 (文件稳定之后才报告, 见 file_watch.h)
+ */
+void watchTimer(int value) {
+    std::vector<FileChange> changes;
+    if (modelWatcher.poll(changes)) reloadModel(changes.back().firstSeen);
+    glutTimerFunc(WATCH_INTERVAL_MS, watchTimer, value);
+}
+
+/**
+ * @brief [材质版] 核心渲染函数
+ * 填充/glPolygonMode 线框走按材质分批的三角形路径, 其余线框模式只画边
  */
 void display() {
+    TRACE_FUNCTION();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
@@ -130,31 +292,186 @@ void display() {
     glRotatef(rotateX, 1.0f, 0.0f, 0.0f);
     glRotatef(rotateY, 0.0f, 1.0f, 0.0f);
 
-    glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
-    
-    glColor3f(1.0f, 1.0f, 0.3f); // 给香蕉一个黄色
-    
-    glBegin(GL_TRIANGLES);
-    for (size_t i = 0; i < faces.size(); ++i) {
-        const Face& face = faces[i];
-        for (int j = 0; j < 3; ++j) {
-            const Vec3& normal = normals[face.vn_indices[j]];
-            glNormal3f(normal.x, normal.y, normal.z);
-            
-            const Vec2& texcoord = texcoords[face.vt_indices[j]];
-            glTexCoord2f(texcoord.u, texcoord.v);
-            
-            const Vec3& vertex = vertices[face.v_indices[j]];
-            glVertex3f(vertex.x, vertex.y, vertex.z);
-        }
+    // 填充模式下按三角形的平均投影面积选择三角形或点绘制 (带滞后, 避免在阈值附近来回切换)
+    float area = projectedTriangleArea();
+    if (splatMode == SPLAT_AUTO) splatting = splatting ? area < splatArea * 2.0f : area < splatArea;
+    else splatting = splatMode == SPLAT_ON;
+    bool fill = wireMode == WIRE_OFF;
+
+    size_t lineCount = model.indices.size();  // glPolygonMode 线框: 每个三角形三条边
+    size_t points = 0;
+    int timerTag = fill && splatting ? TIMER_TAG_SPLATS : wireMode;
+    gpuTimer.begin(timerTag);
+    if (wireMode >= WIRE_EDGES) lineCount = drawEdges();
+    else if (fill && splatting) points = drawSplats();
+    else drawSurface();
+    size_t primitives = timerTag == TIMER_TAG_SPLATS ? points : timerTag == WIRE_OFF ? model.indices.size() / 3 : lineCount;
+    gpuTimer.end(primitives, area);
+
+    // 支持计时查询时结果晚几帧到达: 模式、图元数和投影面积都用查询发出时记录的值; 否则只有本帧的 CPU 提交时间
+    auto record = [](const GpuTimerSample& s) {
+        if (s.tag == TIMER_TAG_SPLATS) splatTimer.add(true, s.ms, s.count, s.value);
+        else if (s.tag == WIRE_OFF) splatTimer.add(false, s.ms, s.count, s.value);
+        else wireTimer.add(s.tag, s.ms, s.count);
+    };
+    if (!gpuTimer.supported()) {
+        GpuTimerSample cpu = { std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(),
+                               timerTag, primitives, area };
+        record(cpu);
     }
-    glEnd();
-    
+    GpuTimerSample sample;
+    while (gpuTimer.poll(sample)) record(sample);
+
+    captureFrame();
     glutSwapBuffers();
+    replayFrameDone();
+    if (!reloadShown) {
+        // 包括等待文件写完的去抖动时间
+        reloadShown = true;
+        std::cout << "热重载: 从察觉文件变化到画面更新 "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - reloadSeen).count() << " ms" << std::endl;
+    }
+}
+
+/**
+ * @brief 按材质画三角形 (填充或 glPolygonMode 线框)
+ * 每种材质只切换一次状态, 再用一次 glDrawElements 画完它的连续索引区间
+ */
+void drawSurface() {
+    TRACE_FUNCTION();
+    glPolygonMode(GL_FRONT_AND_BACK, wireMode == WIRE_POLYGON_LINE ? GL_LINE : GL_FILL);
+
+    const GLsizei stride = OBJ_VERTEX_STRIDE * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, modelVBO.id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, modelIBO.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, (void*)0);
+    glNormalPointer(GL_FLOAT, stride, (void*)(3 * sizeof(float)));
+    glTexCoordPointer(2, GL_FLOAT, stride, (void*)(6 * sizeof(float)));
+    if (aoEnabled) {
+        // 颜色数组 (材质颜色 x AO) 代替每个材质的 glColor
+        glBindBuffer(GL_ARRAY_BUFFER, aoColorVBO.id);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glColorPointer(4, GL_UNSIGNED_BYTE, 0, (void*)0);
+    }
+
+    for (size_t i = 0; i < model.ranges.size(); ++i) {
+        const ObjRange& range = model.ranges[i];
+        const ObjMaterial& mat = model.materials[range.material];
+        // GL_COLOR_MATERIAL 开启时, 环境光和漫反射颜色来自 glColor
+        if (!aoEnabled) glColor4f(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], mat.opacity);
+        GLfloat specular[] = { mat.specular[0], mat.specular[1], mat.specular[2], 1.0f };
+        glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular);
+        glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, mat.shininess > 128.0f ? 128.0f : mat.shininess);
+        glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.firstIndex * sizeof(unsigned)));
+    }
+
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief 三角形的平均投影面积 (像素), 按模型包围盒中心到视点的距离估计
+ * 随机朝向的三角形投影面积平均为实际面积的一半
+ */
+float projectedTriangleArea() {
+    GLfloat mv[16];
+    glGetFloatv(GL_MODELVIEW_MATRIX, mv);
+    Vec3 c = aabbCenter(model.bounds);
+    Vec3 eye = vec3(mv[0] * c.x + mv[4] * c.y + mv[8] * c.z + mv[12],
+                    mv[1] * c.x + mv[5] * c.y + mv[9] * c.z + mv[13],
+                    mv[2] * c.x + mv[6] * c.y + mv[10] * c.z + mv[14]);
+    float distance = length(eye);
+    if (distance <= 0.0f) return 1e30f;
+    float pixelsPerUnit = pointScale / distance;
+    return 0.5f * triangleArea * pixelsPerUnit * pixelsPerUnit;
+}
+
+/**
+ * @brief 把所有顶点画成屏幕对齐的圆盘, 返回点数
+ * 点的大小 = 2 x 世界空间半径 x pointScale / 深度, 在顶点着色器中计算 (GLSL 120, 固定管线的变换和光源状态)
+ */
+size_t drawSplats() {
+    TRACE_FUNCTION();
+    if (!splatProgram || model.vertices.empty()) return 0;
+    glUseProgram(splatProgram);
+    glUniform1f(glGetUniformLocation(splatProgram, "pointScale"), pointScale);
+    glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    glEnable(GL_POINT_SPRITE);
+
+    const GLsizei stride = OBJ_VERTEX_STRIDE * sizeof(float);
+    glBindBuffer(GL_ARRAY_BUFFER, modelVBO.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, (void*)0);
+    glNormalPointer(GL_FLOAT, stride, (void*)(3 * sizeof(float)));
+    glBindBuffer(GL_ARRAY_BUFFER, aoEnabled ? aoColorVBO.id : splatColorVBO.id);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, (void*)0);
+    glBindBuffer(GL_ARRAY_BUFFER, splatRadiusVBO.id);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+
+    GLsizei count = (GLsizei)model.vertexCount();
+    glDrawArrays(GL_POINTS, 0, count);
+
+    glDisableVertexAttribArray(1);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glDisable(GL_POINT_SPRITE);
+    glDisable(GL_VERTEX_PROGRAM_POINT_SIZE);
+    glUseProgram(0);
+    return count;
+}
+
+/**
+ * @brief 用 GL_LINES 画唯一边 / 折痕边 / 轮廓边, 返回画出的线段数
+ * 只需要位置属性; 轮廓边依赖视点, 每帧在 CPU 上筛选后以 GL_STREAM_DRAW 上传
+ */
+size_t drawEdges() {
+    TRACE_FUNCTION();
+    GLuint ibo = edgeIBO.id;
+    size_t count = edgeTable.lineIndices.size();
+    if (wireMode == WIRE_CREASES) {
+        ibo = creaseIBO.id;
+        count = edgeTable.creaseIndices.size();
+    } else if (wireMode == WIRE_SILHOUETTE) {
+        GLfloat modelView[16];
+        float eye[3];
+        glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+        eyeFromModelView(modelView, eye);
+        silhouetteEdges(edgeTable, eye, silhouetteIndices);
+        ibo = silhouetteIBO;
+        count = silhouetteIndices.size();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned), count ? &silhouetteIndices[0] : 0, GL_STREAM_DRAW);
+    }
+
+    glDisable(GL_LIGHTING);
+    glColor3f(1.0f, 1.0f, 0.3f);
+    glBindBuffer(GL_ARRAY_BUFFER, modelVBO.id);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, OBJ_VERTEX_STRIDE * sizeof(float), (void*)0);
+    glDrawElements(GL_LINES, (GLsizei)count, GL_UNSIGNED_INT, 0);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glEnable(GL_LIGHTING);
+    return count / 2;
 }
 
 // --- 其他函数 (与之前相同) ---
 void init() {
+    TRACE_FUNCTION();
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_NORMALIZE);
@@ -170,18 +487,90 @@ void init() {
     glLightfv(GL_LIGHT0, GL_SPECULAR, white_light);
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    initSplatProgram();
+    gpuTimer.init();
+    if (!gpuTimer.supported()) std::cout << "不支持 GL_EXT_timer_query, 各模式只统计 CPU 提交时间" << std::endl;
+}
+
+// 点绘制着色器: 光照只算 0 号光源的漫反射 (两面) 和全局环境光, 与填充模式的颜色接近
+const char* splatVertexShaderSource = R"glsl(
+#version 120
+attribute float aRadius;
+uniform float pointScale;
+varying vec4 color;
+
+void main()
+{
+    vec4 eye = gl_ModelViewMatrix * gl_Vertex;
+    vec3 n = normalize(gl_NormalMatrix * gl_Normal);
+    vec3 l = normalize(gl_LightSource[0].position.xyz - eye.xyz);
+    float diffuse = abs(dot(n, l));
+    color = vec4(gl_Color.rgb * (gl_LightModel.ambient.rgb + diffuse * gl_LightSource[0].diffuse.rgb), gl_Color.a);
+    gl_Position = gl_ProjectionMatrix * eye;
+    gl_PointSize = max(1.0, 2.0 * aRadius * pointScale / -eye.z);
+}
+)glsl";
+
+const char* splatFragmentShaderSource = R"glsl(
+#version 120
+varying vec4 color;
+
+void main()
+{
+    // 方形的点精灵裁成圆盘
+    vec2 p = gl_PointCoord * 2.0 - 1.0;
+    if (dot(p, p) > 1.0) discard;
+    gl_FragColor = color;
+}
+)glsl";
+
+/**
+ * @brief 编译点绘制着色器, 出错时打印日志并关闭点绘制
+ */
+void initSplatProgram() {
+    TRACE_FUNCTION();
+    GLint ok = 0;
+    char log[1024];
+    GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vs, 1, &splatVertexShaderSource, NULL);
+    glCompileShader(vs);
+    glGetShaderiv(vs, GL_COMPILE_STATUS, &ok);
+    if (!ok) { glGetShaderInfoLog(vs, sizeof(log), NULL, log); std::cerr << "点绘制顶点着色器编译失败:\n" << log << std::endl; }
+    GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fs, 1, &splatFragmentShaderSource, NULL);
+    glCompileShader(fs);
+    glGetShaderiv(fs, GL_COMPILE_STATUS, &ok);
+    if (!ok) { glGetShaderInfoLog(fs, sizeof(log), NULL, log); std::cerr << "点绘制片元着色器编译失败:\n" << log << std::endl; }
+
+    splatProgram = glCreateProgram();
+    glAttachShader(splatProgram, vs);
+    glAttachShader(splatProgram, fs);
+    glBindAttribLocation(splatProgram, 1, "aRadius");   // 0 号属性与 gl_Vertex 共用
+    glLinkProgram(splatProgram);
+    glGetProgramiv(splatProgram, GL_LINK_STATUS, &ok);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    if (!ok) {
+        glGetProgramInfoLog(splatProgram, sizeof(log), NULL, log);
+        std::cerr << "点绘制着色器链接失败, 点绘制不可用:\n" << log << std::endl;
+        glDeleteProgram(splatProgram);
+        splatProgram = 0;
+    }
 }
 
 void reshape(int w, int h) {
+    TRACE_FUNCTION();
     if (h == 0) h = 1;
     glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluPerspective(45.0f, (float)w / h, 0.1f, 500.0f); // 调整了远裁剪面
+    pointScale = h / (2.0f * std::tan(22.5f * 3.14159265f / 180.0f));
     glMatrixMode(GL_MODELVIEW);
 }
 
 void mouseButton(int button, int state, int x, int y) {
+    TRACE_FUNCTION();
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) { isDragging = true; lastMouseX = x; lastMouseY = y; }
         else { isDragging = false; }
@@ -189,6 +578,7 @@ void mouseButton(int button, int state, int x, int y) {
 }
 
 void mouseMove(int x, int y) {
+    TRACE_FUNCTION();
     if (isDragging) {
         rotateY += (x - lastMouseX) * 0.5f;
         rotateX += (y - lastMouseY) * 0.5f;
@@ -198,8 +588,31 @@ void mouseMove(int x, int y) {
 }
 
 void keyboard(unsigned char key, int x, int y) {
+    TRACE_FUNCTION();
     switch (key) {
         case 27: case 'q': exit(0); break;
-        case 'w': isWireframe = !isWireframe; glutPostRedisplay(); break;
+        case 'w':
+            wireMode = (wireMode + 1) % WIRE_MODE_COUNT;
+            std::cout << "显示模式切换: " << wireModeName(wireMode) << std::endl;
+            glutPostRedisplay();
+            break;
+        case 'a': // 开关环境光遮蔽 (第一次开启时读取缓存或烘焙)
+            aoEnabled = !aoEnabled;
+            updateAo();
+            std::cout << "环境光遮蔽: " << (aoEnabled ? "开启" : "关闭") << std::endl;
+            glutPostRedisplay();
+            break;
+        case 'p': // 点绘制: 自动 / 总是三角形 / 总是点
+            splatMode = (splatMode + 1) % SPLAT_MODE_COUNT;
+            std::cout << "点绘制: " << (splatMode == SPLAT_AUTO ? "自动" : splatMode == SPLAT_OFF ? "关闭" : "开启") << std::endl;
+            glutPostRedisplay();
+            break;
+        case 'r': // 手动重新读取模型 (例如只修改了 .mtl 文件时)
+            reloadModel(std::chrono::steady_clock::now());
+            break;
+        case 'c': // 开始/停止录制 (只有重绘的帧才会被录制)
+            captureToggle();
+            glutPostRedisplay();
+            break;
     }
 }
\ No newline at end of file
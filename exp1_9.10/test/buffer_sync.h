@@ -0,0 +1,106 @@
+#ifndef BUFFER_SYNC_H
+#define BUFFER_SYNC_H
+
+// 按块哈希增量更新的顶点 / 索引缓冲, 用于热重载
+//
+//   SyncedBuffer vbo;
+//   vbo.create(GL_ARRAY_BUFFER);
+//   vbo.upload(data, bytes);                   // 第一次: glBufferData 整体上传, 记录每块的哈希
+//   BufferSyncStats s = vbo.upload(data2, bytes2);   // 之后: 只上传哈希变化的块
+//
+// - 缓冲按 chunkBytes (默认 64 KB) 切块, 每块一个 64 位哈希; 各块的哈希在 parallelFor 中并行计算
+// - 哈希不同的相邻块合并为一段, 每段一次 glBufferSubData
+// - 新数据超过已分配的大小时重新 glBufferData; 变小时保留原来的存储, 只更新前面的部分
+// - 只在原位修改 (移动顶点、修改法线 / 纹理坐标、改变材质颜色) 时节省上传量;
+//   插入或删除顶点会使之后的所有块错位, 退化为接近整体上传
+
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "chunk_hash.h"
+#include "trace.h"
+
+struct BufferSyncStats {
+    size_t chunks, dirtyChunks;     // 新数据的块数, 其中需要上传的块数
+    size_t ranges;                  // glBufferSubData 调用次数
+    size_t uploadedBytes;
+    bool reallocated;               // 整体 glBufferData
+    double hashMs, uploadMs;
+
+    BufferSyncStats() : chunks(0), dirtyChunks(0), ranges(0), uploadedBytes(0), reallocated(false), hashMs(0.0), uploadMs(0.0) {}
+    void add(const BufferSyncStats& o) {
+        chunks += o.chunks;
+        dirtyChunks += o.dirtyChunks;
+        ranges += o.ranges;
+        uploadedBytes += o.uploadedBytes;
+        reallocated = reallocated || o.reallocated;
+        hashMs += o.hashMs;
+        uploadMs += o.uploadMs;
+    }
+};
+
+class SyncedBuffer {
+public:
+    GLuint id;
+    size_t size;            // 当前有效数据的字节数
+    size_t chunkBytes;
+
+    SyncedBuffer() : id(0), size(0), chunkBytes(64 * 1024), target_(GL_ARRAY_BUFFER), capacity_(0) {}
+
+    void create(GLenum target) {
+        target_ = target;
+        glGenBuffers(1, &id);
+    }
+
+    /**
+     * @brief 上传 bytes 字节; 已经上传过时只更新内容变化的块
+     */
+    BufferSyncStats upload(const void* data, size_t bytes) {
+        TRACE_FUNCTION();
+        BufferSyncStats s;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::vector<uint64_t> hashes;
+        hashChunks(data, bytes, chunkBytes, hashes);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        s.hashMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        s.chunks = hashes.size();
+
+        glBindBuffer(target_, id);
+        if (bytes > capacity_ || capacity_ == 0) {
+            glBufferData(target_, bytes, data, GL_STATIC_DRAW);
+            capacity_ = bytes;
+            s.reallocated = true;
+            s.dirtyChunks = s.chunks;
+            s.uploadedBytes = bytes;
+        } else {
+            const uint8_t* p = (const uint8_t*)data;
+            for (size_t c = 0; c < hashes.size();) {
+                if (c < hashes_.size() && hashes_[c] == hashes[c]) { ++c; continue; }
+                size_t first = c;
+                while (c < hashes.size() && (c >= hashes_.size() || hashes_[c] != hashes[c])) ++c;
+                size_t offset = first * chunkBytes, length = std::min(bytes, c * chunkBytes) - offset;
+                glBufferSubData(target_, offset, length, p + offset);
+                s.dirtyChunks += c - first;
+                s.uploadedBytes += length;
+                ++s.ranges;
+            }
+        }
+        glBindBuffer(target_, 0);
+        hashes_.swap(hashes);
+        size = bytes;
+        s.uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+        return s;
+    }
+
+private:
+    GLenum target_;
+    size_t capacity_;                 // 显存中已分配的字节数
+    std::vector<uint64_t> hashes_;    // 显存中每块内容的哈希
+};
+
+#endif
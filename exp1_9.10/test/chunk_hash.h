@@ -0,0 +1,50 @@
+#ifndef CHUNK_HASH_H
+#define CHUNK_HASH_H
+
+// 64 位数据哈希, 用于判断缓冲内容是否变化 (buffer_sync.h) 和缓存文件是否过期 (ao_bake.h)
+// 不是密码学哈希, 只用于检测内容变化
+
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "parallel_for.h"
+#include "trace.h"
+
+/**
+ * @brief 一块数据的 64 位哈希 (每次 8 字节的乘法-异或混合, 长度也参与混合)
+ */
+inline uint64_t hashChunk(const uint8_t* data, size_t bytes) {
+    const uint64_t k = 0x9E3779B97F4A7C15ull;
+    uint64_t h = bytes * k;
+    size_t i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        uint64_t w;
+        memcpy(&w, data + i, 8);
+        h = (h ^ (w * k)) * 0xBF58476D1CE4E5B9ull;
+        h ^= h >> 31;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, bytes - i);
+    h = (h ^ (tail * k)) * 0x94D049BB133111EBull;
+    return h ^ (h >> 29);
+}
+
+/**
+ * @brief 计算每块的哈希, 结果写入 out (块数 = ceil(bytes / chunkBytes))
+ */
+inline void hashChunks(const void* data, size_t bytes, size_t chunkBytes, std::vector<uint64_t>& out) {
+    TRACE_FUNCTION();
+    size_t chunks = (bytes + chunkBytes - 1) / chunkBytes;
+    out.resize(chunks);
+    const uint8_t* p = (const uint8_t*)data;
+    parallelFor(chunks, 0, [&](size_t begin, size_t end, int) {
+        for (size_t c = begin; c < end; ++c) {
+            size_t offset = c * chunkBytes;
+            out[c] = hashChunk(p + offset, std::min(chunkBytes, bytes - offset));
+        }
+    });
+}
+
+#endif
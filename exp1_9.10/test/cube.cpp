@@ -1,12 +1,19 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <chrono>
 
 #include <GLUT/glut.h>
 #include <OpenGL/gl.h>
 
+#include "input_replay.h"
+#include "obj_blocks.h"
+#include "parallel_for.h"
+#include "mesh_edges.h"
+#include "halfedge.h"
+#include "gpu_timer.h"
+#include "trace.h"
+
 // --- 数据结构 ---
 struct Vec3 { float x, y, z; };
 
@@ -21,10 +28,25 @@ std::vector<Vec3> vertices; // 存储顶点
 std::vector<Vec3> normals;  // 存储法线
 std::vector<Face> faces;    // 存储面
 
+// 线框模式使用的边邻接表 (加载后建立一次)
+std::vector<unsigned> triangleIndices;
+EdgeTable edgeTable;
+std::vector<unsigned> silhouetteIndices;
+WireFrameTimer wireTimer;
+GpuTimer gpuTimer;        // 各模式的绘制时间 (计时查询, 不需要 glFinish)
+
+// 细分曲面 ('+' / '-' 键切换级别, 0 = 原始网格); 共面的三角形先合并回四边形, 再做 Catmull-Clark
+SubdivisionLevels subdivision;
+int subdivLevel = 0;
+std::vector<unsigned> subdivTriangles;
+std::vector<float> subdivNormals;
+const float* edgePositions = 0;
+
 // 交互控制 (与之前相同)
 float rotateX = 20.0f, rotateY = -30.0f, zoom = -5.0f;
 int lastMouseX, lastMouseY;
-bool isDragging = false, isWireframe = false;
+bool isDragging = false;
+int wireMode = WIRE_OFF; // 'w' 键循环切换: 填充 / 线框 / 唯一边 / 折痕边 / 轮廓边
 
 // --- 函数声明 ---
 void loadOBJ(const std::string& filename);
@@ -34,10 +56,14 @@ void reshape(int w, int h);
 void mouseButton(int button, int state, int x, int y);
 void mouseMove(int x, int y);
 void keyboard(unsigned char key, int x, int y);
+size_t drawEdges();
+void setSubdivisionLevel(int level);
 
 
 int main(int argc, char** argv) {
+    TRACE_INIT("cube_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
     glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutInitWindowPosition(150, 150);
@@ -46,9 +72,8 @@ int main(int argc, char** argv) {
     init();
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
-    glutMouseFunc(mouseButton);
-    glutMotionFunc(mouseMove);
-    glutKeyboardFunc(keyboard);
+    replayInstallInput(mouseButton, mouseMove, keyboard); // 鼠标/键盘回调 (支持录制与回放)
+    replayInstallIdle(NULL);
     glutMainLoop();
     return 0;
 }
@@ -56,45 +81,109 @@ int main(int argc, char** argv) {
 /**
  * @brief [升级版] 从 .obj 文件加载顶点、法线和面信息
  * 现在可以解析 "f v//vn" 格式
+ * 整个文件读入临时 arena, 按行切块后在任务调度器上先计数再并行解析 (obj_blocks.h),
+ * 每个面的三角形起始编号由前缀和确定, 扇形三角化也按面并行; 结果与逐行顺序解析相同
  */
 void loadOBJ(const std::string& filename) {
-    std::ifstream file(filename.c_str());
-    if (!file) { std::cerr << "错误: 无法打开文件 " << filename << std::endl; exit(1); }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-
-        if (prefix == "v") { // 顶点
-            Vec3 vertex;
-            ss >> vertex.x >> vertex.y >> vertex.z;
-            vertices.push_back(vertex);
-        } else if (prefix == "vn") { // 法线
-            Vec3 normal;
-            ss >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-        } else if (prefix == "f") { // 面
-            Face face;
-            // 使用 sscanf 来轻松解析 "v//vn" 格式
-            // C++的字符串流处理这种格式比较麻烦, sscanf 更直接
-            char buffer[128];
-            ss.read(buffer, sizeof(buffer)); // 读取剩余行内容
-            sscanf(buffer, "%d//%d %d//%d %d//%d", 
-                   &face.v_indices[0], &face.vn_indices[0],
-                   &face.v_indices[1], &face.vn_indices[1],
-                   &face.v_indices[2], &face.vn_indices[2]);
-
-            // OBJ 索引从1开始, C++数组从0开始, 所以要减1
-            for (int i = 0; i < 3; ++i) {
-                face.v_indices[i]--;
-                face.vn_indices[i]--;
+    TRACE_FUNCTION();
+    MeshArena textArena;
+    const char* text = readFileText(filename, textArena);
+    if (!text) exit(1);
+    std::vector<ObjTextBlock> blocks;
+    ObjTextBlock total = countObjBlocks(text, blocks);
+    if (total.normals == 0) { std::cerr << "错误: " << filename << " 中没有法线 (vn)" << std::endl; exit(1); }
+
+    // 临时数组一次性放进 scratch, 用完整块释放
+    MeshArena scratch;
+    if (!scratch.reserve(MeshArena::footprint<float>(total.texcoords * 2) + MeshArena::footprint<ObjCornerKey>(total.corners)
+                         + MeshArena::footprint<size_t>(total.faces + 1) * 2 + MeshArena::footprint<unsigned>(total.faces)))
+        exit(1);
+    float* texcoords = scratch.alloc<float>(total.texcoords * 2);
+    ObjCornerKey* corners = scratch.alloc<ObjCornerKey>(total.corners);
+    size_t* faceCorner = scratch.alloc<size_t>(total.faces + 1);
+    size_t* faceTriangle = scratch.alloc<size_t>(total.faces + 1);
+    unsigned* faceValid = scratch.alloc<unsigned>(total.faces);
+    vertices.resize(total.positions);
+    normals.resize(total.normals);
+
+    size_t blockCount = blocks.size();
+    std::vector<std::vector<ObjDirective> > directives(blockCount); // 立方体不用材质, 状态行忽略
+    parallelFor(blockCount, (int)blockCount, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i)
+            parseObjBlock(blocks[i], vertices.empty() ? 0 : &vertices[0].x, texcoords, &normals[0].x,
+                          corners, faceCorner, faceValid, directives[i]);
+    });
+    faceCorner[total.faces] = total.corners;
+    faceTriangle[0] = 0;
+    for (size_t f = 0; f < total.faces; ++f)
+        faceTriangle[f + 1] = faceTriangle[f] + (faceValid[f] >= 3 ? faceValid[f] - 2 : 0);
+    faces.resize(faceTriangle[total.faces]);
+    triangleIndices.resize(faces.size() * 3);
+
+    // 多于三个角的面按扇形拆成三角形; 越界的顶点已标记为 -1 跳过, 缺失或越界的法线用 0 号法线
+    parallelFor(total.faces, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            size_t t = faceTriangle[f], n = 0;
+            int first[2] = { 0, 0 }, prev[2] = { 0, 0 };
+            for (size_t c = faceCorner[f]; c < faceCorner[f + 1]; ++c) {
+                int cv = corners[c].v, cvn = corners[c].vn < 0 ? 0 : corners[c].vn;
+                if (cv < 0) continue;
+                if (n >= 2) {
+                    Face& face = faces[t];
+                    face.v_indices[0] = first[0]; face.vn_indices[0] = first[1];
+                    face.v_indices[1] = prev[0];  face.vn_indices[1] = prev[1];
+                    face.v_indices[2] = cv;       face.vn_indices[2] = cvn;
+                    for (int j = 0; j < 3; ++j) triangleIndices[t * 3 + j] = face.v_indices[j];
+                    ++t;
+                }
+                if (n == 0) { first[0] = cv; first[1] = cvn; }
+                prev[0] = cv; prev[1] = cvn;
+                ++n;
             }
-            faces.push_back(face);
         }
+    });
+    size_t residentBytes = vertices.size() * sizeof(Vec3) + normals.size() * sizeof(Vec3)
+                         + faces.size() * sizeof(Face) + triangleIndices.size() * sizeof(unsigned);
+    size_t peakBytes = residentBytes + textArena.bytesReserved() + scratch.bytesReserved();
+    scratch.release();
+    textArena.release();
+
+    std::cout << "Cube模型加载成功: " << vertices.size() << " 个顶点, " << normals.size() << " 个法线, " << faces.size()
+              << " 个面, 常驻 " << residentBytes / 1024.0 << " KB, 峰值 " << peakBytes / 1024.0 << " KB." << std::endl;
+
+    if (!faces.empty()) buildEdgeTable(edgeTable, &triangleIndices[0], faces.size(), &vertices[0].x, 3, 0);
+    printEdgeStats(edgeTable, faces.size());
+    edgePositions = vertices.empty() ? 0 : &vertices[0].x;
+
+    // 每个侧面由两个三角形组成, 合并成四边形后 Catmull-Clark 才能得到对称的结果
+    if (faces.empty()) return;
+    std::vector<unsigned> faceStart, faceVerts;
+    mergeCoplanarTriangles(&vertices[0].x, &triangleIndices[0], faces.size(), faceStart, faceVerts);
+    HalfEdgeMesh base;
+    buildHalfEdgeMesh(base, &vertices[0].x, vertices.size(), &faceStart[0], faceStart.size() - 1, &faceVerts[0]);
+    subdivision.reset(base);
+    std::cout << "半边网格: " << base.faceCount() << " 个面, " << base.edgeCount << " 条边." << std::endl;
+}
+
+/**
+ * @brief 切换细分级别 (与 pyramid.cpp 相同): 三角化、求平滑法线、重建边邻接表
+ */
+void setSubdivisionLevel(int level) {
+    TRACE_FUNCTION();
+    if (subdivision.meshes.empty()) return;
+    subdivLevel = std::max(0, std::min(level, SUBDIVISION_MAX_LEVEL));
+    if (subdivLevel == 0) {
+        edgePositions = &vertices[0].x;
+        buildEdgeTable(edgeTable, &triangleIndices[0], faces.size(), edgePositions, 3, 0);
+    } else {
+        const HalfEdgeMesh& mesh = subdivision.level(subdivLevel);
+        halfEdgeTriangles(mesh, subdivTriangles);
+        halfEdgeVertexNormals(mesh, subdivNormals);
+        edgePositions = &mesh.positions[0];
+        buildEdgeTable(edgeTable, &subdivTriangles[0], subdivTriangles.size() / 3, edgePositions, 3, 0);
     }
-    std::cout << "Cube模型加载成功: " << vertices.size() << " 个顶点, " << normals.size() << " 个法线, " << faces.size() << " 个面." << std::endl;
+    std::cout << "细分级别: " << subdivLevel << " (" << subdivision.schemeName() << ", "
+              << (subdivLevel == 0 ? faces.size() : subdivTriangles.size() / 3) << " 个三角形)" << std::endl;
 }
 
 
@@ -103,6 +192,7 @@ void loadOBJ(const std::string& filename) {
  * 现在使用从OBJ文件加载的法线, 实现更平滑的光照
  */
 void display() {
+    TRACE_FUNCTION();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
@@ -110,31 +200,81 @@ void display() {
     glRotatef(rotateX, 1.0f, 0.0f, 0.0f);
     glRotatef(rotateY, 0.0f, 1.0f, 0.0f);
 
-    glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
-    
-    glColor3f(1.0f, 0.5f, 0.2f); // 给立方体一个橙色
-    
-    // 遍历所有面并绘制
-    glBegin(GL_TRIANGLES);
-    for (size_t i = 0; i < faces.size(); ++i) {
-        const Face& face = faces[i];
-        for (int j = 0; j < 3; ++j) {
-            // 在绘制每个顶点前, 先指定它的法线
-            const Vec3& normal = normals[face.vn_indices[j]];
-            glNormal3f(normal.x, normal.y, normal.z);
-            
-            const Vec3& vertex = vertices[face.v_indices[j]];
-            glVertex3f(vertex.x, vertex.y, vertex.z);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    gpuTimer.begin(wireMode);
+    size_t lineCount = (subdivLevel > 0 ? subdivTriangles.size() / 3 : faces.size()) * 3;
+    if (wireMode >= WIRE_EDGES) {
+        lineCount = drawEdges(); // 只画边
+    } else if (subdivLevel > 0) {
+        // 细分后的网格没有文件中的法线, 使用半边网格求出的平滑法线
+        glPolygonMode(GL_FRONT_AND_BACK, wireMode == WIRE_POLYGON_LINE ? GL_LINE : GL_FILL);
+        glColor3f(1.0f, 0.5f, 0.2f);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, edgePositions);
+        glNormalPointer(GL_FLOAT, 0, &subdivNormals[0]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)subdivTriangles.size(), GL_UNSIGNED_INT, &subdivTriangles[0]);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    } else {
+        glPolygonMode(GL_FRONT_AND_BACK, wireMode == WIRE_POLYGON_LINE ? GL_LINE : GL_FILL);
+
+        glColor3f(1.0f, 0.5f, 0.2f); // 给立方体一个橙色
+
+        // 遍历所有面并绘制
+        glBegin(GL_TRIANGLES);
+        for (size_t i = 0; i < faces.size(); ++i) {
+            const Face& face = faces[i];
+            for (int j = 0; j < 3; ++j) {
+                // 在绘制每个顶点前, 先指定它的法线
+                const Vec3& normal = normals[face.vn_indices[j]];
+                glNormal3f(normal.x, normal.y, normal.z);
+
+                const Vec3& vertex = vertices[face.v_indices[j]];
+                glVertex3f(vertex.x, vertex.y, vertex.z);
+            }
         }
+        glEnd();
     }
-    glEnd();
-    
+    gpuTimer.end(lineCount);
+    wireTimer.addTimed(gpuTimer, wireMode, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(), lineCount);
+
     glutSwapBuffers();
+    replayFrameDone();
 }
 
 
+/**
+ * @brief 用一个 GL_LINES 索引数组画唯一边 / 折痕边 / 轮廓边, 返回线段数
+ */
+size_t drawEdges() {
+    TRACE_FUNCTION();
+    const std::vector<unsigned>* lines = &edgeTable.lineIndices;
+    if (wireMode == WIRE_CREASES) {
+        lines = &edgeTable.creaseIndices;
+    } else if (wireMode == WIRE_SILHOUETTE) {
+        GLfloat modelView[16];
+        float eye[3];
+        glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+        eyeFromModelView(modelView, eye);
+        silhouetteEdges(edgeTable, eye, silhouetteIndices);
+        lines = &silhouetteIndices;
+    }
+    if (lines->empty()) return 0;
+
+    glDisable(GL_LIGHTING);
+    glColor3f(1.0f, 0.5f, 0.2f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, edgePositions);
+    glDrawElements(GL_LINES, (GLsizei)lines->size(), GL_UNSIGNED_INT, &(*lines)[0]);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+    return lines->size() / 2;
+}
+
 // --- 其他函数 (与pyramid.cpp基本相同, 无需修改) ---
 void init() {
+    TRACE_FUNCTION();
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_NORMALIZE);
@@ -147,9 +287,12 @@ void init() {
     glLightfv(GL_LIGHT0, GL_SPECULAR, white_light);
     glEnable(GL_COLOR_MATERIAL);
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    gpuTimer.init();
+    if (!gpuTimer.supported()) std::cout << "不支持 GL_EXT_timer_query, 各模式只统计 CPU 提交时间" << std::endl;
 }
 
 void reshape(int w, int h) {
+    TRACE_FUNCTION();
     if (h == 0) h = 1;
     glViewport(0, 0, w, h);
     glMatrixMode(GL_PROJECTION);
@@ -159,6 +302,7 @@ void reshape(int w, int h) {
 }
 
 void mouseButton(int button, int state, int x, int y) {
+    TRACE_FUNCTION();
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) { isDragging = true; lastMouseX = x; lastMouseY = y; }
         else { isDragging = false; }
@@ -166,6 +310,7 @@ void mouseButton(int button, int state, int x, int y) {
 }
 
 void mouseMove(int x, int y) {
+    TRACE_FUNCTION();
     if (isDragging) {
         rotateY += (x - lastMouseX) * 0.5f;
         rotateX += (y - lastMouseY) * 0.5f;
@@ -175,8 +320,17 @@ void mouseMove(int x, int y) {
 }
 
 void keyboard(unsigned char key, int x, int y) {
+    TRACE_FUNCTION();
     switch (key) {
         case 27: case 'q': exit(0); break;
-        case 'w': isWireframe = !isWireframe; glutPostRedisplay(); break;
+        case 'w':
+            wireMode = (wireMode + 1) % WIRE_MODE_COUNT;
+            std::cout << "显示模式切换: " << wireModeName(wireMode) << std::endl;
+            glutPostRedisplay();
+            break;
+        case '+': case '=': case '-': // 提高 / 降低细分级别
+            setSubdivisionLevel(subdivLevel + (key == '-' ? -1 : 1));
+            glutPostRedisplay();
+            break;
     }
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+// 多网格提交方式的 CPU 开销基准测试 (需要 OpenGL 窗口, 见 multi_draw.h)
+//
+//   ./draw_bench             对象数 1000, 3000, 10000, 30000, 100000
+//   ./draw_bench 30000       最多测到 30000 个对象
+//
+// 立方体和金字塔交替排成立方阵列, 全部在视野内. 每种对象数、每种可用的提交方式各画若干帧,
+// 分别报告发出绘制调用的 CPU 时间 (submit 返回为止) 和加上 glFinish 等 GPU 画完的时间,
+// 以及相对逐个提交的加速比. 命令列表与 scene_viewer 一样已按网格排序
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "math3d.h"
+#include "obj_loader.h"
+#include "multi_draw.h"
+#include "trace.h"
+
+const int BENCH_WARMUP_FRAMES = 5;
+const int BENCH_FRAMES = 30;
+const int BENCH_SIZES[] = { 1000, 3000, 10000, 30000, 100000 };
+
+struct BenchResult {
+    double submitMs, frameMs;
+    size_t calls;
+};
+
+/**
+ * @brief 用给定的提交方式画若干帧, 返回每帧平均的提交时间和总时间
+ */
+BenchResult runFrames(MultiDrawBatch& batch, int mode, const std::vector<DrawCommand>& draws, const Mat4& proj) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    BenchResult result = { 0.0, 0.0, 0 };
+    for (int frame = 0; frame < BENCH_WARMUP_FRAMES + BENCH_FRAMES; ++frame) {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(proj.m);
+        glMatrixMode(GL_MODELVIEW);
+        glLoadIdentity();
+        GLfloat light_pos[] = { 0.3f, 1.0f, 0.5f, 0.0f };
+        glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+
+        Clock::time_point t0 = Clock::now();
+        batch.submit(mode, &draws[0], draws.size());
+        Clock::time_point t1 = Clock::now();
+        glFinish();
+        Clock::time_point t2 = Clock::now();
+        if (frame < BENCH_WARMUP_FRAMES) continue;
+        result.submitMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        result.frameMs += std::chrono::duration<double, std::milli>(t2 - t0).count();
+    }
+    result.submitMs /= BENCH_FRAMES;
+    result.frameMs /= BENCH_FRAMES;
+    result.calls = batch.lastCalls();
+    return result;
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("draw_bench_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    glutInit(&argc, argv);
+    int maxObjects = argc >= 2 ? atoi(argv[1]) : 100000;
+    if (maxObjects <= 0) { std::cerr << "错误: 对象数必须为正数" << std::endl; return 1; }
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(800, 600);
+    glutCreateWindow("Draw Submission Bench");
+
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_NORMALIZE);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+
+    // --- 网格与实例 ---
+    const char* files[] = { "cube.obj", "pyramid.obj" };
+    static const float colors[][3] = { { 1.0f, 1.0f, 0.3f }, { 1.0f, 0.5f, 0.2f } };
+    Mesh meshes[2];
+    std::vector<MultiDrawMesh> sources(2);
+    for (int m = 0; m < 2; ++m) {
+        if (!loadMesh(files[m], meshes[m])) return 1;
+        MultiDrawMesh& src = sources[m];
+        src.positions = meshes[m].positions;
+        src.normals = meshes[m].normals;
+        src.indices = meshes[m].indices;
+        src.vertexCount = meshes[m].vertexCount;
+        src.indexCount = meshes[m].indexCount;
+        std::copy(colors[m], colors[m] + 3, src.color);
+    }
+    std::vector<int> instanceMesh(maxObjects);
+    for (int i = 0; i < maxObjects; ++i) instanceMesh[i] = i % 2;
+    MultiDrawBatch batch;
+    batch.init(sources, instanceMesh);
+
+    // 立方阵列, 相机在阵列正前方, 视野刚好包住整个阵列
+    int side = (int)std::ceil(std::cbrt((double)maxObjects));
+    float spacing = 3.0f, half = 0.5f * spacing * (side - 1);
+    float distance = half * 2.5f + 5.0f;
+    Mat4 proj = mat4Perspective(60.0f, 800.0f / 600.0f, 0.1f, distance * 4.0f);
+    Mat4 view = mat4Translate(0, 0, -distance) * mat4RotateXYZ(20.0f, 0, 0) * mat4RotateXYZ(0, -30.0f, 0);
+    std::vector<Mat4> modelView(maxObjects);
+    for (int i = 0; i < maxObjects; ++i) {
+        int x = i % side, y = (i / side) % side, z = i / (side * side);
+        modelView[i] = view * mat4Translate(x * spacing - half, y * spacing - half, z * spacing - half);
+    }
+
+    std::cout << "每种提交方式先画 " << BENCH_WARMUP_FRAMES << " 帧预热, 再取 " << BENCH_FRAMES << " 帧的平均" << std::endl;
+    std::vector<DrawCommand> draws;
+    for (size_t s = 0; s < sizeof(BENCH_SIZES) / sizeof(BENCH_SIZES[0]); ++s) {
+        int count = std::min(BENCH_SIZES[s], maxObjects);
+        // 前 count 个实例, 按网格排序
+        draws.clear();
+        for (int m = 0; m < 2; ++m) {
+            for (int i = m; i < count; i += 2) {
+                DrawCommand cmd;
+                cmd.mesh = m;
+                cmd.instance = i;
+                std::copy(modelView[i].m, modelView[i].m + 16, cmd.modelView);
+                draws.push_back(cmd);
+            }
+        }
+        std::cout << count << " 个对象:" << std::endl;
+        double baseMs = 0.0;
+        for (int mode = 0; mode < SUBMIT_MODE_COUNT; ++mode) {
+            if (!batch.supported(mode)) continue;
+            BenchResult r = runFrames(batch, mode, draws, proj);
+            if (mode == SUBMIT_PER_OBJECT) baseMs = r.submitMs;
+            std::cout << "  [" << submitModeName(mode) << "] 提交 " << r.submitMs << " ms, 含 GPU 完成 " << r.frameMs
+                      << " ms, " << r.calls << " 次绘制调用";
+            if (mode != SUBMIT_PER_OBJECT && r.submitMs > 0.0) std::cout << ", 提交快 " << baseMs / r.submitMs << " 倍";
+            std::cout << std::endl;
+        }
+        if (count == maxObjects) break;
+    }
+    for (int mode = 0; mode < SUBMIT_MODE_COUNT; ++mode)
+        if (!batch.supported(mode)) std::cout << "注意: 当前上下文不支持 " << submitModeName(mode) << ", 已跳过" << std::endl;
+    return 0;
+}
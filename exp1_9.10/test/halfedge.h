@@ -0,0 +1,510 @@
+#ifndef HALFEDGE_H
+#define HALFEDGE_H
+
+// 半边网格与细分曲面 (全三角形网格用 Loop, 其余用 Catmull-Clark)
+//
+//   HalfEdgeMesh base;
+//   buildHalfEdgeMesh(base, positions, vertexCount, faceStart, faceCount, faceVerts);
+//   SubdivisionLevels levels;
+//   levels.reset(base);
+//   const HalfEdgeMesh& m = levels.level(3);    // 按需逐级计算并缓存, 打印每级耗时
+//   halfEdgeTriangles(m, indices);             // 扇形三角化, 用于绘制
+//
+// 布局: 同一个面的半边连续存放, 面 f 的半边为 [faceStart[f], faceStart[f + 1]), 因此
+// next / prev / face 都是 O(1) 的下标运算, 只有 twin 需要单独存放; 每条半边还记录所属的无向边编号
+// - 顶点的 1-ring: 从 vertexOut 出发反复执行 next(twin(h)); 边界顶点的 vertexOut 是沿边界的第一条出边,
+//   遍历在没有 twin 的出边处结束
+// - 非流形的边 (同一方向出现两次, 或被三个以上的面共享) 按边界处理; 1-ring 不能完整遍历的顶点在细分时保持不动
+//
+// 细分的每一级都是按元素独立计算: 顶点点 (每个顶点)、边点 (每条边)、面点 (每个面) 和新的面
+// 都由 parallelFor 并行生成, 新网格的编号由旧网格的编号直接算出, 不需要哈希表:
+//   新顶点 = [旧顶点 V 个][边点 E 个][面点 F 个, 仅 Catmull-Clark]
+//   Loop: 面 f 分成 4f .. 4f+3;  Catmull-Clark: 半边 h 所在的角生成第 h 个四边形
+// 之后重建半边结构: 按起点分桶 (计数排序), 每条半边在终点的出边中找反向半边, 同样按半边并行
+//
+// 只依赖标准库, 可以被自带 Vec3 的 pyramid / cube 查看器直接包含
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "parallel_for.h"
+#include "trace.h"
+
+const int SUBDIVISION_MAX_LEVEL = 6;
+
+struct HalfEdgeMesh {
+    std::vector<float> positions;       // 每个顶点 3 个 float
+    std::vector<unsigned> faceStart;    // faceCount + 1 个
+    std::vector<unsigned> origin;       // 半边的起点
+    std::vector<int> twin;              // 反向半边, -1 = 边界边
+    std::vector<unsigned> faceOf;       // 半边所属的面
+    std::vector<unsigned> edgeOf;       // 半边所属的无向边
+    std::vector<int> vertexOut;         // 顶点的一条出边 (边界顶点为沿边界的第一条), -1 = 孤立顶点
+    std::vector<uint8_t> vertexManifold;  // 1-ring 可以完整遍历
+    size_t edgeCount;
+
+    HalfEdgeMesh() : edgeCount(0) {}
+    size_t vertexCount() const { return positions.size() / 3; }
+    size_t faceCount() const { return faceStart.empty() ? 0 : faceStart.size() - 1; }
+    size_t halfEdgeCount() const { return origin.size(); }
+
+    unsigned next(unsigned h) const { return h + 1 < faceStart[faceOf[h] + 1] ? h + 1 : faceStart[faceOf[h]]; }
+    unsigned prev(unsigned h) const { return h > faceStart[faceOf[h]] ? h - 1 : faceStart[faceOf[h] + 1] - 1; }
+    unsigned dest(unsigned h) const { return origin[next(h)]; }
+    unsigned faceSize(unsigned f) const { return faceStart[f + 1] - faceStart[f]; }
+    bool onBoundary(unsigned v) const { return vertexOut[v] >= 0 && twin[prev((unsigned)vertexOut[v])] < 0; }
+
+    bool allTriangles() const {
+        for (size_t f = 0; f < faceCount(); ++f)
+            if (faceSize((unsigned)f) != 3) return false;
+        return true;
+    }
+};
+
+struct SubdivisionTiming {
+    double pointsMs, facesMs, buildMs, totalMs;
+};
+
+/**
+ * @brief 由多边形列表建立半边网格
+ * faceStart: faceCount + 1 个偏移, 面 f 的顶点为 faceVerts[faceStart[f] .. faceStart[f + 1])
+ */
+inline void buildHalfEdgeMesh(HalfEdgeMesh& m, const float* positions, size_t vertexCount,
+                              const unsigned* faceStart, size_t faceCount, const unsigned* faceVerts) {
+    TRACE_FUNCTION();
+    m.positions.assign(positions, positions + vertexCount * 3);
+    m.faceStart.assign(faceStart, faceStart + faceCount + 1);
+    size_t halfEdges = faceStart[faceCount];
+    m.origin.assign(faceVerts, faceVerts + halfEdges);
+    m.faceOf.resize(halfEdges);
+    parallelFor(faceCount, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f)
+            for (unsigned h = faceStart[f]; h < faceStart[f + 1]; ++h) m.faceOf[h] = (unsigned)f;
+    });
+
+    // 按起点分桶 (计数排序): 顶点 v 的出边为 outList[outStart[v] .. outStart[v + 1])
+    std::vector<unsigned> outStart(vertexCount + 1, 0), outList(halfEdges);
+    for (size_t h = 0; h < halfEdges; ++h) ++outStart[m.origin[h] + 1];
+    for (size_t v = 0; v < vertexCount; ++v) outStart[v + 1] += outStart[v];
+    {
+        std::vector<unsigned> cursor(outStart.begin(), outStart.end() - 1);
+        for (size_t h = 0; h < halfEdges; ++h) outList[cursor[m.origin[h]]++] = (unsigned)h;
+    }
+
+    // 反向半边: a -> b 在 b 的出边中找 b -> a; 两个方向都恰好出现一次才配对
+    m.twin.assign(halfEdges, -1);
+    parallelFor(halfEdges, 0, [&](size_t begin, size_t end, int) {
+        for (size_t h = begin; h < end; ++h) {
+            unsigned a = m.origin[h], b = m.dest((unsigned)h);
+            int found = -1, reverse = 0, forward = 0;
+            for (unsigned k = outStart[b]; k < outStart[b + 1]; ++k)
+                if (m.dest(outList[k]) == a) { found = (int)outList[k]; ++reverse; }
+            for (unsigned k = outStart[a]; k < outStart[a + 1]; ++k)
+                if (m.dest(outList[k]) == b) ++forward;
+            if (reverse == 1 && forward == 1) m.twin[h] = found;
+        }
+    });
+
+    // 无向边编号: 每对半边中编号较小的一条 (或边界半边) 持有边, 分段计数 + 前缀和保证编号与线程数无关
+    int chunks = jobSystem().threadCount() * 4;
+    size_t per = (halfEdges + chunks - 1) / chunks;
+    std::vector<size_t> owned(chunks + 1, 0);
+    m.edgeOf.resize(halfEdges);
+    parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t c = begin; c < end; ++c) {
+            size_t lo = std::min(halfEdges, c * per), hi = std::min(halfEdges, lo + per), n = 0;
+            for (size_t h = lo; h < hi; ++h) n += m.twin[h] < 0 || (size_t)m.twin[h] > h;
+            owned[c + 1] = n;
+        }
+    });
+    for (int c = 0; c < chunks; ++c) owned[c + 1] += owned[c];
+    m.edgeCount = owned[chunks];
+    parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t c = begin; c < end; ++c) {
+            size_t lo = std::min(halfEdges, c * per), hi = std::min(halfEdges, lo + per);
+            unsigned id = (unsigned)owned[c];
+            for (size_t h = lo; h < hi; ++h)
+                if (m.twin[h] < 0 || (size_t)m.twin[h] > h) m.edgeOf[h] = id++;
+        }
+    });
+    parallelFor(halfEdges, 0, [&](size_t begin, size_t end, int) {
+        for (size_t h = begin; h < end; ++h)
+            if (m.twin[h] >= 0 && (size_t)m.twin[h] < h) m.edgeOf[h] = m.edgeOf[m.twin[h]];
+    });
+
+    // 每个顶点的起始出边: 边界顶点取前一条半边没有反向半边的出边, 否则取编号最小的出边
+    m.vertexOut.assign(vertexCount, -1);
+    m.vertexManifold.assign(vertexCount, 0);
+    parallelFor(vertexCount, 0, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            unsigned count = outStart[v + 1] - outStart[v];
+            if (count == 0) continue;
+            unsigned start = outList[outStart[v]];
+            for (unsigned k = outStart[v]; k < outStart[v + 1]; ++k) {
+                if (m.twin[m.prev(outList[k])] < 0) { start = outList[k]; break; }
+            }
+            m.vertexOut[v] = (int)start;
+            unsigned visited = 0, h = start;
+            for (;;) {
+                ++visited;
+                int t = m.twin[h];
+                if (t < 0 || visited > count) break;
+                h = m.next((unsigned)t);
+                if (h == start) break;
+            }
+            m.vertexManifold[v] = visited == count;
+        }
+    });
+}
+
+// --- 细分 ---
+
+inline void heAccumulate(float* dst, const float* src, float w) {
+    dst[0] += src[0] * w; dst[1] += src[1] * w; dst[2] += src[2] * w;
+}
+
+/**
+ * @brief 边界顶点的两个边界邻点 (前一个和后一个)
+ */
+inline void heBoundaryNeighbors(const HalfEdgeMesh& m, unsigned v, unsigned& before, unsigned& after) {
+    unsigned start = (unsigned)m.vertexOut[v], h = start;
+    before = m.origin[m.prev(start)];
+    while (m.twin[h] >= 0) h = m.next((unsigned)m.twin[h]);
+    after = m.dest(h);
+}
+
+/**
+ * @brief 由边界顶点规则 (3/4 v + 1/8 两个边界邻点) 计算新位置; 非流形顶点保持不动
+ * 返回 true 表示已经处理, 内部顶点返回 false
+ */
+inline bool heBoundaryVertexPoint(const HalfEdgeMesh& m, unsigned v, float* out) {
+    const float* p = &m.positions[v * 3];
+    if (m.vertexOut[v] < 0 || !m.vertexManifold[v]) { out[0] = p[0]; out[1] = p[1]; out[2] = p[2]; return true; }
+    if (!m.onBoundary(v)) return false;
+    unsigned before, after;
+    heBoundaryNeighbors(m, v, before, after);
+    out[0] = out[1] = out[2] = 0.0f;
+    heAccumulate(out, p, 0.75f);
+    heAccumulate(out, &m.positions[before * 3], 0.125f);
+    heAccumulate(out, &m.positions[after * 3], 0.125f);
+    return true;
+}
+
+/**
+ * @brief Loop 细分一级 (输入必须全部是三角形)
+ */
+inline void loopSubdivide(const HalfEdgeMesh& in, HalfEdgeMesh& out, SubdivisionTiming* timing = 0) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    size_t V = in.vertexCount(), E = in.edgeCount, F = in.faceCount(), H = in.halfEdgeCount();
+    std::vector<float> positions((V + E) * 3, 0.0f);
+
+    // 顶点点: (1 - n beta) v + beta * 邻点之和, beta = 3 / (8n) (n = 3 时为 3/16)
+    parallelFor(V, 0, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            float* dst = &positions[v * 3];
+            if (heBoundaryVertexPoint(in, (unsigned)v, dst)) continue;
+            float sum[3] = { 0.0f, 0.0f, 0.0f };
+            unsigned n = 0, start = (unsigned)in.vertexOut[v], h = start;
+            do {
+                heAccumulate(sum, &in.positions[in.dest(h) * 3], 1.0f);
+                ++n;
+                h = in.next((unsigned)in.twin[h]);
+            } while (h != start);
+            float beta = n == 3 ? 3.0f / 16.0f : 3.0f / (8.0f * n);
+            heAccumulate(dst, &in.positions[v * 3], 1.0f - n * beta);
+            heAccumulate(dst, sum, beta);
+        }
+    });
+    // 边点: 3/8 (a + b) + 1/8 (两侧的对顶点); 边界边取中点
+    parallelFor(H, 0, [&](size_t begin, size_t end, int) {
+        for (size_t h = begin; h < end; ++h) {
+            int t = in.twin[h];
+            if (t >= 0 && (size_t)t < h) continue;   // 每条边只算一次
+            float* dst = &positions[(V + in.edgeOf[h]) * 3];
+            const float* a = &in.positions[in.origin[h] * 3];
+            const float* b = &in.positions[in.dest((unsigned)h) * 3];
+            if (t < 0) {
+                heAccumulate(dst, a, 0.5f);
+                heAccumulate(dst, b, 0.5f);
+                continue;
+            }
+            heAccumulate(dst, a, 0.375f);
+            heAccumulate(dst, b, 0.375f);
+            heAccumulate(dst, &in.positions[in.origin[in.prev((unsigned)h)] * 3], 0.125f);
+            heAccumulate(dst, &in.positions[in.origin[in.prev((unsigned)t)] * 3], 0.125f);
+        }
+    });
+    Clock::time_point t1 = Clock::now();
+
+    // 每个三角形 (a, b, c) 分成 3 个角上的三角形和中间的一个, 绕向不变
+    std::vector<unsigned> faceStart(F * 4 + 1), faceVerts(F * 12);
+    parallelFor(F, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            unsigned h0 = in.faceStart[f], h1 = h0 + 1, h2 = h0 + 2;
+            unsigned a = in.origin[h0], b = in.origin[h1], c = in.origin[h2];
+            unsigned ab = (unsigned)V + in.edgeOf[h0], bc = (unsigned)V + in.edgeOf[h1], ca = (unsigned)V + in.edgeOf[h2];
+            unsigned tris[12] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+            for (int k = 0; k < 12; ++k) faceVerts[f * 12 + k] = tris[k];
+            for (int k = 0; k < 4; ++k) faceStart[f * 4 + k] = (unsigned)(f * 12 + k * 3);
+        }
+    });
+    faceStart[F * 4] = (unsigned)(F * 12);
+    Clock::time_point t2 = Clock::now();
+
+    buildHalfEdgeMesh(out, positions.empty() ? 0 : &positions[0], V + E, &faceStart[0], F * 4, faceVerts.empty() ? 0 : &faceVerts[0]);
+    Clock::time_point t3 = Clock::now();
+    if (timing) {
+        timing->pointsMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        timing->facesMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        timing->buildMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+        timing->totalMs = std::chrono::duration<double, std::milli>(t3 - t0).count();
+    }
+}
+
+/**
+ * @brief Catmull-Clark 细分一级 (任意多边形, 输出全部是四边形)
+ */
+inline void catmullClarkSubdivide(const HalfEdgeMesh& in, HalfEdgeMesh& out, SubdivisionTiming* timing = 0) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    size_t V = in.vertexCount(), E = in.edgeCount, F = in.faceCount(), H = in.halfEdgeCount();
+    std::vector<float> positions((V + E + F) * 3, 0.0f);
+    const float* facePoints = &positions[(V + E) * 3];
+
+    // 面点: 面上顶点的平均
+    parallelFor(F, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            float* dst = &positions[(V + E + f) * 3];
+            float w = 1.0f / in.faceSize((unsigned)f);
+            for (unsigned h = in.faceStart[f]; h < in.faceStart[f + 1]; ++h) heAccumulate(dst, &in.positions[in.origin[h] * 3], w);
+        }
+    });
+    // 边点: (a + b + 两侧面点) / 4; 边界边取中点
+    parallelFor(H, 0, [&](size_t begin, size_t end, int) {
+        for (size_t h = begin; h < end; ++h) {
+            int t = in.twin[h];
+            if (t >= 0 && (size_t)t < h) continue;
+            float* dst = &positions[(V + in.edgeOf[h]) * 3];
+            const float* a = &in.positions[in.origin[h] * 3];
+            const float* b = &in.positions[in.dest((unsigned)h) * 3];
+            if (t < 0) {
+                heAccumulate(dst, a, 0.5f);
+                heAccumulate(dst, b, 0.5f);
+                continue;
+            }
+            heAccumulate(dst, a, 0.25f);
+            heAccumulate(dst, b, 0.25f);
+            heAccumulate(dst, facePoints + in.faceOf[h] * 3, 0.25f);
+            heAccumulate(dst, facePoints + in.faceOf[t] * 3, 0.25f);
+        }
+    });
+    // 顶点点: (Q + 2R + (n - 3) v) / n, Q 为相邻面点的平均, R 为相邻边中点的平均
+    parallelFor(V, 0, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            float* dst = &positions[v * 3];
+            if (heBoundaryVertexPoint(in, (unsigned)v, dst)) continue;
+            const float* p = &in.positions[v * 3];
+            float q[3] = { 0.0f, 0.0f, 0.0f }, r[3] = { 0.0f, 0.0f, 0.0f };
+            unsigned n = 0, start = (unsigned)in.vertexOut[v], h = start;
+            do {
+                heAccumulate(q, facePoints + in.faceOf[h] * 3, 1.0f);
+                heAccumulate(r, p, 0.5f);
+                heAccumulate(r, &in.positions[in.dest(h) * 3], 0.5f);
+                ++n;
+                h = in.next((unsigned)in.twin[h]);
+            } while (h != start);
+            float inv = 1.0f / n;
+            heAccumulate(dst, q, inv * inv);
+            heAccumulate(dst, r, 2.0f * inv * inv);
+            heAccumulate(dst, p, (n - 3.0f) * inv);
+        }
+    });
+    Clock::time_point t1 = Clock::now();
+
+    // 半边 h (面 f 的一个角 v) 生成四边形 (v, h 的边点, f 的面点, prev(h) 的边点), 绕向不变
+    std::vector<unsigned> faceStart(H + 1), faceVerts(H * 4);
+    parallelFor(H, 0, [&](size_t begin, size_t end, int) {
+        for (size_t h = begin; h < end; ++h) {
+            faceVerts[h * 4] = in.origin[h];
+            faceVerts[h * 4 + 1] = (unsigned)V + in.edgeOf[h];
+            faceVerts[h * 4 + 2] = (unsigned)(V + E) + in.faceOf[h];
+            faceVerts[h * 4 + 3] = (unsigned)V + in.edgeOf[in.prev((unsigned)h)];
+            faceStart[h] = (unsigned)(h * 4);
+        }
+    });
+    faceStart[H] = (unsigned)(H * 4);
+    Clock::time_point t2 = Clock::now();
+
+    buildHalfEdgeMesh(out, positions.empty() ? 0 : &positions[0], V + E + F, &faceStart[0], H, faceVerts.empty() ? 0 : &faceVerts[0]);
+    Clock::time_point t3 = Clock::now();
+    if (timing) {
+        timing->pointsMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        timing->facesMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+        timing->buildMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+        timing->totalMs = std::chrono::duration<double, std::milli>(t3 - t0).count();
+    }
+}
+
+/**
+ * @brief 逐级细分的结果, 第 0 级为输入网格; 每级只计算一次
+ */
+struct SubdivisionLevels {
+    std::vector<HalfEdgeMesh> meshes;
+    bool useLoop;
+
+    SubdivisionLevels() : useLoop(true) {}
+
+    void reset(const HalfEdgeMesh& base) {
+        meshes.assign(1, base);
+        useLoop = base.allTriangles();
+    }
+
+    const char* schemeName() const { return useLoop ? "Loop" : "Catmull-Clark"; }
+
+    const HalfEdgeMesh& level(int k) {
+        if (k > SUBDIVISION_MAX_LEVEL) k = SUBDIVISION_MAX_LEVEL;
+        while ((int)meshes.size() <= k) {
+            HalfEdgeMesh next;
+            SubdivisionTiming t;
+            if (useLoop) loopSubdivide(meshes.back(), next, &t);
+            else catmullClarkSubdivide(meshes.back(), next, &t);
+            meshes.push_back(next);
+            std::cout << schemeName() << " 细分第 " << meshes.size() - 1 << " 级: " << next.vertexCount() << " 个顶点, "
+                      << next.faceCount() << " 个面, 耗时 " << t.totalMs << " ms [点 " << t.pointsMs << ", 面 " << t.facesMs
+                      << ", 半边 " << t.buildMs << "] (" << jobSystem().threadCount() << " 线程)" << std::endl;
+        }
+        return meshes[k];
+    }
+};
+
+// --- 绘制辅助 ---
+
+/**
+ * @brief 扇形三角化所有面, 输出三角形索引 (面 f 的三角形从 faceStart[f] - 2f 开始)
+ */
+inline void halfEdgeTriangles(const HalfEdgeMesh& m, std::vector<unsigned>& indices) {
+    TRACE_FUNCTION();
+    size_t F = m.faceCount();
+    indices.resize((m.halfEdgeCount() - 2 * F) * 3);
+    parallelFor(F, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            unsigned first = m.faceStart[f], t = first - 2 * (unsigned)f;
+            for (unsigned h = first + 1; h + 1 < m.faceStart[f + 1]; ++h, ++t) {
+                indices[t * 3] = m.origin[first];
+                indices[t * 3 + 1] = m.origin[h];
+                indices[t * 3 + 2] = m.origin[h + 1];
+            }
+        }
+    });
+}
+
+/**
+ * @brief 顶点法线: 1-ring 上各面法线 (Newell 方法, 长度与面积成正比) 之和, 已归一化
+ */
+inline void halfEdgeVertexNormals(const HalfEdgeMesh& m, std::vector<float>& normals) {
+    TRACE_FUNCTION();
+    size_t F = m.faceCount(), V = m.vertexCount();
+    std::vector<float> faceNormals(F * 3, 0.0f);
+    parallelFor(F, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            float* n = &faceNormals[f * 3];
+            for (unsigned h = m.faceStart[f]; h < m.faceStart[f + 1]; ++h) {
+                const float* a = &m.positions[m.origin[h] * 3];
+                const float* b = &m.positions[m.dest(h) * 3];
+                n[0] += (a[1] - b[1]) * (a[2] + b[2]);
+                n[1] += (a[2] - b[2]) * (a[0] + b[0]);
+                n[2] += (a[0] - b[0]) * (a[1] + b[1]);
+            }
+        }
+    });
+    normals.assign(V * 3, 0.0f);
+    parallelFor(V, 0, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            if (m.vertexOut[v] < 0) continue;
+            float* dst = &normals[v * 3];
+            unsigned start = (unsigned)m.vertexOut[v], h = start, steps = 0;
+            for (;;) {
+                heAccumulate(dst, &faceNormals[m.faceOf[h] * 3], 1.0f);
+                int t = m.twin[h];
+                if (t < 0 || ++steps > m.halfEdgeCount()) break;
+                h = m.next((unsigned)t);
+                if (h == start) break;
+            }
+            float len = std::sqrt(dst[0] * dst[0] + dst[1] * dst[1] + dst[2] * dst[2]);
+            if (len > 0.0f) { dst[0] /= len; dst[1] /= len; dst[2] /= len; }
+        }
+    });
+}
+
+/**
+ * @brief 把共面的相邻三角形两两合并为四边形 (用于 cube.obj 这种三角化后的四边形网格)
+ * 输出多边形列表 (faceStart / faceVerts); 不能合并的三角形原样保留
+ */
+inline void mergeCoplanarTriangles(const float* positions, const unsigned* indices, size_t triangleCount,
+                                   std::vector<unsigned>& faceStart, std::vector<unsigned>& faceVerts) {
+    TRACE_FUNCTION();
+    std::vector<unsigned> triStart(triangleCount + 1);
+    for (size_t t = 0; t <= triangleCount; ++t) triStart[t] = (unsigned)(t * 3);
+    HalfEdgeMesh tri;
+    unsigned maxIndex = 0;
+    for (size_t i = 0; i < triangleCount * 3; ++i) maxIndex = std::max(maxIndex, indices[i]);
+    buildHalfEdgeMesh(tri, positions, triangleCount ? maxIndex + 1 : 0, &triStart[0], triangleCount, indices);
+
+    std::vector<float> normals(triangleCount * 3);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const float* a = positions + indices[t * 3] * 3;
+        const float* b = positions + indices[t * 3 + 1] * 3;
+        const float* c = positions + indices[t * 3 + 2] * 3;
+        float u[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] }, v[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        float n[3] = { u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+        float len = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        for (int k = 0; k < 3; ++k) normals[t * 3 + k] = len > 0.0f ? n[k] / len : 0.0f;
+    }
+
+    std::vector<int> partner(triangleCount, -1);
+    std::vector<unsigned> sharedHalfEdge(triangleCount);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (partner[t] >= 0) continue;
+        for (unsigned h = triStart[t]; h < triStart[t + 1]; ++h) {
+            int tw = tri.twin[h];
+            if (tw < 0) continue;
+            unsigned o = tri.faceOf[tw];
+            if (partner[o] >= 0 || o == t) continue;
+            const float* n0 = &normals[t * 3];
+            const float* n1 = &normals[o * 3];
+            if (n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] < 0.99999f) continue;
+            partner[t] = (int)o;
+            partner[o] = (int)t;
+            sharedHalfEdge[t] = h;
+            break;
+        }
+    }
+
+    // 按三角形顺序输出; 配对总是由编号较小的三角形发起, 由它输出合并后的四边形:
+    // 三角形 a -> b -> c 与邻居 b -> a -> d 合并为 a -> d -> b -> c
+    faceStart.assign(1, 0);
+    faceVerts.clear();
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (partner[t] < 0) {
+            faceVerts.insert(faceVerts.end(), indices + t * 3, indices + t * 3 + 3);
+        } else if ((size_t)partner[t] > t) {
+            unsigned h = sharedHalfEdge[t];
+            unsigned a = tri.origin[h], b = tri.dest(h), c = tri.origin[tri.prev(h)];
+            unsigned d = tri.origin[tri.prev((unsigned)tri.twin[h])];
+            unsigned quad[4] = { a, d, b, c };
+            faceVerts.insert(faceVerts.end(), quad, quad + 4);
+        } else {
+            continue;
+        }
+        faceStart.push_back((unsigned)faceVerts.size());
+    }
+}
+
+#endif
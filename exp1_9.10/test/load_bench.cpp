@@ -0,0 +1,127 @@
+// OBJ 加载的多线程扩展性基准测试 (不需要窗口)
+//
+//   ./load_bench             合成网格: 1000 x 1000 个四边形, 写入 load_bench_grid.obj 后读取
+//   ./load_bench 2000        合成网格: 2000 x 2000 个四边形
+//   ./load_bench model.obj   读取已有的 OBJ 文件
+//   ./load_bench model.obj 16   最多测到 16 个线程 (默认为硬件线程数)
+//
+// 依次把共用调度器 (job_system.h) 设为 1, 2, 4, ... 个线程, 每种线程数读取多次取最短时间,
+// 报告耗时、吞吐量和相对单线程的加速比, 并检查结果与单线程完全相同
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "obj_reader.h"
+#include "job_system.h"
+#include "trace.h"
+
+const int BENCH_RUNS = 5;
+
+/**
+ * @brief 写出 n x n 个四边形的起伏网格 (v / vt / vn + 四边形面), 返回文件字节数
+ */
+size_t writeGridObj(const std::string& filename, int n) {
+    TRACE_FUNCTION();
+    std::ofstream file(filename.c_str());
+    if (!file) { std::cerr << "错误: 无法写入 " << filename << std::endl; exit(1); }
+    int side = n + 1;
+    file << "# load_bench 合成网格 " << n << " x " << n << "\n";
+    for (int y = 0; y < side; ++y) {
+        for (int x = 0; x < side; ++x) {
+            float fx = (float)x / n, fy = (float)y / n;
+            file << "v " << fx << " " << fy << " " << 0.05f * std::sin(x * 0.1f) * std::cos(y * 0.07f) << "\n";
+        }
+    }
+    for (int y = 0; y < side; ++y)
+        for (int x = 0; x < side; ++x) file << "vt " << (float)x / n << " " << (float)y / n << "\n";
+    file << "vn 0 0 1\n";
+    for (int y = 0; y < n; ++y) {
+        if (y % 256 == 0) file << "g rows" << y << "\n";
+        for (int x = 0; x < n; ++x) {
+            int a = y * side + x + 1, b = a + 1, c = a + side + 1, d = a + side;
+            file << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 " << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+        }
+    }
+    return (size_t)file.tellp();
+}
+
+bool sameModel(const ObjModel& a, const ObjModel& b) {
+    if (a.vertices != b.vertices || a.indices != b.indices || a.positionIndex != b.positionIndex) return false;
+    if (a.groups != b.groups || a.materials.size() != b.materials.size() || a.ranges.size() != b.ranges.size()) return false;
+    for (size_t i = 0; i < a.ranges.size(); ++i) {
+        if (a.ranges[i].material != b.ranges[i].material || a.ranges[i].firstIndex != b.ranges[i].firstIndex ||
+            a.ranges[i].indexCount != b.ranges[i].indexCount) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取 BENCH_RUNS 次, 返回最短耗时 (毫秒); 最后一次的结果留在 model 中
+ * readObj 每次都会打印统计信息, 计时期间暂时关闭 std::cout
+ */
+double bestLoadMs(const std::string& filename, ObjModel& model) {
+    double best = 1e30;
+    std::ostringstream sink;
+    std::streambuf* saved = std::cout.rdbuf(sink.rdbuf());
+    for (int r = 0; r < BENCH_RUNS; ++r) {
+        model = ObjModel();
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        bool ok = readObj(filename, model);
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        if (!ok) { std::cout.rdbuf(saved); exit(1); }
+    }
+    std::cout.rdbuf(saved);
+    return best;
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("load_bench_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    std::string filename;
+    if (argc >= 2 && strstr(argv[1], ".obj")) {
+        filename = argv[1];
+    } else {
+        int n = argc >= 2 ? atoi(argv[1]) : 1000;
+        if (n <= 0) { std::cerr << "错误: 网格大小必须为正数" << std::endl; return 1; }
+        filename = "load_bench_grid.obj";
+        size_t bytes = writeGridObj(filename, n);
+        std::cout << "已生成 " << filename << " (" << bytes / (1024.0 * 1024.0) << " MB)" << std::endl;
+    }
+    int maxThreads = argc >= 3 ? atoi(argv[2]) : hardwareThreads();
+    if (maxThreads < 1) maxThreads = 1;
+
+    std::ifstream probe(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (!probe) { std::cerr << "错误: 无法打开文件 " << filename << std::endl; return 1; }
+    double megabytes = (double)probe.tellg() / (1024.0 * 1024.0);
+
+    std::cout << "硬件线程数 " << hardwareThreads() << ", 每种线程数读取 " << BENCH_RUNS << " 次取最短时间" << std::endl;
+    ObjModel reference;
+    double baseMs = 0.0;
+    for (int threads = 1;; threads = std::min(threads * 2, maxThreads)) {
+        jobSystem().setThreadCount(threads);
+        ObjModel model;
+        double ms = bestLoadMs(filename, model);
+        bool same = true;
+        if (threads == 1) {
+            baseMs = ms;
+            reference = model;
+            std::cout << model.positionCount << " 个位置, " << model.vertexCount() << " 个顶点, "
+                      << model.indices.size() / 3 << " 个三角面" << std::endl;
+        } else {
+            same = sameModel(reference, model);
+        }
+        std::cout << "  " << threads << " 线程: " << ms << " ms, " << megabytes / (ms / 1000.0) << " MB/秒, "
+                  << baseMs / ms << " 倍" << (same ? "" : "  [错误: 结果与单线程不同]") << std::endl;
+        if (!same) return 1;
+        if (threads >= maxThreads) break;
+    }
+    if (maxThreads > hardwareThreads())
+        std::cout << "注意: 线程数超过硬件线程数时, 加速比只反映调度开销" << std::endl;
+    return 0;
+}
@@ -0,0 +1,177 @@
+#ifndef MATH3D_H
+#define MATH3D_H
+
+// 场景查看器等程序共用的小型数学库
+// 矩阵统一采用列主序 (与 OpenGL 的 glLoadMatrixf / glMultMatrixf 一致)
+
+#include <cmath>
+#include <cfloat>
+
+// --- 向量 ---
+struct Vec3 { float x, y, z; };
+
+inline Vec3 vec3(float x, float y, float z) { Vec3 r = { x, y, z }; return r; }
+inline Vec3 operator+(const Vec3& a, const Vec3& b) { return vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+inline Vec3 operator-(const Vec3& a, const Vec3& b) { return vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+inline Vec3 operator*(const Vec3& a, float s) { return vec3(a.x * s, a.y * s, a.z * s); }
+inline float dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline Vec3 cross(const Vec3& a, const Vec3& b) {
+    return vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+}
+inline float length(const Vec3& a) { return std::sqrt(dot(a, a)); }
+inline Vec3 normalize(const Vec3& a) {
+    float len = length(a);
+    return len > 0.0f ? a * (1.0f / len) : a;
+}
+inline Vec3 vmin(const Vec3& a, const Vec3& b) {
+    return vec3(a.x < b.x ? a.x : b.x, a.y < b.y ? a.y : b.y, a.z < b.z ? a.z : b.z);
+}
+inline Vec3 vmax(const Vec3& a, const Vec3& b) {
+    return vec3(a.x > b.x ? a.x : b.x, a.y > b.y ? a.y : b.y, a.z > b.z ? a.z : b.z);
+}
+
+// --- 4x4 矩阵 (列主序, m[col * 4 + row]) ---
+struct Mat4 { float m[16]; };
+
+inline Mat4 mat4Identity() {
+    Mat4 r = {{ 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 }};
+    return r;
+}
+
+inline Mat4 operator*(const Mat4& a, const Mat4& b) {
+    Mat4 r;
+    for (int c = 0; c < 4; ++c)
+        for (int row = 0; row < 4; ++row)
+            r.m[c * 4 + row] = a.m[0 * 4 + row] * b.m[c * 4 + 0] + a.m[1 * 4 + row] * b.m[c * 4 + 1]
+                             + a.m[2 * 4 + row] * b.m[c * 4 + 2] + a.m[3 * 4 + row] * b.m[c * 4 + 3];
+    return r;
+}
+
+inline Mat4 mat4Translate(float x, float y, float z) {
+    Mat4 r = mat4Identity();
+    r.m[12] = x; r.m[13] = y; r.m[14] = z;
+    return r;
+}
+
+inline Mat4 mat4Scale(float s) {
+    Mat4 r = mat4Identity();
+    r.m[0] = r.m[5] = r.m[10] = s;
+    return r;
+}
+
+/**
+ * @brief 按 X -> Y -> Z 的顺序施加欧拉角旋转 (角度制), 即 R = Rz * Ry * Rx
+ */
+inline Mat4 mat4RotateXYZ(float degX, float degY, float degZ) {
+    const float k = 3.14159265359f / 180.0f;
+    float cx = std::cos(degX * k), sx = std::sin(degX * k);
+    float cy = std::cos(degY * k), sy = std::sin(degY * k);
+    float cz = std::cos(degZ * k), sz = std::sin(degZ * k);
+    Mat4 r = mat4Identity();
+    r.m[0] = cy * cz;  r.m[4] = sx * sy * cz - cx * sz;  r.m[8]  = cx * sy * cz + sx * sz;
+    r.m[1] = cy * sz;  r.m[5] = sx * sy * sz + cx * cz;  r.m[9]  = cx * sy * sz - sx * cz;
+    r.m[2] = -sy;      r.m[6] = sx * cy;                 r.m[10] = cx * cy;
+    return r;
+}
+
+inline Mat4 mat4Perspective(float fovyDeg, float aspect, float zNear, float zFar) {
+    float f = 1.0f / std::tan(fovyDeg * 3.14159265359f / 360.0f);
+    Mat4 r = {{ 0 }};
+    r.m[0] = f / aspect;
+    r.m[5] = f;
+    r.m[10] = (zFar + zNear) / (zNear - zFar);
+    r.m[11] = -1.0f;
+    r.m[14] = 2.0f * zFar * zNear / (zNear - zFar);
+    return r;
+}
+
+inline Vec3 transformPoint(const Mat4& a, const Vec3& p) {
+    return vec3(a.m[0] * p.x + a.m[4] * p.y + a.m[8]  * p.z + a.m[12],
+                a.m[1] * p.x + a.m[5] * p.y + a.m[9]  * p.z + a.m[13],
+                a.m[2] * p.x + a.m[6] * p.y + a.m[10] * p.z + a.m[14]);
+}
+
+// --- 轴对齐包围盒 ---
+struct AABB {
+    Vec3 min, max;
+};
+
+inline AABB aabbEmpty() {
+    AABB b = { vec3(FLT_MAX, FLT_MAX, FLT_MAX), vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX) };
+    return b;
+}
+inline void aabbExpand(AABB& b, const Vec3& p) { b.min = vmin(b.min, p); b.max = vmax(b.max, p); }
+inline void aabbMerge(AABB& b, const AABB& o) { b.min = vmin(b.min, o.min); b.max = vmax(b.max, o.max); }
+inline Vec3 aabbCenter(const AABB& b) { return (b.min + b.max) * 0.5f; }
+
+/**
+ * @brief 用仿射矩阵变换包围盒 (Arvo 方法), 结果仍是轴对齐的保守包围盒
+ */
+inline AABB aabbTransform(const Mat4& a, const AABB& b) {
+    AABB r;
+    r.min = r.max = vec3(a.m[12], a.m[13], a.m[14]);
+    const float* bmin = &b.min.x;
+    const float* bmax = &b.max.x;
+    float* rmin = &r.min.x;
+    float* rmax = &r.max.x;
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 3; ++col) {
+            float e = a.m[col * 4 + row] * bmin[col];
+            float f = a.m[col * 4 + row] * bmax[col];
+            rmin[row] += e < f ? e : f;
+            rmax[row] += e < f ? f : e;
+        }
+    }
+    return r;
+}
+
+// --- 视锥体 ---
+// 平面方程 n·p + d >= 0 表示点在平面内侧
+struct Plane { Vec3 n; float d; };
+
+struct Frustum {
+    Plane planes[6];
+};
+
+enum CullResult { CULL_OUTSIDE = 0, CULL_INTERSECT = 1, CULL_INSIDE = 2 };
+
+/**
+ * @brief 从 (投影 * 视图) 矩阵中提取六个裁剪平面 (Gribb-Hartmann 方法)
+ */
+inline Frustum frustumFromMatrix(const Mat4& vp) {
+    Frustum f;
+    const float* m = vp.m;
+    for (int i = 0; i < 6; ++i) {
+        int row = i / 2;
+        float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+        Plane& p = f.planes[i];
+        p.n = vec3(m[3] + sign * m[row], m[7] + sign * m[4 + row], m[11] + sign * m[8 + row]);
+        p.d = m[15] + sign * m[12 + row];
+        float inv = 1.0f / length(p.n);
+        p.n = p.n * inv;
+        p.d *= inv;
+    }
+    return f;
+}
+
+/**
+ * @brief 包围盒与视锥体求交
+ * planeMask 标记仍需检测的平面; 完全位于某平面内侧后会清除对应位,
+ * 这样 BVH 子节点就不必再检测父节点已完全通过的平面
+ */
+inline CullResult frustumTestAABB(const Frustum& f, const AABB& b, unsigned& planeMask) {
+    CullResult result = CULL_INSIDE;
+    for (int i = 0; i < 6; ++i) {
+        if (!(planeMask & (1u << i))) continue;
+        const Plane& p = f.planes[i];
+        // 沿法线方向最远/最近的两个顶点
+        Vec3 pos = vec3(p.n.x >= 0 ? b.max.x : b.min.x, p.n.y >= 0 ? b.max.y : b.min.y, p.n.z >= 0 ? b.max.z : b.min.z);
+        Vec3 neg = vec3(p.n.x >= 0 ? b.min.x : b.max.x, p.n.y >= 0 ? b.min.y : b.max.y, p.n.z >= 0 ? b.min.z : b.max.z);
+        if (dot(p.n, pos) + p.d < 0.0f) return CULL_OUTSIDE;
+        if (dot(p.n, neg) + p.d >= 0.0f) planeMask &= ~(1u << i);
+        else result = CULL_INTERSECT;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+// 线性 (bump) 分配器
+// 先根据计数预扫描的结果一次性申请整块内存, 之后的分配只是移动指针,
+// 释放时整块归还; 用于模型的常驻数据和加载期间的临时数据
+
+#include <cstdlib>
+#include <cstddef>
+#include <iostream>
+
+class MeshArena {
+public:
+    MeshArena() : base(0), capacity(0), used(0) {}
+    ~MeshArena() { release(); }
+
+    MeshArena(MeshArena&& other) noexcept : base(other.base), capacity(other.capacity), used(other.used) {
+        other.base = 0;
+        other.capacity = other.used = 0;
+    }
+    MeshArena& operator=(MeshArena&& other) noexcept {
+        if (this != &other) {
+            release();
+            base = other.base; capacity = other.capacity; used = other.used;
+            other.base = 0;
+            other.capacity = other.used = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief 一次性申请 bytes 字节 (之前的内容会被释放)
+     */
+    bool reserve(size_t bytes) {
+        release();
+        if (bytes == 0) return true;
+        base = static_cast<char*>(std::malloc(bytes));
+        if (!base) { std::cerr << "错误: 内存不足, 无法申请 " << bytes << " 字节" << std::endl; return false; }
+        capacity = bytes;
+        return true;
+    }
+
+    /**
+     * @brief 分配 count 个 T (按 ALIGNMENT 对齐), 空间不足时返回空指针
+     */
+    template <typename T>
+    T* alloc(size_t count) {
+        size_t offset = alignUp(used);
+        size_t bytes = count * sizeof(T);
+        if (offset + bytes > capacity) return 0;
+        used = offset + bytes;
+        return reinterpret_cast<T*>(base + offset);
+    }
+
+    /**
+     * @brief 整块归还内存
+     */
+    void release() {
+        std::free(base);
+        base = 0;
+        capacity = used = 0;
+    }
+
+    size_t bytesReserved() const { return capacity; }
+    size_t bytesUsed() const { return used; }
+
+    static const size_t ALIGNMENT = 16;
+
+    /**
+     * @brief 计算分配 count 个 T 需要预留的字节数 (含对齐余量), 用于 reserve 前累加
+     */
+    template <typename T>
+    static size_t footprint(size_t count) { return alignUp(count * sizeof(T)); }
+
+private:
+    MeshArena(const MeshArena&);
+    MeshArena& operator=(const MeshArena&);
+
+    static size_t alignUp(size_t n) { return (n + ALIGNMENT - 1) & ~(ALIGNMENT - 1); }
+
+    char* base;
+    size_t capacity;
+    size_t used;
+};
+
+#endif
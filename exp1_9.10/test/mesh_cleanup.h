@@ -0,0 +1,259 @@
+#ifndef MESH_CLEANUP_H
+#define MESH_CLEANUP_H
+
+// 上传前的网格清理: 删除退化三角形和重复三角形, 压缩没有被引用的顶点
+// 1. 并行: 标记退化三角形 (两个角是同一顶点或同一位置, 或者面积接近 0)
+// 2. 并行: 重复三角形按三个位置编号排序后的三元组比较, 与绕向无关;
+//    三元组按哈希分到若干分片, 每个分片一个哈希表, 保留索引缓冲中第一次出现的三角形
+// 3. 并行: 保留的三角形按原顺序压缩 (分段计数 + 前缀和), 材质区间随之收缩
+// 4. 并行: 没有被引用的顶点删除, 其余顶点保持原顺序重新编号并重映射索引, positionIndex 随顶点一起压缩
+//
+// 重复三角形以位置而不是 (v, vt, vn) 顶点判断: 扫描和导出数据中的重复面常常带有不同的法线或纹理坐标;
+// 同一材质内的先后顺序不变, 不同材质之间重复时保留材质编号较小的一个
+
+#include <vector>
+#include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "parallel_for.h"
+#include "obj_reader.h"
+#include "trace.h"
+
+struct CleanupOptions {
+    bool removeDegenerate;
+    bool removeDuplicates;
+    bool compactVertices;
+    float areaEpsilon;        // 面积 (叉积长度的一半) 不超过 areaEpsilon x 包围盒对角线长度的平方时视为退化
+    int threads;              // <= 0 表示使用调度器的全部线程
+
+    CleanupOptions() : removeDegenerate(true), removeDuplicates(true), compactVertices(true), areaEpsilon(1e-9f), threads(0) {}
+};
+
+struct CleanupResult {
+    size_t trianglesBefore, trianglesAfter;
+    size_t degenerate, duplicates;
+    size_t verticesBefore, verticesAfter;
+    double degenerateMs, duplicateMs, compactMs, totalMs;
+};
+
+// 排序后的三个位置编号
+struct CleanupTriKey {
+    unsigned a, b, c;
+    bool operator==(const CleanupTriKey& o) const { return a == o.a && b == o.b && c == o.c; }
+};
+
+struct CleanupTriKeyHash {
+    size_t operator()(const CleanupTriKey& k) const {
+        uint64_t h = ((uint64_t)k.a * 0x9E3779B97F4A7C15ull) ^ ((uint64_t)k.b * 0xC2B2AE3D27D4EB4Full) ^ ((uint64_t)k.c * 0x165667B19E3779F9ull);
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+/**
+ * @brief 清理 ObjModel (原地修改顶点、索引、positionIndex 和材质区间)
+ */
+inline CleanupResult cleanupObjModel(ObjModel& model, const CleanupOptions& opt) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    CleanupResult result;
+    size_t triangles = model.indices.size() / 3, n = model.vertexCount();
+    result.trianglesBefore = triangles;
+    result.verticesBefore = n;
+    result.degenerate = result.duplicates = 0;
+    int chunks = opt.threads > 0 ? opt.threads * 4 : jobSystem().threadCount() * 4;
+    size_t triChunk = (triangles + chunks - 1) / chunks;
+    const unsigned* idx = model.indices.empty() ? 0 : &model.indices[0];
+    const float* data = model.vertices.empty() ? 0 : &model.vertices[0];
+    bool hasPositionIndex = model.positionIndex.size() == n;
+
+    // 每个三角形: 0 = 保留, 1 = 退化, 2 = 重复
+    std::vector<uint8_t> drop(triangles, 0);
+    std::vector<CleanupTriKey> keys(triangles);
+
+    // --- 1. 退化三角形, 同时生成与绕向无关的位置三元组 ---
+    Vec3 extent = model.bounds.max - model.bounds.min;
+    float limit = extent.x >= 0.0f ? 2.0f * opt.areaEpsilon * dot(extent, extent) : 0.0f;   // 与叉积长度比较
+    parallelFor(triangles, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t t = begin; t < end; ++t) {
+            unsigned v[3] = { idx[t * 3], idx[t * 3 + 1], idx[t * 3 + 2] };
+            unsigned p[3];
+            for (int k = 0; k < 3; ++k) p[k] = hasPositionIndex ? model.positionIndex[v[k]] : v[k];
+            if (p[0] > p[1]) std::swap(p[0], p[1]);
+            if (p[1] > p[2]) std::swap(p[1], p[2]);
+            if (p[0] > p[1]) std::swap(p[0], p[1]);
+            CleanupTriKey key = { p[0], p[1], p[2] };
+            keys[t] = key;
+            if (!opt.removeDegenerate) continue;
+            if (p[0] == p[1] || p[1] == p[2]) { drop[t] = 1; continue; }
+            const float* a = data + (size_t)v[0] * OBJ_VERTEX_STRIDE;
+            const float* b = data + (size_t)v[1] * OBJ_VERTEX_STRIDE;
+            const float* c = data + (size_t)v[2] * OBJ_VERTEX_STRIDE;
+            Vec3 e1 = vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), e2 = vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]);
+            if (length(cross(e1, e2)) <= limit) drop[t] = 1;
+        }
+    });
+    Clock::time_point t1 = Clock::now();
+
+    // --- 2. 重复三角形 (只在非退化的三角形之间比较) ---
+    if (opt.removeDuplicates) {
+        const size_t shardBits = 6, shardCount = (size_t)1 << shardBits;
+        CleanupTriKeyHash hasher;
+        std::vector<uint8_t> shardOf(triangles);
+        std::vector<size_t> shardCounts((size_t)chunks * shardCount, 0);
+        parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(triangles, ch * triChunk), hi = std::min(triangles, lo + triChunk);
+                for (size_t t = lo; t < hi; ++t) {
+                    if (drop[t]) continue;
+                    uint64_t h = (uint64_t)hasher(keys[t]) * 0x9E3779B97F4A7C15ull;
+                    shardOf[t] = (uint8_t)(h >> (64 - shardBits));
+                    ++shardCounts[ch * shardCount + shardOf[t]];
+                }
+            }
+        });
+        // 分片内按 (段, 段内顺序) 排列, 即索引缓冲中的顺序
+        std::vector<size_t> shardStart(shardCount + 1, 0);
+        for (size_t s = 0; s < shardCount; ++s) {
+            size_t offset = shardStart[s];
+            for (int ch = 0; ch < chunks; ++ch) {
+                size_t count = shardCounts[ch * shardCount + s];
+                shardCounts[ch * shardCount + s] = offset;
+                offset += count;
+            }
+            shardStart[s + 1] = offset;
+        }
+        std::vector<unsigned> shardList(shardStart[shardCount]);
+        parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(triangles, ch * triChunk), hi = std::min(triangles, lo + triChunk);
+                size_t* cursor = &shardCounts[ch * shardCount];
+                for (size_t t = lo; t < hi; ++t)
+                    if (!drop[t]) shardList[cursor[shardOf[t]]++] = (unsigned)t;
+            }
+        });
+        parallelFor(shardCount, (int)shardCount, [&](size_t begin, size_t end, int) {
+            for (size_t s = begin; s < end; ++s) {
+                std::unordered_set<CleanupTriKey, CleanupTriKeyHash> seen;
+                seen.reserve(shardStart[s + 1] - shardStart[s]);
+                for (size_t k = shardStart[s]; k < shardStart[s + 1]; ++k) {
+                    unsigned t = shardList[k];
+                    if (!seen.insert(keys[t]).second) drop[t] = 2;
+                }
+            }
+        });
+    }
+    std::vector<CleanupTriKey>().swap(keys);
+    Clock::time_point t2 = Clock::now();
+
+    // --- 3. 压缩索引缓冲 (保持顺序), 重新计算材质区间 ---
+    std::vector<size_t> keptBefore(chunks + 1, 0);
+    std::vector<size_t> degenerateCounts(chunks, 0), duplicateCounts(chunks, 0);
+    parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t ch = begin; ch < end; ++ch) {
+            size_t lo = std::min(triangles, ch * triChunk), hi = std::min(triangles, lo + triChunk), kept = 0;
+            for (size_t t = lo; t < hi; ++t) {
+                if (drop[t] == 0) ++kept;
+                else if (drop[t] == 1) ++degenerateCounts[ch];
+                else ++duplicateCounts[ch];
+            }
+            keptBefore[ch + 1] = kept;
+        }
+    });
+    for (int ch = 0; ch < chunks; ++ch) {
+        keptBefore[ch + 1] += keptBefore[ch];
+        result.degenerate += degenerateCounts[ch];
+        result.duplicates += duplicateCounts[ch];
+    }
+    size_t keptTriangles = keptBefore[chunks];
+    // 三角形 t 之前保留了多少个三角形 (t = 0 .. triangles), 用于换算材质区间
+    std::vector<unsigned> newTri(triangles + 1);
+    std::vector<unsigned> indices(keptTriangles * 3);
+    parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t ch = begin; ch < end; ++ch) {
+            size_t lo = std::min(triangles, ch * triChunk), hi = std::min(triangles, lo + triChunk);
+            unsigned next = (unsigned)keptBefore[ch];
+            for (size_t t = lo; t < hi; ++t) {
+                newTri[t] = next;
+                if (drop[t]) continue;
+                indices[next * 3] = idx[t * 3];
+                indices[next * 3 + 1] = idx[t * 3 + 1];
+                indices[next * 3 + 2] = idx[t * 3 + 2];
+                ++next;
+            }
+        }
+    });
+    newTri[triangles] = (unsigned)keptTriangles;
+    std::vector<ObjRange> ranges;
+    for (size_t i = 0; i < model.ranges.size(); ++i) {
+        ObjRange r = model.ranges[i];
+        unsigned first = newTri[r.firstIndex / 3], last = newTri[(r.firstIndex + r.indexCount) / 3];
+        if (last == first) continue;
+        r.firstIndex = first * 3;
+        r.indexCount = (last - first) * 3;
+        ranges.push_back(r);
+    }
+    model.indices.swap(indices);
+    model.ranges.swap(ranges);
+    std::vector<uint8_t>().swap(drop);
+    std::vector<unsigned>().swap(newTri);
+
+    // --- 4. 压缩顶点: 被引用的顶点按原顺序获得新编号 (分段前缀和) ---
+    if (opt.compactVertices && n > 0) {
+        std::vector<std::atomic<uint8_t> > used(n);
+        for (size_t i = 0; i < n; ++i) used[i].store(0, std::memory_order_relaxed);
+        parallelFor(model.indices.size(), chunks, [&](size_t begin, size_t end, int) {
+            for (size_t i = begin; i < end; ++i) used[model.indices[i]].store(1, std::memory_order_relaxed);
+        });
+        size_t vchunk = (n + chunks - 1) / chunks;
+        std::vector<size_t> usedBefore(chunks + 1, 0);
+        parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(n, ch * vchunk), hi = std::min(n, lo + vchunk), count = 0;
+                for (size_t i = lo; i < hi; ++i) count += used[i].load(std::memory_order_relaxed);
+                usedBefore[ch + 1] = count;
+            }
+        });
+        for (int ch = 0; ch < chunks; ++ch) usedBefore[ch + 1] += usedBefore[ch];
+        size_t kept = usedBefore[chunks];
+        if (kept < n) {
+            std::vector<unsigned> remap(n);
+            std::vector<float> vertices(kept * OBJ_VERTEX_STRIDE);
+            std::vector<unsigned> positionIndex(hasPositionIndex ? kept : 0);
+            parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+                for (size_t ch = begin; ch < end; ++ch) {
+                    size_t lo = std::min(n, ch * vchunk), hi = std::min(n, lo + vchunk);
+                    unsigned next = (unsigned)usedBefore[ch];
+                    for (size_t i = lo; i < hi; ++i) {
+                        if (!used[i].load(std::memory_order_relaxed)) continue;
+                        remap[i] = next;
+                        std::memcpy(&vertices[(size_t)next * OBJ_VERTEX_STRIDE], data + i * OBJ_VERTEX_STRIDE, OBJ_VERTEX_STRIDE * sizeof(float));
+                        if (hasPositionIndex) positionIndex[next] = model.positionIndex[i];
+                        ++next;
+                    }
+                }
+            });
+            parallelFor(model.indices.size(), chunks, [&](size_t begin, size_t end, int) {
+                for (size_t i = begin; i < end; ++i) model.indices[i] = remap[model.indices[i]];
+            });
+            model.vertices.swap(vertices);
+            if (hasPositionIndex) model.positionIndex.swap(positionIndex);
+        }
+    }
+    Clock::time_point t3 = Clock::now();
+
+    result.trianglesAfter = keptTriangles;
+    result.verticesAfter = model.vertexCount();
+    result.degenerateMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.duplicateMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    result.compactMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    result.totalMs = std::chrono::duration<double, std::milli>(t3 - t0).count();
+    return result;
+}
+
+#endif
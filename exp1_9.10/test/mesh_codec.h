@@ -0,0 +1,802 @@
+#ifndef MESH_CODEC_H
+#define MESH_CODEC_H
+
+// 紧凑的二进制网格格式 (.meshc), 代替文本 OBJ 存放在磁盘上, 缩短冷缓存 (网络存储) 时的加载时间
+// 编码分三层, 解码时各层都是顺序扫描. 顶点每 MESHC_VERTEX_BLOCK 个、三角形每 MESHC_TRIANGLE_BLOCK 个分为一块,
+// 每块的字节流单独编码, 块之间没有依赖: 解码时每块是一个任务, 所有线程同时解码, 每块的中间数据也留在缓存中:
+// 1. 顶点: 按索引缓冲中第一次出现的顺序重排; 位置按包围盒量化为整数, 法线用八面体映射量化, 纹理坐标按取值范围量化;
+//    每个分量与上一个顶点做差 (16 位回绕算术, 无损), zigzag 后拆成低字节和高字节两个平面.
+//    相邻顶点在空间上接近, 差值很小, 高字节平面几乎全是 0
+// 2. 索引: 利用三角形邻接关系的边 FIFO 编码. 每个三角形先在最近的 15 条边中查找共享边,
+//    找到时只需编码第三个顶点: 下一个新顶点 (重排后新顶点总是按顺序出现) / 最近 14 个顶点之一 / 显式差值,
+//    这样大部分三角形只需要一个字节. 三角形的顶点可能被轮换 (绕序不变)
+// 3. 熵编码: 每个字节流单独做 order-0 rANS (12 位概率, 4 路交错, 按字节输出); 节省不到 1/16 的流原样存储
+//
+// 有损部分只有量化 (默认位置 16 位, 误差不超过包围盒边长的 1/131070); 材质与材质区间原样保存, g / o 分组名不保存;
+// positionIndex 不保存, 需要时解码后用 meshcBuildPositionIndex 重建
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "obj_reader.h"
+#include "parallel_for.h"
+#include "trace.h"
+
+const char MESHC_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+const uint32_t MESHC_VERSION = 2;         // 2: 顶点和三角形分块, 各块独立解码
+const int MESHC_CHANNELS = 7;             // px py pz 八面体 u v 纹理 u v
+const int MESHC_PLANES = MESHC_CHANNELS * 2;        // 每个分量两个字节平面
+const size_t MESHC_VERTEX_BLOCK = 65536;            // 每块的顶点数; 块内第一个顶点与 0 做差
+const size_t MESHC_TRIANGLE_BLOCK = 65536;          // 每块的三角形数; 块内边 FIFO 和顶点 FIFO 从空开始
+const int MESHC_EDGE_FIFO = 16;
+const int MESHC_VERTEX_FIFO = 16;
+
+const uint32_t RANS_SCALE_BITS = 12;
+const uint32_t RANS_SCALE = 1u << RANS_SCALE_BITS;
+const uint32_t RANS_L = 1u << 23;         // 状态的下界; 按字节输出时状态保持在 [L, 256L)
+
+enum MeshcStreamMode { MESHC_STREAM_RAW = 0, MESHC_STREAM_RANS = 1 };
+
+struct MeshcOptions {
+    int positionBits;    // 1..16
+    int normalBits;      // 每个八面体分量
+    int texcoordBits;
+
+    MeshcOptions() : positionBits(16), normalBits(12), texcoordBits(14) {}
+};
+
+struct MeshcStats {
+    size_t vertexBytes, indexBytes;       // 顶点平面 / 索引流编码后的字节数
+    size_t encodedBytes;                  // 整个文件
+    size_t rawBytes;                      // 解码后的交错顶点 + 索引
+    double ms;                            // 编码或解码耗时
+};
+
+// --- 字节流读写 ---
+inline void meshcPutU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+inline void meshcPutVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+    out.push_back((uint8_t)v);
+}
+
+inline void meshcPutFloat(std::vector<uint8_t>& out, float f) {
+    uint32_t v;
+    memcpy(&v, &f, 4);
+    meshcPutU32(out, v);
+}
+
+inline void meshcPutString(std::vector<uint8_t>& out, const std::string& s) {
+    meshcPutVarint(out, (uint32_t)s.size());
+    out.insert(out.end(), s.begin(), s.end());
+}
+
+// 带边界检查的读取游标; 越界后 ok 变为 false, 之后读到的都是 0
+struct MeshcReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok;
+
+    MeshcReader(const uint8_t* data, size_t size) : p(data), end(data + size), ok(true) {}
+
+    const uint8_t* bytes(size_t n) {
+        if (!ok || (size_t)(end - p) < n) { ok = false; return 0; }
+        const uint8_t* r = p;
+        p += n;
+        return r;
+    }
+    uint8_t u8() { const uint8_t* b = bytes(1); return b ? b[0] : 0; }
+    uint32_t u32() {
+        const uint8_t* b = bytes(4);
+        return b ? (uint32_t)b[0] | ((uint32_t)b[1] << 8) | ((uint32_t)b[2] << 16) | ((uint32_t)b[3] << 24) : 0;
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = u8();
+            v |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    float f32() { uint32_t v = u32(); float f; memcpy(&f, &v, 4); return f; }
+    std::string str() {
+        uint32_t n = varint();
+        const uint8_t* b = bytes(n);
+        return b ? std::string((const char*)b, n) : std::string();
+    }
+};
+
+inline uint32_t meshcZigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t meshcUnzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// --- rANS ---
+
+/**
+ * @brief 把符号计数归一化为和为 RANS_SCALE 的频率, 出现过的符号频率至少为 1
+ */
+inline void ransNormalize(const uint32_t* counts, size_t total, uint32_t* freq) {
+    uint32_t sum = 0;
+    int largest = -1;
+    for (int s = 0; s < 256; ++s) {
+        freq[s] = 0;
+        if (!counts[s]) continue;
+        freq[s] = (uint32_t)std::max<uint64_t>(1, (uint64_t)counts[s] * RANS_SCALE / total);
+        sum += freq[s];
+        if (largest < 0 || counts[s] > counts[largest]) largest = s;
+    }
+    if (sum < RANS_SCALE) freq[largest] += RANS_SCALE - sum;
+    while (sum > RANS_SCALE) {   // 许多稀有符号被提升到 1 时, 从当前频率最大的符号中扣除
+        int top = 0;
+        for (int s = 1; s < 256; ++s) if (freq[s] > freq[top]) top = s;
+        --freq[top];
+        --sum;
+    }
+}
+
+/**
+ * @brief 编码一个字节流并追加到 out: 模式, 原始长度, 负载长度, 负载
+ * rANS 负载: 32 字节的符号位图 + 各符号频率 (varint) + 4 个初始状态 + 按解码顺序排列的字节
+ */
+inline void meshcEncodeStream(const uint8_t* data, size_t n, std::vector<uint8_t>& out) {
+    std::vector<uint8_t> payload;
+    if (n >= 64) {
+        uint32_t counts[256] = { 0 }, freq[256], start[256];
+        for (size_t i = 0; i < n; ++i) ++counts[data[i]];
+        ransNormalize(counts, n, freq);
+        uint8_t present[32] = { 0 };
+        for (int s = 0, cum = 0; s < 256; ++s) {
+            start[s] = cum;
+            cum += freq[s];
+            if (freq[s]) present[s >> 3] |= (uint8_t)(1 << (s & 7));
+        }
+        payload.insert(payload.end(), present, present + 32);
+        for (int s = 0; s < 256; ++s) if (freq[s]) meshcPutVarint(payload, freq[s]);
+
+        // 从末尾向前编码, 字节也从后向前写, 解码时即可顺序读取
+        std::vector<uint8_t> buffer(n * 2 + 64);
+        uint8_t* end = &buffer[0] + buffer.size();
+        uint8_t* ptr = end;
+        uint32_t x[4] = { RANS_L, RANS_L, RANS_L, RANS_L };
+        for (size_t i = n; i-- > 0; ) {
+            uint32_t& st = x[i & 3];
+            uint32_t f = freq[data[i]];
+            uint32_t xmax = ((RANS_L >> RANS_SCALE_BITS) << 8) * f;
+            while (st >= xmax) { *--ptr = (uint8_t)st; st >>= 8; }
+            st = ((st / f) << RANS_SCALE_BITS) + (st % f) + start[data[i]];
+        }
+        for (int k = 3; k >= 0; --k) {
+            ptr -= 4;
+            for (int b = 0; b < 4; ++b) ptr[b] = (uint8_t)(x[k] >> (8 * b));
+        }
+        payload.insert(payload.end(), ptr, end);
+    }
+    // 只有节省超过 1/16 时才用 rANS: 原样存储的流解码只是一次 memcpy, 比逐字节的 rANS 快得多
+    bool rans = !payload.empty() && payload.size() + n / 16 < n;
+    out.push_back(rans ? MESHC_STREAM_RANS : MESHC_STREAM_RAW);
+    meshcPutVarint(out, (uint32_t)n);
+    if (rans) {
+        meshcPutVarint(out, (uint32_t)payload.size());
+        out.insert(out.end(), payload.begin(), payload.end());
+    } else {
+        meshcPutVarint(out, (uint32_t)n);
+        out.insert(out.end(), data, data + n);
+    }
+}
+
+// 解码表的一项: 槽位 -> (符号, 频率, 槽位在符号区间内的偏移)
+struct RansSlot {
+    uint16_t freq, bias;
+    uint8_t symbol;
+};
+
+// 文件中一个编码后的字节流: 先顺序读出各个流的位置, 再各自 (并行) 解码
+struct MeshcStreamRef {
+    uint8_t mode;
+    uint32_t size;            // 原始长度
+    const uint8_t* payload;
+    uint32_t payloadSize;
+};
+
+inline bool meshcReadStreamRef(MeshcReader& in, MeshcStreamRef& ref) {
+    ref.mode = in.u8();
+    ref.size = in.varint();
+    ref.payloadSize = in.varint();
+    ref.payload = in.bytes(ref.payloadSize);
+    return in.ok;
+}
+
+/**
+ * @brief 解码一个字节流到 out (大小为原始长度)
+ */
+inline bool meshcDecodeStream(const MeshcStreamRef& ref, std::vector<uint8_t>& out) {
+    uint32_t n = ref.size, payloadSize = ref.payloadSize;
+    const uint8_t* payload = ref.payload;
+    out.resize(n);
+    if (ref.mode == MESHC_STREAM_RAW) {
+        if (payloadSize != n) return false;
+        if (n) memcpy(&out[0], payload, n);
+        return true;
+    }
+    if (ref.mode != MESHC_STREAM_RANS) return false;
+
+    MeshcReader r(payload, payloadSize);
+    const uint8_t* present = r.bytes(32);
+    if (!present) return false;
+    static thread_local RansSlot slots[RANS_SCALE];
+    uint32_t cum = 0;
+    for (int s = 0; s < 256 && r.ok; ++s) {
+        if (!(present[s >> 3] & (1 << (s & 7)))) continue;
+        uint32_t f = r.varint();
+        if (f == 0 || cum + f > RANS_SCALE) return false;
+        for (uint32_t k = 0; k < f; ++k) {
+            RansSlot& slot = slots[cum + k];
+            slot.freq = (uint16_t)f;
+            slot.bias = (uint16_t)k;
+            slot.symbol = (uint8_t)s;
+        }
+        cum += f;
+    }
+    uint32_t x[4];
+    for (int k = 0; k < 4; ++k) x[k] = r.u32();
+    if (!r.ok || cum != RANS_SCALE) return false;
+    if (slots[0].freq == RANS_SCALE) {   // 只有一个符号 (例如平滑网格的高字节平面全是 0): 状态不会变化, 也不消耗字节
+        if (n) memset(&out[0], slots[0].symbol, n);
+        return r.p == r.end;
+    }
+
+    const uint8_t* p = r.p;
+    const uint8_t* end = r.end;
+    uint8_t* dst = n ? &out[0] : 0;
+    // 4 个状态互不依赖, 展开后 CPU 可以重叠执行它们的查表和乘法
+#define MESHC_RANS_STEP(st, i)                                                      \
+    {                                                                               \
+        const RansSlot& slot = slots[st & (RANS_SCALE - 1)];                        \
+        dst[i] = slot.symbol;                                                       \
+        st = slot.freq * (st >> RANS_SCALE_BITS) + slot.bias;                       \
+        while (st < RANS_L && p < end) st = (st << 8) | *p++;                       \
+    }
+    uint32_t x0 = x[0], x1 = x[1], x2 = x[2], x3 = x[3];
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        MESHC_RANS_STEP(x0, i);
+        MESHC_RANS_STEP(x1, i + 1);
+        MESHC_RANS_STEP(x2, i + 2);
+        MESHC_RANS_STEP(x3, i + 3);
+    }
+    uint32_t* tail[4] = { &x0, &x1, &x2, &x3 };
+    for (; i < n; ++i) MESHC_RANS_STEP(*tail[i & 3], i);
+#undef MESHC_RANS_STEP
+    return p == end;
+}
+
+// --- 量化 ---
+struct MeshcQuantizer {
+    float posMin[3], posStep[3];
+    float uvMin[2], uvStep[2];
+    uint32_t normalMax;
+};
+
+inline uint16_t meshcQuantize(float v, float minValue, float step) {
+    if (step <= 0.0f) return 0;
+    float q = std::floor((v - minValue) / step + 0.5f);
+    return (uint16_t)std::min(std::max(q, 0.0f), 65535.0f);
+}
+
+/**
+ * @brief 八面体映射: 单位向量 -> [0, normalMax]^2
+ */
+inline void meshcEncodeNormal(const float* n, uint32_t normalMax, uint16_t* q) {
+    float len = std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]);
+    float x = len > 0.0f ? n[0] / len : 0.0f, y = len > 0.0f ? n[1] / len : 0.0f, z = len > 0.0f ? n[2] / len : 1.0f;
+    if (z < 0.0f) {
+        float ox = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    q[0] = (uint16_t)std::floor((x * 0.5f + 0.5f) * normalMax + 0.5f);
+    q[1] = (uint16_t)std::floor((y * 0.5f + 0.5f) * normalMax + 0.5f);
+}
+
+inline void meshcDecodeNormal(uint32_t qx, uint32_t qy, float invNormalMax, float* n) {
+    float x = qx * invNormalMax * 2.0f - 1.0f, y = qy * invNormalMax * 2.0f - 1.0f;
+    float z = 1.0f - std::fabs(x) - std::fabs(y);
+    float t = z < 0.0f ? -z : 0.0f;
+    x += x >= 0.0f ? -t : t;
+    y += y >= 0.0f ? -t : t;
+    float inv = 1.0f / std::sqrt(x * x + y * y + z * z);
+    n[0] = x * inv; n[1] = y * inv; n[2] = z * inv;
+}
+
+// 合并一个分量第 i 个值的低/高字节, 还原 zigzag, 加上前一个量化值
+inline uint16_t meshcUndelta(const uint8_t* lo, const uint8_t* hi, size_t i, uint16_t prev) {
+    uint16_t z = (uint16_t)(lo[i] | (hi[i] << 8));
+    return (uint16_t)(prev + (uint16_t)((z >> 1) ^ (uint16_t)-(int16_t)(z & 1)));
+}
+
+/**
+ * @brief 解码一块顶点: refs 为这一块的 MESHC_PLANES 个字节流, 还原 n 个交错顶点到 dst
+ * 位置、法线、纹理坐标各一个循环, 在整块上累加差值并反量化; range 输出量化位置的最小值 (0..2) 和最大值 (3..5)
+ */
+inline bool meshcDecodeVertices(const MeshcStreamRef* refs, size_t n, const MeshcQuantizer& qz, float* dst, uint16_t* range) {
+    TRACE_FUNCTION();
+    static thread_local std::vector<uint8_t> planes[MESHC_PLANES];   // 每个线程一份, 不超过一块, 反复使用不再分配
+    for (int c = 0; c < MESHC_PLANES; ++c)
+        if (!meshcDecodeStream(refs[c], planes[c])) return false;
+    const uint8_t* lo[MESHC_CHANNELS];
+    const uint8_t* hi[MESHC_CHANNELS];
+    for (int c = 0; c < MESHC_CHANNELS; ++c) {
+        lo[c] = &planes[c * 2][0];
+        hi[c] = &planes[c * 2 + 1][0];
+    }
+
+    uint16_t px = 0, py = 0, pz = 0;
+    uint16_t qmin[3] = { 65535, 65535, 65535 }, qmax[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < n; ++i) {
+        px = meshcUndelta(lo[0], hi[0], i, px);
+        py = meshcUndelta(lo[1], hi[1], i, py);
+        pz = meshcUndelta(lo[2], hi[2], i, pz);
+        float* v = dst + i * OBJ_VERTEX_STRIDE;
+        v[0] = qz.posMin[0] + px * qz.posStep[0];
+        v[1] = qz.posMin[1] + py * qz.posStep[1];
+        v[2] = qz.posMin[2] + pz * qz.posStep[2];
+        qmin[0] = std::min(qmin[0], px); qmax[0] = std::max(qmax[0], px);
+        qmin[1] = std::min(qmin[1], py); qmax[1] = std::max(qmax[1], py);
+        qmin[2] = std::min(qmin[2], pz); qmax[2] = std::max(qmax[2], pz);
+    }
+    const float invNormalMax = qz.normalMax ? 1.0f / qz.normalMax : 0.0f;
+    uint16_t nx = 0, ny = 0;
+    for (size_t i = 0; i < n; ++i) {
+        nx = meshcUndelta(lo[3], hi[3], i, nx);
+        ny = meshcUndelta(lo[4], hi[4], i, ny);
+        meshcDecodeNormal(nx, ny, invNormalMax, dst + i * OBJ_VERTEX_STRIDE + 3);
+    }
+    uint16_t tu = 0, tv = 0;
+    for (size_t i = 0; i < n; ++i) {
+        tu = meshcUndelta(lo[5], hi[5], i, tu);
+        tv = meshcUndelta(lo[6], hi[6], i, tv);
+        dst[i * OBJ_VERTEX_STRIDE + 6] = qz.uvMin[0] + tu * qz.uvStep[0];
+        dst[i * OBJ_VERTEX_STRIDE + 7] = qz.uvMin[1] + tv * qz.uvStep[1];
+    }
+    for (int k = 0; k < 3; ++k) {
+        range[k] = qmin[k];
+        range[3 + k] = qmax[k];
+    }
+    return true;
+}
+
+// --- 索引编码 ---
+// 编码字节: 高 4 位为共享边在边 FIFO 中的位置 (0 为最近), 15 表示没有共享边;
+// 低 4 位为第三个顶点: 0 = 下一个新顶点, 1..14 = 顶点 FIFO 中的位置, 15 = 数据流中的显式差值 (zigzag varint).
+// 没有共享边时编码字节为 0xF0, 三个顶点各用一个同样含义的字节写在数据流中
+struct MeshcIndexState {
+    unsigned edges[MESHC_EDGE_FIFO][2];
+    unsigned vertices[MESHC_VERTEX_FIFO];
+    unsigned edgeHead, vertexHead;
+    unsigned next;        // 下一个新顶点
+    unsigned last;        // 上一个编码的顶点, 显式差值相对于它
+
+    MeshcIndexState() : edgeHead(0), vertexHead(0), next(0), last(0) {
+        memset(edges, 0xff, sizeof(edges));
+        memset(vertices, 0xff, sizeof(vertices));
+    }
+    void pushEdge(unsigned a, unsigned b) {
+        edges[edgeHead][0] = a;
+        edges[edgeHead][1] = b;
+        edgeHead = (edgeHead + 1) % MESHC_EDGE_FIFO;
+    }
+    void pushVertex(unsigned v) {
+        vertices[vertexHead] = v;
+        vertexHead = (vertexHead + 1) % MESHC_VERTEX_FIFO;
+    }
+    const unsigned* edge(int i) const { return edges[(edgeHead + MESHC_EDGE_FIFO - 1 - i) % MESHC_EDGE_FIFO]; }
+    unsigned vertex(int i) const { return vertices[(vertexHead + MESHC_VERTEX_FIFO - 1 - i) % MESHC_VERTEX_FIFO]; }
+};
+
+inline uint8_t meshcEncodeVertexRef(MeshcIndexState& st, unsigned v, std::vector<uint8_t>& data) {
+    uint8_t code = 15;
+    if (v == st.next) {
+        code = 0;
+        ++st.next;
+    } else {
+        for (int i = 0; i < 14; ++i) if (st.vertex(i) == v) { code = (uint8_t)(i + 1); break; }
+        if (code == 15) meshcPutVarint(data, meshcZigzag((int32_t)(v - st.last)));
+    }
+    if (code == 0 || code == 15) st.pushVertex(v);
+    st.last = v;
+    return code;
+}
+
+/**
+ * @brief 编码一块三角形; next 为这一块之前已经出现过的顶点数, 返回这一块之后的值
+ */
+inline unsigned meshcEncodeIndices(const unsigned* indices, size_t count, unsigned next, std::vector<uint8_t>& codes,
+                                   std::vector<uint8_t>& data) {
+    MeshcIndexState st;
+    st.next = next;
+    codes.reserve(count / 3);
+    for (size_t t = 0; t + 2 < count; t += 3) {
+        const unsigned* tri = indices + t;
+        int fe = -1, rot = 0;
+        for (int i = 0; i < 15 && fe < 0; ++i) {
+            const unsigned* e = st.edge(i);
+            for (int r = 0; r < 3; ++r)
+                if (tri[r] == e[0] && tri[(r + 1) % 3] == e[1]) { fe = i; rot = r; break; }
+        }
+        if (fe >= 0) {
+            unsigned a = tri[rot], b = tri[(rot + 1) % 3], c = tri[(rot + 2) % 3];
+            codes.push_back((uint8_t)((fe << 4) | meshcEncodeVertexRef(st, c, data)));
+            st.pushEdge(c, b);
+            st.pushEdge(a, c);
+        } else {
+            codes.push_back(0xF0);
+            for (int k = 0; k < 3; ++k) {
+                size_t at = data.size();
+                data.push_back(0);
+                uint8_t code = meshcEncodeVertexRef(st, tri[k], data);   // 显式差值紧跟在它的编码字节之后
+                data[at] = code;
+            }
+            st.pushEdge(tri[1], tri[0]);
+            st.pushEdge(tri[2], tri[1]);
+            st.pushEdge(tri[0], tri[2]);
+        }
+    }
+    return st.next;
+}
+
+inline bool meshcDecodeVertexRef(MeshcIndexState& st, uint8_t code, MeshcReader& data, unsigned& v) {
+    if (code == 0) v = st.next++;
+    else if (code < 15) v = st.vertex(code - 1);
+    else v = st.last + (unsigned)meshcUnzigzag(data.varint());
+    if (code == 0 || code == 15) st.pushVertex(v);
+    st.last = v;
+    return data.ok;
+}
+
+/**
+ * @brief 解码一块三角形 (编码流 codeRef, 数据流 dataRef) 到 indices; next 与编码时相同
+ */
+inline bool meshcDecodeIndices(const MeshcStreamRef& codeRef, const MeshcStreamRef& dataRef, unsigned* indices,
+                               size_t triangles, unsigned next, unsigned vertexCount) {
+    TRACE_FUNCTION();
+    static thread_local std::vector<uint8_t> codes, dataStream;   // 每个线程一份, 反复使用不再分配
+    if (!meshcDecodeStream(codeRef, codes) || !meshcDecodeStream(dataRef, dataStream) || codes.size() != triangles) return false;
+    MeshcIndexState st;
+    st.next = next;
+    MeshcReader data(dataStream.empty() ? 0 : &dataStream[0], dataStream.size());
+    for (size_t t = 0; t < codes.size(); ++t) {
+        uint8_t code = codes[t];
+        unsigned* tri = indices + t * 3;
+        if ((code >> 4) != 15) {
+            const unsigned* e = st.edge(code >> 4);
+            tri[0] = e[0];
+            tri[1] = e[1];
+            if (!meshcDecodeVertexRef(st, code & 15, data, tri[2])) return false;
+            st.pushEdge(tri[2], tri[1]);
+            st.pushEdge(tri[0], tri[2]);
+        } else {
+            for (int k = 0; k < 3; ++k)
+                if (!meshcDecodeVertexRef(st, data.u8(), data, tri[k])) return false;
+            st.pushEdge(tri[1], tri[0]);
+            st.pushEdge(tri[2], tri[1]);
+            st.pushEdge(tri[0], tri[2]);
+        }
+        if (tri[0] >= vertexCount || tri[1] >= vertexCount || tri[2] >= vertexCount) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 编码模型, 结果写入 out; 返回各部分的字节数和耗时
+ */
+inline MeshcStats encodeMesh(const ObjModel& model, const MeshcOptions& opt, std::vector<uint8_t>& out) {
+    TRACE_FUNCTION();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    MeshcStats stats = { 0, 0, 0, 0, 0.0 };
+    const size_t vertexCount = model.vertexCount(), indexCount = model.indices.size();
+    stats.rawBytes = model.vertices.size() * sizeof(float) + indexCount * sizeof(unsigned);
+
+    // --- 1. 按第一次出现的顺序重排顶点; 没有被引用的顶点排在最后 ---
+    std::vector<unsigned> remap(vertexCount, ~0u), order;
+    order.reserve(vertexCount);
+    std::vector<unsigned> indices(indexCount);
+    for (size_t i = 0; i < indexCount; ++i) {
+        unsigned v = model.indices[i];
+        if (remap[v] == ~0u) { remap[v] = (unsigned)order.size(); order.push_back(v); }
+        indices[i] = remap[v];
+    }
+    for (size_t v = 0; v < vertexCount; ++v)
+        if (remap[v] == ~0u) { remap[v] = (unsigned)order.size(); order.push_back((unsigned)v); }
+
+    // --- 2. 量化参数 ---
+    MeshcQuantizer qz;
+    float uvLo[2] = { FLT_MAX, FLT_MAX }, uvHi[2] = { -FLT_MAX, -FLT_MAX };
+    for (size_t v = 0; v < vertexCount; ++v)
+        for (int k = 0; k < 2; ++k) {
+            float t = model.vertices[v * OBJ_VERTEX_STRIDE + 6 + k];
+            uvLo[k] = std::min(uvLo[k], t);
+            uvHi[k] = std::max(uvHi[k], t);
+        }
+    const float* lo = &model.bounds.min.x;
+    const float* hi = &model.bounds.max.x;
+    float posMax = (float)((1u << opt.positionBits) - 1), uvMax = (float)((1u << opt.texcoordBits) - 1);
+    for (int k = 0; k < 3; ++k) {
+        qz.posMin[k] = vertexCount ? lo[k] : 0.0f;
+        qz.posStep[k] = vertexCount ? (hi[k] - lo[k]) / posMax : 0.0f;
+    }
+    for (int k = 0; k < 2; ++k) {
+        qz.uvMin[k] = vertexCount ? uvLo[k] : 0.0f;
+        qz.uvStep[k] = vertexCount ? (uvHi[k] - uvLo[k]) / uvMax : 0.0f;
+    }
+    qz.normalMax = (1u << opt.normalBits) - 1;
+
+    // --- 3. 量化 + 差分 + zigzag, 拆成字节平面 (每块的第一个顶点与 0 做差) ---
+    std::vector<uint8_t> planes[MESHC_PLANES];
+    for (int c = 0; c < MESHC_PLANES; ++c) planes[c].resize(vertexCount);
+    uint16_t prev[MESHC_CHANNELS] = { 0 };
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (i % MESHC_VERTEX_BLOCK == 0) memset(prev, 0, sizeof(prev));
+        const float* src = &model.vertices[order[i] * OBJ_VERTEX_STRIDE];
+        uint16_t q[MESHC_CHANNELS];
+        for (int k = 0; k < 3; ++k) q[k] = meshcQuantize(src[k], qz.posMin[k], qz.posStep[k]);
+        meshcEncodeNormal(src + 3, qz.normalMax, q + 3);
+        for (int k = 0; k < 2; ++k) q[5 + k] = meshcQuantize(src[6 + k], qz.uvMin[k], qz.uvStep[k]);
+        for (int c = 0; c < MESHC_CHANNELS; ++c) {
+            uint16_t d = (uint16_t)(q[c] - prev[c]);
+            uint16_t z = (uint16_t)((d << 1) ^ (uint16_t)((int16_t)d >> 15));
+            planes[c * 2][i] = (uint8_t)z;
+            planes[c * 2 + 1][i] = (uint8_t)(z >> 8);
+            prev[c] = q[c];
+        }
+    }
+
+    // --- 4. 头部 + 材质, 然后是各块顶点熵编码后的字节平面 ---
+    out.clear();
+    for (int i = 0; i < 4; ++i) out.push_back((uint8_t)MESHC_MAGIC[i]);
+    meshcPutU32(out, MESHC_VERSION);
+    meshcPutVarint(out, (uint32_t)vertexCount);
+    meshcPutVarint(out, (uint32_t)indexCount);
+    for (int k = 0; k < 3; ++k) { meshcPutFloat(out, qz.posMin[k]); meshcPutFloat(out, qz.posStep[k]); }
+    for (int k = 0; k < 2; ++k) { meshcPutFloat(out, qz.uvMin[k]); meshcPutFloat(out, qz.uvStep[k]); }
+    meshcPutVarint(out, qz.normalMax);
+    meshcPutVarint(out, (uint32_t)model.materials.size());
+    for (size_t m = 0; m < model.materials.size(); ++m) {
+        const ObjMaterial& mat = model.materials[m];
+        meshcPutString(out, mat.name);
+        for (int k = 0; k < 3; ++k) meshcPutFloat(out, mat.ambient[k]);
+        for (int k = 0; k < 3; ++k) meshcPutFloat(out, mat.diffuse[k]);
+        for (int k = 0; k < 3; ++k) meshcPutFloat(out, mat.specular[k]);
+        meshcPutFloat(out, mat.shininess);
+        meshcPutFloat(out, mat.opacity);
+        meshcPutString(out, mat.diffuseMap);
+    }
+    meshcPutVarint(out, (uint32_t)model.ranges.size());
+    for (size_t r = 0; r < model.ranges.size(); ++r) {
+        meshcPutVarint(out, (uint32_t)model.ranges[r].material);
+        meshcPutVarint(out, model.ranges[r].firstIndex);
+        meshcPutVarint(out, model.ranges[r].indexCount);
+    }
+    size_t before = out.size();
+    for (size_t first = 0; first < vertexCount; first += MESHC_VERTEX_BLOCK) {
+        size_t count = std::min(MESHC_VERTEX_BLOCK, vertexCount - first);
+        for (int c = 0; c < MESHC_PLANES; ++c) meshcEncodeStream(&planes[c][first], count, out);
+    }
+    stats.vertexBytes = out.size() - before;
+
+    // --- 5. 索引: 每块写出块前已经出现过的顶点数, 然后是编码流和数据流 ---
+    before = out.size();
+    const size_t triangles = indexCount / 3;
+    unsigned next = 0;
+    for (size_t first = 0; first < triangles; first += MESHC_TRIANGLE_BLOCK) {
+        size_t count = std::min(MESHC_TRIANGLE_BLOCK, triangles - first);
+        std::vector<uint8_t> codes, data;
+        meshcPutVarint(out, next);
+        next = meshcEncodeIndices(&indices[first * 3], count * 3, next, codes, data);
+        meshcEncodeStream(codes.empty() ? 0 : &codes[0], codes.size(), out);
+        meshcEncodeStream(data.empty() ? 0 : &data[0], data.size(), out);
+    }
+    stats.indexBytes = out.size() - before;
+    stats.encodedBytes = out.size();
+    stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return stats;
+}
+
+/**
+ * @brief 解码到 model (交错顶点, 索引, 材质与材质区间, 包围盒)
+ * 不建立 positionIndex (见 meshcBuildPositionIndex), model.positionIndex 为空, positionCount 为 0
+ */
+inline bool decodeMesh(const uint8_t* bytes, size_t size, ObjModel& model, MeshcStats* statsOut = 0) {
+    TRACE_FUNCTION();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    MeshcReader in(bytes, size);
+    const uint8_t* magic = in.bytes(4);
+    if (!magic || memcmp(magic, MESHC_MAGIC, 4) != 0 || in.u32() != MESHC_VERSION) {
+        std::cerr << "错误: 不是 .meshc 文件或版本不符" << std::endl;
+        return false;
+    }
+    uint32_t vertexCount = in.varint(), indexCount = in.varint();
+    MeshcQuantizer qz;
+    for (int k = 0; k < 3; ++k) { qz.posMin[k] = in.f32(); qz.posStep[k] = in.f32(); }
+    for (int k = 0; k < 2; ++k) { qz.uvMin[k] = in.f32(); qz.uvStep[k] = in.f32(); }
+    qz.normalMax = in.varint();
+
+    // vertices / indices 保留原来的容量: 反复解码到同一个 model (热重载, 基准测试) 时不用重新分配
+    model.positionIndex.clear();
+    model.materials.clear();
+    model.ranges.clear();
+    model.groups.clear();
+    model.positionCount = 0;
+    uint32_t materialCount = in.varint();
+    for (uint32_t m = 0; m < materialCount && in.ok; ++m) {
+        ObjMaterial mat;
+        mat.name = in.str();
+        for (int k = 0; k < 3; ++k) mat.ambient[k] = in.f32();
+        for (int k = 0; k < 3; ++k) mat.diffuse[k] = in.f32();
+        for (int k = 0; k < 3; ++k) mat.specular[k] = in.f32();
+        mat.shininess = in.f32();
+        mat.opacity = in.f32();
+        mat.diffuseMap = in.str();
+        model.materials.push_back(mat);
+    }
+    uint32_t rangeCount = in.varint();
+    for (uint32_t r = 0; r < rangeCount && in.ok; ++r) {
+        ObjRange range;
+        uint32_t material = in.varint();   // 按无符号比较: 转成 int 之后很大的值会变成负数, 绕过上界检查
+        range.material = (int)material;
+        range.firstIndex = in.varint();
+        range.indexCount = in.varint();
+        if (material >= model.materials.size() || (uint64_t)range.firstIndex + range.indexCount > indexCount) in.ok = false;
+        model.ranges.push_back(range);
+    }
+    // --- 顺序读出各块字节流的位置 (只解析流的头部) ---
+    const size_t triangleCount = indexCount / 3;
+    const size_t vertexBlocks = (vertexCount + MESHC_VERTEX_BLOCK - 1) / MESHC_VERTEX_BLOCK;
+    const size_t triangleBlocks = (triangleCount + MESHC_TRIANGLE_BLOCK - 1) / MESHC_TRIANGLE_BLOCK;
+    std::vector<MeshcStreamRef> vertexRefs(vertexBlocks * MESHC_PLANES), codeRefs(triangleBlocks), dataRefs(triangleBlocks);
+    std::vector<unsigned> blockNext(triangleBlocks);
+    bool ok = in.ok && indexCount % 3 == 0;
+    for (size_t b = 0; b < vertexBlocks && ok; ++b) {
+        size_t count = std::min(MESHC_VERTEX_BLOCK, vertexCount - b * MESHC_VERTEX_BLOCK);
+        for (int c = 0; c < MESHC_PLANES && ok; ++c) {
+            MeshcStreamRef& ref = vertexRefs[b * MESHC_PLANES + c];
+            ok = meshcReadStreamRef(in, ref) && ref.size == count;
+        }
+    }
+    for (size_t b = 0; b < triangleBlocks && ok; ++b) {
+        size_t count = std::min(MESHC_TRIANGLE_BLOCK, triangleCount - b * MESHC_TRIANGLE_BLOCK);
+        blockNext[b] = in.varint();
+        ok = meshcReadStreamRef(in, codeRefs[b]) && codeRefs[b].size == count && meshcReadStreamRef(in, dataRefs[b]);
+    }
+    if (!ok) { std::cerr << "错误: .meshc 数据损坏" << std::endl; return false; }
+
+    // --- 每个顶点块和三角形块各是一个任务, 由工作窃取调度器分给所有线程 ---
+    model.vertices.resize((size_t)vertexCount * OBJ_VERTEX_STRIDE);
+    model.indices.resize(indexCount);
+    const size_t tasks = vertexBlocks + triangleBlocks;
+    std::vector<uint16_t> blockRange(vertexBlocks * 6);   // 每个顶点块量化位置的最小值和最大值
+    std::vector<uint8_t> failed(tasks, 0);
+    parallelFor(tasks, (int)tasks, [&](size_t begin, size_t end, int) {
+        for (size_t task = begin; task < end; ++task) {
+            if (task < vertexBlocks) {
+                size_t first = task * MESHC_VERTEX_BLOCK, count = std::min(MESHC_VERTEX_BLOCK, vertexCount - first);
+                failed[task] = !meshcDecodeVertices(&vertexRefs[task * MESHC_PLANES], count, qz,
+                                                    &model.vertices[first * OBJ_VERTEX_STRIDE], &blockRange[task * 6]);
+            } else {
+                size_t b = task - vertexBlocks, first = b * MESHC_TRIANGLE_BLOCK;
+                size_t count = std::min(MESHC_TRIANGLE_BLOCK, triangleCount - first);
+                failed[task] = !meshcDecodeIndices(codeRefs[b], dataRefs[b], &model.indices[first * 3], count, blockNext[b], vertexCount);
+            }
+        }
+    });
+    for (size_t task = 0; task < tasks; ++task) {
+        if (failed[task]) {
+            std::cerr << "错误: .meshc " << (task < vertexBlocks ? "顶点" : "索引") << "数据损坏" << std::endl;
+            return false;
+        }
+    }
+
+    // 包围盒: 合并各块的量化范围
+    model.bounds = aabbEmpty();
+    if (vertexBlocks) {
+        uint16_t qmin[3] = { 65535, 65535, 65535 }, qmax[3] = { 0, 0, 0 };
+        for (size_t b = 0; b < vertexBlocks; ++b) {
+            for (int k = 0; k < 3; ++k) {
+                qmin[k] = std::min(qmin[k], blockRange[b * 6 + k]);
+                qmax[k] = std::max(qmax[k], blockRange[b * 6 + 3 + k]);
+            }
+        }
+        model.bounds.min = vec3(qz.posMin[0] + qmin[0] * qz.posStep[0], qz.posMin[1] + qmin[1] * qz.posStep[1], qz.posMin[2] + qmin[2] * qz.posStep[2]);
+        model.bounds.max = vec3(qz.posMin[0] + qmax[0] * qz.posStep[0], qz.posMin[1] + qmax[1] * qz.posStep[1], qz.posMin[2] + qmax[2] * qz.posStep[2]);
+    }
+    if (statsOut) {
+        statsOut->encodedBytes = size;
+        statsOut->rawBytes = model.vertices.size() * sizeof(float) + model.indices.size() * sizeof(unsigned);
+        statsOut->vertexBytes = statsOut->indexBytes = 0;
+        statsOut->ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    return true;
+}
+
+/**
+ * @brief 为解码后的模型建立 positionIndex: 位置完全相同的顶点共享一个编号
+ * 解码后的位置都落在量化格点上, 量化值相同的位置反量化后逐位相同, 所以直接比较 float 的位模式.
+ * 逐顶点的哈希查找比解码本身慢得多, 因此不放在 decodeMesh 里; 只有需要按位置建立邻接关系的调用者
+ * (线框边表、网格清理) 才调用它
+ */
+inline void meshcBuildPositionIndex(ObjModel& model) {
+    TRACE_FUNCTION();
+    size_t n = model.vertexCount();
+    model.positionIndex.resize(n);
+    size_t tableSize = 16;
+    while (tableSize < n * 2) tableSize <<= 1;
+    std::vector<unsigned> table(tableSize, ~0u);   // 开放寻址哈希表, 存放每个位置第一次出现的顶点 (~0u 表示空槽)
+    unsigned positions = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const float* p = &model.vertices[i * OBJ_VERTEX_STRIDE];
+        uint32_t bits[3];
+        memcpy(bits, p, sizeof(bits));
+        uint64_t h = (bits[0] * 0x9E3779B97F4A7C15ull) ^ (bits[1] * 0xC2B2AE3D27D4EB4Full) ^ (bits[2] * 0x165667B19E3779F9ull);
+        size_t slot = (size_t)(h >> 32) & (tableSize - 1);
+        while (table[slot] != ~0u && memcmp(&model.vertices[table[slot] * OBJ_VERTEX_STRIDE], p, sizeof(bits)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == ~0u) {
+            table[slot] = (unsigned)i;
+            model.positionIndex[i] = positions++;
+        } else {
+            model.positionIndex[i] = model.positionIndex[table[slot]];
+        }
+    }
+    model.positionCount = positions;
+}
+
+inline bool writeMeshc(const std::string& filename, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(filename.c_str(), std::ios::binary);
+    if (!file) { std::cerr << "错误: 无法写入文件 " << filename << std::endl; return false; }
+    file.write((const char*)&bytes[0], bytes.size());
+    return (bool)file;
+}
+
+/**
+ * @brief 把整个文件读入 bytes, readMs 为读取耗时
+ */
+inline bool readMeshcFile(const std::string& filename, std::vector<uint8_t>& bytes, double& readMs) {
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) { std::cerr << "错误: 无法打开文件 " << filename << std::endl; return false; }
+    file.seekg(0, std::ios::end);
+    bytes.resize((size_t)file.tellg());
+    file.seekg(0, std::ios::beg);
+    if (!bytes.empty()) file.read((char*)&bytes[0], bytes.size());
+    readMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return (bool)file;
+}
+
+/**
+ * @brief 读取并解码 .meshc 文件, 输出与 readObj 相同的 ObjModel (positionIndex 除外, 见 decodeMesh)
+ */
+inline bool readMeshc(const std::string& filename, ObjModel& model) {
+    TRACE_FUNCTION();
+    std::vector<uint8_t> bytes;
+    double readMs = 0.0;
+    if (!readMeshcFile(filename, bytes, readMs)) return false;
+    MeshcStats stats;
+    if (bytes.empty() || !decodeMesh(&bytes[0], bytes.size(), model, &stats)) return false;
+    std::cout << "MESHC读取成功 " << filename << ": " << model.vertexCount() << " 个顶点, " << model.indices.size() / 3
+              << " 个三角面, " << model.ranges.size() << " 个材质批次; " << bytes.size() / 1024.0 << " KB, 读取 "
+              << readMs << " ms (" << bytes.size() / (readMs * 1e3) << " MB/s), 解码 " << stats.ms << " ms (消耗压缩数据 "
+              << bytes.size() / (stats.ms * 1e3) << " MB/s, 输出 " << stats.rawBytes / (stats.ms * 1e6) << " GB/s)" << std::endl;
+    return true;
+}
+
+#endif
@@ -0,0 +1,188 @@
+#ifndef MESH_EDGES_H
+#define MESH_EDGES_H
+
+// 唯一边提取与线框模式
+// glPolygonMode(GL_LINE) 会把两个三角形共享的边各画一次, 而且仍然按三角形提交;
+// 这里在加载后建立一次边邻接表 (以排序后的位置编号对为键的哈希表),
+// 每条边只出现一次, 所有边放进一个 GL_LINES 索引缓冲
+// - 折痕: 边界边、非流形边, 以及两侧面法线夹角大于阈值的边 (与视点无关, 只算一次)
+// - 轮廓: 边界边、非流形边, 以及两侧面一正一反的边 (随视点变化, 每帧重新筛选)
+//
+// 只依赖标准库, 可以被自带 Vec3 的 pyramid / cube 查看器直接包含
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <cmath>
+#include <cstdint>
+#include "trace.h"
+
+const float EDGE_CREASE_ANGLE = 30.0f;   // 折痕阈值 (度)
+
+struct MeshEdge {
+    unsigned v0, v1;     // 绘制时使用的顶点编号
+    int face0, face1;    // 相邻三角形, face1 = -1 表示边界边
+    bool nonManifold;    // 被三个或更多三角形共享
+};
+
+struct EdgeTable {
+    std::vector<MeshEdge> edges;
+    std::vector<float> facePlanes;      // 每个三角形 (nx, ny, nz, d), 法线已归一化
+    std::vector<unsigned> lineIndices;  // 全部唯一边, 每两个编号一条线段
+    std::vector<unsigned> creaseIndices;
+    size_t boundaryEdges, nonManifoldEdges;
+
+    EdgeTable() : boundaryEdges(0), nonManifoldEdges(0) {}
+};
+
+/**
+ * @brief 建立边邻接表
+ * indices:    三角形顶点编号 (triangleCount * 3)
+ * positions:  顶点位置, 每个顶点间隔 stride 个 float
+ * positionOf: 顶点 -> 位置编号, 用于让法线/纹理接缝两侧的顶点共享同一条边; 为空时直接用顶点编号
+ */
+inline void buildEdgeTable(EdgeTable& table, const unsigned* indices, size_t triangleCount,
+                           const float* positions, int stride, const unsigned* positionOf) {
+    TRACE_FUNCTION();
+    table.edges.clear();
+    table.edges.reserve(triangleCount * 3 / 2 + 16);
+    table.facePlanes.resize(triangleCount * 4);
+    table.boundaryEdges = table.nonManifoldEdges = 0;
+
+    std::unordered_map<uint64_t, unsigned> lookup;
+    lookup.reserve(triangleCount * 3 / 2 + 16);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const unsigned* tri = indices + t * 3;
+        const float* a = positions + (size_t)tri[0] * stride;
+        const float* b = positions + (size_t)tri[1] * stride;
+        const float* c = positions + (size_t)tri[2] * stride;
+        float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+        float vx = c[0] - a[0], vy = c[1] - a[1], vz = c[2] - a[2];
+        float nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+        float len = std::sqrt(nx * nx + ny * ny + nz * nz);
+        if (len > 0.0f) { nx /= len; ny /= len; nz /= len; }
+        float* plane = &table.facePlanes[t * 4];
+        plane[0] = nx; plane[1] = ny; plane[2] = nz;
+        plane[3] = -(nx * a[0] + ny * a[1] + nz * a[2]);
+
+        for (int e = 0; e < 3; ++e) {
+            unsigned v0 = tri[e], v1 = tri[(e + 1) % 3];
+            unsigned p0 = positionOf ? positionOf[v0] : v0, p1 = positionOf ? positionOf[v1] : v1;
+            if (p0 == p1) continue;  // 退化边
+            uint64_t key = p0 < p1 ? ((uint64_t)p0 << 32) | p1 : ((uint64_t)p1 << 32) | p0;
+            std::pair<std::unordered_map<uint64_t, unsigned>::iterator, bool> it =
+                lookup.insert(std::make_pair(key, (unsigned)table.edges.size()));
+            if (it.second) {
+                MeshEdge edge = { v0, v1, (int)t, -1, false };
+                table.edges.push_back(edge);
+            } else {
+                MeshEdge& edge = table.edges[it.first->second];
+                if (edge.face1 < 0) edge.face1 = (int)t;
+                else edge.nonManifold = true;
+            }
+        }
+    }
+
+    // 全部唯一边 + 折痕边 (与视点无关)
+    float creaseCos = std::cos(EDGE_CREASE_ANGLE * 3.14159265f / 180.0f);
+    table.lineIndices.clear();
+    table.creaseIndices.clear();
+    table.lineIndices.reserve(table.edges.size() * 2);
+    for (size_t i = 0; i < table.edges.size(); ++i) {
+        const MeshEdge& edge = table.edges[i];
+        table.lineIndices.push_back(edge.v0);
+        table.lineIndices.push_back(edge.v1);
+        bool crease = edge.face1 < 0 || edge.nonManifold;
+        if (!crease) {
+            const float* n0 = &table.facePlanes[edge.face0 * 4];
+            const float* n1 = &table.facePlanes[edge.face1 * 4];
+            crease = n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] < creaseCos;
+        }
+        if (crease) {
+            table.creaseIndices.push_back(edge.v0);
+            table.creaseIndices.push_back(edge.v1);
+        }
+        if (edge.face1 < 0) ++table.boundaryEdges;
+        if (edge.nonManifold) ++table.nonManifoldEdges;
+    }
+}
+
+/**
+ * @brief 筛选轮廓边: eye 为模型空间中的视点
+ */
+inline void silhouetteEdges(const EdgeTable& table, const float* eye, std::vector<unsigned>& out) {
+    TRACE_FUNCTION();
+    out.clear();
+    for (size_t i = 0; i < table.edges.size(); ++i) {
+        const MeshEdge& edge = table.edges[i];
+        bool keep = edge.face1 < 0 || edge.nonManifold;
+        if (!keep) {
+            const float* p0 = &table.facePlanes[edge.face0 * 4];
+            const float* p1 = &table.facePlanes[edge.face1 * 4];
+            bool front0 = p0[0] * eye[0] + p0[1] * eye[1] + p0[2] * eye[2] + p0[3] > 0.0f;
+            bool front1 = p1[0] * eye[0] + p1[1] * eye[1] + p1[2] * eye[2] + p1[3] > 0.0f;
+            keep = front0 != front1;
+        }
+        if (keep) {
+            out.push_back(edge.v0);
+            out.push_back(edge.v1);
+        }
+    }
+}
+
+/**
+ * @brief 从模型视图矩阵 (列主序, 只含旋转和平移) 求模型空间中的视点: eye = -R^T * t
+ */
+inline void eyeFromModelView(const float* m, float* eye) {
+    for (int i = 0; i < 3; ++i)
+        eye[i] = -(m[i * 4] * m[12] + m[i * 4 + 1] * m[13] + m[i * 4 + 2] * m[14]);
+}
+
+// --- 线框模式 ('w' 键循环切换) ---
+enum WireMode { WIRE_OFF, WIRE_POLYGON_LINE, WIRE_EDGES, WIRE_CREASES, WIRE_SILHOUETTE, WIRE_MODE_COUNT };
+
+inline const char* wireModeName(int mode) {
+    static const char* names[] = { "填充", "glPolygonMode 线框", "唯一边", "折痕边", "轮廓边" };
+    return names[mode];
+}
+
+inline void printEdgeStats(const EdgeTable& table, size_t triangleCount) {
+    std::cout << "边邻接表: " << table.edges.size() << " 条唯一边 (glPolygonMode 线框需要画 " << triangleCount * 3
+              << " 条), " << table.creaseIndices.size() / 2 << " 条折痕边, " << table.boundaryEdges << " 条边界边, "
+              << table.nonManifoldEdges << " 条非流形边." << std::endl;
+}
+
+// 按模式累计绘制时间, 每 60 帧输出一次
+struct WireFrameTimer {
+    int mode, frames;
+    double totalMs;
+    size_t lines;
+
+    WireFrameTimer() : mode(WIRE_OFF), frames(0), totalMs(0.0), lines(0) {}
+
+    void add(int currentMode, double ms, size_t lineCount) {
+        if (currentMode != mode) { mode = currentMode; frames = 0; totalMs = 0.0; }
+        totalMs += ms;
+        lines = lineCount;
+        if (++frames == 60) {
+            std::cout << "[" << wireModeName(mode) << "] 平均绘制时间 " << totalMs / frames << " ms";
+            if (mode != WIRE_OFF) std::cout << ", " << lines << " 条线段";
+            std::cout << std::endl;
+            frames = 0;
+            totalMs = 0.0;
+        }
+    }
+
+    /**
+     * @brief 取出 GPU 计时查询的结果逐个累计 (见 gpu_timer.h): 模式和线段数都用发出查询时记录的值,
+     * 即 gpu.begin(mode) / gpu.end(lineCount); 不支持计时查询时累计本帧的 CPU 提交时间 cpuMs
+     */
+    template <typename GpuTimerT>
+    void addTimed(GpuTimerT& gpu, int currentMode, double cpuMs, size_t lineCount) {
+        if (!gpu.supported()) { add(currentMode, cpuMs, lineCount); return; }
+        typename GpuTimerT::Sample sample;
+        while (gpu.poll(sample)) add(sample.tag, sample.ms, sample.count);
+    }
+};
+
+#endif
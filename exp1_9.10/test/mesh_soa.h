@@ -0,0 +1,370 @@
+#ifndef MESH_SOA_H
+#define MESH_SOA_H
+
+// 结构数组 (SoA) 形式的顶点位置 + SIMD 几何核函数
+//
+//   SoaPositions p;
+//   p.assign(&model.vertices[0], model.vertexCount(), OBJ_VERTEX_STRIDE);   // 从交错顶点中取出位置
+//   const SoaKernels& k = soaKernels();                                     // 运行时选择 AVX2 / SSE2 / 标量
+//   k.transform(m.m, p.x, p.y, p.z, out.x, out.y, out.z, p.paddedSize());
+//   k.bounds(p.x, p.y, p.z, p.size(), bmin, bmax);
+//
+// - x / y / z 各自是 32 字节对齐的连续数组, 长度补齐到 SOA_LANES 的整数倍 (补齐部分为 0),
+//   逐元素的核函数 (transform / normalize) 可以直接处理补齐后的长度, 不需要尾部循环
+// - 矩阵是列主序的 4x4 float 数组: Mat4::m, 或 glm::value_ptr(glm::mat4); 只使用仿射部分 (不做透视除法)
+// - AVX2 核函数用 __attribute__((target)) 单独编译, 不需要给整个程序加 -mavx2;
+//   启动时用 __builtin_cpu_supports 检测, 不支持的 CPU 上使用 SSE2 (x86-64 的基本指令集)
+// - 非 x86 平台 (Apple Silicon 等) 只有标量版本; 标量 SoA 循环通常会被编译器自动向量化为 NEON
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#define MESH_SOA_X86 1
+#include <immintrin.h>
+#endif
+
+const size_t SOA_LANES = 8;     // AVX2 一次处理 8 个 float
+const size_t SOA_ALIGN = 32;
+
+// --- 容器 ---
+
+class SoaPositions {
+public:
+    float* x;
+    float* y;
+    float* z;
+
+    SoaPositions() : x(0), y(0), z(0), size_(0), padded_(0), block_(0) {}
+    explicit SoaPositions(size_t n) : x(0), y(0), z(0), size_(0), padded_(0), block_(0) { resize(n); }
+    ~SoaPositions() { free(block_); }
+
+    size_t size() const { return size_; }
+    size_t paddedSize() const { return padded_; }
+
+    /**
+     * @brief 改变元素个数; 容量不够时重新分配 (原有内容不保留), 补齐部分清零
+     */
+    void resize(size_t n) {
+        size_t padded = (n + SOA_LANES - 1) / SOA_LANES * SOA_LANES;
+        if (padded > padded_ || !block_) {
+            free(block_);
+            block_ = 0;
+            size_t bytes = std::max<size_t>(padded, SOA_LANES) * sizeof(float) * 3;
+            if (posix_memalign(&block_, SOA_ALIGN, bytes) != 0) block_ = 0;
+            padded_ = padded;
+            x = (float*)block_;
+            y = x + padded_;
+            z = y + padded_;
+        }
+        size_ = n;
+        for (size_t i = n; i < padded_; ++i) x[i] = y[i] = z[i] = 0.0f;
+    }
+
+    /**
+     * @brief 从交错数组中取出位置: src[i * stride + 0..2]
+     */
+    void assign(const float* src, size_t n, size_t stride) {
+        resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = src[i * stride];
+            y[i] = src[i * stride + 1];
+            z[i] = src[i * stride + 2];
+        }
+    }
+
+    /**
+     * @brief 写回交错数组: dst[i * stride + 0..2]
+     */
+    void store(float* dst, size_t stride) const {
+        for (size_t i = 0; i < size_; ++i) {
+            dst[i * stride] = x[i];
+            dst[i * stride + 1] = y[i];
+            dst[i * stride + 2] = z[i];
+        }
+    }
+
+private:
+    SoaPositions(const SoaPositions&);              // 不可复制
+    SoaPositions& operator=(const SoaPositions&);
+
+    size_t size_, padded_;
+    void* block_;     // x / y / z 三个数组连续分配
+};
+
+// --- 核函数表 ---
+
+struct SoaKernels {
+    const char* name;
+    // out = m * (x, y, z, 1) 的前三个分量; n 可以是 paddedSize(), 输入和输出可以是同一组数组
+    void (*transform)(const float* m, const float* x, const float* y, const float* z,
+                      float* ox, float* oy, float* oz, size_t n);
+    // 包围盒; n == 0 时 bmin = +FLT_MAX, bmax = -FLT_MAX
+    void (*bounds)(const float* x, const float* y, const float* z, size_t n, float* bmin, float* bmax);
+    // 原地归一化; 长度为 0 的向量保持为 0
+    void (*normalize)(float* x, float* y, float* z, size_t n);
+    // 三角形 t 的单位法线 (按 indices[3t..3t+2] 的逆时针顺序), 退化三角形为 0
+    void (*faceNormals)(const float* x, const float* y, const float* z, const unsigned* indices, size_t triangles,
+                        float* nx, float* ny, float* nz);
+};
+
+// --- 标量版本 ---
+
+inline void soaTransformScalar(const float* m, const float* x, const float* y, const float* z,
+                               float* ox, float* oy, float* oz, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        float px = x[i], py = y[i], pz = z[i];
+        ox[i] = m[0] * px + m[4] * py + m[8] * pz + m[12];
+        oy[i] = m[1] * px + m[5] * py + m[9] * pz + m[13];
+        oz[i] = m[2] * px + m[6] * py + m[10] * pz + m[14];
+    }
+}
+
+inline void soaBoundsScalar(const float* x, const float* y, const float* z, size_t n, float* bmin, float* bmax) {
+    bmin[0] = bmin[1] = bmin[2] = FLT_MAX;
+    bmax[0] = bmax[1] = bmax[2] = -FLT_MAX;
+    for (size_t i = 0; i < n; ++i) {
+        bmin[0] = std::min(bmin[0], x[i]); bmax[0] = std::max(bmax[0], x[i]);
+        bmin[1] = std::min(bmin[1], y[i]); bmax[1] = std::max(bmax[1], y[i]);
+        bmin[2] = std::min(bmin[2], z[i]); bmax[2] = std::max(bmax[2], z[i]);
+    }
+}
+
+inline void soaNormalizeScalar(float* x, float* y, float* z, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        float len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+        float s = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+        x[i] *= s; y[i] *= s; z[i] *= s;
+    }
+}
+
+inline void soaFaceNormalsScalar(const float* x, const float* y, const float* z, const unsigned* indices, size_t triangles,
+                                 float* nx, float* ny, float* nz) {
+    for (size_t t = 0; t < triangles; ++t) {
+        unsigned a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+        float ux = x[b] - x[a], uy = y[b] - y[a], uz = z[b] - z[a];
+        float vx = x[c] - x[a], vy = y[c] - y[a], vz = z[c] - z[a];
+        float cx = uy * vz - uz * vy, cy = uz * vx - ux * vz, cz = ux * vy - uy * vx;
+        float len2 = cx * cx + cy * cy + cz * cz;
+        float s = len2 > 0.0f ? 1.0f / std::sqrt(len2) : 0.0f;
+        nx[t] = cx * s; ny[t] = cy * s; nz[t] = cz * s;
+    }
+}
+
+#ifdef MESH_SOA_X86
+
+// --- SSE2 版本 (4 路) ---
+
+// 1/sqrt(len2) 的近似值加一次牛顿迭代, 相对误差约 1e-7 量级; len2 == 0 时为 0
+inline __m128 soaRsqrt4(__m128 len2) {
+    __m128 r = _mm_rsqrt_ps(len2);
+    __m128 half = _mm_mul_ps(_mm_set1_ps(0.5f), len2);
+    r = _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half, _mm_mul_ps(r, r))));
+    return _mm_and_ps(r, _mm_cmpgt_ps(len2, _mm_setzero_ps()));
+}
+
+inline void soaTransformSSE2(const float* m, const float* x, const float* y, const float* z,
+                             float* ox, float* oy, float* oz, size_t n) {
+    __m128 m0 = _mm_set1_ps(m[0]), m1 = _mm_set1_ps(m[1]), m2 = _mm_set1_ps(m[2]);
+    __m128 m4 = _mm_set1_ps(m[4]), m5 = _mm_set1_ps(m[5]), m6 = _mm_set1_ps(m[6]);
+    __m128 m8 = _mm_set1_ps(m[8]), m9 = _mm_set1_ps(m[9]), m10 = _mm_set1_ps(m[10]);
+    __m128 m12 = _mm_set1_ps(m[12]), m13 = _mm_set1_ps(m[13]), m14 = _mm_set1_ps(m[14]);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, px), _mm_mul_ps(m4, py)), _mm_add_ps(_mm_mul_ps(m8, pz), m12));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m1, px), _mm_mul_ps(m5, py)), _mm_add_ps(_mm_mul_ps(m9, pz), m13));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m2, px), _mm_mul_ps(m6, py)), _mm_add_ps(_mm_mul_ps(m10, pz), m14));
+        _mm_storeu_ps(ox + i, rx); _mm_storeu_ps(oy + i, ry); _mm_storeu_ps(oz + i, rz);
+    }
+    soaTransformScalar(m, x + i, y + i, z + i, ox + i, oy + i, oz + i, n - i);
+}
+
+inline void soaBoundsSSE2(const float* x, const float* y, const float* z, size_t n, float* bmin, float* bmax) {
+    __m128 lox = _mm_set1_ps(FLT_MAX), loy = lox, loz = lox;
+    __m128 hix = _mm_set1_ps(-FLT_MAX), hiy = hix, hiz = hix;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        lox = _mm_min_ps(lox, px); hix = _mm_max_ps(hix, px);
+        loy = _mm_min_ps(loy, py); hiy = _mm_max_ps(hiy, py);
+        loz = _mm_min_ps(loz, pz); hiz = _mm_max_ps(hiz, pz);
+    }
+    float lo[3][4], hi[3][4];
+    _mm_storeu_ps(lo[0], lox); _mm_storeu_ps(lo[1], loy); _mm_storeu_ps(lo[2], loz);
+    _mm_storeu_ps(hi[0], hix); _mm_storeu_ps(hi[1], hiy); _mm_storeu_ps(hi[2], hiz);
+    soaBoundsScalar(x + i, y + i, z + i, n - i, bmin, bmax);
+    for (int c = 0; c < 3; ++c) {
+        for (int l = 0; l < 4; ++l) {
+            bmin[c] = std::min(bmin[c], lo[c][l]);
+            bmax[c] = std::max(bmax[c], hi[c][l]);
+        }
+    }
+}
+
+inline void soaNormalizeSSE2(float* x, float* y, float* z, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+        __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz));
+        __m128 s = soaRsqrt4(len2);
+        _mm_storeu_ps(x + i, _mm_mul_ps(px, s)); _mm_storeu_ps(y + i, _mm_mul_ps(py, s)); _mm_storeu_ps(z + i, _mm_mul_ps(pz, s));
+    }
+    soaNormalizeScalar(x + i, y + i, z + i, n - i);
+}
+
+inline void soaFaceNormalsSSE2(const float* x, const float* y, const float* z, const unsigned* indices, size_t triangles,
+                               float* nx, float* ny, float* nz) {
+    size_t t = 0;
+    for (; t + 4 <= triangles; t += 4) {
+        // SSE2 没有 gather, 逐个读入 4 个三角形的 12 个顶点, 叉积和归一化用向量完成
+        const unsigned* tri = indices + t * 3;
+        unsigned a0 = tri[0], a1 = tri[3], a2 = tri[6], a3 = tri[9];
+        unsigned b0 = tri[1], b1 = tri[4], b2 = tri[7], b3 = tri[10];
+        unsigned c0 = tri[2], c1 = tri[5], c2 = tri[8], c3 = tri[11];
+        __m128 ax = _mm_setr_ps(x[a0], x[a1], x[a2], x[a3]);
+        __m128 ay = _mm_setr_ps(y[a0], y[a1], y[a2], y[a3]);
+        __m128 az = _mm_setr_ps(z[a0], z[a1], z[a2], z[a3]);
+        __m128 ux = _mm_sub_ps(_mm_setr_ps(x[b0], x[b1], x[b2], x[b3]), ax);
+        __m128 uy = _mm_sub_ps(_mm_setr_ps(y[b0], y[b1], y[b2], y[b3]), ay);
+        __m128 uz = _mm_sub_ps(_mm_setr_ps(z[b0], z[b1], z[b2], z[b3]), az);
+        __m128 vx = _mm_sub_ps(_mm_setr_ps(x[c0], x[c1], x[c2], x[c3]), ax);
+        __m128 vy = _mm_sub_ps(_mm_setr_ps(y[c0], y[c1], y[c2], y[c3]), ay);
+        __m128 vz = _mm_sub_ps(_mm_setr_ps(z[c0], z[c1], z[c2], z[c3]), az);
+        __m128 cx = _mm_sub_ps(_mm_mul_ps(uy, vz), _mm_mul_ps(uz, vy));
+        __m128 cy = _mm_sub_ps(_mm_mul_ps(uz, vx), _mm_mul_ps(ux, vz));
+        __m128 cz = _mm_sub_ps(_mm_mul_ps(ux, vy), _mm_mul_ps(uy, vx));
+        __m128 s = soaRsqrt4(_mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, cx), _mm_mul_ps(cy, cy)), _mm_mul_ps(cz, cz)));
+        _mm_storeu_ps(nx + t, _mm_mul_ps(cx, s)); _mm_storeu_ps(ny + t, _mm_mul_ps(cy, s)); _mm_storeu_ps(nz + t, _mm_mul_ps(cz, s));
+    }
+    soaFaceNormalsScalar(x, y, z, indices + t * 3, triangles - t, nx + t, ny + t, nz + t);
+}
+
+// --- AVX2 + FMA 版本 (8 路) ---
+
+#define SOA_AVX2 __attribute__((target("avx2,fma")))
+
+SOA_AVX2 inline __m256 soaRsqrt8(__m256 len2) {
+    __m256 r = _mm256_rsqrt_ps(len2);
+    __m256 half = _mm256_mul_ps(_mm256_set1_ps(0.5f), len2);
+    r = _mm256_mul_ps(r, _mm256_fnmadd_ps(half, _mm256_mul_ps(r, r), _mm256_set1_ps(1.5f)));
+    return _mm256_and_ps(r, _mm256_cmp_ps(len2, _mm256_setzero_ps(), _CMP_GT_OQ));
+}
+
+SOA_AVX2 inline void soaTransformAVX2(const float* m, const float* x, const float* y, const float* z,
+                                      float* ox, float* oy, float* oz, size_t n) {
+    __m256 m0 = _mm256_set1_ps(m[0]), m1 = _mm256_set1_ps(m[1]), m2 = _mm256_set1_ps(m[2]);
+    __m256 m4 = _mm256_set1_ps(m[4]), m5 = _mm256_set1_ps(m[5]), m6 = _mm256_set1_ps(m[6]);
+    __m256 m8 = _mm256_set1_ps(m[8]), m9 = _mm256_set1_ps(m[9]), m10 = _mm256_set1_ps(m[10]);
+    __m256 m12 = _mm256_set1_ps(m[12]), m13 = _mm256_set1_ps(m[13]), m14 = _mm256_set1_ps(m[14]);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        __m256 rx = _mm256_fmadd_ps(m0, px, _mm256_fmadd_ps(m4, py, _mm256_fmadd_ps(m8, pz, m12)));
+        __m256 ry = _mm256_fmadd_ps(m1, px, _mm256_fmadd_ps(m5, py, _mm256_fmadd_ps(m9, pz, m13)));
+        __m256 rz = _mm256_fmadd_ps(m2, px, _mm256_fmadd_ps(m6, py, _mm256_fmadd_ps(m10, pz, m14)));
+        _mm256_storeu_ps(ox + i, rx); _mm256_storeu_ps(oy + i, ry); _mm256_storeu_ps(oz + i, rz);
+    }
+    soaTransformScalar(m, x + i, y + i, z + i, ox + i, oy + i, oz + i, n - i);
+}
+
+SOA_AVX2 inline void soaBoundsAVX2(const float* x, const float* y, const float* z, size_t n, float* bmin, float* bmax) {
+    __m256 lox = _mm256_set1_ps(FLT_MAX), loy = lox, loz = lox;
+    __m256 hix = _mm256_set1_ps(-FLT_MAX), hiy = hix, hiz = hix;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        lox = _mm256_min_ps(lox, px); hix = _mm256_max_ps(hix, px);
+        loy = _mm256_min_ps(loy, py); hiy = _mm256_max_ps(hiy, py);
+        loz = _mm256_min_ps(loz, pz); hiz = _mm256_max_ps(hiz, pz);
+    }
+    float lo[3][8], hi[3][8];
+    _mm256_storeu_ps(lo[0], lox); _mm256_storeu_ps(lo[1], loy); _mm256_storeu_ps(lo[2], loz);
+    _mm256_storeu_ps(hi[0], hix); _mm256_storeu_ps(hi[1], hiy); _mm256_storeu_ps(hi[2], hiz);
+    soaBoundsScalar(x + i, y + i, z + i, n - i, bmin, bmax);
+    for (int c = 0; c < 3; ++c) {
+        for (int l = 0; l < 8; ++l) {
+            bmin[c] = std::min(bmin[c], lo[c][l]);
+            bmax[c] = std::max(bmax[c], hi[c][l]);
+        }
+    }
+}
+
+SOA_AVX2 inline void soaNormalizeAVX2(float* x, float* y, float* z, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i), py = _mm256_loadu_ps(y + i), pz = _mm256_loadu_ps(z + i);
+        __m256 len2 = _mm256_fmadd_ps(px, px, _mm256_fmadd_ps(py, py, _mm256_mul_ps(pz, pz)));
+        __m256 s = soaRsqrt8(len2);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(px, s)); _mm256_storeu_ps(y + i, _mm256_mul_ps(py, s)); _mm256_storeu_ps(z + i, _mm256_mul_ps(pz, s));
+    }
+    soaNormalizeScalar(x + i, y + i, z + i, n - i);
+}
+
+// 8 个三角形的第 corner 个顶点的一个坐标分量
+#define SOA_LOAD8(c, tri, corner) _mm256_setr_ps(c[tri[corner]], c[tri[3 + corner]], c[tri[6 + corner]], c[tri[9 + corner]], \
+                                                 c[tri[12 + corner]], c[tri[15 + corner]], c[tri[18 + corner]], c[tri[21 + corner]])
+
+SOA_AVX2 inline void soaFaceNormalsAVX2(const float* x, const float* y, const float* z, const unsigned* indices, size_t triangles,
+                                        float* nx, float* ny, float* nz) {
+    // 每次 8 个三角形; 顶点坐标逐个读入寄存器 (在测试过的 CPU 上比 vgatherdps 快), 叉积和归一化用 8 路 FMA
+    size_t t = 0;
+    for (; t + 8 <= triangles; t += 8) {
+        const unsigned* tri = indices + t * 3;
+        __m256 ax = SOA_LOAD8(x, tri, 0), ay = SOA_LOAD8(y, tri, 0), az = SOA_LOAD8(z, tri, 0);
+        __m256 ux = _mm256_sub_ps(SOA_LOAD8(x, tri, 1), ax);
+        __m256 uy = _mm256_sub_ps(SOA_LOAD8(y, tri, 1), ay);
+        __m256 uz = _mm256_sub_ps(SOA_LOAD8(z, tri, 1), az);
+        __m256 vx = _mm256_sub_ps(SOA_LOAD8(x, tri, 2), ax);
+        __m256 vy = _mm256_sub_ps(SOA_LOAD8(y, tri, 2), ay);
+        __m256 vz = _mm256_sub_ps(SOA_LOAD8(z, tri, 2), az);
+        __m256 cx = _mm256_fmsub_ps(uy, vz, _mm256_mul_ps(uz, vy));
+        __m256 cy = _mm256_fmsub_ps(uz, vx, _mm256_mul_ps(ux, vz));
+        __m256 cz = _mm256_fmsub_ps(ux, vy, _mm256_mul_ps(uy, vx));
+        __m256 s = soaRsqrt8(_mm256_fmadd_ps(cx, cx, _mm256_fmadd_ps(cy, cy, _mm256_mul_ps(cz, cz))));
+        _mm256_storeu_ps(nx + t, _mm256_mul_ps(cx, s)); _mm256_storeu_ps(ny + t, _mm256_mul_ps(cy, s)); _mm256_storeu_ps(nz + t, _mm256_mul_ps(cz, s));
+    }
+    soaFaceNormalsScalar(x, y, z, indices + t * 3, triangles - t, nx + t, ny + t, nz + t);
+}
+
+#endif // MESH_SOA_X86
+
+// --- 运行时选择 ---
+
+enum SoaLevel { SOA_SCALAR, SOA_SSE2, SOA_AVX2_FMA, SOA_LEVEL_COUNT };
+
+/**
+ * @brief 返回指定指令集的核函数表; 当前 CPU / 平台不支持时返回 NULL
+ */
+inline const SoaKernels* soaKernelSet(SoaLevel level) {
+    static const SoaKernels scalar = { "标量", soaTransformScalar, soaBoundsScalar, soaNormalizeScalar, soaFaceNormalsScalar };
+#ifdef MESH_SOA_X86
+    static const SoaKernels sse2 = { "SSE2", soaTransformSSE2, soaBoundsSSE2, soaNormalizeSSE2, soaFaceNormalsSSE2 };
+    static const SoaKernels avx2 = { "AVX2+FMA", soaTransformAVX2, soaBoundsAVX2, soaNormalizeAVX2, soaFaceNormalsAVX2 };
+    static const bool hasAVX2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (level == SOA_SSE2) return &sse2;
+    if (level == SOA_AVX2_FMA) return hasAVX2 ? &avx2 : 0;
+#endif
+    return level == SOA_SCALAR ? &scalar : 0;
+}
+
+inline const SoaKernels* soaPickBest() {
+    for (int level = SOA_LEVEL_COUNT - 1; level > 0; --level)
+        if (const SoaKernels* k = soaKernelSet((SoaLevel)level)) return k;
+    return soaKernelSet(SOA_SCALAR);
+}
+
+/**
+ * @brief 当前 CPU 支持的最快的核函数表 (第一次调用时检测)
+ */
+inline const SoaKernels& soaKernels() {
+    static const SoaKernels* best = soaPickBest();
+    return *best;
+}
+
+#endif
@@ -0,0 +1,279 @@
+#ifndef MESH_WELD_H
+#define MESH_WELD_H
+
+// 基于空间哈希的顶点焊接 (合并距离在 epsilon 以内的重复顶点)
+// 1. 并行: 把位置量化到边长为 epsilon 的网格单元, 得到 (单元键, 顶点) 对并排序
+// 2. 相同单元的顶点连续存放, 单元键建成开放寻址哈希表
+// 3. 并行: 每个顶点检查自身及 26 个相邻单元, 距离 (以及可选的法线/纹理坐标) 满足条件
+//    则用无锁并查集合并; 合并具有传递性, 一串间距都小于 epsilon 的顶点会被并成一个
+// 4. 每个集合保留编号最小的顶点, 压缩顶点数组并原地重映射索引
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "parallel_for.h"
+#include "obj_reader.h"
+#include "trace.h"
+
+struct WeldOptions {
+    float epsilon;            // 位置容差
+    bool matchNormals;        // 是否要求法线接近
+    float normalCosTolerance; // 法线夹角余弦的下限
+    bool matchTexcoords;      // 是否要求纹理坐标接近
+    float texcoordEpsilon;
+    int threads;              // <= 0 表示使用全部硬件线程
+
+    WeldOptions() : epsilon(1e-5f), matchNormals(false), normalCosTolerance(0.999f),
+                    matchTexcoords(false), texcoordEpsilon(1e-4f), threads(0) {}
+};
+
+struct WeldResult {
+    size_t verticesBefore, verticesAfter;
+    double keyMs, sortMs, mergeMs, compactMs, totalMs;
+};
+
+// --- 无锁并查集 (总是把较大的根挂到较小的根下, 因此根就是集合中编号最小的顶点) ---
+inline unsigned weldFind(std::atomic<unsigned>* parent, unsigned v) {
+    unsigned p = parent[v].load(std::memory_order_relaxed);
+    while (p != v) {
+        unsigned gp = parent[p].load(std::memory_order_relaxed);
+        if (gp != p) parent[v].compare_exchange_weak(p, gp, std::memory_order_relaxed); // 路径减半
+        v = p;
+        p = parent[v].load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+inline void weldUnion(std::atomic<unsigned>* parent, unsigned a, unsigned b) {
+    for (;;) {
+        a = weldFind(parent, a);
+        b = weldFind(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        unsigned expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+// 单元坐标打包为 64 位键, 每轴 21 位; 超出范围时回绕, 不同单元可能共用一个键, 只影响速度不影响结果
+inline uint64_t weldCellKey(int64_t cx, int64_t cy, int64_t cz) {
+    const int64_t bias = 1 << 20;
+    return ((uint64_t)((cx + bias) & 0x1fffff) << 42) | ((uint64_t)((cy + bias) & 0x1fffff) << 21) | (uint64_t)((cz + bias) & 0x1fffff);
+}
+
+struct WeldSlot {
+    uint64_t key;
+    int32_t cell;   // -1 表示空槽
+    WeldSlot() : key(0), cell(-1) {}
+};
+
+inline uint64_t weldHash(uint64_t k) {
+    k ^= k >> 33; k *= 0xff51afd7ed558ccdULL; k ^= k >> 33;
+    return k;
+}
+
+/**
+ * @brief 焊接交错顶点数组
+ * vertices: 每个顶点 stride 个 float, 位置在偏移 0; normalOffset / uvOffset 为 -1 表示没有该属性
+ * indices:  原地重映射
+ * remapOut: 若非空, 输出 旧顶点 -> 新顶点 的映射, 便于调用者同步其它按顶点存放的数组
+ */
+inline WeldResult weldVertices(std::vector<float>& vertices, int stride, int normalOffset, int uvOffset,
+                               std::vector<unsigned>& indices, const WeldOptions& opt,
+                               std::vector<unsigned>* remapOut = 0) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    WeldResult result;
+    size_t n = vertices.size() / stride;
+    result.verticesBefore = n;
+    int threads = opt.threads > 0 ? opt.threads : hardwareThreads();
+    const float* data = vertices.empty() ? 0 : &vertices[0];
+    float inv = 1.0f / opt.epsilon;
+
+    // --- 1. 量化并生成 (单元键, 顶点) 对 ---
+    std::vector<std::pair<uint64_t, unsigned> > cells(n);
+    parallelFor(n, threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const float* p = data + i * stride;
+            cells[i].first = weldCellKey((int64_t)std::floor(p[0] * inv), (int64_t)std::floor(p[1] * inv), (int64_t)std::floor(p[2] * inv));
+            cells[i].second = (unsigned)i;
+        }
+    });
+    Clock::time_point t1 = Clock::now();
+
+    // --- 2. 分段并行排序, 再两两归并 ---
+    size_t chunk = (n + threads - 1) / std::max(threads, 1);
+    parallelFor(threads, threads, [&](size_t begin, size_t end, int) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t lo = std::min(n, t * chunk), hi = std::min(n, lo + chunk);
+            std::sort(cells.begin() + lo, cells.begin() + hi);
+        }
+    });
+    for (size_t width = chunk; width > 0 && width < n; width *= 2) {
+        size_t pairs = (n + 2 * width - 1) / (2 * width);
+        parallelFor(pairs, threads, [&](size_t begin, size_t end, int) {
+            for (size_t p = begin; p < end; ++p) {
+                size_t lo = p * 2 * width, mid = std::min(n, lo + width), hi = std::min(n, lo + 2 * width);
+                std::inplace_merge(cells.begin() + lo, cells.begin() + mid, cells.begin() + hi);
+            }
+        });
+    }
+
+    // 单元表: 键 -> [起始, 结束)
+    std::vector<uint32_t> cellStart;
+    cellStart.reserve(n / 2 + 1);
+    for (size_t i = 0; i < n; ++i)
+        if (i == 0 || cells[i].first != cells[i - 1].first) cellStart.push_back((uint32_t)i);
+    size_t cellCount = cellStart.size();
+    cellStart.push_back((uint32_t)n);
+
+    // 槽中直接存放键, 查找相邻单元时每次探测只访问一次内存
+    size_t tableSize = 16;
+    while (tableSize < cellCount * 2) tableSize *= 2;
+    std::vector<WeldSlot> table(tableSize);
+    for (size_t c = 0; c < cellCount; ++c) {
+        uint64_t key = cells[cellStart[c]].first;
+        size_t h = weldHash(key) & (tableSize - 1);
+        while (table[h].cell >= 0) h = (h + 1) & (tableSize - 1);
+        table[h].key = key;
+        table[h].cell = (int32_t)c;
+    }
+    // 占用位图: 大多数相邻单元是空的, 先查这张小得多 (缓存友好) 的位图, 命中后才去探测哈希表
+    size_t filterBits = tableSize * 4;
+    std::vector<uint64_t> filter(filterBits / 64, 0);
+    for (size_t c = 0; c < cellCount; ++c) {
+        size_t bit = (weldHash(cells[cellStart[c]].first) >> 20) & (filterBits - 1);
+        filter[bit >> 6] |= (uint64_t)1 << (bit & 63);
+    }
+    Clock::time_point t2 = Clock::now();
+
+    // --- 3. 并行检查相邻单元, 用并查集合并 ---
+    std::vector<std::atomic<unsigned> > parent(n);
+    for (size_t i = 0; i < n; ++i) parent[i].store((unsigned)i, std::memory_order_relaxed);
+    float eps2 = opt.epsilon * opt.epsilon;
+    float uvEps = opt.texcoordEpsilon;
+    parallelFor(cellCount, threads, [&](size_t begin, size_t end, int) {
+        for (size_t c = begin; c < end; ++c) {
+            uint64_t key = cells[cellStart[c]].first;
+            int64_t cx = (int64_t)(key >> 42) - (1 << 20), cy = (int64_t)((key >> 21) & 0x1fffff) - (1 << 20), cz = (int64_t)(key & 0x1fffff) - (1 << 20);
+            for (int dz = -1; dz <= 1; ++dz)
+            for (int dy = -1; dy <= 1; ++dy)
+            for (int dx = -1; dx <= 1; ++dx) {
+                uint64_t nkey = weldCellKey(cx + dx, cy + dy, cz + dz);
+                if (nkey < key) continue; // 每对单元只处理一次
+                uint64_t hash = weldHash(nkey);
+                size_t bit = (hash >> 20) & (filterBits - 1);
+                if (!(filter[bit >> 6] & ((uint64_t)1 << (bit & 63)))) continue;
+                size_t h = hash & (tableSize - 1);
+                int32_t other = -1;
+                while (table[h].cell >= 0) {
+                    if (table[h].key == nkey) { other = table[h].cell; break; }
+                    h = (h + 1) & (tableSize - 1);
+                }
+                if (other < 0) continue;
+                for (uint32_t i = cellStart[c]; i < cellStart[c + 1]; ++i) {
+                    unsigned a = cells[i].second;
+                    const float* pa = data + (size_t)a * stride;
+                    uint32_t jStart = (nkey == key) ? i + 1 : cellStart[other];
+                    for (uint32_t j = jStart; j < cellStart[other + 1]; ++j) {
+                        unsigned b = cells[j].second;
+                        const float* pb = data + (size_t)b * stride;
+                        float dx2 = pa[0] - pb[0], dy2 = pa[1] - pb[1], dz2 = pa[2] - pb[2];
+                        if (dx2 * dx2 + dy2 * dy2 + dz2 * dz2 > eps2) continue;
+                        if (opt.matchNormals && normalOffset >= 0) {
+                            const float* na = pa + normalOffset;
+                            const float* nb = pb + normalOffset;
+                            if (na[0] * nb[0] + na[1] * nb[1] + na[2] * nb[2] < opt.normalCosTolerance) continue;
+                        }
+                        if (opt.matchTexcoords && uvOffset >= 0) {
+                            if (std::fabs(pa[uvOffset] - pb[uvOffset]) > uvEps || std::fabs(pa[uvOffset + 1] - pb[uvOffset + 1]) > uvEps) continue;
+                        }
+                        weldUnion(&parent[0], a, b);
+                    }
+                }
+            }
+        }
+    });
+    Clock::time_point t3 = Clock::now();
+
+    // --- 4. 压缩: 根节点按编号顺序获得新编号 (分段前缀和) ---
+    std::vector<unsigned> remap(n);
+    std::vector<size_t> chunkRoots(threads + 1, 0);
+    size_t vchunk = (n + threads - 1) / std::max(threads, 1);
+    parallelFor(threads, threads, [&](size_t begin, size_t end, int) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t lo = std::min(n, t * vchunk), hi = std::min(n, lo + vchunk), roots = 0;
+            for (size_t i = lo; i < hi; ++i) {
+                unsigned r = weldFind(&parent[0], (unsigned)i);
+                remap[i] = r;
+                if (r == i) ++roots;
+            }
+            chunkRoots[t + 1] = roots;
+        }
+    });
+    for (int t = 0; t < threads; ++t) chunkRoots[t + 1] += chunkRoots[t];
+    size_t welded = chunkRoots[threads];
+
+    std::vector<unsigned> newIndex(n);
+    std::vector<float> compacted(welded * stride);
+    parallelFor(threads, threads, [&](size_t begin, size_t end, int) {
+        for (size_t t = begin; t < end; ++t) {
+            size_t lo = std::min(n, t * vchunk), hi = std::min(n, lo + vchunk);
+            unsigned next = (unsigned)chunkRoots[t];
+            for (size_t i = lo; i < hi; ++i) {
+                if (remap[i] != i) continue;
+                newIndex[i] = next;
+                std::memcpy(&compacted[(size_t)next * stride], data + i * stride, stride * sizeof(float));
+                ++next;
+            }
+        }
+    });
+    // 根的编号总小于集合中其它顶点, 上一步已经为所有根分配了新编号
+    parallelFor(n, threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) remap[i] = newIndex[remap[i]];
+    });
+    parallelFor(indices.size(), threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) indices[i] = remap[indices[i]];
+    });
+    vertices.swap(compacted);
+    if (remapOut) remapOut->swap(remap);
+    Clock::time_point t4 = Clock::now();
+
+    result.verticesAfter = welded;
+    result.keyMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.sortMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    result.mergeMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    result.compactMs = std::chrono::duration<double, std::milli>(t4 - t3).count();
+    result.totalMs = std::chrono::duration<double, std::milli>(t4 - t0).count();
+    return result;
+}
+
+/**
+ * @brief 焊接 ObjModel 的顶点 (法线/纹理坐标是否参与比较由 opt 决定)
+ * 索引数量不变, 材质区间仍然有效; 之后再只按位置焊接一次, 重建 positionIndex,
+ * 使文件中重复出现的同一位置共享一个编号, 邻接关系不再被割断
+ */
+inline WeldResult weldObjModel(ObjModel& model, const WeldOptions& opt) {
+    TRACE_FUNCTION();
+    WeldResult result = weldVertices(model.vertices, OBJ_VERTEX_STRIDE, 3, 6, model.indices, opt);
+
+    size_t n = model.vertexCount();
+    std::vector<float> positions(n * 3);
+    for (size_t i = 0; i < n; ++i)
+        for (int k = 0; k < 3; ++k) positions[i * 3 + k] = model.vertices[i * OBJ_VERTEX_STRIDE + k];
+    WeldOptions positionOnly = opt;
+    positionOnly.matchNormals = false;
+    positionOnly.matchTexcoords = false;
+    std::vector<unsigned> noIndices;
+    weldVertices(positions, 3, -1, -1, noIndices, positionOnly, &model.positionIndex);
+    model.positionCount = positions.size() / 3;
+    return result;
+}
+
+#endif
@@ -0,0 +1,237 @@
+// .meshc 编码工具与基准测试 (不需要窗口)
+//
+//   ./meshc banana.obj                     编码为 banana.meshc, 校验解码结果并测试解码速度
+//   ./meshc banana.obj out.meshc --bits 14 位置量化位数 (默认 16)
+//   ./meshc 1000                           合成 1000 x 1000 个四边形的网格 (写入 grid_1000.meshc), 测试大模型的解码速度
+//
+// 输出压缩比 (相对 OBJ 文本和相对未压缩的二进制顶点 + 索引)、编码/解码耗时、量化带来的最大位置/法线/纹理坐标误差,
+// 以及 1 个线程和全部线程的解码吞吐量: 消耗压缩数据的 MB/s (与读取同一个 .meshc 文件的速度对比) 和输出的 GB/s
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "obj_reader.h"
+#include "mesh_codec.h"
+#include "trace.h"
+
+/**
+ * @brief 合成 n x n 个四边形的起伏网格 (共享顶点, 按行排列的三角形)
+ */
+void makeGridModel(int n, ObjModel& model) {
+    TRACE_FUNCTION();
+    model = ObjModel();
+    size_t side = (size_t)n + 1;
+    model.vertices.resize(side * side * OBJ_VERTEX_STRIDE);
+    model.positionIndex.resize(side * side);
+    for (size_t y = 0; y < side; ++y) {
+        for (size_t x = 0; x < side; ++x) {
+            size_t i = y * side + x;
+            float fx = (float)x / n, fy = (float)y / n;
+            float h = 0.05f * std::sin(fx * 25.0f) * std::cos(fy * 17.0f);
+            // 高度场 z = h(x, y) 的法线 (-dh/dx, -dh/dy, 1)
+            float dx = 0.05f * 25.0f * std::cos(fx * 25.0f) * std::cos(fy * 17.0f);
+            float dy = -0.05f * 17.0f * std::sin(fx * 25.0f) * std::sin(fy * 17.0f);
+            Vec3 nrm = normalize(vec3(-dx, -dy, 1.0f));
+            float* v = &model.vertices[i * OBJ_VERTEX_STRIDE];
+            v[0] = fx; v[1] = fy; v[2] = h;
+            v[3] = nrm.x; v[4] = nrm.y; v[5] = nrm.z;
+            v[6] = fx; v[7] = fy;
+            model.positionIndex[i] = (unsigned)i;
+            aabbExpand(model.bounds, vec3(v[0], v[1], v[2]));
+        }
+    }
+    model.positionCount = side * side;
+    model.indices.reserve((size_t)n * n * 6);
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            unsigned a = (unsigned)(y * side + x), b = a + 1, c = a + (unsigned)side, d = c + 1;
+            unsigned quad[6] = { a, b, d, a, d, c };
+            model.indices.insert(model.indices.end(), quad, quad + 6);
+        }
+    }
+    const float gray[3] = { 0.8f, 0.8f, 0.8f };
+    model.materials.push_back(makeObjMaterial("(default)", gray));
+    ObjRange range = { 0, 0, (unsigned)model.indices.size() };
+    model.ranges.push_back(range);
+}
+
+/**
+ * @brief 逐个三角形比较解码结果 (三角形顺序不变, 顶点可能被轮换), 输出最大误差; 拓扑或材质不一致时返回 false
+ */
+bool verifyDecoded(const ObjModel& a, const ObjModel& b) {
+    TRACE_FUNCTION();
+    if (a.indices.size() != b.indices.size() || a.ranges.size() != b.ranges.size() || a.materials.size() != b.materials.size()) {
+        std::cerr << "校验失败: 三角形或材质数量不一致" << std::endl;
+        return false;
+    }
+    for (size_t r = 0; r < a.ranges.size(); ++r) {
+        if (a.ranges[r].material != b.ranges[r].material || a.ranges[r].firstIndex != b.ranges[r].firstIndex ||
+            a.ranges[r].indexCount != b.ranges[r].indexCount) {
+            std::cerr << "校验失败: 材质区间 " << r << " 不一致" << std::endl;
+            return false;
+        }
+    }
+    for (size_t m = 0; m < a.materials.size(); ++m) {
+        if (a.materials[m].name != b.materials[m].name || memcmp(a.materials[m].diffuse, b.materials[m].diffuse, sizeof(a.materials[m].diffuse)) != 0) {
+            std::cerr << "校验失败: 材质 " << a.materials[m].name << " 不一致" << std::endl;
+            return false;
+        }
+    }
+    float maxPos = 0.0f, maxNormalDeg = 0.0f, maxUV = 0.0f;
+    for (size_t t = 0; t < a.indices.size(); t += 3) {
+        float best = FLT_MAX;
+        int bestRot = 0;
+        for (int r = 0; r < 3; ++r) {
+            float err = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                const float* va = &a.vertices[a.indices[t + (k + r) % 3] * OBJ_VERTEX_STRIDE];
+                const float* vb = &b.vertices[b.indices[t + k] * OBJ_VERTEX_STRIDE];
+                for (int c = 0; c < 3; ++c) err = std::max(err, std::fabs(va[c] - vb[c]));
+            }
+            if (err < best) { best = err; bestRot = r; }
+        }
+        maxPos = std::max(maxPos, best);
+        for (int k = 0; k < 3; ++k) {
+            const float* va = &a.vertices[a.indices[t + (k + bestRot) % 3] * OBJ_VERTEX_STRIDE];
+            const float* vb = &b.vertices[b.indices[t + k] * OBJ_VERTEX_STRIDE];
+            Vec3 na = normalize(vec3(va[3], va[4], va[5])), nb = vec3(vb[3], vb[4], vb[5]);
+            float d = std::min(1.0f, std::max(-1.0f, dot(na, nb)));
+            maxNormalDeg = std::max(maxNormalDeg, std::acos(d) * 57.2957795f);
+            maxUV = std::max(maxUV, std::max(std::fabs(va[6] - vb[6]), std::fabs(va[7] - vb[7])));
+        }
+    }
+    Vec3 extent = a.bounds.max - a.bounds.min;
+    std::cout << "最大误差: 位置 " << maxPos << " (包围盒最长边的 " << maxPos / std::max(extent.x, std::max(extent.y, extent.z))
+              << "), 法线 " << maxNormalDeg << " 度, 纹理坐标 " << maxUV << std::endl;
+    return true;
+}
+
+/**
+ * @brief 反复解码到至少 0.3 秒, 返回每次的平均耗时 (ms)
+ */
+double timeDecode(const std::vector<uint8_t>& bytes, ObjModel& decoded, int& runs) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    double elapsed = 0.0;
+    runs = 0;
+    do {
+        decodeMesh(&bytes[0], bytes.size(), decoded);
+        ++runs;
+        elapsed = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    } while (elapsed < 300.0);
+    return elapsed / runs;
+}
+
+/**
+ * @brief 请求系统把文件从页缓存中丢弃, 之后的读取来自磁盘; 不支持时返回 false (macOS 没有 posix_fadvise)
+ */
+bool dropFileCache(const std::string& path) {
+#if defined(POSIX_FADV_DONTNEED)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    fsync(fd);   // 脏页不会被丢弃, 先写回
+    bool ok = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return ok;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("meshc_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <模型.obj | 网格边长> [输出.meshc] [--bits <位置量化位数>]" << std::endl;
+        return 1;
+    }
+    std::string input = argv[1], output;
+    MeshcOptions opt;
+    for (int i = 2; i < argc; ++i) {
+        if (!strcmp(argv[i], "--bits") && i + 1 < argc) opt.positionBits = std::max(1, std::min(16, atoi(argv[++i])));
+        else output = argv[i];
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    ObjModel model;
+    size_t objBytes = 0;
+    double parseMs = 0.0;
+    if (input.find_first_not_of("0123456789") == std::string::npos) {
+        int n = atoi(input.c_str());
+        makeGridModel(n, model);
+        std::cout << "合成网格: " << n << " x " << n << " 个四边形, " << model.vertexCount() << " 个顶点" << std::endl;
+        if (output.empty()) output = "grid_" + input + ".meshc";
+    } else {
+        Clock::time_point t0 = Clock::now();
+        if (!readObj(input, model)) return 1;
+        parseMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        std::ifstream file(input.c_str(), std::ios::binary | std::ios::ate);
+        objBytes = (size_t)file.tellg();
+        if (output.empty()) output = input.substr(0, input.find_last_of('.')) + ".meshc";
+    }
+
+    // --- 编码 ---
+    std::vector<uint8_t> bytes;
+    MeshcStats enc = encodeMesh(model, opt, bytes);
+    if (!output.empty()) {
+        if (!writeMeshc(output, bytes)) return 1;
+        std::cout << "写入 " << output << std::endl;
+    }
+    size_t triangles = model.indices.size() / 3;
+    std::cout << "二进制 (交错顶点 + 索引): " << enc.rawBytes / 1024.0 << " KB -> .meshc: " << enc.encodedBytes / 1024.0
+              << " KB (顶点 " << enc.vertexBytes / 1024.0 << " KB, 索引 " << enc.indexBytes / 1024.0 << " KB, "
+              << 8.0 * enc.indexBytes / std::max<size_t>(triangles, 1) << " 位/三角形)" << std::endl;
+    std::cout << "压缩比: 相对二进制 " << (double)enc.rawBytes / enc.encodedBytes << " : 1";
+    if (objBytes) std::cout << ", 相对 OBJ 文本 (" << objBytes / 1024.0 << " KB) " << (double)objBytes / enc.encodedBytes << " : 1";
+    std::cout << "; 编码耗时 " << enc.ms << " ms" << std::endl;
+
+    // --- 解码: 校验一次 (并与单线程的结果逐位比较), 再分别用 1 个线程和全部线程重复解码 ---
+    ObjModel decoded, single;
+    if (!decodeMesh(&bytes[0], bytes.size(), decoded)) return 1;
+    if (!verifyDecoded(model, decoded)) return 1;
+    int threads = jobSystem().threadCount();
+    jobSystem().setThreadCount(1);
+    if (!decodeMesh(&bytes[0], bytes.size(), single)) return 1;
+    if (single.vertices != decoded.vertices || single.indices != decoded.indices) {
+        std::cerr << "错误: 多线程解码结果与单线程不同" << std::endl;
+        return 1;
+    }
+    double decodeMs = 0.0;
+    for (int t = 1;; t = threads) {
+        jobSystem().setThreadCount(t);
+        int runs = 0;
+        decodeMs = timeDecode(bytes, decoded, runs);
+        std::cout << "解码 " << t << " 线程: " << decodeMs << " ms (" << runs << " 次平均), 消耗压缩数据 "
+                  << enc.encodedBytes / (decodeMs * 1e3) << " MB/s, 输出 " << enc.rawBytes / (decodeMs * 1e6) << " GB/s";
+        if (parseMs > 0) std::cout << "; 解析 OBJ 文本 " << parseMs << " ms (" << parseMs / decodeMs << " 倍)";
+        std::cout << std::endl;
+        if (t == threads) break;
+    }
+    double decodeMBps = enc.encodedBytes / (decodeMs * 1e3);
+
+    // --- 读取同一个文件, 同样重复到至少 0.3 秒取平均 ---
+    // 每次读取前尽量把文件移出页缓存; 做不到时文件还在页缓存中, 得到的是读取速度的上限, 冷缓存或网络存储上更慢
+    std::vector<uint8_t> fileBytes;
+    double readMs = 0.0, readTotal = 0.0;
+    bool cold = true;
+    int runs = 0;
+    do {
+        cold = dropFileCache(output) && cold;
+        if (!readMeshcFile(output, fileBytes, readMs)) return 1;
+        readTotal += readMs;
+        ++runs;
+    } while (readTotal < 300.0);
+    if (fileBytes != bytes) { std::cerr << "错误: 读回的 " << output << " 与编码结果不同" << std::endl; return 1; }
+    readMs = readTotal / runs;
+    double readMBps = fileBytes.size() / (readMs * 1e3);
+    std::cout << "读取 " << output << ": " << readMs << " ms (" << runs << " 次平均, " << (cold ? "冷缓存" : "页缓存") << "), "
+              << readMBps << " MB/s; 解码消耗压缩数据的速度是读取的 " << decodeMBps / readMBps << " 倍" << std::endl;
+    return 0;
+}
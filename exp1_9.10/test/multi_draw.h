@@ -0,0 +1,535 @@
+#ifndef MULTI_DRAW_H
+#define MULTI_DRAW_H
+
+// 多网格合批提交: 所有网格放进共享的 VBO / IBO, 每帧只生成命令缓冲和变换缓冲, 用一次调用提交
+//
+//   MultiDrawBatch batch;
+//   batch.init(meshes, instanceMesh);                  // 需要网格的 CPU 数据仍在; 之后可以释放
+//   batch.submit(SUBMIT_INDIRECT, &draws[0], count);   // draws 按网格排序时合批效果最好
+//
+// 三种提交方式 (submitModeName):
+// - SUBMIT_PER_OBJECT: 每个绘制 glLoadMatrixf + glDrawElements, CPU 时间与绘制数成正比, 作为对照
+// - SUBMIT_INDIRECT: glMultiDrawElementsIndirect (GL 4.3, 或 ARB_multi_draw_indirect + ARB_base_instance).
+//   共享缓冲中每个网格只存一份; 每帧把模型视图矩阵按绘制编号写入变换缓冲, 作为 divisor = 1 的实例属性,
+//   命令的 baseInstance 就是绘制编号, 顶点着色器取到的是变换缓冲的第 baseInstance + gl_InstanceID 行.
+//   相邻的同网格绘制合并为一条 instanceCount > 1 的命令, 所以命令数不超过可见网格的种类数
+// - SUBMIT_MULTI_DRAW: GL 2.1 上的退路 (macOS 的旧版上下文没有间接绘制, 也没有 baseInstance).
+//   小网格的每个实例在另一对共享缓冲中有自己的一份顶点, 顶点带实例编号; 变换按实例编号放在浮点纹理中,
+//   顶点着色器用编号取矩阵; 每帧把可见实例的索引区间交给一次 glMultiDrawElements.
+//   顶点数超过 MULTI_DRAW_MAX_BAKED_VERTICES 的网格不复制, 它们的实例仍逐个提交 (这样的实例通常很少)
+// 两条着色器路径的光照与固定管线相同: 0 号光源 (方向光) 的漫反射加全局环境光, 颜色按网格
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "trace.h"
+
+#ifndef GL_RGBA32F_ARB
+#define GL_RGBA32F_ARB 0x8814
+#endif
+
+// 间接绘制的函数声明只在 GL 4.3 的头文件中有; macOS 的 OpenGL/gl.h 停在 2.1, 这时只编译另外两条路径
+#if defined(GL_VERSION_4_3)
+#define MULTI_DRAW_HAS_INDIRECT 1
+#else
+#define MULTI_DRAW_HAS_INDIRECT 0
+#endif
+
+enum SubmitMode { SUBMIT_PER_OBJECT, SUBMIT_MULTI_DRAW, SUBMIT_INDIRECT, SUBMIT_MODE_COUNT };
+
+inline const char* submitModeName(int mode) {
+    switch (mode) {
+        case SUBMIT_PER_OBJECT: return "逐个提交";
+        case SUBMIT_MULTI_DRAW: return "glMultiDrawElements + 变换纹理";
+        case SUBMIT_INDIRECT: return "glMultiDrawElementsIndirect";
+    }
+    return "?";
+}
+
+const size_t MULTI_DRAW_MAX_BAKED_VERTICES = 1024;   // 退路: 顶点数不超过它的网格才为每个实例复制一份
+const int MULTI_DRAW_MATRICES_PER_ROW = 256;         // 变换纹理每行的矩阵数, 每个矩阵占 4 个纹素 (4 列)
+
+// 一次绘制: 网格 + 实例 + 打包好的模型视图矩阵 (view * world)
+struct DrawCommand {
+    int mesh;
+    int instance;
+    float modelView[16];
+};
+
+// 上传用的网格数据 (位置、法线各 3 个 float 一个顶点)
+struct MultiDrawMesh {
+    const float* positions;
+    const float* normals;
+    const unsigned* indices;
+    size_t vertexCount, indexCount;
+    float color[3];
+};
+
+// 与 GL 规范中 DrawElementsIndirectCommand 的布局相同
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+/**
+ * @brief 当前上下文的 GL 版本是否不低于 major.minor
+ */
+inline bool glVersionAtLeast(int major, int minor) {
+    const char* version = (const char*)glGetString(GL_VERSION);
+    int ma = 0, mi = 0;
+    if (!version || sscanf(version, "%d.%d", &ma, &mi) != 2) return false;
+    return ma > major || (ma == major && mi >= minor);
+}
+
+// 两个着色器程序共用的光照: 与固定管线的方向光 + GL_COLOR_MATERIAL 相同
+const char* multiDrawShadeSource = R"glsl(
+varying vec3 color;
+
+void shade(mat4 modelView, vec3 position, vec3 normal, vec3 baseColor)
+{
+    vec3 n = normalize(mat3(modelView) * normal);
+    vec3 l = normalize(gl_LightSource[0].position.xyz);
+    // 固定管线在插值之前截断逐顶点颜色
+    color = min(baseColor * (gl_LightModel.ambient.rgb + max(dot(n, l), 0.0) * gl_LightSource[0].diffuse.rgb), 1.0);
+    gl_Position = gl_ProjectionMatrix * (modelView * vec4(position, 1.0));
+}
+)glsl";
+
+// 退路: 按顶点上的实例编号从变换纹理中取矩阵
+const char* multiDrawTextureVertexSource = R"glsl(
+uniform sampler2D transforms;
+uniform vec2 texelSize;
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+attribute vec3 aColor;
+attribute float aInstance;
+
+vec4 column(float x, float row)
+{
+    return texture2DLod(transforms, vec2(x + 0.5, row + 0.5) * texelSize, 0.0);
+}
+
+void main()
+{
+    float row = floor(aInstance / MATRICES_PER_ROW);
+    float x = (aInstance - row * MATRICES_PER_ROW) * 4.0;
+    mat4 modelView = mat4(column(x, row), column(x + 1.0, row), column(x + 2.0, row), column(x + 3.0, row));
+    shade(modelView, aPosition, aNormal, aColor);
+}
+)glsl";
+
+// 间接绘制: 矩阵是实例属性, baseInstance 选中变换缓冲的行
+const char* multiDrawIndirectVertexSource = R"glsl(
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+attribute vec3 aColor;
+attribute vec4 aModelView0;
+attribute vec4 aModelView1;
+attribute vec4 aModelView2;
+attribute vec4 aModelView3;
+
+void main()
+{
+    shade(mat4(aModelView0, aModelView1, aModelView2, aModelView3), aPosition, aNormal, aColor);
+}
+)glsl";
+
+const char* multiDrawFragmentSource = R"glsl(
+#version 120
+varying vec3 color;
+
+void main()
+{
+    gl_FragColor = vec4(color, 1.0);
+}
+)glsl";
+
+class MultiDrawBatch {
+public:
+    // 顶点属性编号 (两个程序相同)
+    enum { ATTRIB_POSITION = 0, ATTRIB_NORMAL = 1, ATTRIB_COLOR = 2, ATTRIB_INSTANCE = 3, ATTRIB_MODEL_VIEW = 4 };
+
+    MultiDrawBatch() : vbo_(0), ibo_(0), bakedVbo_(0), bakedIbo_(0), transformTex_(0), textureRows_(0),
+                       textureProgram_(0), indirectProgram_(0), commandBuffer_(0), transformBuffer_(0), calls_(0) {
+        for (int mode = 0; mode < SUBMIT_MODE_COUNT; ++mode) supported_[mode] = mode == SUBMIT_PER_OBJECT;
+    }
+
+    /**
+     * @brief 上传共享缓冲, 编译着色器, 检查各提交方式是否可用
+     * instanceMesh[i] 是实例 i 的网格; 提交时 DrawCommand::instance 必须小于 instanceMesh.size()
+     */
+    void init(const std::vector<MultiDrawMesh>& meshes, const std::vector<int>& instanceMesh) {
+        TRACE_FUNCTION();
+        const size_t stride = 9;   // 位置 3 + 法线 3 + 颜色 3
+
+        // --- 每个网格一份 (逐个提交 / 间接绘制) ---
+        // 索引在上传时加上网格的起始顶点, 所以不需要 baseVertex
+        size_t totalVertices = 0, totalIndices = 0;
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            totalVertices += meshes[m].vertexCount;
+            totalIndices += meshes[m].indexCount;
+        }
+        std::vector<float> vertices(totalVertices * stride);
+        std::vector<unsigned> indices(totalIndices);
+        firstIndex_.resize(meshes.size());
+        indexCount_.resize(meshes.size());
+        size_t vertex = 0, index = 0;
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            const MultiDrawMesh& src = meshes[m];
+            writeVertices(src, &vertices[vertex * stride], stride);
+            for (size_t i = 0; i < src.indexCount; ++i) indices[index + i] = (unsigned)vertex + src.indices[i];
+            firstIndex_[m] = (GLuint)index;
+            indexCount_[m] = (GLuint)src.indexCount;
+            vertex += src.vertexCount;
+            index += src.indexCount;
+        }
+        glGenBuffers(1, &vbo_);
+        glGenBuffers(1, &ibo_);
+        uploadBuffers(vbo_, ibo_, vertices, indices);
+
+        // --- 退路: 小网格的每个实例一份, 顶点带实例编号 ---
+        const size_t bakedStride = stride + 1;
+        size_t bakedVertices = 0, bakedIndices = 0, bakedInstances = 0;
+        for (size_t i = 0; i < instanceMesh.size(); ++i) {
+            const MultiDrawMesh& src = meshes[instanceMesh[i]];
+            if (src.vertexCount > MULTI_DRAW_MAX_BAKED_VERTICES) continue;
+            bakedVertices += src.vertexCount;
+            bakedIndices += src.indexCount;
+            ++bakedInstances;
+        }
+        vertices.assign(bakedVertices * bakedStride, 0.0f);
+        indices.assign(bakedIndices, 0);
+        instanceOffset_.assign(instanceMesh.size(), 0);
+        instanceCount_.assign(instanceMesh.size(), 0);
+        vertex = index = 0;
+        for (size_t i = 0; i < instanceMesh.size(); ++i) {
+            const MultiDrawMesh& src = meshes[instanceMesh[i]];
+            if (src.vertexCount > MULTI_DRAW_MAX_BAKED_VERTICES) continue;
+            writeVertices(src, &vertices[vertex * bakedStride], bakedStride);
+            for (size_t v = 0; v < src.vertexCount; ++v) vertices[(vertex + v) * bakedStride + stride] = (float)i;
+            for (size_t k = 0; k < src.indexCount; ++k) indices[index + k] = (unsigned)vertex + src.indices[k];
+            instanceOffset_[i] = (const GLvoid*)(index * sizeof(unsigned));
+            instanceCount_[i] = (GLsizei)src.indexCount;
+            vertex += src.vertexCount;
+            index += src.indexCount;
+        }
+        glGenBuffers(1, &bakedVbo_);
+        glGenBuffers(1, &bakedIbo_);
+        uploadBuffers(bakedVbo_, bakedIbo_, vertices, indices);
+
+        // 变换纹理: 每行 MULTI_DRAW_MATRICES_PER_ROW 个矩阵
+        textureRows_ = std::max(1, (int)((instanceMesh.size() + MULTI_DRAW_MATRICES_PER_ROW - 1) / MULTI_DRAW_MATRICES_PER_ROW));
+        transforms_.assign((size_t)textureRows_ * MULTI_DRAW_MATRICES_PER_ROW * 16, 0.0f);
+        supported_[SUBMIT_PER_OBJECT] = true;
+        supported_[SUBMIT_MULTI_DRAW] = textureFetchSupported();
+        supported_[SUBMIT_INDIRECT] = MULTI_DRAW_HAS_INDIRECT && (glVersionAtLeast(4, 3) ||
+            (glutExtensionSupported("GL_ARB_multi_draw_indirect") && glutExtensionSupported("GL_ARB_base_instance") &&
+             glutExtensionSupported("GL_ARB_instanced_arrays")));
+        if (supported_[SUBMIT_MULTI_DRAW]) {
+            glGenTextures(1, &transformTex_);
+            glBindTexture(GL_TEXTURE_2D, transformTex_);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, MULTI_DRAW_MATRICES_PER_ROW * 4, textureRows_, 0, GL_RGBA, GL_FLOAT, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            std::string vs = std::string("#version 120\n#define MATRICES_PER_ROW ") + std::to_string(MULTI_DRAW_MATRICES_PER_ROW)
+                           + ".0\n" + multiDrawShadeSource + multiDrawTextureVertexSource;
+            textureProgram_ = buildProgram(vs.c_str());
+            supported_[SUBMIT_MULTI_DRAW] = textureProgram_ != 0;
+            if (textureProgram_) {
+                glUseProgram(textureProgram_);
+                glUniform1i(glGetUniformLocation(textureProgram_, "transforms"), 0);
+                glUniform2f(glGetUniformLocation(textureProgram_, "texelSize"), 1.0f / (MULTI_DRAW_MATRICES_PER_ROW * 4), 1.0f / textureRows_);
+                glUseProgram(0);
+            }
+        }
+        if (supported_[SUBMIT_INDIRECT]) {
+            std::string vs = std::string("#version 120\n") + multiDrawShadeSource + multiDrawIndirectVertexSource;
+            indirectProgram_ = buildProgram(vs.c_str());
+            supported_[SUBMIT_INDIRECT] = indirectProgram_ != 0;
+            glGenBuffers(1, &commandBuffer_);
+            glGenBuffers(1, &transformBuffer_);
+        }
+        std::cout << "合批提交: " << meshes.size() << " 个网格共享 " << totalVertices << " 个顶点, " << bakedInstances << " / "
+                  << instanceMesh.size() << " 个实例复制到退路缓冲 (" << bakedVertices * bakedStride * sizeof(float) / 1024.0
+                  << " KB); 变换纹理 " << textureRows_ << " 行; 可用:";
+        for (int mode = 0; mode < SUBMIT_MODE_COUNT; ++mode)
+            if (supported_[mode]) std::cout << " [" << submitModeName(mode) << "]";
+        std::cout << std::endl;
+    }
+
+    bool supported(int mode) const { return mode >= 0 && mode < SUBMIT_MODE_COUNT && supported_[mode]; }
+
+    /**
+     * @brief mode 之后的下一个可用的提交方式 (循环)
+     */
+    SubmitMode nextSupported(int mode) const {
+        for (int i = 1; i <= SUBMIT_MODE_COUNT; ++i) {
+            int m = (mode + i) % SUBMIT_MODE_COUNT;
+            if (supported_[m]) return (SubmitMode)m;
+        }
+        return SUBMIT_PER_OBJECT;
+    }
+
+    // 上一次 submit 发出的绘制调用数
+    size_t lastCalls() const { return calls_; }
+
+    /**
+     * @brief 提交一帧的绘制; 调用前应已设置投影矩阵和 0 号光源, 返回后模型视图矩阵不变
+     * 不可用的方式退回逐个提交
+     */
+    void submit(int mode, const DrawCommand* draws, size_t count) {
+        TRACE_FUNCTION();
+        calls_ = 0;
+        if (count == 0) return;
+        if (!supported(mode)) mode = SUBMIT_PER_OBJECT;
+        if (mode == SUBMIT_MULTI_DRAW) submitMultiDraw(draws, count);
+        else if (mode == SUBMIT_INDIRECT) submitIndirect(draws, count);
+        else submitPerObject(draws, count, false);
+    }
+
+private:
+    static void writeVertices(const MultiDrawMesh& src, float* out, size_t stride) {
+        for (size_t v = 0; v < src.vertexCount; ++v) {
+            float* dst = out + v * stride;
+            for (int k = 0; k < 3; ++k) {
+                dst[k] = src.positions[v * 3 + k];
+                dst[3 + k] = src.normals[v * 3 + k];
+                dst[6 + k] = src.color[k];
+            }
+        }
+    }
+
+    static void uploadBuffers(GLuint vbo, GLuint ibo, const std::vector<float>& vertices, const std::vector<unsigned>& indices) {
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.empty() ? 0 : &vertices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned), indices.empty() ? 0 : &indices[0], GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // 退路需要着色器、顶点着色器纹理采样和浮点纹理, 变换纹理的高度不能超过最大纹理尺寸
+    bool textureFetchSupported() const {
+        GLint vertexUnits = 0, maxSize = 0;
+        glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexUnits);
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+        return glVersionAtLeast(2, 0) && vertexUnits > 0 && textureRows_ <= maxSize && maxSize >= MULTI_DRAW_MATRICES_PER_ROW * 4 &&
+               (glVersionAtLeast(3, 0) || glutExtensionSupported("GL_ARB_texture_float"));
+    }
+
+    /**
+     * @brief 编译并链接程序, 出错时打印日志并返回 0
+     */
+    static GLuint buildProgram(const char* vertexSource) {
+        GLint ok = 0;
+        char log[1024];
+        GLuint vs = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vs, 1, &vertexSource, NULL);
+        glCompileShader(vs);
+        glGetShaderiv(vs, GL_COMPILE_STATUS, &ok);
+        if (!ok) { glGetShaderInfoLog(vs, sizeof(log), NULL, log); std::cerr << "合批顶点着色器编译失败:\n" << log << std::endl; }
+        GLuint fs = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fs, 1, &multiDrawFragmentSource, NULL);
+        glCompileShader(fs);
+
+        GLuint program = glCreateProgram();
+        glAttachShader(program, vs);
+        glAttachShader(program, fs);
+        glBindAttribLocation(program, ATTRIB_POSITION, "aPosition");
+        glBindAttribLocation(program, ATTRIB_NORMAL, "aNormal");
+        glBindAttribLocation(program, ATTRIB_COLOR, "aColor");
+        glBindAttribLocation(program, ATTRIB_INSTANCE, "aInstance");
+        for (int c = 0; c < 4; ++c)
+            glBindAttribLocation(program, ATTRIB_MODEL_VIEW + c, ("aModelView" + std::to_string(c)).c_str());
+        glLinkProgram(program);
+        glGetProgramiv(program, GL_LINK_STATUS, &ok);
+        glDeleteShader(vs);
+        glDeleteShader(fs);
+        if (!ok) {
+            glGetProgramInfoLog(program, sizeof(log), NULL, log);
+            std::cerr << "合批着色器链接失败:\n" << log << std::endl;
+            glDeleteProgram(program);
+            return 0;
+        }
+        return program;
+    }
+
+    // 共享缓冲中位置、法线、颜色三个属性的指针
+    static void setVertexAttribs(size_t stride) {
+        GLsizei bytes = (GLsizei)(stride * sizeof(float));
+        glEnableVertexAttribArray(ATTRIB_POSITION);
+        glEnableVertexAttribArray(ATTRIB_NORMAL);
+        glEnableVertexAttribArray(ATTRIB_COLOR);
+        glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, bytes, (void*)0);
+        glVertexAttribPointer(ATTRIB_NORMAL, 3, GL_FLOAT, GL_FALSE, bytes, (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, bytes, (void*)(6 * sizeof(float)));
+    }
+
+    static void clearVertexAttribs() {
+        glDisableVertexAttribArray(ATTRIB_POSITION);
+        glDisableVertexAttribArray(ATTRIB_NORMAL);
+        glDisableVertexAttribArray(ATTRIB_COLOR);
+    }
+
+    /**
+     * @brief 固定管线逐个提交; skipBaked 为 true 时跳过已在退路缓冲中提交过的实例
+     */
+    void submitPerObject(const DrawCommand* draws, size_t count, bool skipBaked) {
+        TRACE_FUNCTION();
+        const GLsizei stride = 9 * sizeof(float);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glEnableClientState(GL_COLOR_ARRAY);
+        glVertexPointer(3, GL_FLOAT, stride, (void*)0);
+        glNormalPointer(GL_FLOAT, stride, (void*)(3 * sizeof(float)));
+        glColorPointer(3, GL_FLOAT, stride, (void*)(6 * sizeof(float)));
+        glMatrixMode(GL_MODELVIEW);
+        glPushMatrix();
+        for (size_t d = 0; d < count; ++d) {
+            const DrawCommand& cmd = draws[d];
+            if (skipBaked && instanceCount_[cmd.instance] > 0) continue;
+            glLoadMatrixf(cmd.modelView);
+            glDrawElements(GL_TRIANGLES, (GLsizei)indexCount_[cmd.mesh], GL_UNSIGNED_INT, (void*)(firstIndex_[cmd.mesh] * sizeof(unsigned)));
+            ++calls_;
+        }
+        glPopMatrix();
+        glDisableClientState(GL_COLOR_ARRAY);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    /**
+     * @brief GL 2.1 退路: 可见实例的矩阵写入变换纹理 (只上传改动的行), 索引区间交给一次 glMultiDrawElements
+     */
+    void submitMultiDraw(const DrawCommand* draws, size_t count) {
+        TRACE_FUNCTION();
+        counts_.clear();
+        offsets_.clear();
+        int rowMin = textureRows_, rowMax = -1;
+        bool leftovers = false;
+        for (size_t d = 0; d < count; ++d) {
+            int inst = draws[d].instance;
+            if (instanceCount_[inst] == 0) { leftovers = true; continue; }
+            memcpy(&transforms_[(size_t)inst * 16], draws[d].modelView, 16 * sizeof(float));
+            int row = inst / MULTI_DRAW_MATRICES_PER_ROW;
+            rowMin = std::min(rowMin, row);
+            rowMax = std::max(rowMax, row);
+            counts_.push_back(instanceCount_[inst]);
+            offsets_.push_back(instanceOffset_[inst]);
+        }
+        if (!counts_.empty()) {
+            glBindTexture(GL_TEXTURE_2D, transformTex_);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rowMin, MULTI_DRAW_MATRICES_PER_ROW * 4, rowMax - rowMin + 1, GL_RGBA, GL_FLOAT,
+                            &transforms_[(size_t)rowMin * MULTI_DRAW_MATRICES_PER_ROW * 16]);
+            glUseProgram(textureProgram_);
+            glBindBuffer(GL_ARRAY_BUFFER, bakedVbo_);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bakedIbo_);
+            setVertexAttribs(10);
+            glEnableVertexAttribArray(ATTRIB_INSTANCE);
+            glVertexAttribPointer(ATTRIB_INSTANCE, 1, GL_FLOAT, GL_FALSE, 10 * sizeof(float), (void*)(9 * sizeof(float)));
+            glMultiDrawElements(GL_TRIANGLES, &counts_[0], GL_UNSIGNED_INT, &offsets_[0], (GLsizei)counts_.size());
+            ++calls_;
+            glDisableVertexAttribArray(ATTRIB_INSTANCE);
+            clearVertexAttribs();
+            glUseProgram(0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        if (leftovers) submitPerObject(draws, count, true);
+    }
+
+    /**
+     * @brief 间接绘制: 生成本帧的命令缓冲和变换缓冲, 一次 glMultiDrawElementsIndirect
+     */
+    void submitIndirect(const DrawCommand* draws, size_t count) {
+        TRACE_FUNCTION();
+#if MULTI_DRAW_HAS_INDIRECT
+        commands_.clear();
+        drawTransforms_.resize(count * 16);
+        int lastMesh = -1;
+        for (size_t d = 0; d < count; ++d) {
+            memcpy(&drawTransforms_[d * 16], draws[d].modelView, 16 * sizeof(float));
+            if (draws[d].mesh == lastMesh) {
+                ++commands_.back().instanceCount;   // 变换缓冲中紧接着的一行
+                continue;
+            }
+            DrawElementsIndirectCommand cmd = { indexCount_[draws[d].mesh], 1, firstIndex_[draws[d].mesh], 0, (GLuint)d };
+            commands_.push_back(cmd);
+            lastMesh = draws[d].mesh;
+        }
+
+        // 每帧整块重新分配 (orphan), 不等待 GPU 读完上一帧的内容
+        glBindBuffer(GL_ARRAY_BUFFER, transformBuffer_);
+        glBufferData(GL_ARRAY_BUFFER, drawTransforms_.size() * sizeof(float), &drawTransforms_[0], GL_STREAM_DRAW);
+        for (int c = 0; c < 4; ++c) {
+            glEnableVertexAttribArray(ATTRIB_MODEL_VIEW + c);
+            glVertexAttribPointer(ATTRIB_MODEL_VIEW + c, 4, GL_FLOAT, GL_FALSE, 16 * sizeof(float), (void*)(c * 4 * sizeof(float)));
+            glVertexAttribDivisor(ATTRIB_MODEL_VIEW + c, 1);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer_);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands_.size() * sizeof(DrawElementsIndirectCommand), &commands_[0], GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo_);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo_);
+        setVertexAttribs(9);
+        glUseProgram(indirectProgram_);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, (GLsizei)commands_.size(), 0);
+        ++calls_;
+
+        glUseProgram(0);
+        clearVertexAttribs();
+        for (int c = 0; c < 4; ++c) {
+            glVertexAttribDivisor(ATTRIB_MODEL_VIEW + c, 0);
+            glDisableVertexAttribArray(ATTRIB_MODEL_VIEW + c);
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+#else
+        submitPerObject(draws, count, false);
+#endif
+    }
+
+    // 共享缓冲 (每个网格一份)
+    GLuint vbo_, ibo_;
+    std::vector<GLuint> firstIndex_, indexCount_;
+
+    // 退路: 每个实例一份, instanceCount_ 为 0 的实例没有复制
+    GLuint bakedVbo_, bakedIbo_;
+    std::vector<const GLvoid*> instanceOffset_;
+    std::vector<GLsizei> instanceCount_;
+    GLuint transformTex_;
+    int textureRows_;
+    std::vector<float> transforms_;          // 按实例编号, 与变换纹理的内容相同
+    std::vector<GLsizei> counts_;            // 每帧的 glMultiDrawElements 参数
+    std::vector<const GLvoid*> offsets_;
+
+    GLuint textureProgram_, indirectProgram_;
+
+    // 间接绘制
+    GLuint commandBuffer_, transformBuffer_;
+    std::vector<DrawElementsIndirectCommand> commands_;
+    std::vector<float> drawTransforms_;      // 按绘制编号
+
+    bool supported_[SUBMIT_MODE_COUNT];
+    size_t calls_;
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef OBJ_BLOCKS_H
+#define OBJ_BLOCKS_H
+
+// OBJ 文本的分块并行解析 (readObj 和 cube / pyramid 的加载共用)
+// 文本按行边界切成若干块: 各块先并行计数, 前缀和得到每块的全局起始编号, 再并行解析到预先分配的数组;
+// 结果与逐行顺序解析完全相同
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+
+#include "obj_parse.h"
+#include "job_system.h"
+#include "trace.h"
+
+// (v, vt, vn) 三元组作为顶点去重的键
+struct ObjCornerKey {
+    int v, vt, vn;
+    bool operator==(const ObjCornerKey& o) const { return v == o.v && vt == o.vt && vn == o.vn; }
+};
+
+// 文本中的一段连续的行, 由一个任务解析
+struct ObjTextBlock {
+    const char* begin;
+    const char* end;
+    // 第一遍: 本块内的数量
+    size_t positions, texcoords, normals, faces, corners;
+    // 前缀和: 本块第一个元素的全局编号
+    size_t firstPosition, firstTexcoord, firstNormal, firstFace, firstCorner;
+};
+
+// 影响后续面的状态行 (mtllib / usemtl / g / o), 按文件顺序在主线程上处理
+enum ObjDirectiveType { OBJ_MTLLIB, OBJ_USEMTL, OBJ_GROUP };
+
+struct ObjDirective {
+    ObjDirectiveType type;
+    size_t face;          // 出现在第几个 "f" 之前 (全局编号)
+    std::string text;
+};
+
+/**
+ * @brief 第一遍: 统计一段文本中各类元素的数量
+ */
+inline void countObjBlock(ObjTextBlock& b) {
+    b.positions = b.texcoords = b.normals = b.faces = b.corners = 0;
+    for (const char* s = b.begin; s < b.end; s = nextLine(s)) {
+        s = skipBlanks(s);
+        if (isKeyword(s, "v")) ++b.positions;
+        else if (isKeyword(s, "vt")) ++b.texcoords;
+        else if (isKeyword(s, "vn")) ++b.normals;
+        else if (isKeyword(s, "f")) {
+            ++b.faces;
+            const char* p = skipBlanks(s + 1);
+            while (isTokenChar(*p) && *p != '#') {
+                ++b.corners;
+                while (isTokenChar(*p)) ++p;
+                p = skipBlanks(p);
+            }
+        }
+    }
+}
+
+/**
+ * @brief 把以 '\0' 结尾的文本按行边界切成若干块, 在任务调度器上并行计数, 前缀和得到每块的全局起始编号
+ * 返回的块中 positions / faces 等字段为全部块的合计
+ */
+inline ObjTextBlock countObjBlocks(const char* text, std::vector<ObjTextBlock>& blocks) {
+    TRACE_FUNCTION();
+    JobSystem& js = jobSystem();
+    blocks.clear();
+    {
+        size_t length = strlen(text);
+        const size_t minBlockBytes = 256 * 1024;
+        size_t blockCount = std::max<size_t>(1, std::min<size_t>(js.threadCount() * 8, length / minBlockBytes));
+        const char* begin = text;
+        for (size_t i = 1; i <= blockCount && *begin; ++i) {
+            const char* end = i == blockCount ? text + length : nextLine(text + length * i / blockCount);
+            if (end <= begin) continue;
+            ObjTextBlock b;
+            memset(&b, 0, sizeof(b));
+            b.begin = begin;
+            b.end = end;
+            blocks.push_back(b);
+            begin = end;
+        }
+    }
+    size_t blockCount = blocks.size();
+    js.parallelFor(blockCount, (int)blockCount, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) countObjBlock(blocks[i]);
+    });
+    ObjTextBlock total;
+    memset(&total, 0, sizeof(total));
+    for (size_t i = 0; i < blockCount; ++i) {
+        ObjTextBlock& b = blocks[i];
+        b.firstPosition = total.positions; total.positions += b.positions;
+        b.firstTexcoord = total.texcoords; total.texcoords += b.texcoords;
+        b.firstNormal = total.normals;     total.normals += b.normals;
+        b.firstFace = total.faces;         total.faces += b.faces;
+        b.firstCorner = total.corners;     total.corners += b.corners;
+    }
+    return total;
+}
+
+/**
+ * @brief 第二遍: 把一段文本中的数据写入全局数组中属于本块的位置
+ * 负索引相对于 "到这一行为止" 的全局数量, 与逐行顺序解析的结果相同;
+ * 越界的角记为 v = -1 (跳过), 每个面记录第一个角的位置和有效角数
+ */
+inline void parseObjBlock(const ObjTextBlock& b, float* positions, float* texcoords, float* normals,
+                          ObjCornerKey* corners, size_t* faceCorner, unsigned* faceValid,
+                          std::vector<ObjDirective>& directives) {
+    size_t v = b.firstPosition, vt = b.firstTexcoord, vn = b.firstNormal, f = b.firstFace, c = b.firstCorner;
+    for (const char* s = b.begin; s < b.end; s = nextLine(s)) {
+        s = skipBlanks(s);
+        if (isKeyword(s, "v")) {
+            parseFloats(s + 1, positions + 3 * v++, 3);
+        } else if (isKeyword(s, "vt")) {
+            parseFloats(s + 2, texcoords + 2 * vt++, 2);
+        } else if (isKeyword(s, "vn")) {
+            parseFloats(s + 2, normals + 3 * vn++, 3);
+        } else if (isKeyword(s, "f")) {
+            int numV = (int)v, numVt = (int)vt, numVn = (int)vn;
+            unsigned valid = 0;
+            faceCorner[f] = c;
+            const char* p = skipBlanks(s + 1);
+            while (isTokenChar(*p) && *p != '#') {
+                ObjCornerKey& key = corners[c++];
+                parseObjCorner(p, numV, numVt, numVn, key.v, key.vt, key.vn);
+                p = skipBlanks(p);
+                if (key.v < 0 || key.v >= numV) { key.v = -1; continue; }
+                if (key.vt >= numVt) key.vt = -1;
+                if (key.vn >= numVn) key.vn = -1;
+                ++valid;
+            }
+            faceValid[f++] = valid;
+        } else if (isKeyword(s, "mtllib")) {
+            ObjDirective d = { OBJ_MTLLIB, f, parseName(s + 6) };
+            directives.push_back(d);
+        } else if (isKeyword(s, "usemtl")) {
+            ObjDirective d = { OBJ_USEMTL, f, parseName(s + 6) };
+            directives.push_back(d);
+        } else if (isKeyword(s, "g") || isKeyword(s, "o")) {
+            ObjDirective d = { OBJ_GROUP, f, parseName(s + 1) };
+            directives.push_back(d);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+// 供场景查看器使用的通用 OBJ 加载器
+// 与各个 viewer 中的 loadOBJ 不同, 这里把模型整理成按位置索引的网格,
+// 方便一次性上传到显存, 再用 glDrawElements 绘制任意多个实例
+//
+// 加载分两遍: 先对整个文件做一次计数预扫描, 再按计数结果一次性申请内存,
+// 避免 push_back 反复扩容和拷贝. 常驻数据 (位置/法线/索引) 放在 Mesh::arena 中,
+// 只在加载期间使用的数据 (文件文本、文件法线池等) 放在临时 arena 中, 加载结束后整块释放
+
+#include <iostream>
+#include <string>
+
+#include "math3d.h"
+#include "mesh_arena.h"
+#include "obj_parse.h"
+#include "trace.h"
+
+struct Mesh {
+    MeshArena arena;             // 常驻数据所在的唯一一块内存
+    float* positions;            // x, y, z 连续存放
+    float* normals;              // 与 positions 一一对应
+    unsigned* indices;           // 每三个构成一个三角形
+    size_t vertexCount;
+    size_t indexCount;
+    AABB bounds;
+
+    // 内存统计
+    size_t residentBytes;        // 加载完成后仍占用的字节数
+    size_t peakBytes;            // 加载过程中的峰值字节数
+
+    Mesh() : positions(0), normals(0), indices(0), vertexCount(0), indexCount(0),
+             bounds(aabbEmpty()), residentBytes(0), peakBytes(0) {}
+
+    /**
+     * @brief 数据已经上传到显存后, 可以调用此函数归还 CPU 端的常驻内存 (包围盒保留)
+     */
+    void releaseCPUData() {
+        arena.release();
+        positions = normals = 0;
+        indices = 0;
+        residentBytes = 0;
+    }
+};
+
+/**
+ * @brief 加载 OBJ 文件为按位置索引的网格
+ * - 多边形面按扇形拆分为三角形
+ * - 文件中的法线按其引用的位置累加后归一化; 没有法线时使用面法线累加
+ */
+inline bool loadMesh(const std::string& filename, Mesh& mesh) {
+    TRACE_FUNCTION();
+    // --- 1. 读入文本并计数 ---
+    MeshArena textArena;
+    const char* text = readFileText(filename, textArena);
+    if (!text) return false;
+    ObjCounts counts = countObj(text);
+
+    // --- 2. 一次性申请常驻内存和临时内存 ---
+    size_t residentSize = MeshArena::footprint<float>(counts.positions * 3) * 2
+                        + MeshArena::footprint<unsigned>(counts.triangles * 3);
+    size_t scratchSize = MeshArena::footprint<float>(counts.normals * 3)
+                       + MeshArena::footprint<int>(counts.triangles * 3)
+                       + MeshArena::footprint<int>(counts.maxCorners) * 2;
+    MeshArena scratch;
+    if (!mesh.arena.reserve(residentSize) || !scratch.reserve(scratchSize)) return false;
+
+    mesh.positions = mesh.arena.alloc<float>(counts.positions * 3);
+    mesh.normals = mesh.arena.alloc<float>(counts.positions * 3);
+    mesh.indices = mesh.arena.alloc<unsigned>(counts.triangles * 3);
+    float* fileNormals = scratch.alloc<float>(counts.normals * 3);
+    int* cornerNormals = scratch.alloc<int>(counts.triangles * 3); // 与 indices 对应的文件法线索引
+    int* polyV = scratch.alloc<int>(counts.maxCorners);
+    int* polyVn = scratch.alloc<int>(counts.maxCorners);
+
+    // --- 3. 解析 ---
+    int numV = 0, numVn = 0;
+    size_t numIndices = 0;
+    mesh.bounds = aabbEmpty();
+    for (const char* s = text; *s; s = nextLine(s)) {
+        s = skipBlanks(s);
+        if (isKeyword(s, "v")) {
+            float* p = mesh.positions + numV * 3;
+            parseFloats(s + 1, p, 3);
+            aabbExpand(mesh.bounds, vec3(p[0], p[1], p[2]));
+            ++numV;
+        } else if (isKeyword(s, "vn")) {
+            parseFloats(s + 2, fileNormals + numVn * 3, 3);
+            ++numVn;
+        } else if (isKeyword(s, "f")) {
+            size_t corners = 0;
+            const char* p = skipBlanks(s + 1);
+            while (isTokenChar(*p) && *p != '#' && corners < counts.maxCorners) {
+                int v, vt, vn;
+                parseObjCorner(p, numV, 0, numVn, v, vt, vn);
+                p = skipBlanks(p);
+                if (v < 0 || v >= numV) continue;
+                polyV[corners] = v;
+                polyVn[corners] = vn;
+                ++corners;
+            }
+            // 扇形三角化: (0, i, i+1)
+            for (size_t i = 1; i + 1 < corners; ++i) {
+                size_t tri[3] = { 0, i, i + 1 };
+                for (int k = 0; k < 3; ++k) {
+                    mesh.indices[numIndices] = (unsigned)polyV[tri[k]];
+                    cornerNormals[numIndices] = polyVn[tri[k]];
+                    ++numIndices;
+                }
+            }
+        }
+    }
+    mesh.vertexCount = numV;
+    mesh.indexCount = numIndices;
+
+    // --- 4. 累加并归一化法线 ---
+    for (size_t i = 0; i < mesh.vertexCount * 3; ++i) mesh.normals[i] = 0.0f;
+    for (size_t t = 0; t + 2 < numIndices; t += 3) {
+        const float* a = mesh.positions + mesh.indices[t] * 3;
+        const float* b = mesh.positions + mesh.indices[t + 1] * 3;
+        const float* c = mesh.positions + mesh.indices[t + 2] * 3;
+        Vec3 faceNormal = cross(vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+        for (int k = 0; k < 3; ++k) {
+            int vn = cornerNormals[t + k];
+            const float* n = (vn >= 0 && vn < numVn) ? fileNormals + vn * 3 : &faceNormal.x;
+            float* dst = mesh.normals + mesh.indices[t + k] * 3;
+            dst[0] += n[0]; dst[1] += n[1]; dst[2] += n[2];
+        }
+    }
+    for (size_t i = 0; i < mesh.vertexCount; ++i) {
+        float* n = mesh.normals + i * 3;
+        Vec3 u = normalize(vec3(n[0], n[1], n[2]));
+        n[0] = u.x; n[1] = u.y; n[2] = u.z;
+    }
+
+    // --- 5. 整块释放临时内存 ---
+    mesh.residentBytes = mesh.arena.bytesReserved();
+    mesh.peakBytes = mesh.residentBytes + textArena.bytesReserved() + scratch.bytesReserved();
+    scratch.release();
+    textArena.release();
+
+    std::cout << "模型加载成功 " << filename << ": " << mesh.vertexCount << " 个顶点, "
+              << mesh.indexCount / 3 << " 个三角面, 常驻 " << mesh.residentBytes / 1024.0
+              << " KB, 峰值 " << mesh.peakBytes / 1024.0 << " KB." << std::endl;
+    return true;
+}
+
+#endif
@@ -0,0 +1,130 @@
+#ifndef OBJ_PARSE_H
+#define OBJ_PARSE_H
+
+// OBJ/MTL 文本解析的公共小工具
+// 整个文件先读入内存 (以 '\0' 结尾), 之后按行用指针扫描, 不经过 stringstream
+
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <cstdlib>
+
+#include "mesh_arena.h"
+
+// --- 计数预扫描 ---
+struct ObjCounts {
+    size_t positions, texcoords, normals, faces, triangles;
+    size_t maxCorners;           // 单个面最多的角数
+};
+
+inline const char* skipBlanks(const char* s) {
+    while (*s == ' ' || *s == '\t' || *s == '\r') ++s;
+    return s;
+}
+
+inline const char* nextLine(const char* s) {
+    while (*s && *s != '\n') ++s;
+    return *s ? s + 1 : s;
+}
+
+inline bool isTokenChar(char c) {
+    return c && c != ' ' && c != '\t' && c != '\r' && c != '\n';
+}
+
+/**
+ * @brief 判断行首是否为关键字 keyword (其后必须是空白或行尾)
+ */
+inline bool isKeyword(const char* s, const char* keyword) {
+    while (*keyword) {
+        if (*s++ != *keyword++) return false;
+    }
+    return !isTokenChar(*s);
+}
+
+/**
+ * @brief 统计以 '\0' 结尾的 OBJ 文本中各类元素的数量
+ */
+inline ObjCounts countObj(const char* text) {
+    ObjCounts c = { 0, 0, 0, 0, 0, 0 };
+    for (const char* s = text; *s; s = nextLine(s)) {
+        s = skipBlanks(s);
+        if (isKeyword(s, "v")) ++c.positions;
+        else if (isKeyword(s, "vt")) ++c.texcoords;
+        else if (isKeyword(s, "vn")) ++c.normals;
+        else if (isKeyword(s, "f")) {
+            size_t corners = 0;
+            const char* p = skipBlanks(s + 1);
+            while (isTokenChar(*p) && *p != '#') {
+                ++corners;
+                while (isTokenChar(*p)) ++p;
+                p = skipBlanks(p);
+            }
+            if (corners >= 3) { ++c.faces; c.triangles += corners - 2; }
+            if (corners > c.maxCorners) c.maxCorners = corners;
+        }
+    }
+    return c;
+}
+
+/**
+ * @brief 解析行内的若干个浮点数, 不会越过行尾; 缺失的分量填 0
+ */
+inline const char* parseFloats(const char* s, float* out, int n) {
+    for (int i = 0; i < n; ++i) {
+        s = skipBlanks(s);
+        char* end;
+        out[i] = (*s && *s != '\n') ? std::strtof(s, &end) : 0.0f;
+        if (*s && *s != '\n' && end != s) s = end;
+    }
+    return s;
+}
+
+/**
+ * @brief 读取行内剩余的一个单词 (如材质名、文件名)
+ */
+inline std::string parseName(const char* s) {
+    s = skipBlanks(s);
+    const char* end = s;
+    while (*end && *end != '\n' && *end != '\r') ++end;
+    while (end > s && (end[-1] == ' ' || end[-1] == '\t')) --end;
+    return std::string(s, end);
+}
+
+/**
+ * @brief 解析面中的一个角 "v", "v/vt", "v//vn" 或 "v/vt/vn", 并把 s 移到该角之后
+ * 负索引表示从当前已读取的末尾倒数; 返回的索引已转换为从0开始, 缺失的分量为 -1
+ */
+inline void parseObjCorner(const char*& s, int numV, int numVt, int numVn, int& v, int& vt, int& vn) {
+    v = vt = vn = -1;
+    int values[3] = { 0, 0, 0 };
+    int slot = 0;
+    while (isTokenChar(*s)) {
+        if (*s == '/') { ++slot; ++s; continue; }
+        char* end;
+        long value = std::strtol(s, &end, 10);
+        if (end == s) { ++s; continue; }
+        if (slot < 3) values[slot] = (int)value;
+        s = end;
+    }
+    if (values[0] != 0) v = values[0] > 0 ? values[0] - 1 : numV + values[0];
+    if (values[1] != 0) vt = values[1] > 0 ? values[1] - 1 : numVt + values[1];
+    if (values[2] != 0) vn = values[2] > 0 ? values[2] - 1 : numVn + values[2];
+}
+
+/**
+ * @brief 把整个文件读入临时 arena, 末尾补 '\0'
+ */
+inline const char* readFileText(const std::string& filename, MeshArena& scratch) {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    if (!file) { std::cerr << "错误: 无法打开文件 " << filename << std::endl; return 0; }
+    file.seekg(0, std::ios::end);
+    size_t size = (size_t)file.tellg();
+    file.seekg(0, std::ios::beg);
+    if (!scratch.reserve(size + 1)) return 0;
+    char* text = scratch.alloc<char>(size + 1);
+    file.read(text, size);
+    text[size] = '\0';
+    return text;
+}
+
+#endif
@@ -0,0 +1,425 @@
+#ifndef OBJ_READER_H
+#define OBJ_READER_H
+
+// 支持材质的 OBJ 读取器
+// - 面: "v", "v/vt", "v//vn", "v/vt/vn", 任意边数 (扇形三角化), 支持负索引
+// - 识别 mtllib / usemtl / g / o, 解析 .mtl 材质文件
+// - 相同 (v, vt, vn) 组合的角合并为一个顶点, 输出交错顶点缓冲 + 索引缓冲
+// - 三角形按材质分桶, 每种材质对应索引缓冲中连续的一段,
+//   绘制时每种材质只需一次状态切换和一次 glDrawElements
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "math3d.h"
+#include "mesh_arena.h"
+#include "obj_parse.h"
+#include "obj_blocks.h"
+#include "job_system.h"
+#include "trace.h"
+
+// 交错顶点格式: px py pz nx ny nz u v
+const int OBJ_VERTEX_STRIDE = 8;
+
+struct ObjMaterial {
+    std::string name;
+    float ambient[3];
+    float diffuse[3];
+    float specular[3];
+    float shininess;
+    float opacity;
+    std::string diffuseMap;   // map_Kd, 只记录文件名
+};
+
+// 索引缓冲中属于同一材质的连续区间
+struct ObjRange {
+    int material;
+    unsigned firstIndex;
+    unsigned indexCount;
+};
+
+struct ObjModel {
+    std::vector<float> vertices;          // 交错顶点数据, 每个顶点 OBJ_VERTEX_STRIDE 个 float
+    std::vector<unsigned> indices;        // 已按材质分组
+    std::vector<unsigned> positionIndex;  // 每个顶点来自文件中的第几个 "v", 用于按位置建立邻接关系
+    std::vector<ObjMaterial> materials;
+    std::vector<ObjRange> ranges;
+    std::vector<std::string> groups;      // 出现过的 g / o 名称
+    size_t positionCount;                 // 文件中 "v" 的数量
+    AABB bounds;
+
+    ObjModel() : positionCount(0), bounds(aabbEmpty()) {}
+    size_t vertexCount() const { return vertices.size() / OBJ_VERTEX_STRIDE; }
+};
+
+inline ObjMaterial makeObjMaterial(const std::string& name, const float* diffuse) {
+    ObjMaterial m;
+    m.name = name;
+    for (int i = 0; i < 3; ++i) {
+        m.ambient[i] = 0.2f;
+        m.diffuse[i] = diffuse ? diffuse[i] : 0.8f;
+        m.specular[i] = 0.0f;
+    }
+    m.shininess = 0.0f;
+    m.opacity = 1.0f;
+    return m;
+}
+
+inline std::string directoryOf(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+/**
+ * @brief 解析 .mtl 文件, 材质追加到 materials, 名称到编号的映射写入 byName
+ */
+inline bool readMtl(const std::string& filename, std::vector<ObjMaterial>& materials, std::map<std::string, int>& byName) {
+    TRACE_FUNCTION();
+    MeshArena textArena;
+    const char* text = readFileText(filename, textArena);
+    if (!text) return false;
+
+    ObjMaterial* current = 0;
+    for (const char* s = text; *s; s = nextLine(s)) {
+        s = skipBlanks(s);
+        if (isKeyword(s, "newmtl")) {
+            std::string name = parseName(s + 6);
+            byName[name] = (int)materials.size();
+            materials.push_back(makeObjMaterial(name, 0));
+            current = &materials.back();
+        } else if (!current) {
+            continue;
+        } else if (isKeyword(s, "Ka")) {
+            parseFloats(s + 2, current->ambient, 3);
+        } else if (isKeyword(s, "Kd")) {
+            parseFloats(s + 2, current->diffuse, 3);
+        } else if (isKeyword(s, "Ks")) {
+            parseFloats(s + 2, current->specular, 3);
+        } else if (isKeyword(s, "Ns")) {
+            parseFloats(s + 2, &current->shininess, 1);
+        } else if (isKeyword(s, "d")) {
+            parseFloats(s + 1, &current->opacity, 1);
+        } else if (isKeyword(s, "Tr")) {
+            float tr = 0.0f;
+            parseFloats(s + 2, &tr, 1);
+            current->opacity = 1.0f - tr;
+        } else if (isKeyword(s, "map_Kd")) {
+            current->diffuseMap = parseName(s + 6);
+        }
+    }
+    return true;
+}
+
+// ObjCornerKey 的哈希, 用于角的去重
+struct ObjCornerKeyHash {
+    size_t operator()(const ObjCornerKey& k) const {
+        size_t h = (size_t)k.v * 73856093u;
+        h ^= (size_t)(k.vt + 1) * 19349663u;
+        h ^= (size_t)(k.vn + 1) * 83492791u;
+        return h;
+    }
+};
+
+/**
+ * @brief 读取 OBJ 文件 (以及它引用的 .mtl)
+ * defaultColor 为没有指定材质的面所用的漫反射颜色
+ *
+ * 解析和后处理在共用的任务调度器 (job_system.h) 上并行执行, 结果与逐行顺序解析完全相同:
+ * 1. 文本按行边界切成若干块, 各块先计数, 前缀和得到每块的全局起始编号, 再并行解析到预先分配的数组
+ * 2. mtllib / usemtl / g / o 按文件顺序在调用线程上处理, 确定每个面的材质和三角形起始编号
+ * 3. (v, vt, vn) 去重: 角按键的哈希分到若干分片, 每个分片一个哈希表, 记录每个键第一次出现的角;
+ *    首次出现的角按文件顺序编号 (分段前缀和), 与顺序插入哈希表得到的编号一致
+ * 4. 扇形三角化、面法线、交错顶点和按材质分桶都按面 / 顶点 / 三角形分段并行
+ */
+inline bool readObj(const std::string& filename, ObjModel& model, const float* defaultColor = 0) {
+    TRACE_FUNCTION();
+    MeshArena textArena;
+    const char* text = readFileText(filename, textArena);
+    if (!text) return false;
+    JobSystem& js = jobSystem();
+    const int chunks = js.threadCount() * 4;
+
+    // --- 1. 切块, 计数, 并行解析 ---
+    std::vector<ObjTextBlock> blocks;
+    ObjTextBlock total = countObjBlocks(text, blocks);
+    size_t blockCount = blocks.size();
+    std::vector<float> positions(total.positions * 3), texcoords(total.texcoords * 2), normals(total.normals * 3);
+    std::vector<ObjCornerKey> corners(total.corners);
+    std::vector<size_t> faceCorner(total.faces + 1);
+    std::vector<unsigned> faceValid(total.faces);
+    std::vector<std::vector<ObjDirective> > directives(blockCount);
+    faceCorner[total.faces] = total.corners;
+    js.parallelFor(blockCount, (int)blockCount, [&](size_t begin, size_t end, int) {
+        TRACE_ZONE("readObj::parseBlock");
+        for (size_t i = begin; i < end; ++i)
+            parseObjBlock(blocks[i], positions.empty() ? 0 : &positions[0], texcoords.empty() ? 0 : &texcoords[0],
+                          normals.empty() ? 0 : &normals[0], corners.empty() ? 0 : &corners[0],
+                          &faceCorner[0], faceValid.empty() ? 0 : &faceValid[0], directives[i]);
+    });
+    textArena.release();
+
+    // --- 2. 按文件顺序处理状态行: 每个面的材质, 三角形起始编号 ---
+    std::vector<int> faceMaterial(total.faces, -1);
+    std::vector<size_t> faceTriangle(total.faces + 1, 0);
+    {
+        TRACE_ZONE("readObj::directives");
+        std::map<std::string, int> materialByName;
+        std::string dir = directoryOf(filename);
+        int currentMaterial = -1;
+        size_t f = 0, triangles = 0;
+        for (size_t i = 0; i <= blockCount; ++i) {
+            size_t dcount = i < blockCount ? directives[i].size() : 1;
+            for (size_t k = 0; k < dcount; ++k) {
+                size_t stop = i < blockCount ? directives[i][k].face : total.faces;
+                for (; f < stop; ++f) {
+                    faceTriangle[f] = triangles;
+                    if (faceValid[f] < 3) continue;
+                    if (currentMaterial < 0) {
+                        currentMaterial = (int)model.materials.size();
+                        model.materials.push_back(makeObjMaterial("(default)", defaultColor));
+                    }
+                    faceMaterial[f] = currentMaterial;
+                    triangles += faceValid[f] - 2;
+                }
+                if (i == blockCount) break;
+                const ObjDirective& d = directives[i][k];
+                if (d.type == OBJ_MTLLIB) {
+                    // 一行可以列出多个材质库
+                    const char* p = skipBlanks(d.text.c_str());
+                    while (isTokenChar(*p)) {
+                        const char* end = p;
+                        while (isTokenChar(*end)) ++end;
+                        std::string lib = dir + std::string(p, end);
+                        if (!readMtl(lib, model.materials, materialByName))
+                            std::cerr << "警告: 材质库 " << lib << " 读取失败, 使用默认材质" << std::endl;
+                        p = skipBlanks(end);
+                    }
+                } else if (d.type == OBJ_USEMTL) {
+                    std::map<std::string, int>::iterator it = materialByName.find(d.text);
+                    if (it == materialByName.end()) {
+                        std::cerr << "警告: 未定义的材质 " << d.text << ", 使用默认颜色" << std::endl;
+                        it = materialByName.insert(std::make_pair(d.text, (int)model.materials.size())).first;
+                        model.materials.push_back(makeObjMaterial(d.text, defaultColor));
+                    }
+                    currentMaterial = it->second;
+                } else {
+                    model.groups.push_back(d.text);
+                }
+            }
+        }
+        faceTriangle[total.faces] = triangles;
+    }
+    size_t triangleCount = faceTriangle[total.faces];
+
+    // --- 3. (v, vt, vn) 去重, 编号与按文件顺序插入哈希表相同 ---
+    const size_t shardBits = 6, shardCount = (size_t)1 << shardBits;
+    const size_t cornerCount = corners.size();
+    const size_t cornerChunk = (cornerCount + chunks - 1) / chunks;
+    std::vector<unsigned> cornerId(cornerCount), firstCorner(cornerCount);
+    std::vector<ObjCornerKey> uniqueCorners;
+    {
+        TRACE_ZONE("readObj::dedup");
+        ObjCornerKeyHash hasher;
+        std::vector<uint8_t> shardOf(cornerCount);
+        std::vector<size_t> shardCounts((size_t)chunks * shardCount, 0);
+        js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(cornerCount, ch * cornerChunk), hi = std::min(cornerCount, lo + cornerChunk);
+                size_t* counts = &shardCounts[ch * shardCount];
+                for (size_t c = lo; c < hi; ++c) {
+                    if (corners[c].v < 0) continue;
+                    uint64_t h = (uint64_t)hasher(corners[c]);
+                    uint8_t shard = (uint8_t)(((h ^ (h >> 29)) * 0x9E3779B97F4A7C15ull) >> (64 - shardBits));
+                    shardOf[c] = shard;
+                    ++counts[shard];
+                }
+            }
+        });
+        // 分片内按 (段, 段内顺序) 排列, 即全局的文件顺序
+        std::vector<size_t> shardStart(shardCount + 1, 0);
+        for (size_t s = 0; s < shardCount; ++s) {
+            size_t offset = shardStart[s];
+            for (int ch = 0; ch < chunks; ++ch) {
+                size_t n = shardCounts[ch * shardCount + s];
+                shardCounts[ch * shardCount + s] = offset;
+                offset += n;
+            }
+            shardStart[s + 1] = offset;
+        }
+        std::vector<unsigned> shardList(shardStart[shardCount]);
+        js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(cornerCount, ch * cornerChunk), hi = std::min(cornerCount, lo + cornerChunk);
+                size_t* cursor = &shardCounts[ch * shardCount];
+                for (size_t c = lo; c < hi; ++c)
+                    if (corners[c].v >= 0) shardList[cursor[shardOf[c]]++] = (unsigned)c;
+            }
+        });
+        js.parallelFor(shardCount, (int)shardCount, [&](size_t begin, size_t end, int) {
+            for (size_t s = begin; s < end; ++s) {
+                std::unordered_map<ObjCornerKey, unsigned, ObjCornerKeyHash> first;
+                first.reserve(shardStart[s + 1] - shardStart[s]);
+                for (size_t k = shardStart[s]; k < shardStart[s + 1]; ++k) {
+                    unsigned c = shardList[k];
+                    firstCorner[c] = first.insert(std::make_pair(corners[c], c)).first->second;
+                }
+            }
+        });
+        // 首次出现的角按文件顺序编号
+        std::vector<size_t> chunkFirsts(chunks + 1, 0);
+        js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(cornerCount, ch * cornerChunk), hi = std::min(cornerCount, lo + cornerChunk), n = 0;
+                for (size_t c = lo; c < hi; ++c) n += corners[c].v >= 0 && firstCorner[c] == c;
+                chunkFirsts[ch + 1] = n;
+            }
+        });
+        for (int ch = 0; ch < chunks; ++ch) chunkFirsts[ch + 1] += chunkFirsts[ch];
+        uniqueCorners.resize(chunkFirsts[chunks]);
+        js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t ch = begin; ch < end; ++ch) {
+                size_t lo = std::min(cornerCount, ch * cornerChunk), hi = std::min(cornerCount, lo + cornerChunk);
+                unsigned next = (unsigned)chunkFirsts[ch];
+                for (size_t c = lo; c < hi; ++c) {
+                    if (corners[c].v < 0 || firstCorner[c] != c) continue;
+                    uniqueCorners[next] = corners[c];
+                    cornerId[c] = next++;
+                }
+            }
+        });
+        // 重复的角取它第一次出现时的编号 (第一次出现总在前面, 上一步已经编号)
+        js.parallelFor(cornerCount, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t c = begin; c < end; ++c)
+                if (corners[c].v >= 0 && firstCorner[c] != c) cornerId[c] = cornerId[firstCorner[c]];
+        });
+    }
+
+    // --- 4. 扇形三角化: (0, i, i+1), 只使用有效的角 ---
+    std::vector<unsigned> triVerts(triangleCount * 3);
+    std::vector<int> triMaterial(triangleCount);
+    js.parallelFor(total.faces, chunks, [&](size_t begin, size_t end, int) {
+        TRACE_ZONE("readObj::triangulate");
+        for (size_t f = begin; f < end; ++f) {
+            if (faceValid[f] < 3) continue;
+            size_t t = faceTriangle[f];
+            unsigned first = 0, prev = 0;
+            int seen = 0;
+            for (size_t c = faceCorner[f]; c < faceCorner[f + 1]; ++c) {
+                if (corners[c].v < 0) continue;
+                unsigned id = cornerId[c];
+                if (seen >= 2) {
+                    triVerts[t * 3] = first;
+                    triVerts[t * 3 + 1] = prev;
+                    triVerts[t * 3 + 2] = id;
+                    triMaterial[t++] = faceMaterial[f];
+                }
+                if (seen == 0) first = id;
+                prev = id;
+                ++seen;
+            }
+        }
+    });
+    std::vector<ObjCornerKey>().swap(corners);
+
+    // --- 5. 生成交错顶点; 缺少法线的顶点使用其位置上累加的面法线 ---
+    model.positionCount = positions.size() / 3;
+    std::vector<float> smoothNormals;
+    bool needSmooth = false;
+    for (size_t i = 0; i < uniqueCorners.size() && !needSmooth; ++i) needSmooth = uniqueCorners[i].vn < 0;
+    if (needSmooth) {
+        TRACE_ZONE("readObj::smoothNormals");
+        std::vector<Vec3> faceNormals(triangleCount);
+        js.parallelFor(triangleCount, chunks, [&](size_t begin, size_t end, int) {
+            for (size_t t = begin; t < end; ++t) {
+                const float* a = &positions[uniqueCorners[triVerts[t * 3]].v * 3];
+                const float* b = &positions[uniqueCorners[triVerts[t * 3 + 1]].v * 3];
+                const float* c = &positions[uniqueCorners[triVerts[t * 3 + 2]].v * 3];
+                faceNormals[t] = cross(vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+            }
+        });
+        // 累加按三角形顺序进行, 浮点结果与顺序版本一致
+        smoothNormals.assign(positions.size(), 0.0f);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const Vec3& n = faceNormals[t];
+            for (int k = 0; k < 3; ++k) {
+                float* dst = &smoothNormals[uniqueCorners[triVerts[t * 3 + k]].v * 3];
+                dst[0] += n.x; dst[1] += n.y; dst[2] += n.z;
+            }
+        }
+    }
+
+    size_t vertexCount = uniqueCorners.size();
+    model.vertices.assign(vertexCount * OBJ_VERTEX_STRIDE, 0.0f);
+    model.positionIndex.resize(vertexCount);
+    std::vector<AABB> chunkBounds(chunks, aabbEmpty());
+    js.parallelFor(vertexCount, chunks, [&](size_t begin, size_t end, int chunk) {
+        TRACE_ZONE("readObj::vertices");
+        AABB bounds = aabbEmpty();
+        for (size_t i = begin; i < end; ++i) {
+            const ObjCornerKey& k = uniqueCorners[i];
+            float* dst = &model.vertices[i * OBJ_VERTEX_STRIDE];
+            const float* p = &positions[k.v * 3];
+            const float* n = k.vn >= 0 ? &normals[k.vn * 3] : &smoothNormals[k.v * 3];
+            Vec3 nn = normalize(vec3(n[0], n[1], n[2]));
+            dst[0] = p[0]; dst[1] = p[1]; dst[2] = p[2];
+            dst[3] = nn.x; dst[4] = nn.y; dst[5] = nn.z;
+            if (k.vt >= 0) { dst[6] = texcoords[k.vt * 2]; dst[7] = texcoords[k.vt * 2 + 1]; }
+            model.positionIndex[i] = (unsigned)k.v;
+            aabbExpand(bounds, vec3(p[0], p[1], p[2]));
+        }
+        chunkBounds[chunk] = bounds;
+    });
+    model.bounds = aabbEmpty();
+    for (int c = 0; c < chunks; ++c) aabbMerge(model.bounds, chunkBounds[c]);
+
+    // --- 6. 按材质分桶 (各段计数 + 前缀和 + 散列, 保持同一材质内的文件顺序) ---
+    size_t materialCount = model.materials.size();
+    size_t triChunk = (triangleCount + chunks - 1) / chunks;
+    std::vector<unsigned> chunkCounts((size_t)chunks * materialCount, 0);
+    js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        for (size_t ch = begin; ch < end; ++ch) {
+            size_t lo = std::min(triangleCount, ch * triChunk), hi = std::min(triangleCount, lo + triChunk);
+            for (size_t t = lo; t < hi; ++t) ++chunkCounts[ch * materialCount + triMaterial[t]];
+        }
+    });
+    model.ranges.clear();
+    unsigned offset = 0;
+    for (size_t m = 0; m < materialCount; ++m) {
+        unsigned first = offset;
+        for (int ch = 0; ch < chunks; ++ch) {
+            unsigned n = chunkCounts[ch * materialCount + m];
+            chunkCounts[ch * materialCount + m] = offset;
+            offset += n;
+        }
+        if (offset == first) continue;
+        ObjRange r = { (int)m, first * 3, (offset - first) * 3 };
+        model.ranges.push_back(r);
+    }
+    model.indices.resize(triVerts.size());
+    js.parallelFor((size_t)chunks, chunks, [&](size_t begin, size_t end, int) {
+        TRACE_ZONE("readObj::bucket");
+        for (size_t ch = begin; ch < end; ++ch) {
+            size_t lo = std::min(triangleCount, ch * triChunk), hi = std::min(triangleCount, lo + triChunk);
+            unsigned* cursor = materialCount ? &chunkCounts[ch * materialCount] : 0;
+            for (size_t t = lo; t < hi; ++t) {
+                unsigned dst = cursor[triMaterial[t]]++ * 3;
+                model.indices[dst] = triVerts[t * 3];
+                model.indices[dst + 1] = triVerts[t * 3 + 1];
+                model.indices[dst + 2] = triVerts[t * 3 + 2];
+            }
+        }
+    });
+
+    std::cout << "OBJ读取成功 " << filename << ": " << model.positionCount << " 个位置, "
+              << model.vertexCount() << " 个顶点, " << model.indices.size() / 3 << " 个三角面, "
+              << model.ranges.size() << " 个材质批次, " << model.groups.size() << " 个分组." << std::endl;
+    return true;
+}
+
+#endif
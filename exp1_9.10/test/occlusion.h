@@ -0,0 +1,468 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+// 软件层次 Z (HiZ) 遮挡剔除
+// 1. 每帧挑选屏幕上最大的若干个遮挡体, 把它们的三角形光栅化到低分辨率深度缓冲
+//    - 屏幕被划分为水平条带, 每个线程负责一条; 半平面 (边函数) 光栅化, 一次处理 4 个像素
+//    - 深度存 1/w (在屏幕空间中线性, 越大越近, 0 表示无穷远), 只保留最近的值
+// 2. 逐级取 2x2 中的最小值 (最远) 生成深度 mip 金字塔
+// 3. 实例包围盒投影到屏幕, 在覆盖范围只有 2x2 个 texel 左右的那一级上比较:
+//    包围盒最近点比所有 texel 的最远遮挡深度还远, 就一定被挡住
+//
+// 所有近似都偏向 "可见": 跨越近平面的三角形不作为遮挡体, 像素深度取像素内的最远值;
+// 只有整个像素都被遮挡体盖住才写入深度 (否则会挡住从像素其余部分露出的物体):
+// 网格边界和轮廓处的边向内收缩半个像素; 同一网格相邻三角形之间的内部边不收缩 (收缩会留下裂缝),
+// 跨过内部边的像素要求不碰到遮挡体的任何外边界, 深度取遮挡体最远的 1/w
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+
+#include "math3d.h"
+#include "parallel_for.h"
+#include "trace.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define OCCLUSION_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define OCCLUSION_NEON 1
+#endif
+
+const int OCC_WIDTH = 256;              // 遮挡缓冲分辨率 (与窗口宽高比无关), 宽度必须是 4 的倍数
+const int OCC_HEIGHT = 128;
+const int OCC_MAX_OCCLUDERS = 64;       // 每帧最多的遮挡体实例数
+const int OCC_MAX_MESH_TRIANGLES = 512; // 三角形更多的网格不作为遮挡体
+const float OCC_NEAR_W = 0.1f;          // 与投影矩阵的近平面一致
+
+// --- 4 路 SIMD 的最小封装 ---
+#if defined(OCCLUSION_SSE)
+typedef __m128 occ4;
+inline occ4 occ4_set1(float v) { return _mm_set1_ps(v); }
+inline occ4 occ4_set(float a, float b, float c, float d) { return _mm_setr_ps(a, b, c, d); }
+inline occ4 occ4_add(occ4 a, occ4 b) { return _mm_add_ps(a, b); }
+inline occ4 occ4_mul(occ4 a, occ4 b) { return _mm_mul_ps(a, b); }
+inline occ4 occ4_max(occ4 a, occ4 b) { return _mm_max_ps(a, b); }
+inline occ4 occ4_load(const float* p) { return _mm_loadu_ps(p); }
+inline void occ4_store(float* p, occ4 v) { _mm_storeu_ps(p, v); }
+// 三个边函数都 > 0 的通道
+inline occ4 occ4_inside(occ4 e0, occ4 e1, occ4 e2) {
+    occ4 zero = _mm_setzero_ps();
+    return _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(e0, zero), _mm_cmpgt_ps(e1, zero)), _mm_cmpgt_ps(e2, zero));
+}
+inline occ4 occ4_select(occ4 mask, occ4 a, occ4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+inline bool occ4_any(occ4 mask) { return _mm_movemask_ps(mask) != 0; }
+inline int occ4_bits(occ4 mask) { return _mm_movemask_ps(mask); }   // 第 i 位 = 第 i 个通道
+#elif defined(OCCLUSION_NEON)
+typedef float32x4_t occ4;
+inline occ4 occ4_set1(float v) { return vdupq_n_f32(v); }
+inline occ4 occ4_set(float a, float b, float c, float d) { float t[4] = { a, b, c, d }; return vld1q_f32(t); }
+inline occ4 occ4_add(occ4 a, occ4 b) { return vaddq_f32(a, b); }
+inline occ4 occ4_mul(occ4 a, occ4 b) { return vmulq_f32(a, b); }
+inline occ4 occ4_max(occ4 a, occ4 b) { return vmaxq_f32(a, b); }
+inline occ4 occ4_load(const float* p) { return vld1q_f32(p); }
+inline void occ4_store(float* p, occ4 v) { vst1q_f32(p, v); }
+inline occ4 occ4_inside(occ4 e0, occ4 e1, occ4 e2) {
+    occ4 zero = vdupq_n_f32(0.0f);
+    return vreinterpretq_f32_u32(vandq_u32(vandq_u32(vcgtq_f32(e0, zero), vcgtq_f32(e1, zero)), vcgtq_f32(e2, zero)));
+}
+inline occ4 occ4_select(occ4 mask, occ4 a, occ4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+inline bool occ4_any(occ4 mask) { return vmaxvq_u32(vreinterpretq_u32_f32(mask)) != 0; }
+inline int occ4_bits(occ4 mask) {
+    uint32x4_t m = vreinterpretq_u32_f32(mask);
+    return (int)((vgetq_lane_u32(m, 0) & 1) | (vgetq_lane_u32(m, 1) & 1) << 1 | (vgetq_lane_u32(m, 2) & 1) << 2 | (vgetq_lane_u32(m, 3) & 1) << 3);
+}
+#else
+struct occ4 { float v[4]; };
+inline occ4 occ4_set1(float s) { occ4 r; for (int i = 0; i < 4; ++i) r.v[i] = s; return r; }
+inline occ4 occ4_set(float a, float b, float c, float d) { occ4 r = { { a, b, c, d } }; return r; }
+inline occ4 occ4_add(occ4 a, occ4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+inline occ4 occ4_mul(occ4 a, occ4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+inline occ4 occ4_max(occ4 a, occ4 b) { for (int i = 0; i < 4; ++i) a.v[i] = std::max(a.v[i], b.v[i]); return a; }
+inline occ4 occ4_load(const float* p) { return occ4_set(p[0], p[1], p[2], p[3]); }
+inline void occ4_store(float* p, occ4 v) { for (int i = 0; i < 4; ++i) p[i] = v.v[i]; }
+inline occ4 occ4_inside(occ4 e0, occ4 e1, occ4 e2) {
+    occ4 r;
+    for (int i = 0; i < 4; ++i) r.v[i] = (e0.v[i] > 0 && e1.v[i] > 0 && e2.v[i] > 0) ? 1.0f : 0.0f;
+    return r;
+}
+inline occ4 occ4_select(occ4 mask, occ4 a, occ4 b) { for (int i = 0; i < 4; ++i) a.v[i] = mask.v[i] != 0 ? a.v[i] : b.v[i]; return a; }
+inline bool occ4_any(occ4 mask) { return mask.v[0] != 0 || mask.v[1] != 0 || mask.v[2] != 0 || mask.v[3] != 0; }
+inline int occ4_bits(occ4 mask) { return (mask.v[0] != 0) | (mask.v[1] != 0) << 1 | (mask.v[2] != 0) << 2 | (mask.v[3] != 0) << 3; }
+#endif
+
+// 屏幕空间三角形, 已经整理成逆时针并预先计算好边函数与深度平面
+struct OccTriangle {
+    float a[3], b[3], c[3];   // 边函数 E_i(x, y) = a_i * x + b_i * y + c_i
+    float da, db, dc;         // 1/w 平面 (已减去像素内的最大偏差)
+    float minInvW;            // 三个顶点中最小的 1/w, 深度不会比它更远
+    float inner[3];           // 中心处 E_i > inner[i] 时整个像素在边 i 内侧 (非内部边已收缩, 为 0)
+    float floorInvW;          // 跨过内部边的像素改用整个遮挡体最远的 1/w
+    int minX, maxX, minY, maxY;
+    int outline;              // 所属遮挡体在 OcclusionBuffer::outlines 中的编号, -1 表示没有内部边 (不需要检查)
+};
+
+// 一个遮挡体的外边界 (网格边界、轮廓处的折叠边、非流形边) 经过的像素, 在遮挡体包围矩形内按位存放
+struct OccOutline {
+    int x0, y0, width, height;
+    size_t offset;            // 在 OcclusionBuffer::outlineBits 中的起始位置 (以位计)
+};
+
+/**
+ * @brief 求出每条三角形边的相邻边: neighbours[三角形 * 3 + e] (边 e 是顶点 e 对面的边),
+ * 恰好被两个三角形共享的边互相指向对方, 其余为 -1; 遮挡体网格的拓扑不变, 加载时建立一次即可
+ */
+inline void buildOccluderNeighbours(const unsigned* indices, size_t indexCount, std::vector<int>& neighbours) {
+    size_t slots = indexCount / 3 * 3;
+    std::vector<std::pair<uint64_t, int> > edges(slots);   // (较小编号, 较大编号) 作为键
+    for (size_t i = 0; i < slots; ++i) {
+        uint64_t s = indices[i / 3 * 3 + (i % 3 + 1) % 3], d = indices[i / 3 * 3 + (i % 3 + 2) % 3];
+        edges[i] = std::make_pair(std::min(s, d) << 32 | std::max(s, d), (int)i);
+    }
+    std::sort(edges.begin(), edges.end());
+    neighbours.assign(slots, -1);
+    for (size_t i = 0; i < slots;) {
+        size_t j = i + 1;
+        while (j < slots && edges[j].first == edges[i].first) ++j;
+        if (j - i == 2) {
+            neighbours[edges[i].second] = edges[i + 1].second;
+            neighbours[edges[i + 1].second] = edges[i].second;
+        }
+        i = j;
+    }
+}
+
+struct OcclusionBuffer {
+    int width, height;
+    std::vector<std::vector<float> > mips;   // mips[0] 为全分辨率, 每级宽高减半
+    std::vector<int> mipWidth, mipHeight;
+    std::vector<OccTriangle> triangles;
+    std::vector<OccOutline> outlines;
+    std::vector<uint32_t> outlineBits;
+
+    // 统计
+    size_t occluderTriangles, skippedTriangles;
+
+    OcclusionBuffer() : width(0), height(0), occluderTriangles(0), skippedTriangles(0) {}
+
+    void resize(int w, int h) {
+        width = w;
+        height = h;
+        mips.clear();
+        mipWidth.clear();
+        mipHeight.clear();
+        for (;;) {
+            mipWidth.push_back(w);
+            mipHeight.push_back(h);
+            mips.push_back(std::vector<float>((size_t)w * h, 0.0f));
+            if (w == 1 && h == 1) break;
+            w = std::max(1, w / 2);
+            h = std::max(1, h / 2);
+        }
+    }
+
+    void clear() {
+        std::fill(mips[0].begin(), mips[0].end(), 0.0f);
+        triangles.clear();
+        outlines.clear();
+        outlineBits.clear();
+        occluderTriangles = skippedTriangles = 0;
+    }
+
+    /**
+     * @brief 把一个遮挡体的三角形变换到屏幕空间并加入本帧的三角形列表
+     * mvp: 投影 * 视图 * 模型, positions: 每个顶点 3 个 float
+     * neighbours: buildOccluderNeighbours 预先求出的相邻边, 为空时在这里现算
+     *
+     * 边分两类 (按顶点编号配对, 只统计实际加入的三角形):
+     * - 内部边: 恰好两个三角形共享, 且它们在屏幕上位于边的两侧
+     * - 外边界: 其余的边 (网格边界、轮廓处的折叠边、非流形边), 遮挡体投影的边缘只可能在这些边上
+     * 三角形自己的外边界向内收缩半个像素; 像素中心在三角形内、但跨过内部边时,
+     * 只有不碰到遮挡体任何一段外边界才整个被盖住, 深度取整个遮挡体最远的 1/w
+     */
+    void addOccluder(const Mat4& mvp, const float* positions, size_t vertexCount, const unsigned* indices, size_t indexCount,
+                     const int* neighbours = 0) {
+        TRACE_ZONE("OcclusionBuffer::addOccluder");
+        const float* m = mvp.m;
+        std::vector<float> screen(vertexCount * 3);  // x, y (像素), 1/w; 1/w < 0 表示在近平面之前
+        for (size_t v = 0; v < vertexCount; ++v) {
+            const float* p = positions + v * 3;
+            float cx = m[0] * p[0] + m[4] * p[1] + m[8] * p[2] + m[12];
+            float cy = m[1] * p[0] + m[5] * p[1] + m[9] * p[2] + m[13];
+            float cw = m[3] * p[0] + m[7] * p[1] + m[11] * p[2] + m[15];
+            if (cw < OCC_NEAR_W) { screen[v * 3 + 2] = -1.0f; continue; }
+            float iw = 1.0f / cw;
+            screen[v * 3] = (cx * iw * 0.5f + 0.5f) * width;
+            screen[v * 3 + 1] = (cy * iw * 0.5f + 0.5f) * height;
+            screen[v * 3 + 2] = iw;
+        }
+
+        // --- 1. 有效的三角形: 0 = 不用, 1 = 逆时针, 2 = 顺时针 (正反面都作为遮挡体, 光栅化时交换后两个顶点) ---
+        size_t triCount = indexCount / 3;
+        std::vector<unsigned char> state(triCount, 0);
+        float occluderFloor = 1e30f;   // 整个遮挡体最远的 1/w
+        float bx0 = 1e30f, by0 = 1e30f, bx1 = -1e30f, by1 = -1e30f;
+        for (size_t k = 0; k < triCount; ++k) {
+            const float* p0 = &screen[indices[k * 3] * 3];
+            const float* p1 = &screen[indices[k * 3 + 1] * 3];
+            const float* p2 = &screen[indices[k * 3 + 2] * 3];
+            if (p0[2] < 0 || p1[2] < 0 || p2[2] < 0) { ++skippedTriangles; continue; }
+            float area = (p1[0] - p0[0]) * (p2[1] - p0[1]) - (p2[0] - p0[0]) * (p1[1] - p0[1]);
+            if (std::fabs(area) < 1e-6f) continue;
+            state[k] = area > 0 ? 1 : 2;
+            occluderFloor = std::min(occluderFloor, std::min(p0[2], std::min(p1[2], p2[2])));
+            bx0 = std::min(bx0, std::min(p0[0], std::min(p1[0], p2[0]))); bx1 = std::max(bx1, std::max(p0[0], std::max(p1[0], p2[0])));
+            by0 = std::min(by0, std::min(p0[1], std::min(p1[1], p2[1]))); by1 = std::max(by1, std::max(p0[1], std::max(p1[1], p2[1])));
+        }
+
+        // --- 2. 内部边: 相邻的两个三角形都有效, 且它们的对顶点在这条边所在直线的两侧 ---
+        std::vector<int> ownNeighbours;
+        if (!neighbours) {
+            buildOccluderNeighbours(indices, indexCount, ownNeighbours);
+            neighbours = ownNeighbours.empty() ? 0 : &ownNeighbours[0];
+        }
+        std::vector<unsigned char> interior(triCount * 3, 0);   // 按原始顶点顺序的边编号
+        bool anyInterior = false;
+        for (size_t i = 0; i < triCount * 3; ++i) {
+            int n = neighbours[i];
+            if (n < (int)i || !state[i / 3] || !state[n / 3]) continue;   // 每对只看一次
+            const float* s = &screen[indices[i / 3 * 3 + (i % 3 + 1) % 3] * 3];
+            const float* d = &screen[indices[i / 3 * 3 + (i % 3 + 2) % 3] * 3];
+            const float* oa = &screen[indices[i] * 3];
+            const float* ob = &screen[indices[n] * 3];
+            float la = (s[1] - d[1]) * oa[0] + (d[0] - s[0]) * oa[1] + (s[0] * d[1] - s[1] * d[0]);
+            float lb = (s[1] - d[1]) * ob[0] + (d[0] - s[0]) * ob[1] + (s[0] * d[1] - s[1] * d[0]);
+            if ((la > 0 && lb < 0) || (la < 0 && lb > 0)) { interior[i] = interior[n] = 1; anyInterior = true; }
+        }
+
+        // 有内部边时, 把外边界经过的像素 (与线段相交的像素方块) 标记出来
+        int outlineIndex = -1;
+        if (anyInterior) {
+            OccOutline o;
+            o.x0 = std::max(0, (int)std::floor(bx0));
+            o.y0 = std::max(0, (int)std::floor(by0));
+            o.width = std::min(width - 1, (int)std::ceil(bx1)) - o.x0 + 1;
+            o.height = std::min(height - 1, (int)std::ceil(by1)) - o.y0 + 1;
+            if (o.width > 0 && o.height > 0) {
+                o.offset = outlineBits.size() * 32;
+                outlineBits.resize(outlineBits.size() + ((size_t)o.width * o.height + 31) / 32, 0);
+                for (size_t i = 0; i < triCount * 3; ++i) {
+                    if (!state[i / 3] || interior[i]) continue;
+                    markOutline(o, &screen[indices[i / 3 * 3 + (i % 3 + 1) % 3] * 3], &screen[indices[i / 3 * 3 + (i % 3 + 2) % 3] * 3]);
+                }
+                outlineIndex = (int)outlines.size();
+                outlines.push_back(o);
+            }
+        }
+
+        // --- 3. 边函数与深度平面 ---
+        for (size_t k = 0; k < triCount; ++k) {
+            if (!state[k]) continue;
+            bool flip = state[k] == 2;
+            const float* p0 = &screen[indices[k * 3] * 3];
+            const float* p1 = &screen[indices[k * 3 + (flip ? 2 : 1)] * 3];
+            const float* p2 = &screen[indices[k * 3 + (flip ? 1 : 2)] * 3];
+            float area = (p1[0] - p0[0]) * (p2[1] - p0[1]) - (p2[0] - p0[0]) * (p1[1] - p0[1]);
+
+            OccTriangle t;
+            float minX = std::min(p0[0], std::min(p1[0], p2[0])), maxX = std::max(p0[0], std::max(p1[0], p2[0]));
+            float minY = std::min(p0[1], std::min(p1[1], p2[1])), maxY = std::max(p0[1], std::max(p1[1], p2[1]));
+            t.minX = std::max(0, (int)std::floor(minX));
+            t.maxX = std::min(width - 1, (int)std::ceil(maxX));
+            t.minY = std::max(0, (int)std::floor(minY));
+            t.maxY = std::min(height - 1, (int)std::ceil(maxY));
+            if (t.minX > t.maxX || t.minY > t.maxY) continue;
+
+            const float* v[3] = { p0, p1, p2 };
+            for (int e = 0; e < 3; ++e) {
+                const float* s = v[(e + 1) % 3];
+                const float* d = v[(e + 2) % 3];
+                t.a[e] = s[1] - d[1];
+                t.b[e] = d[0] - s[0];
+                t.c[e] = s[0] * d[1] - s[1] * d[0];
+            }
+            // E_i / area 就是重心坐标, 1/w = sum(重心坐标 * 顶点 1/w)
+            float inv = 1.0f / area;
+            t.da = (t.a[0] * p0[2] + t.a[1] * p1[2] + t.a[2] * p2[2]) * inv;
+            t.db = (t.b[0] * p0[2] + t.b[1] * p1[2] + t.b[2] * p2[2]) * inv;
+            t.dc = (t.c[0] * p0[2] + t.c[1] * p1[2] + t.c[2] * p2[2]) * inv;
+            t.dc -= 0.5f * (std::fabs(t.da) + std::fabs(t.db)); // 在像素中心取值, 减去到像素角的最大变化
+            t.minInvW = std::min(p0[2], std::min(p1[2], p2[2]));
+            t.floorInvW = occluderFloor;
+            // 边函数从像素中心到像素角的最大变化为 0.5 * (|a| + |b|): 中心处超过它, 整个像素就在边的内侧
+            for (int e = 0; e < 3; ++e) {
+                float halfPixel = 0.5f * (std::fabs(t.a[e]) + std::fabs(t.b[e]));
+                if (interior[k * 3 + (e == 0 || !flip ? e : 3 - e)]) t.inner[e] = halfPixel;
+                else { t.c[e] -= halfPixel; t.inner[e] = 0.0f; }
+            }
+            t.outline = interior[k * 3] || interior[k * 3 + 1] || interior[k * 3 + 2] ? outlineIndex : -1;
+            triangles.push_back(t);
+            ++occluderTriangles;
+        }
+    }
+
+    /**
+     * @brief 在 o 中标记线段 s-d 经过的所有像素: 逐行求线段在该行 [y, y+1] 内的 x 范围
+     * 范围两端各放宽一点, 刚好擦过像素边界的线段也算经过 (偏向不写入)
+     */
+    void markOutline(const OccOutline& o, const float* s, const float* d) {
+        const float eps = 1e-3f;
+        float minY = std::min(s[1], d[1]), maxY = std::max(s[1], d[1]);
+        int row0 = std::max(o.y0, (int)std::floor(minY - eps)), row1 = std::min(o.y0 + o.height - 1, (int)std::floor(maxY + eps));
+        float dy = d[1] - s[1];
+        for (int y = row0; y <= row1; ++y) {
+            float xa, xb;
+            if (std::fabs(dy) < 1e-6f) {
+                xa = s[0]; xb = d[0];
+            } else {
+                float ya = std::max((float)y, minY), yb = std::min((float)(y + 1), maxY);
+                xa = s[0] + (d[0] - s[0]) * (ya - s[1]) / dy;
+                xb = s[0] + (d[0] - s[0]) * (yb - s[1]) / dy;
+            }
+            int x0 = std::max(o.x0, (int)std::floor(std::min(xa, xb) - eps));
+            int x1 = std::min(o.x0 + o.width - 1, (int)std::floor(std::max(xa, xb) + eps));
+            for (int x = x0; x <= x1; ++x) {
+                size_t bit = o.offset + (size_t)(y - o.y0) * o.width + (x - o.x0);
+                outlineBits[bit >> 5] |= 1u << (bit & 31);
+            }
+        }
+    }
+
+    /**
+     * @brief 像素 (x, y) 是否有遮挡体 o 的外边界经过
+     */
+    bool onOutline(const OccOutline& o, int x, int y) const {
+        if (x < o.x0 || y < o.y0 || x >= o.x0 + o.width || y >= o.y0 + o.height) return false;
+        size_t bit = o.offset + (size_t)(y - o.y0) * o.width + (x - o.x0);
+        return (outlineBits[bit >> 5] >> (bit & 31) & 1) != 0;
+    }
+
+    /**
+     * @brief 把一个三角形光栅化到 [rowBegin, rowEnd) 行, 每次处理 4 个像素
+     */
+    void rasterizeTriangle(const OccTriangle& t, int rowBegin, int rowEnd) {
+        int y0 = std::max(t.minY, rowBegin), y1 = std::min(t.maxY + 1, rowEnd);
+        int x0 = t.minX & ~3;
+        float* depth = &mips[0][0];
+        occ4 offsets = occ4_set(0.5f, 1.5f, 2.5f, 3.5f);
+        occ4 floorW = occ4_set1(t.minInvW);
+        occ4 edgeW = occ4_set1(t.floorInvW);
+        occ4 innerNeg[3] = { occ4_set1(-t.inner[0]), occ4_set1(-t.inner[1]), occ4_set1(-t.inner[2]) };
+        for (int y = y0; y < y1; ++y) {
+            float py = y + 0.5f;
+            for (int x = x0; x <= t.maxX; x += 4) {
+                occ4 px = occ4_add(occ4_set1((float)x), offsets);
+                occ4 e0 = occ4_add(occ4_set1(t.b[0] * py + t.c[0]), occ4_mul(px, occ4_set1(t.a[0])));
+                occ4 e1 = occ4_add(occ4_set1(t.b[1] * py + t.c[1]), occ4_mul(px, occ4_set1(t.a[1])));
+                occ4 e2 = occ4_add(occ4_set1(t.b[2] * py + t.c[2]), occ4_mul(px, occ4_set1(t.a[2])));
+                occ4 mask = occ4_inside(e0, e1, e2);
+                if (!occ4_any(mask)) continue;
+                occ4 whole = occ4_inside(occ4_add(e0, innerNeg[0]), occ4_add(e1, innerNeg[1]), occ4_add(e2, innerNeg[2]));
+                occ4 z = occ4_max(occ4_add(occ4_set1(t.db * py + t.dc), occ4_mul(px, occ4_set1(t.da))), floorW);
+                z = occ4_select(whole, z, edgeW);
+                float* dst = depth + (size_t)y * width + x;
+                int straddle = occ4_bits(mask) & ~occ4_bits(whole);
+                if (straddle && t.outline >= 0) {
+                    // 跨过内部边的像素 (少数): 有外边界经过就不写入
+                    const OccOutline& o = outlines[t.outline];
+                    float zs[4];
+                    occ4_store(zs, z);
+                    int keep = occ4_bits(mask);
+                    for (int i = 0; i < 4; ++i)
+                        if ((straddle >> i & 1) && onOutline(o, x + i, y)) keep &= ~(1 << i);
+                    for (int i = 0; i < 4; ++i)
+                        if (keep >> i & 1) dst[i] = std::max(dst[i], zs[i]);
+                    continue;
+                }
+                occ4 cur = occ4_load(dst);
+                occ4_store(dst, occ4_select(mask, occ4_max(cur, z), cur));
+            }
+        }
+    }
+
+    /**
+     * @brief 多线程光栅化: 屏幕按行分成条带, 每个线程只写自己的条带, 不需要加锁
+     */
+    void rasterize(int threads) {
+        TRACE_ZONE("OcclusionBuffer::rasterize");
+        int bands = threads > 0 ? threads : hardwareThreads();
+        bands = std::min(bands, height);
+        int rowsPerBand = (height + bands - 1) / bands;
+        parallelFor((size_t)bands, bands, [&](size_t begin, size_t end, int) {
+            for (size_t band = begin; band < end; ++band) {
+                int rowBegin = (int)band * rowsPerBand, rowEnd = std::min(height, rowBegin + rowsPerBand);
+                for (size_t i = 0; i < triangles.size(); ++i) {
+                    const OccTriangle& t = triangles[i];
+                    if (t.maxY < rowBegin || t.minY >= rowEnd) continue;
+                    rasterizeTriangle(t, rowBegin, rowEnd);
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief 逐级取 2x2 的最小 1/w (最远深度); 奇数尺寸时把多出的一行/列并入最后一个 texel
+     */
+    void buildPyramid() {
+        TRACE_ZONE("OcclusionBuffer::buildPyramid");
+        for (size_t level = 1; level < mips.size(); ++level) {
+            const std::vector<float>& src = mips[level - 1];
+            std::vector<float>& dst = mips[level];
+            int sw = mipWidth[level - 1], sh = mipHeight[level - 1];
+            int dw = mipWidth[level], dh = mipHeight[level];
+            for (int y = 0; y < dh; ++y) {
+                int sy0 = y * 2, sy1 = (y == dh - 1) ? sh : std::min(sh, y * 2 + 2);
+                for (int x = 0; x < dw; ++x) {
+                    int sx0 = x * 2, sx1 = (x == dw - 1) ? sw : std::min(sw, x * 2 + 2);
+                    float v = src[(size_t)sy0 * sw + sx0];
+                    for (int sy = sy0; sy < sy1; ++sy)
+                        for (int sx = sx0; sx < sx1; ++sx) v = std::min(v, src[(size_t)sy * sw + sx]);
+                    dst[(size_t)y * dw + x] = v;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 包围盒是否可能可见 (false 表示一定被遮挡)
+     */
+    bool testAABB(const Mat4& viewProj, const AABB& box) const {
+        const float* m = viewProj.m;
+        float minX = 1e30f, maxX = -1e30f, minY = 1e30f, maxY = -1e30f, nearestInvW = 0.0f;
+        for (int i = 0; i < 8; ++i) {
+            float px = (i & 1) ? box.max.x : box.min.x;
+            float py = (i & 2) ? box.max.y : box.min.y;
+            float pz = (i & 4) ? box.max.z : box.min.z;
+            float cx = m[0] * px + m[4] * py + m[8] * pz + m[12];
+            float cy = m[1] * px + m[5] * py + m[9] * pz + m[13];
+            float cw = m[3] * px + m[7] * py + m[11] * pz + m[15];
+            if (cw < OCC_NEAR_W) return true;  // 与近平面相交, 视为可见
+            float iw = 1.0f / cw;
+            float sx = (cx * iw * 0.5f + 0.5f) * width, sy = (cy * iw * 0.5f + 0.5f) * height;
+            minX = std::min(minX, sx); maxX = std::max(maxX, sx);
+            minY = std::min(minY, sy); maxY = std::max(maxY, sy);
+            nearestInvW = std::max(nearestInvW, iw);
+        }
+        int x0 = std::max(0, (int)std::floor(minX)), x1 = std::min(width - 1, (int)std::floor(maxX));
+        int y0 = std::max(0, (int)std::floor(minY)), y1 = std::min(height - 1, (int)std::floor(maxY));
+        if (x0 > x1 || y0 > y1) return true;  // 屏幕外的交给视锥体剔除处理
+
+        // 选择覆盖范围约为 2x2 texel 的那一级
+        int extent = std::max(x1 - x0, y1 - y0);
+        size_t level = 0;
+        while ((extent >> level) > 1 && level + 1 < mips.size()) ++level;
+        const std::vector<float>& mip = mips[level];
+        int mw = mipWidth[level], mh = mipHeight[level];
+        int tx0 = std::min(mw - 1, x0 >> level), tx1 = std::min(mw - 1, x1 >> level);
+        int ty0 = std::min(mh - 1, y0 >> level), ty1 = std::min(mh - 1, y1 >> level);
+        for (int y = ty0; y <= ty1; ++y)
+            for (int x = tx0; x <= tx1; ++x)
+                if (nearestInvW >= mip[(size_t)y * mw + x]) return true;
+        return false;
+    }
+};
+
+#endif
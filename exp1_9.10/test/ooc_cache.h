@@ -0,0 +1,225 @@
+#ifndef OOC_CACHE_H
+#define OOC_CACHE_H
+
+// 外存模型的显存块缓存: 每个常驻块占一对 VBO/IBO, 常驻字节数不超过固定预算, 按 LRU 淘汰
+//
+//   cache.beginFrame();
+//   for (每个可见块, 由近到远) cache.request(i);   // 未常驻的块记入本帧的缺失列表
+//   cache.update();                                 // 按请求顺序装入缺失的块
+//   for (每个可见块) if (cache.resident(i)) { cache.bind(i); 绘制; }
+//
+// - 装入: 直接用 mmap 映射的文件数据调用 glBufferData, 随后 MADV_DONTNEED 释放这些页,
+//         进程的内存占用不随模型大小增长
+// - 淘汰: 从 LRU 尾部开始, 只淘汰本帧没有请求的块; 常驻块全部在本帧可见时停止装入 (记为预算不足)
+// - 每帧装入的字节数有上限, 避免一次装入很多块造成卡顿; 推迟的块先 MADV_WILLNEED, 由内核在后台预读
+// - 淘汰时释放缓冲的存储, 缓冲对象名放回空闲池, 下次装入时复用
+
+#include <vector>
+#include <chrono>
+#include <utility>
+#include <cstdint>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "ooc_format.h"
+#include "trace.h"
+
+struct OocCacheStats {
+    size_t requests, hits;          // 命中率 = hits / requests
+    size_t loads, evictions;
+    size_t deferred;                // 超过每帧装入上限而推迟的请求
+    size_t overBudget;              // 预算已被本帧可见的块占满而无法装入的请求
+    uint64_t loadedBytes;
+    double loadMs;
+
+    OocCacheStats() { reset(); }
+    void reset() {
+        requests = hits = loads = evictions = deferred = overBudget = 0;
+        loadedBytes = 0;
+        loadMs = 0.0;
+    }
+    void add(const OocCacheStats& o) {
+        requests += o.requests; hits += o.hits; loads += o.loads; evictions += o.evictions;
+        deferred += o.deferred; overBudget += o.overBudget; loadedBytes += o.loadedBytes; loadMs += o.loadMs;
+    }
+    double hitRate() const { return requests ? 100.0 * hits / requests : 100.0; }
+};
+
+class OocChunkCache {
+public:
+    OocChunkCache() : file_(0), budget_(0), uploadLimit_(0), residentBytes_(0), residentChunks_(0),
+                      frame_(0), head_(-1), tail_(-1) {}
+
+    /**
+     * @brief budgetBytes: 常驻块的总字节数上限; uploadBytesPerFrame: 每帧最多装入的字节数 (至少装入一块)
+     */
+    void init(OocFile* file, uint64_t budgetBytes, uint64_t uploadBytesPerFrame) {
+        file_ = file;
+        budget_ = budgetBytes;
+        uploadLimit_ = uploadBytesPerFrame;
+        Entry empty = { 0, 0, 0, -1, -1, false };
+        entries_.assign(file->chunkCount(), empty);
+    }
+
+    /**
+     * @brief 改变预算; 超出部分立即按 LRU 顺序淘汰 (包括本帧用到的块)
+     */
+    void setBudget(uint64_t budgetBytes) {
+        budget_ = budgetBytes;
+        while (residentBytes_ > budget_ && tail_ >= 0) evict(tail_);
+    }
+
+    void beginFrame() {
+        ++frame_;
+        missing_.clear();
+    }
+
+    /**
+     * @brief 本帧需要第 chunk 块; 返回它是否已经常驻 (命中)
+     */
+    bool request(int chunk) {
+        Entry& e = entries_[chunk];
+        e.lastFrame = frame_;
+        ++stats.requests;
+        if (!e.resident) {
+            missing_.push_back(chunk);
+            return false;
+        }
+        ++stats.hits;
+        lruRemove(chunk);
+        pushFront(chunk);
+        return true;
+    }
+
+    /**
+     * @brief 按请求顺序装入本帧缺失的块, 直到达到每帧上限或预算被本帧可见的块占满
+     */
+    void update() {
+        TRACE_FUNCTION();
+        uint64_t uploaded = 0;
+        for (size_t i = 0; i < missing_.size(); ++i) {
+            int chunk = missing_[i];
+            const OocChunk& c = file_->chunks[chunk];
+            if (uploaded > 0 && uploaded + c.bytes() > uploadLimit_) {
+                file_->map.willNeed(c.offset, c.bytes());
+                ++stats.deferred;
+                continue;
+            }
+            if (!makeRoom(c.bytes())) {
+                ++stats.overBudget;
+                continue;
+            }
+            load(chunk);
+            uploaded += c.bytes();
+        }
+        missing_.clear();
+    }
+
+    bool resident(int chunk) const { return entries_[chunk].resident; }
+
+    void bind(int chunk) const {
+        glBindBuffer(GL_ARRAY_BUFFER, entries_[chunk].vbo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, entries_[chunk].ibo);
+    }
+
+    uint64_t budget() const { return budget_; }
+    uint64_t residentBytes() const { return residentBytes_; }
+    size_t residentChunks() const { return residentChunks_; }
+
+    OocCacheStats stats;   // 由调用者定期输出并清零
+
+private:
+    struct Entry {
+        GLuint vbo, ibo;
+        unsigned lastFrame;       // 最近一次被请求的帧
+        int prev, next;           // LRU 链表, 表头为最近使用
+        bool resident;
+    };
+
+    // 腾出 bytes 字节的预算; 只淘汰本帧没有请求的块
+    bool makeRoom(uint64_t bytes) {
+        if (bytes > budget_) return false;
+        while (residentBytes_ + bytes > budget_) {
+            if (tail_ < 0 || entries_[tail_].lastFrame == frame_) return false;
+            evict(tail_);
+        }
+        return true;
+    }
+
+    void load(int chunk) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        Entry& e = entries_[chunk];
+        const OocChunk& c = file_->chunks[chunk];
+        if (!freeBuffers_.empty()) {
+            e.vbo = freeBuffers_.back().first;
+            e.ibo = freeBuffers_.back().second;
+            freeBuffers_.pop_back();
+        } else {
+            glGenBuffers(1, &e.vbo);
+            glGenBuffers(1, &e.ibo);
+        }
+        // 读取映射时由缺页中断从磁盘读入 (已预读的块直接来自页缓存)
+        glBindBuffer(GL_ARRAY_BUFFER, e.vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)c.vertexBytes(), file_->vertices(chunk), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, e.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)c.indexBytes(), file_->indices(chunk), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        file_->map.dontNeed(c.offset, c.bytes());   // 驱动已经复制了一份, 映射的页可以丢弃
+
+        e.resident = true;
+        pushFront(chunk);
+        residentBytes_ += c.bytes();
+        ++residentChunks_;
+        ++stats.loads;
+        stats.loadedBytes += c.bytes();
+        stats.loadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    void evict(int chunk) {
+        Entry& e = entries_[chunk];
+        lruRemove(chunk);
+        // 缓冲对象名留给下次装入复用, 存储本身立即释放
+        glBindBuffer(GL_ARRAY_BUFFER, e.vbo);
+        glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, e.ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        freeBuffers_.push_back(std::make_pair(e.vbo, e.ibo));
+        e.vbo = e.ibo = 0;
+        e.resident = false;
+        residentBytes_ -= file_->chunks[chunk].bytes();
+        --residentChunks_;
+        ++stats.evictions;
+    }
+
+    void pushFront(int chunk) {
+        Entry& e = entries_[chunk];
+        e.prev = -1;
+        e.next = head_;
+        if (head_ >= 0) entries_[head_].prev = chunk;
+        head_ = chunk;
+        if (tail_ < 0) tail_ = chunk;
+    }
+
+    void lruRemove(int chunk) {
+        Entry& e = entries_[chunk];
+        if (e.prev >= 0) entries_[e.prev].next = e.next; else head_ = e.next;
+        if (e.next >= 0) entries_[e.next].prev = e.prev; else tail_ = e.prev;
+        e.prev = e.next = -1;
+    }
+
+    OocFile* file_;
+    uint64_t budget_, uploadLimit_;
+    uint64_t residentBytes_;
+    size_t residentChunks_;
+    unsigned frame_;
+    std::vector<Entry> entries_;
+    int head_, tail_;
+    std::vector<int> missing_;                              // 本帧缺失的块, 按请求顺序
+    std::vector<std::pair<GLuint, GLuint> > freeBuffers_;   // 淘汰后待复用的 (VBO, IBO)
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef OOC_FORMAT_H
+#define OOC_FORMAT_H
+
+// 外存 (out-of-core) 模型的分块文件格式, 由 ooc_split 生成, ooc_viewer 通过 mmap 读取
+//
+//   [OocHeader][OocChunk x chunkCount] ... 填充 ... [块 0 数据] ... [块 1 数据] ...
+//
+// 每块数据从 OOC_ALIGN 对齐的偏移开始: vertexCount 个顶点 (px py pz nx ny nz), 紧接 indexCount 个 uint32 索引.
+// 对齐到页边界, 运行时可以按块 madvise 预读 / 释放, 而不影响相邻的块
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "math3d.h"
+
+const char OOC_MAGIC[8] = { 'O', 'O', 'C', 'M', 'E', 'S', 'H', '1' };
+const uint32_t OOC_VERSION = 1;
+const uint64_t OOC_ALIGN = 16384;        // macOS arm64 的页大小为 16 KB, 同时也是 4 KB 的整数倍
+const int OOC_VERTEX_FLOATS = 6;         // 位置 + 法线
+
+struct OocHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t chunkCount;
+    uint64_t triangles;                  // 全部块的三角形数之和
+    uint64_t vertices;                   // 全部块的顶点数之和 (块边界上的顶点在每块各存一份)
+    AABB bounds;
+};
+
+struct OocChunk {
+    AABB bounds;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint64_t offset;                     // 数据在文件中的字节偏移
+
+    uint64_t vertexBytes() const { return (uint64_t)vertexCount * OOC_VERTEX_FLOATS * sizeof(float); }
+    uint64_t indexBytes() const { return (uint64_t)indexCount * sizeof(uint32_t); }
+    uint64_t bytes() const { return vertexBytes() + indexBytes(); }
+};
+
+inline uint64_t oocAlign(uint64_t offset) { return (offset + OOC_ALIGN - 1) / OOC_ALIGN * OOC_ALIGN; }
+
+/**
+ * @brief 只读或读写映射整个文件 (POSIX mmap)
+ * 映射本身不占用物理内存, 访问到的页由内核按需读入, 内存紧张时可以直接丢弃 (文件就是后备存储)
+ */
+class MappedFile {
+public:
+    MappedFile() : data_(0), size_(0) {}
+    ~MappedFile() { close(); }
+
+    bool openRead(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { std::cerr << "错误: 无法打开文件 " << path << std::endl; return false; }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            std::cerr << "错误: 文件 " << path << " 为空或无法读取" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        return map(fd, (size_t)st.st_size, PROT_READ, path);
+    }
+
+    /**
+     * @brief 创建 (或截断) 大小为 bytes 的文件并可写映射, 初始内容全部为 0
+     */
+    bool create(const std::string& path, size_t bytes) {
+        close();
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) { std::cerr << "错误: 无法创建文件 " << path << std::endl; return false; }
+        if (bytes == 0) { ::close(fd); return true; }
+        if (ftruncate(fd, (off_t)bytes) != 0) {
+            std::cerr << "错误: 无法把文件 " << path << " 扩展到 " << bytes << " 字节" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        return map(fd, bytes, PROT_READ | PROT_WRITE, path);
+    }
+
+    void close() {
+        if (data_) munmap(data_, size_);
+        data_ = 0;
+        size_ = 0;
+    }
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+    // 访问模式提示 (范围会扩展到页边界; 失败不影响正确性, 因此忽略返回值)
+    void sequential() { if (data_) madvise(data_, size_, MADV_SEQUENTIAL); }
+    void willNeed(uint64_t offset, uint64_t bytes) { advise(offset, bytes, MADV_WILLNEED); }
+    void dontNeed(uint64_t offset, uint64_t bytes) { advise(offset, bytes, MADV_DONTNEED); }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    bool map(int fd, size_t bytes, int prot, const std::string& path) {
+        void* p = mmap(0, bytes, prot, MAP_SHARED, fd, 0);
+        ::close(fd);   // 映射建立后不再需要文件描述符
+        if (p == MAP_FAILED) { std::cerr << "错误: 无法映射文件 " << path << std::endl; return false; }
+        data_ = (char*)p;
+        size_ = bytes;
+        return true;
+    }
+
+    void advise(uint64_t offset, uint64_t bytes, int advice) {
+        if (!data_ || offset >= size_) return;
+        uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+        uint64_t begin = offset / page * page;
+        uint64_t end = offset + bytes < size_ ? offset + bytes : size_;
+        madvise(data_ + begin, (size_t)(end - begin), advice);
+    }
+
+    char* data_;
+    size_t size_;
+};
+
+/**
+ * @brief 映射后的分块文件: 头和块表常驻 (很小), 块数据留在映射中按需读入
+ */
+struct OocFile {
+    MappedFile map;
+    OocHeader header;
+    const OocChunk* chunks;
+
+    OocFile() : chunks(0) { memset(&header, 0, sizeof(header)); }
+
+    bool open(const std::string& path) {
+        if (!map.openRead(path)) return false;
+        if (map.size() < sizeof(OocHeader)) { std::cerr << "错误: " << path << " 不是分块模型文件" << std::endl; return false; }
+        memcpy(&header, map.data(), sizeof(header));
+        if (memcmp(header.magic, OOC_MAGIC, sizeof(OOC_MAGIC)) != 0 || header.version != OOC_VERSION) {
+            std::cerr << "错误: " << path << " 不是分块模型文件或版本不符 (请重新运行 ooc_split)" << std::endl;
+            return false;
+        }
+        uint64_t tableEnd = sizeof(OocHeader) + (uint64_t)header.chunkCount * sizeof(OocChunk);
+        if (tableEnd > map.size()) { std::cerr << "错误: " << path << " 块表不完整" << std::endl; return false; }
+        chunks = (const OocChunk*)(map.data() + sizeof(OocHeader));
+        for (uint32_t i = 0; i < header.chunkCount; ++i) {
+            if (chunks[i].offset < tableEnd || chunks[i].offset + chunks[i].bytes() > map.size()) {
+                std::cerr << "错误: " << path << " 第 " << i << " 块超出文件范围" << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t chunkCount() const { return header.chunkCount; }
+    const float* vertices(size_t i) const { return (const float*)(map.data() + chunks[i].offset); }
+    const uint32_t* indices(size_t i) const { return (const uint32_t*)(map.data() + chunks[i].offset + chunks[i].vertexBytes()); }
+};
+
+#endif
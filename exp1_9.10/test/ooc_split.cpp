@@ -0,0 +1,390 @@
+// 把放不进内存的大 OBJ 模型切分成空间上连续的块, 输出 ooc_viewer 使用的分块文件 (格式见 ooc_format.h)
+//
+//   ./ooc_split scan.obj scan.ooc                  每块最多 65536 个三角形
+//   ./ooc_split scan.obj scan.ooc --chunk 32768
+//
+// 整个过程不把模型读入内存: OBJ 文本通过 mmap 顺序扫描, 位置、法线和三角形写入临时文件后映射访问,
+// 常驻的只有固定大小的网格计数表和当前块的顶点重映射表, 其余页面由内核按需换入换出
+// 1. 扫描 "v" 行, 位置写入临时文件, 求包围盒并统计三角形数
+// 2. 扫描 "f" 行, 按三角形重心所在的网格单元计数 (128^3 均匀网格), 同时把面法线累加到三个顶点上
+// 3. 单元按 Morton 顺序排列, 相邻单元依次装入块直到三角形数达到上限; 前缀和得到每个单元的写入位置
+// 4. 再扫描一遍 "f" 行, 把三角形散列到所属单元的位置 (计数排序)
+// 5. 逐块把全局位置索引重映射为块内索引, 计算包围盒, 写出顶点和索引
+// 只使用位置和面, 忽略 vt / vn 和材质; 法线在整个模型范围内累加, 块边界处不会出现明暗接缝
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/resource.h>
+
+#include "math3d.h"
+#include "obj_parse.h"
+#include "ooc_format.h"
+#include "trace.h"
+
+const int SPLIT_GRID_BITS = 7;                           // 每个轴 128 个单元
+const unsigned SPLIT_GRID_SIZE = 1u << SPLIT_GRID_BITS;
+const size_t SPLIT_CELLS = (size_t)1 << (3 * SPLIT_GRID_BITS);
+const size_t SPLIT_RELEASE_BYTES = 64 << 20;             // 顺序扫描时每 64 MB 释放一次已读过的页
+
+typedef std::chrono::steady_clock Clock;
+
+// 一块: 三角形文件中连续的一段 (由 Morton 顺序上相邻的单元组成)
+struct SplitPiece {
+    uint64_t firstTriangle;
+    uint32_t triangleCount;
+};
+
+inline Vec3 positionAt(const float* positions, size_t i) {
+    return vec3(positions[i * 3], positions[i * 3 + 1], positions[i * 3 + 2]);
+}
+
+inline double msSince(Clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+}
+
+/**
+ * @brief 逐行调用 fn(line); 传入的每一行都以 '\n' 或 '\0' 结尾, 解析函数不会越过映射的末尾
+ * 每读完 SPLIT_RELEASE_BYTES 字节就释放已经扫描过的页, 文本本身不会在进程中常驻
+ */
+template <typename Fn>
+void forEachLine(MappedFile& file, Fn fn) {
+    const char* text = file.data();
+    const char* end = text + file.size();
+    const char* released = text;
+    for (const char* s = text; s < end; ) {
+        const char* nl = (const char*)memchr(s, '\n', end - s);
+        if (!nl) {
+            std::string last(s, end);   // 最后一行没有换行符, 复制一份补上 '\0'
+            fn(last.c_str());
+            break;
+        }
+        fn(s);
+        s = nl + 1;
+        if ((size_t)(s - released) >= SPLIT_RELEASE_BYTES) {
+            file.dontNeed(released - text, s - released);
+            released = s;
+        }
+    }
+    file.dontNeed(released - text, end - released);
+}
+
+/**
+ * @brief 按文件顺序对每个三角形调用 fn(a, b, c) (多边形扇形三角化), 参数为从 0 开始的位置索引
+ */
+template <typename Fn>
+void forEachTriangle(MappedFile& text, Fn fn) {
+    int numV = 0;
+    std::vector<unsigned> poly;
+    forEachLine(text, [&](const char* line) {
+        const char* s = skipBlanks(line);
+        if (isKeyword(s, "v")) { ++numV; return; }
+        if (!isKeyword(s, "f")) return;
+        poly.clear();
+        const char* p = skipBlanks(s + 1);
+        while (isTokenChar(*p) && *p != '#') {
+            int v, vt, vn;
+            parseObjCorner(p, numV, 0, 0, v, vt, vn);
+            p = skipBlanks(p);
+            if (v >= 0 && v < numV) poly.push_back((unsigned)v);
+        }
+        for (size_t i = 1; i + 1 < poly.size(); ++i) fn(poly[0], poly[i], poly[i + 1]);
+    });
+}
+
+// 把 7 位整数的各位分散到每 3 位的最低位
+inline unsigned spreadBits(unsigned x) {
+    unsigned r = 0;
+    for (int i = 0; i < SPLIT_GRID_BITS; ++i) r |= ((x >> i) & 1u) << (3 * i);
+    return r;
+}
+
+struct SplitGrid {
+    AABB bounds;
+    Vec3 scale;
+
+    explicit SplitGrid(const AABB& b) : bounds(b) {
+        Vec3 extent = b.max - b.min;
+        float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+        if (maxExtent <= 0.0f) maxExtent = 1.0f;
+        // 各轴使用相同的单元边长, 这样扁平的模型也能得到接近立方体的块
+        float s = SPLIT_GRID_SIZE / maxExtent;
+        scale = vec3(s, s, s);
+    }
+
+    /**
+     * @brief 点所在单元的 Morton 编码, 直接作为单元下标; 按下标顺序遍历即按 Morton 曲线遍历
+     */
+    unsigned cell(const Vec3& p) const {
+        Vec3 g = vec3((p.x - bounds.min.x) * scale.x, (p.y - bounds.min.y) * scale.y, (p.z - bounds.min.z) * scale.z);
+        unsigned x = (unsigned)std::min(std::max(g.x, 0.0f), (float)(SPLIT_GRID_SIZE - 1));
+        unsigned y = (unsigned)std::min(std::max(g.y, 0.0f), (float)(SPLIT_GRID_SIZE - 1));
+        unsigned z = (unsigned)std::min(std::max(g.z, 0.0f), (float)(SPLIT_GRID_SIZE - 1));
+        return spreadBits(x) | (spreadBits(y) << 1) | (spreadBits(z) << 2);
+    }
+};
+
+/**
+ * @brief 映射一个只在本进程中使用的临时文件; 映射建立后立即删除文件名, 进程退出 (包括异常退出) 时由系统回收
+ */
+bool createScratch(MappedFile& file, const std::string& path, size_t bytes) {
+    if (!file.create(path, bytes)) return false;
+    unlink(path.c_str());
+    return true;
+}
+
+/**
+ * @brief 第 1 步: 位置写入临时文件, 同时求包围盒并统计三角形数
+ */
+bool scanPositions(MappedFile& text, const std::string& path, MappedFile& positions,
+                   size_t& positionCount, size_t& triangleCount, AABB& bounds) {
+    TRACE_FUNCTION();
+    std::string tmpPath = path + ".tmp";
+    FILE* out = fopen(tmpPath.c_str(), "wb");
+    if (!out) { std::cerr << "错误: 无法创建临时文件 " << tmpPath << std::endl; return false; }
+    std::vector<float> buffer;
+    buffer.reserve(3 << 16);
+    positionCount = triangleCount = 0;
+    bounds = aabbEmpty();
+    forEachLine(text, [&](const char* line) {
+        const char* s = skipBlanks(line);
+        if (isKeyword(s, "v")) {
+            float p[3];
+            parseFloats(s + 1, p, 3);
+            buffer.insert(buffer.end(), p, p + 3);
+            aabbExpand(bounds, vec3(p[0], p[1], p[2]));
+            ++positionCount;
+            if (buffer.size() == buffer.capacity()) {
+                fwrite(&buffer[0], sizeof(float), buffer.size(), out);
+                buffer.clear();
+            }
+        } else if (isKeyword(s, "f")) {
+            size_t corners = 0;
+            const char* p = skipBlanks(s + 1);
+            while (isTokenChar(*p) && *p != '#') {
+                ++corners;
+                while (isTokenChar(*p)) ++p;
+                p = skipBlanks(p);
+            }
+            if (corners >= 3) triangleCount += corners - 2;
+        }
+    });
+    if (!buffer.empty()) fwrite(&buffer[0], sizeof(float), buffer.size(), out);
+    bool ok = fclose(out) == 0;
+    if (!ok) std::cerr << "错误: 写入临时文件 " << tmpPath << " 失败 (磁盘已满?)" << std::endl;
+    if (ok && positionCount > 0) ok = positions.openRead(tmpPath);
+    unlink(tmpPath.c_str());
+    return ok;
+}
+
+/**
+ * @brief 第 3 步: 按 Morton 顺序把相邻单元装入块; cellCount 原地改为每个单元在三角形文件中的起始位置
+ */
+void packCells(std::vector<uint64_t>& cellCount, uint32_t chunkTriangles, std::vector<SplitPiece>& pieces) {
+    TRACE_FUNCTION();
+    pieces.clear();
+    SplitPiece current = { 0, 0 };
+    uint64_t next = 0;
+    for (size_t c = 0; c < cellCount.size(); ++c) {
+        uint64_t cellTriangles = cellCount[c], count = cellTriangles;
+        cellCount[c] = next;
+        if (count == 0) continue;
+        if (current.triangleCount > 0 && current.triangleCount + count > chunkTriangles) {
+            pieces.push_back(current);
+            current.firstTriangle = next;
+            current.triangleCount = 0;
+        }
+        // 单个单元超过上限时 (非常密集的区域) 按文件顺序切成若干块
+        while (current.triangleCount + count > chunkTriangles) {
+            uint32_t take = chunkTriangles - current.triangleCount;
+            current.triangleCount += take;
+            pieces.push_back(current);
+            current.firstTriangle += current.triangleCount;
+            current.triangleCount = 0;
+            count -= take;
+        }
+        current.triangleCount += (uint32_t)count;
+        next += cellTriangles;
+    }
+    if (current.triangleCount > 0) pieces.push_back(current);
+}
+
+/**
+ * @brief 第 5 步: 写出一块 (全局位置索引 -> 块内索引), 返回块表项
+ */
+OocChunk writePiece(FILE* out, uint64_t offset, const uint32_t* triangles, uint32_t triangleCount,
+                    const float* positions, const float* normals,
+                    std::unordered_map<uint32_t, uint32_t>& remap, std::vector<float>& vertices, std::vector<uint32_t>& indices) {
+    remap.clear();
+    vertices.clear();
+    indices.resize((size_t)triangleCount * 3);
+    OocChunk chunk;
+    chunk.bounds = aabbEmpty();
+    for (size_t i = 0; i < indices.size(); ++i) {
+        uint32_t v = triangles[i];
+        std::pair<std::unordered_map<uint32_t, uint32_t>::iterator, bool> ins =
+            remap.insert(std::make_pair(v, (uint32_t)(vertices.size() / OOC_VERTEX_FLOATS)));
+        if (ins.second) {
+            const float* p = positions + (size_t)v * 3;
+            Vec3 n = normalize(vec3(normals[(size_t)v * 3], normals[(size_t)v * 3 + 1], normals[(size_t)v * 3 + 2]));
+            float vertex[OOC_VERTEX_FLOATS] = { p[0], p[1], p[2], n.x, n.y, n.z };
+            vertices.insert(vertices.end(), vertex, vertex + OOC_VERTEX_FLOATS);
+            aabbExpand(chunk.bounds, vec3(p[0], p[1], p[2]));
+        }
+        indices[i] = ins.first->second;
+    }
+    chunk.vertexCount = (uint32_t)(vertices.size() / OOC_VERTEX_FLOATS);
+    chunk.indexCount = (uint32_t)indices.size();
+    chunk.offset = offset;
+    fwrite(&vertices[0], sizeof(float), vertices.size(), out);
+    fwrite(&indices[0], sizeof(uint32_t), indices.size(), out);
+    return chunk;
+}
+
+/**
+ * @brief 写入 count 个 0 字节 (块之间的对齐填充)
+ */
+void writePadding(FILE* out, uint64_t count) {
+    static const char zeros[4096] = { 0 };
+    while (count > 0) {
+        size_t n = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+        fwrite(zeros, 1, n, out);
+        count -= n;
+    }
+}
+
+/**
+ * @brief 本进程的峰值常驻内存 (MB)
+ */
+double peakResidentMB() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / (1024.0 * 1024.0);   // macOS 以字节为单位
+#else
+    return usage.ru_maxrss / 1024.0;              // Linux 以 KB 为单位
+#endif
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("ooc_split_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    if (argc < 3) {
+        std::cerr << "用法: " << argv[0] << " <输入.obj> <输出.ooc> [--chunk <每块最多三角形数>]" << std::endl;
+        return 1;
+    }
+    std::string inputPath = argv[1], outputPath = argv[2];
+    uint32_t chunkTriangles = 65536;
+    for (int i = 3; i + 1 < argc; ++i)
+        if (!strcmp(argv[i], "--chunk")) chunkTriangles = (uint32_t)std::max(256, atoi(argv[i + 1]));
+
+    Clock::time_point start = Clock::now();
+    MappedFile text;
+    if (!text.openRead(inputPath)) return 1;
+    text.sequential();
+    size_t srcSize = text.size();
+
+    // --- 1. 位置 ---
+    Clock::time_point t0 = Clock::now();
+    MappedFile positionFile;
+    size_t positionCount = 0, triangleCount = 0;
+    AABB bounds;
+    if (!scanPositions(text, outputPath + ".pos", positionFile, positionCount, triangleCount, bounds)) return 1;
+    if (triangleCount == 0) { std::cerr << "错误: " << inputPath << " 中没有三角形" << std::endl; return 1; }
+    const float* positions = (const float*)positionFile.data();
+    std::cout << "[1/5] 扫描位置: " << positionCount << " 个位置, " << triangleCount << " 个三角形, "
+              << msSince(t0) << " ms (" << srcSize / (1024.0 * 1024.0) / (msSince(t0) / 1000.0) << " MB/s)" << std::endl;
+
+    // --- 2. 单元计数 + 法线累加 ---
+    t0 = Clock::now();
+    SplitGrid grid(bounds);
+    std::vector<uint64_t> cellCount(SPLIT_CELLS, 0);
+    MappedFile normalFile;
+    if (!createScratch(normalFile, outputPath + ".nrm.tmp", positionCount * 3 * sizeof(float))) return 1;
+    float* normals = (float*)normalFile.data();
+    forEachTriangle(text, [&](unsigned a, unsigned b, unsigned c) {
+        Vec3 pa = positionAt(positions, a);
+        Vec3 pb = positionAt(positions, b);
+        Vec3 pc = positionAt(positions, c);
+        ++cellCount[grid.cell((pa + pb + pc) * (1.0f / 3.0f))];
+        Vec3 n = cross(pb - pa, pc - pa);   // 未归一化, 按面积加权
+        unsigned corner[3] = { a, b, c };
+        for (int k = 0; k < 3; ++k) {
+            float* dst = normals + (size_t)corner[k] * 3;
+            dst[0] += n.x; dst[1] += n.y; dst[2] += n.z;
+        }
+    });
+    std::cout << "[2/5] 单元计数与法线: " << msSince(t0) << " ms" << std::endl;
+
+    // --- 3. 装箱 ---
+    t0 = Clock::now();
+    std::vector<SplitPiece> pieces;
+    size_t usedCells = 0;
+    for (size_t c = 0; c < SPLIT_CELLS; ++c) usedCells += cellCount[c] != 0;
+    packCells(cellCount, chunkTriangles, pieces);
+    std::cout << "[3/5] " << usedCells << " 个非空单元装入 " << pieces.size() << " 块, " << msSince(t0) << " ms" << std::endl;
+
+    // --- 4. 散列三角形 ---
+    t0 = Clock::now();
+    MappedFile triangleFile;
+    if (!createScratch(triangleFile, outputPath + ".tri.tmp", triangleCount * 3 * sizeof(uint32_t))) return 1;
+    uint32_t* triangles = (uint32_t*)triangleFile.data();
+    forEachTriangle(text, [&](unsigned a, unsigned b, unsigned c) {
+        Vec3 pa = positionAt(positions, a);
+        Vec3 pb = positionAt(positions, b);
+        Vec3 pc = positionAt(positions, c);
+        uint32_t* dst = triangles + cellCount[grid.cell((pa + pb + pc) * (1.0f / 3.0f))]++ * 3;
+        dst[0] = a; dst[1] = b; dst[2] = c;
+    });
+    text.close();
+    std::cout << "[4/5] 散列三角形: " << msSince(t0) << " ms" << std::endl;
+
+    // --- 5. 写出 ---
+    t0 = Clock::now();
+    FILE* out = fopen(outputPath.c_str(), "wb");
+    if (!out) { std::cerr << "错误: 无法创建输出文件 " << outputPath << std::endl; return 1; }
+    OocHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, OOC_MAGIC, sizeof(OOC_MAGIC));
+    header.version = OOC_VERSION;
+    header.chunkCount = (uint32_t)pieces.size();
+    header.bounds = bounds;
+    std::vector<OocChunk> table(pieces.size());
+    uint64_t offset = sizeof(OocHeader) + table.size() * sizeof(OocChunk);
+    writePadding(out, offset);   // 头和块表最后写入
+
+    std::unordered_map<uint32_t, uint32_t> remap;
+    std::vector<float> vertices;
+    std::vector<uint32_t> indices;
+    uint32_t maxVertices = 0;
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        uint64_t aligned = oocAlign(offset);
+        writePadding(out, aligned - offset);
+        const SplitPiece& piece = pieces[i];
+        const uint32_t* tris = triangles + piece.firstTriangle * 3;
+        table[i] = writePiece(out, aligned, tris, piece.triangleCount, positions, normals, remap, vertices, indices);
+        // 已写出的部分不再需要, 让内核尽早回收这些页
+        triangleFile.dontNeed(piece.firstTriangle * 3 * sizeof(uint32_t), (uint64_t)piece.triangleCount * 3 * sizeof(uint32_t));
+        offset = aligned + table[i].bytes();
+        header.triangles += piece.triangleCount;
+        header.vertices += table[i].vertexCount;
+        maxVertices = std::max(maxVertices, table[i].vertexCount);
+    }
+    fseek(out, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, out);
+    fwrite(&table[0], sizeof(OocChunk), table.size(), out);
+    if (fclose(out) != 0) { std::cerr << "错误: 写入 " << outputPath << " 失败 (磁盘已满?)" << std::endl; return 1; }
+    std::cout << "[5/5] 写出 " << outputPath << ": " << offset / (1024.0 * 1024.0) << " MB, " << msSince(t0) << " ms" << std::endl;
+
+    std::cout << "完成: " << pieces.size() << " 块, 平均 " << header.triangles / pieces.size() << " 个三角形/块 (上限 "
+              << chunkTriangles << "), 单块最多 " << maxVertices << " 个顶点; 块边界重复顶点 "
+              << 100.0 * ((double)header.vertices / std::max<size_t>(positionCount, 1) - 1.0) << "%; 总耗时 "
+              << msSince(start) << " ms, 峰值常驻内存 " << peakResidentMB() << " MB (含映射的临时文件页)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "math3d.h"
+#include "ooc_format.h"
+#include "ooc_cache.h"
+#include "input_replay.h"
+#include "trace.h"
+
+// 外存模型查看器: 打开 ooc_split 生成的分块文件, 只把视锥体内的块装入显存
+//
+//   ./ooc_viewer scan.ooc [--budget <MB>] [--upload <MB>]
+//
+// 块数据留在 mmap 映射中, 常驻显存的块由 OocChunkCache 按 LRU 管理, 总字节数不超过 --budget (默认 256 MB);
+// 每帧最多装入 --upload MB (默认 16 MB), 其余的块推迟到后续帧并提前预读
+
+// --- 模型数据 ---
+OocFile oocFile;
+OocChunkCache cache;
+std::vector<std::pair<float, int> > visibleChunks;   // (到相机距离的平方, 块), 由近到远
+
+// --- 相机 ---
+Vec3 camPos = { 0.0f, 0.0f, 0.0f };
+float yaw = 0.0f, pitch = 0.0f;
+float moveSpeed = 1.0f;
+float farPlane = 1000.0f;
+int windowWidth = 1024, windowHeight = 768;
+
+// 交互控制
+int lastMouseX, lastMouseY;
+bool isDragging = false, isWireframe = false;
+bool useCulling = true;    // 'c' 键切换: 视锥体剔除 / 请求全部块
+bool colorChunks = false;  // 'k' 键切换: 每块一种颜色
+
+// --- 统计 ---
+OocCacheStats totalStats;
+double drawMsSum = 0.0;
+uint64_t drawnTriangles = 0;
+int statFrames = 0;
+
+// --- 函数声明 ---
+void init();
+void display();
+void idle();
+void reshape(int w, int h);
+void mouseButton(int button, int state, int x, int y);
+void mouseMove(int x, int y);
+void keyboard(unsigned char key, int x, int y);
+void printStats();
+
+
+int main(int argc, char** argv) {
+    TRACE_INIT("ooc_viewer_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
+    std::string path;
+    double budgetMB = 256.0, uploadMB = 16.0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--budget") && i + 1 < argc) budgetMB = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--upload") && i + 1 < argc) uploadMB = atof(argv[++i]);
+        else path = argv[i];
+    }
+    if (path.empty()) {
+        std::cerr << "用法: " << argv[0] << " <模型.ooc> [--budget <MB>] [--upload <MB>] (先用 ooc_split 从 OBJ 生成)" << std::endl;
+        return 1;
+    }
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(windowWidth, windowHeight);
+    glutInitWindowPosition(100, 100);
+    glutCreateWindow("Out-of-Core Viewer");
+
+    if (!oocFile.open(path)) exit(1);
+    const OocHeader& h = oocFile.header;
+    uint64_t dataBytes = 0;
+    for (size_t i = 0; i < oocFile.chunkCount(); ++i) dataBytes += oocFile.chunks[i].bytes();
+    std::cout << "分块模型 " << path << ": " << h.chunkCount << " 块, " << h.triangles << " 个三角形, "
+              << h.vertices << " 个顶点, 块数据共 " << dataBytes / (1024.0 * 1024.0) << " MB; 显存预算 "
+              << budgetMB << " MB, 每帧最多装入 " << uploadMB << " MB" << std::endl;
+
+    // 相机放在包围盒正前方, 移动速度和远裁剪面随模型大小缩放
+    Vec3 center = aabbCenter(h.bounds);
+    float radius = std::max(length(h.bounds.max - h.bounds.min) * 0.5f, 1e-3f);
+    camPos = center + vec3(0.0f, 0.0f, radius * 2.0f);
+    moveSpeed = radius * 0.02f;
+    farPlane = radius * 8.0f;
+
+    init();
+    cache.init(&oocFile, (uint64_t)(budgetMB * 1024 * 1024), (uint64_t)(uploadMB * 1024 * 1024));
+    glutDisplayFunc(display);
+    replayInstallIdle(idle);
+    glutReshapeFunc(reshape);
+    replayInstallInput(mouseButton, mouseMove, keyboard);
+    glutMainLoop();
+    return 0;
+}
+
+Mat4 viewMatrix() {
+    return mat4RotateXYZ(-pitch, 0, 0) * mat4RotateXYZ(0, -yaw, 0) * mat4Translate(-camPos.x, -camPos.y, -camPos.z);
+}
+
+Mat4 projectionMatrix() {
+    return mat4Perspective(45.0f, (float)windowWidth / windowHeight, farPlane * 1e-4f, farPlane);
+}
+
+/**
+ * @brief 块编号 -> 颜色 (整数哈希), 用于观察分块结果
+ */
+void chunkColor(int chunk, float* rgb) {
+    unsigned h = (unsigned)chunk * 2654435761u;
+    h ^= h >> 15;
+    for (int i = 0; i < 3; ++i) rgb[i] = 0.35f + 0.65f * ((h >> (8 * i)) & 0xff) / 255.0f;
+}
+
+/**
+ * @brief 核心渲染函数
+ * 1. 用块的包围盒做视锥体剔除, 可见块按距离由近到远排序 (近处的块优先装入)
+ * 2. 向缓存请求可见块, 装入缺失的块 (受预算和每帧上限约束)
+ * 3. 画出已常驻的可见块; 尚未装入的块在后续帧出现
+ */
+void display() {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    Mat4 view = viewMatrix(), proj = projectionMatrix();
+
+    // --- 1. 剔除 ---
+    visibleChunks.clear();
+    {
+        TRACE_ZONE("cull");
+        Frustum frustum = frustumFromMatrix(proj * view);
+        for (size_t i = 0; i < oocFile.chunkCount(); ++i) {
+            const AABB& b = oocFile.chunks[i].bounds;
+            unsigned planeMask = 0x3f;
+            if (useCulling && frustumTestAABB(frustum, b, planeMask) == CULL_OUTSIDE) continue;
+            Vec3 d = aabbCenter(b) - camPos;
+            visibleChunks.push_back(std::make_pair(dot(d, d), (int)i));
+        }
+        std::sort(visibleChunks.begin(), visibleChunks.end());
+    }
+
+    // --- 2. 请求与装入 ---
+    cache.beginFrame();
+    for (size_t v = 0; v < visibleChunks.size(); ++v) cache.request(visibleChunks[v].second);
+    cache.update();
+
+    // --- 3. 绘制 ---
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(proj.m);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(view.m);
+    GLfloat light_pos[] = { 0.3f, 1.0f, 0.5f, 0.0f };
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glColor3f(0.8f, 0.8f, 0.75f);
+    const GLsizei stride = OOC_VERTEX_FLOATS * sizeof(float);
+    for (size_t v = 0; v < visibleChunks.size(); ++v) {
+        int chunk = visibleChunks[v].second;
+        if (!cache.resident(chunk)) continue;
+        if (colorChunks) {
+            float rgb[3];
+            chunkColor(chunk, rgb);
+            glColor3fv(rgb);
+        }
+        cache.bind(chunk);
+        glVertexPointer(3, GL_FLOAT, stride, (void*)0);
+        glNormalPointer(GL_FLOAT, stride, (void*)(3 * sizeof(float)));
+        glDrawElements(GL_TRIANGLES, (GLsizei)oocFile.chunks[chunk].indexCount, GL_UNSIGNED_INT, 0);
+        drawnTriangles += oocFile.chunks[chunk].indexCount / 3;
+    }
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    glutSwapBuffers();
+    replayFrameDone();
+    drawMsSum += std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+    if (++statFrames == 60) printStats();
+}
+
+/**
+ * @brief 每 60 帧输出一次缓存统计: 命中率 (本周期 / 累计)、常驻字节数、装入与淘汰
+ */
+void printStats() {
+    const OocCacheStats& s = cache.stats;
+    totalStats.add(s);
+    double residentMB = cache.residentBytes() / (1024.0 * 1024.0), budgetMB = cache.budget() / (1024.0 * 1024.0);
+    double loadedMB = s.loadedBytes / (1024.0 * 1024.0);
+    char title[256];
+    snprintf(title, sizeof(title), "Out-of-Core Viewer - 常驻 %.1f / %.1f MB, 命中率 %.1f%%", residentMB, budgetMB, s.hitRate());
+    glutSetWindowTitle(title);
+    std::cout << "可见块: " << visibleChunks.size() << " / " << oocFile.chunkCount() << (useCulling ? " [视锥体剔除]" : " [不剔除]")
+              << ", 命中率: " << s.hitRate() << "% (累计 " << totalStats.hitRate() << "%)"
+              << ", 常驻: " << residentMB << " / " << budgetMB << " MB (" << cache.residentChunks() << " 块)"
+              << ", 帧时间: " << drawMsSum / statFrames << " ms, " << drawnTriangles / statFrames << " 三角形/帧" << std::endl;
+    std::cout << "  装入 " << s.loads << " 块 (" << loadedMB << " MB, " << s.loadMs << " ms";
+    if (s.loadMs > 0) std::cout << ", " << loadedMB / (s.loadMs / 1000.0) << " MB/s";
+    std::cout << "), 淘汰 " << s.evictions << " 块, 推迟 " << s.deferred << " 次, 预算不足 " << s.overBudget << " 次" << std::endl;
+    cache.stats.reset();
+    drawMsSum = 0.0;
+    drawnTriangles = 0;
+    statFrames = 0;
+}
+
+void idle() {
+    TRACE_FUNCTION();
+    glutPostRedisplay();
+}
+
+// --- 其他函数 ---
+void init() {
+    TRACE_FUNCTION();
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    glLightModeli(GL_LIGHT_MODEL_TWO_SIDE, GL_TRUE); // 扫描数据的朝向不一定一致
+    GLfloat white_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, white_light);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+}
+
+void reshape(int w, int h) {
+    TRACE_FUNCTION();
+    if (h == 0) h = 1;
+    windowWidth = w;
+    windowHeight = h;
+    glViewport(0, 0, w, h);
+}
+
+void mouseButton(int button, int state, int x, int y) {
+    TRACE_FUNCTION();
+    if (button == GLUT_LEFT_BUTTON) {
+        if (state == GLUT_DOWN) { isDragging = true; lastMouseX = x; lastMouseY = y; }
+        else { isDragging = false; }
+    }
+}
+
+void mouseMove(int x, int y) {
+    TRACE_FUNCTION();
+    if (isDragging) {
+        yaw -= (x - lastMouseX) * 0.3f;
+        pitch -= (y - lastMouseY) * 0.3f;
+        pitch = std::max(-89.0f, std::min(89.0f, pitch));
+        lastMouseX = x; lastMouseY = y;
+        glutPostRedisplay();
+    }
+}
+
+/**
+ * @brief 键盘: w/s 前后移动, a/d 左右平移, r/f 升降, 'l' 线框, 'c' 切换剔除, 'k' 按块着色, '[' / ']' 预算减半 / 加倍
+ */
+void keyboard(unsigned char key, int /*x*/, int /*y*/) {
+    TRACE_FUNCTION();
+    const float k = 3.14159265359f / 180.0f;
+    float fx = -std::sin(yaw * k), fz = -std::cos(yaw * k);
+    switch (key) {
+        case 27: case 'q': exit(0); break;
+        case 'w': camPos.x += fx * moveSpeed; camPos.z += fz * moveSpeed; break;
+        case 's': camPos.x -= fx * moveSpeed; camPos.z -= fz * moveSpeed; break;
+        case 'a': camPos.x += fz * moveSpeed; camPos.z -= fx * moveSpeed; break;
+        case 'd': camPos.x -= fz * moveSpeed; camPos.z += fx * moveSpeed; break;
+        case 'r': camPos.y += moveSpeed; break;
+        case 'f': camPos.y -= moveSpeed; break;
+        case 'l': isWireframe = !isWireframe; break;
+        case 'k': colorChunks = !colorChunks; break;
+        case 'c':
+            useCulling = !useCulling;
+            std::cout << "视锥体剔除: " << (useCulling ? "开启" : "关闭") << std::endl;
+            break;
+        case '[': case ']': {
+            uint64_t budget = key == '[' ? cache.budget() / 2 : cache.budget() * 2;
+            cache.setBudget(std::max<uint64_t>(budget, 1 << 20));
+            std::cout << "显存预算: " << cache.budget() / (1024.0 * 1024.0) << " MB" << std::endl;
+            break;
+        }
+    }
+    glutPostRedisplay();
+}
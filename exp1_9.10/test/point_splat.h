@@ -0,0 +1,199 @@
+#ifndef POINT_SPLAT_H
+#define POINT_SPLAT_H
+
+// 点绘制 (splatting): 三角形投影后小于一个像素时, 三角形建立的开销被浪费, 改为把顶点画成屏幕对齐的圆盘
+//
+//   SplatOptions opt;                       // 近邻数 k, 半径缩放
+//   std::vector<float> radii;               // 每个顶点一个世界空间半径
+//   SplatStats stats;
+//   computeSplatRadii(model, opt, radii, stats);
+//   float area = meanTriangleArea(model);    // 每帧用它估计三角形的平均投影面积, 决定是否切换到点绘制
+//
+// - 半径由局部点密度决定: 到第 k 个近邻的距离 R 内有 k 个点, 密度约为 k / (pi R^2) (按曲面上的点估计),
+//   平均间距 s = R sqrt(pi / k), 半径取 radiusScale * s (默认 0.75, 圆盘之间有重叠, 不会露出空洞)
+// - 近邻查找使用均匀网格: 格子边长按曲面上每格约 k 个点选取, 按格子编号排序后用哈希表找到格子;
+//   每个点从自己的格子开始一圈圈向外找, 第 r 圈之外的点距离至少为 r 个格子加上点到自己格子边界的距离,
+//   够 k 个且都在这个距离之内时停止
+// - 位置相同的顶点 (纹理 / 法线接缝处拆分出的顶点) 不算作近邻
+// - 各顶点在共用调度器 (job_system.h) 上并行查找, 结果与线程数无关
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+
+#include "math3d.h"
+#include "obj_reader.h"
+#include "job_system.h"
+#include "trace.h"
+
+const int SPLAT_MAX_NEIGHBORS = 32;
+const int SPLAT_MAX_RINGS = 16;   // 孤立的点最多向外找这么多圈, 之后用已经找到的近邻 (或格子边长) 估计
+
+struct SplatOptions {
+    int neighbors;          // k
+    float radiusScale;      // 半径 = radiusScale * 平均点间距
+
+    SplatOptions() : neighbors(8), radiusScale(0.75f) {}
+};
+
+struct SplatStats {
+    size_t points, cells;
+    float cellSize, meanRadius;
+    double gridMs, knnMs;
+
+    SplatStats() : points(0), cells(0), cellSize(0.0f), meanRadius(0.0f), gridMs(0.0), knnMs(0.0) {}
+};
+
+inline uint64_t splatCellKey(int x, int y, int z) {
+    return ((uint64_t)(x & 0x1FFFFF) << 42) | ((uint64_t)(y & 0x1FFFFF) << 21) | (uint64_t)(z & 0x1FFFFF);
+}
+
+/**
+ * @brief 按局部点密度计算每个顶点的点绘制半径 (世界空间)
+ */
+inline void computeSplatRadii(const ObjModel& model, const SplatOptions& opt, std::vector<float>& radii, SplatStats& stats) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    size_t count = model.vertexCount();
+    int k = std::max(1, std::min(opt.neighbors, SPLAT_MAX_NEIGHBORS));
+    stats = SplatStats();
+    stats.points = count;
+    radii.assign(count, 0.0f);
+    if (count == 0) return;
+
+    // 格子边长: 点分布在曲面上时, 边长为 extent * sqrt(k / n) 的格子平均约有 k 个点
+    Vec3 extent = model.bounds.max - model.bounds.min;
+    float maxExtent = std::max(extent.x, std::max(extent.y, extent.z));
+    float cell = maxExtent > 0.0f ? maxExtent * std::sqrt((float)k / count) : 1.0f;
+    cell = std::max(cell, maxExtent / 1000000.0f);   // 每个轴最多 2^21 格
+    stats.cellSize = cell;
+    float inv = 1.0f / cell;
+    const float* base = &model.vertices[0];
+    Vec3 lo = model.bounds.min;
+
+    // 按格子编号排序 (键相同时按顶点编号, 顺序与线程数无关), 每个格子对应 order 中的一段
+    JobSystem& js = jobSystem();
+    std::vector<uint64_t> keys(count);
+    js.parallelFor(count, 0, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            const float* p = base + i * OBJ_VERTEX_STRIDE;
+            keys[i] = splatCellKey((int)((p[0] - lo.x) * inv), (int)((p[1] - lo.y) * inv), (int)((p[2] - lo.z) * inv));
+        }
+    });
+    std::vector<unsigned> order(count);
+    for (size_t i = 0; i < count; ++i) order[i] = (unsigned)i;
+    std::sort(order.begin(), order.end(), [&](unsigned a, unsigned b) { return keys[a] < keys[b] || (keys[a] == keys[b] && a < b); });
+    std::vector<unsigned> cellStart;
+    std::unordered_map<uint64_t, unsigned> cellIndex;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0 || keys[order[i]] != keys[order[i - 1]]) {
+            cellIndex[keys[order[i]]] = (unsigned)cellStart.size();
+            cellStart.push_back((unsigned)i);
+        }
+    }
+    cellStart.push_back((unsigned)count);
+    stats.cells = cellIndex.size();
+    Clock::time_point t1 = Clock::now();
+
+    // 每个点一圈圈向外查找 k 个最近的点 (best 按距离平方升序, 插入排序)
+    const float pi = 3.14159265f;
+    js.parallelFor(count, js.threadCount() * 16, [&](size_t begin, size_t end, int) {
+        float best[SPLAT_MAX_NEIGHBORS];
+        for (size_t i = begin; i < end; ++i) {
+            const float* p = base + i * OBJ_VERTEX_STRIDE;
+            float gx = (p[0] - lo.x) * inv, gy = (p[1] - lo.y) * inv, gz = (p[2] - lo.z) * inv;
+            int cx = (int)gx, cy = (int)gy, cz = (int)gz;
+            // 点到自己格子边界的最短距离 (格子边长为单位)
+            float margin = std::min(std::min(std::min(gx - cx, 1.0f - (gx - cx)), std::min(gy - cy, 1.0f - (gy - cy))),
+                                    std::min(gz - cz, 1.0f - (gz - cz)));
+            int found = 0;
+            for (int r = 0; r <= SPLAT_MAX_RINGS; ++r) {
+                for (int dx = -r; dx <= r; ++dx)
+                    for (int dy = -r; dy <= r; ++dy)
+                        for (int dz = -r; dz <= r; ++dz) {
+                            if (std::max(std::abs(dx), std::max(std::abs(dy), std::abs(dz))) != r) continue;  // 只看第 r 圈
+                            std::unordered_map<uint64_t, unsigned>::const_iterator it = cellIndex.find(splatCellKey(cx + dx, cy + dy, cz + dz));
+                            if (it == cellIndex.end()) continue;
+                            for (unsigned s = cellStart[it->second]; s < cellStart[it->second + 1]; ++s) {
+                                const float* q = base + (size_t)order[s] * OBJ_VERTEX_STRIDE;
+                                float ex = q[0] - p[0], ey = q[1] - p[1], ez = q[2] - p[2];
+                                float d2 = ex * ex + ey * ey + ez * ez;
+                                if (d2 == 0.0f || (found == k && d2 >= best[k - 1])) continue;
+                                int j = found < k ? found++ : k - 1;
+                                while (j > 0 && best[j - 1] > d2) { best[j] = best[j - 1]; --j; }
+                                best[j] = d2;
+                            }
+                        }
+                // 第 r + 1 圈中的点距离至少为 (r + margin) 个格子边长
+                float reach = (r + margin) * cell;
+                if (found == k && best[k - 1] <= reach * reach) break;
+            }
+            float reach = found > 0 ? std::sqrt(best[found - 1]) : cell;
+            radii[i] = opt.radiusScale * reach * std::sqrt(pi / std::max(found, 1));
+        }
+    });
+    double sum = 0.0;
+    for (size_t i = 0; i < count; ++i) sum += radii[i];
+    stats.meanRadius = (float)(sum / count);
+    Clock::time_point t2 = Clock::now();
+    stats.gridMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    stats.knnMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+}
+
+/**
+ * @brief 三角形的平均面积 (世界空间)
+ */
+inline float meanTriangleArea(const ObjModel& model) {
+    TRACE_FUNCTION();
+    size_t triangles = model.indices.size() / 3;
+    if (triangles == 0) return 0.0f;
+    JobSystem& js = jobSystem();
+    int chunks = js.threadCount() * 4;
+    std::vector<double> partial(chunks, 0.0);
+    js.parallelFor(triangles, chunks, [&](size_t begin, size_t end, int chunk) {
+        double sum = 0.0;
+        for (size_t t = begin; t < end; ++t) {
+            const float* a = &model.vertices[(size_t)model.indices[t * 3] * OBJ_VERTEX_STRIDE];
+            const float* b = &model.vertices[(size_t)model.indices[t * 3 + 1] * OBJ_VERTEX_STRIDE];
+            const float* c = &model.vertices[(size_t)model.indices[t * 3 + 2] * OBJ_VERTEX_STRIDE];
+            Vec3 n = cross(vec3(b[0] - a[0], b[1] - a[1], b[2] - a[2]), vec3(c[0] - a[0], c[1] - a[1], c[2] - a[2]));
+            sum += 0.5 * length(n);
+        }
+        partial[chunk] += sum;
+    });
+    double total = 0.0;
+    for (int c = 0; c < chunks; ++c) total += partial[c];
+    return (float)(total / triangles);
+}
+
+// --- 点绘制 / 三角形绘制时间对比 ---
+
+// 两种绘制方式各自累计绘制时间, 每 60 帧输出一次, 并与另一种方式最近一次的平均值比较
+struct SplatFrameTimer {
+    int frames[2];
+    double totalMs[2], lastAvg[2];   // [0] = 三角形, [1] = 点
+
+    SplatFrameTimer() {
+        for (int i = 0; i < 2; ++i) { frames[i] = 0; totalMs[i] = 0.0; lastAvg[i] = 0.0; }
+    }
+
+    void add(bool splats, double ms, size_t primitives, float projectedArea) {
+        int i = splats ? 1 : 0;
+        totalMs[i] += ms;
+        if (++frames[i] < 60) return;
+        lastAvg[i] = totalMs[i] / frames[i];
+        std::cout << "[" << (splats ? "点绘制" : "三角形") << "] 平均绘制时间 " << lastAvg[i] << " ms, " << primitives
+                  << (splats ? " 个点" : " 个三角形") << ", 三角形平均投影面积 " << projectedArea << " 像素";
+        if (lastAvg[1 - i] > 0.0) std::cout << " (" << (splats ? "三角形" : "点绘制") << " " << lastAvg[1 - i] << " ms)";
+        std::cout << std::endl;
+        frames[i] = 0;
+        totalMs[i] = 0.0;
+    }
+};
+
+#endif
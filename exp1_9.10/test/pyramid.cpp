@@ -1,13 +1,20 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <sstream>
+#include <chrono>
 
 // 在 macOS 上, 必须使用 <GLUT/glut.h> 和 <OpenGL/gl.h>
 #include <GLUT/glut.h>
 #include <OpenGL/gl.h>
 
+#include "input_replay.h"
+#include "obj_blocks.h"
+#include "parallel_for.h"
+#include "mesh_edges.h"
+#include "halfedge.h"
+#include "gpu_timer.h"
+#include "trace.h"
+
 // --- 数据结构 ---
 // 用于存储三维向量 (顶点或法线)
 struct Vec3 {
@@ -24,13 +31,27 @@ struct Face {
 std::vector<Vec3> vertices; // 存储从OBJ文件读取的顶点
 std::vector<Face> faces;    // 存储从OBJ文件读取的面
 
+// 线框模式使用的边邻接表 (加载后建立一次)
+std::vector<unsigned> triangleIndices; // faces 展开成的索引数组
+EdgeTable edgeTable;
+std::vector<unsigned> silhouetteIndices;
+WireFrameTimer wireTimer;
+GpuTimer gpuTimer;        // 各模式的绘制时间 (计时查询, 不需要 glFinish)
+
+// 细分曲面 ('+' / '-' 键切换级别, 0 = 原始网格; 每级第一次显示时计算并缓存)
+SubdivisionLevels subdivision;
+int subdivLevel = 0;
+std::vector<unsigned> subdivTriangles; // 当前级别三角化后的索引
+std::vector<float> subdivNormals;      // 当前级别的顶点法线 (平滑着色)
+const float* edgePositions = 0;        // edgeTable 所引用的顶点位置
+
 // 交互控制
 float rotateX = 20.0f;
 float rotateY = 0.0f;
 float zoom = -5.0f;
 int lastMouseX, lastMouseY;
 bool isDragging = false;
-bool isWireframe = false; // 控制显示模式 (线框/填充)
+int wireMode = WIRE_OFF;   // 显示模式 ('w' 键循环切换: 填充 / 线框 / 唯一边 / 折痕边 / 轮廓边)
 
 // --- 函数声明 ---
 void loadOBJ(const std::string& filename);
@@ -40,11 +61,15 @@ void reshape(int w, int h);
 void mouseButton(int button, int state, int x, int y);
 void mouseMove(int x, int y);
 void keyboard(unsigned char key, int x, int y);
+size_t drawEdges();
+void setSubdivisionLevel(int level);
 
 // --- 主函数 ---
 int main(int argc, char** argv) {
+    TRACE_INIT("pyramid_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
     // 1. 初始化GLUT
     glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(800, 600);
     glutInitWindowPosition(100, 100);
@@ -59,9 +84,8 @@ int main(int argc, char** argv) {
     // 4. 注册回调函数
     glutDisplayFunc(display);       // 渲染函数
     glutReshapeFunc(reshape);       // 窗口大小改变函数
-    glutMouseFunc(mouseButton);     // 鼠标点击函数
-    glutMotionFunc(mouseMove);      // 鼠标拖动函数
-    glutKeyboardFunc(keyboard);     // 键盘输入函数
+    replayInstallInput(mouseButton, mouseMove, keyboard); // 鼠标/键盘回调 (支持录制与回放)
+    replayInstallIdle(NULL);
 
     // 5. 进入主循环
     glutMainLoop();
@@ -72,41 +96,113 @@ int main(int argc, char** argv) {
 
 /**
  * @brief 从 .obj 文件加载顶点和面信息
+ * 解析方式与 cube.cpp 相同: 读入临时 arena, 按行切块并行计数和解析, 再按面并行扇形三角化
  */
 void loadOBJ(const std::string& filename) {
-    std::ifstream file(filename.c_str());
-    if (!file) {
-        std::cerr << "错误: 无法打开文件 " << filename << std::endl;
+    TRACE_FUNCTION();
+    MeshArena textArena;
+    const char* text = readFileText(filename, textArena);
+    if (!text) exit(1);
+    std::vector<ObjTextBlock> blocks;
+    ObjTextBlock total = countObjBlocks(text, blocks);
+
+    // 临时数组 (文件中的法线和纹理坐标不使用, 但解析时需要位置) 一次性放进 scratch, 用完整块释放
+    MeshArena scratch;
+    if (!scratch.reserve(MeshArena::footprint<float>(total.texcoords * 2) + MeshArena::footprint<float>(total.normals * 3)
+                         + MeshArena::footprint<ObjCornerKey>(total.corners)
+                         + MeshArena::footprint<size_t>(total.faces + 1) * 2 + MeshArena::footprint<unsigned>(total.faces)))
         exit(1);
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string prefix;
-        ss >> prefix;
-
-        if (prefix == "v") { // 顶点
-            Vec3 vertex;
-            ss >> vertex.x >> vertex.y >> vertex.z;
-            vertices.push_back(vertex);
-        } else if (prefix == "f") { // 面
-            Face face;
-            // OBJ 索引从1开始, C++数组从0开始, 所以要减1
-            ss >> face.v1 >> face.v2 >> face.v3;
-            face.v1--; 
-            face.v2--;
-            face.v3--;
-            faces.push_back(face);
+    float* texcoords = scratch.alloc<float>(total.texcoords * 2);
+    float* fileNormals = scratch.alloc<float>(total.normals * 3);
+    ObjCornerKey* corners = scratch.alloc<ObjCornerKey>(total.corners);
+    size_t* faceCorner = scratch.alloc<size_t>(total.faces + 1);
+    size_t* faceTriangle = scratch.alloc<size_t>(total.faces + 1);
+    unsigned* faceValid = scratch.alloc<unsigned>(total.faces);
+    vertices.resize(total.positions);
+
+    size_t blockCount = blocks.size();
+    std::vector<std::vector<ObjDirective> > directives(blockCount); // 不用材质, 状态行忽略
+    parallelFor(blockCount, (int)blockCount, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i)
+            parseObjBlock(blocks[i], vertices.empty() ? 0 : &vertices[0].x, texcoords, fileNormals,
+                          corners, faceCorner, faceValid, directives[i]);
+    });
+    faceCorner[total.faces] = total.corners;
+    faceTriangle[0] = 0;
+    for (size_t f = 0; f < total.faces; ++f)
+        faceTriangle[f + 1] = faceTriangle[f] + (faceValid[f] >= 3 ? faceValid[f] - 2 : 0);
+    faces.resize(faceTriangle[total.faces]);
+
+    // 面: 多于三个角的按扇形拆成三角形 (越界的角已标记为 -1 跳过), 同时展开成建立边邻接表用的索引数组
+    triangleIndices.resize(faces.size() * 3);
+    parallelFor(total.faces, 0, [&](size_t begin, size_t end, int) {
+        for (size_t f = begin; f < end; ++f) {
+            size_t t = faceTriangle[f], n = 0;
+            int first = 0, prev = 0;
+            for (size_t c = faceCorner[f]; c < faceCorner[f + 1]; ++c) {
+                int cv = corners[c].v;
+                if (cv < 0) continue;
+                if (n >= 2) {
+                    Face& face = faces[t];
+                    face.v1 = first; face.v2 = prev; face.v3 = cv;
+                    triangleIndices[t * 3 + 0] = face.v1;
+                    triangleIndices[t * 3 + 1] = face.v2;
+                    triangleIndices[t * 3 + 2] = face.v3;
+                    ++t;
+                }
+                if (n == 0) first = cv;
+                prev = cv;
+                ++n;
+            }
         }
+    });
+    size_t residentBytes = vertices.size() * sizeof(Vec3) + faces.size() * sizeof(Face)
+                         + triangleIndices.size() * sizeof(unsigned);
+    size_t peakBytes = residentBytes + textArena.bytesReserved() + scratch.bytesReserved();
+    scratch.release();
+    textArena.release();
+    std::cout << "模型加载成功: " << vertices.size() << " 个顶点, " << faces.size() << " 个面, 常驻 "
+              << residentBytes / 1024.0 << " KB, 峰值 " << peakBytes / 1024.0 << " KB." << std::endl;
+
+    if (!faces.empty()) buildEdgeTable(edgeTable, &triangleIndices[0], faces.size(), &vertices[0].x, 3, 0);
+    printEdgeStats(edgeTable, faces.size());
+    edgePositions = vertices.empty() ? 0 : &vertices[0].x;
+
+    // 建立半边网格, 作为细分的第 0 级 (全是三角形, 使用 Loop 细分)
+    if (faces.empty()) return;
+    std::vector<unsigned> faceStart(faces.size() + 1);
+    for (size_t i = 0; i < faceStart.size(); ++i) faceStart[i] = (unsigned)(i * 3);
+    HalfEdgeMesh base;
+    buildHalfEdgeMesh(base, &vertices[0].x, vertices.size(), &faceStart[0], faces.size(), &triangleIndices[0]);
+    subdivision.reset(base);
+}
+
+/**
+ * @brief 切换细分级别: 取出 (必要时计算) 该级网格, 三角化并求平滑法线, 重建线框模式的边邻接表
+ */
+void setSubdivisionLevel(int level) {
+    TRACE_FUNCTION();
+    if (subdivision.meshes.empty()) return;
+    subdivLevel = std::max(0, std::min(level, SUBDIVISION_MAX_LEVEL));
+    if (subdivLevel == 0) {
+        edgePositions = &vertices[0].x;
+        buildEdgeTable(edgeTable, &triangleIndices[0], faces.size(), edgePositions, 3, 0);
+    } else {
+        const HalfEdgeMesh& mesh = subdivision.level(subdivLevel);
+        halfEdgeTriangles(mesh, subdivTriangles);
+        halfEdgeVertexNormals(mesh, subdivNormals);
+        edgePositions = &mesh.positions[0];
+        buildEdgeTable(edgeTable, &subdivTriangles[0], subdivTriangles.size() / 3, edgePositions, 3, 0);
     }
-    std::cout << "模型加载成功: " << vertices.size() << " 个顶点, " << faces.size() << " 个面." << std::endl;
+    std::cout << "细分级别: " << subdivLevel << " (" << subdivision.schemeName() << ", "
+              << (subdivLevel == 0 ? faces.size() : subdivTriangles.size() / 3) << " 个三角形)" << std::endl;
 }
 
 /**
  * @brief 初始化OpenGL状态 (光照、深度测试等)
  */
 void init() {
+    TRACE_FUNCTION();
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f); // 设置背景颜色为深灰色
     glEnable(GL_DEPTH_TEST); // 开启深度测试, 保证物体前后关系正确
 
@@ -126,12 +222,15 @@ void init() {
     // --- 设置材质 ---
     glEnable(GL_COLOR_MATERIAL); // 允许使用glColor来指定材质颜色
     glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+    gpuTimer.init();
+    if (!gpuTimer.supported()) std::cout << "不支持 GL_EXT_timer_query, 各模式只统计 CPU 提交时间" << std::endl;
 }
 
 /**
  * @brief 核心渲染函数
  */
 void display() {
+    TRACE_FUNCTION();
     // 1. 清除颜色和深度缓冲区
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -144,42 +243,93 @@ void display() {
     glRotatef(rotateX, 1.0f, 0.0f, 0.0f); // 绕X轴旋转
     glRotatef(rotateY, 0.0f, 1.0f, 0.0f); // 绕Y轴旋转
 
-    // 4. 根据isWireframe变量切换渲染模式
-    glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
+    // 4. 唯一边 / 折痕边 / 轮廓边模式只画边, 其余模式根据 wireMode 切换多边形模式
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    gpuTimer.begin(wireMode);
+    size_t lineCount = (subdivLevel > 0 ? subdivTriangles.size() / 3 : faces.size()) * 3;
+    if (wireMode >= WIRE_EDGES) {
+        lineCount = drawEdges();
+    } else if (subdivLevel > 0) {
+        // 5'. 细分后的网格: 顶点数组 + 平滑法线
+        glPolygonMode(GL_FRONT_AND_BACK, wireMode == WIRE_POLYGON_LINE ? GL_LINE : GL_FILL);
+        glColor3f(0.5f, 0.7f, 1.0f);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, edgePositions);
+        glNormalPointer(GL_FLOAT, 0, &subdivNormals[0]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)subdivTriangles.size(), GL_UNSIGNED_INT, &subdivTriangles[0]);
+        glDisableClientState(GL_NORMAL_ARRAY);
+        glDisableClientState(GL_VERTEX_ARRAY);
+    } else {
+        glPolygonMode(GL_FRONT_AND_BACK, wireMode == WIRE_POLYGON_LINE ? GL_LINE : GL_FILL);
     
-    // 5. 绘制模型
-    glColor3f(0.5f, 0.7f, 1.0f); // 设置物体颜色
-    for (size_t i = 0; i < faces.size(); ++i) {
-        const Face& face = faces[i];
-        const Vec3& v1 = vertices[face.v1];
-        const Vec3& v2 = vertices[face.v2];
-        const Vec3& v3 = vertices[face.v3];
-
-        // 为了简单的光照, 我们即时计算面法线 (Flat Shading)
-        Vec3 U = {v2.x - v1.x, v2.y - v1.y, v2.z - v1.z};
-        Vec3 V = {v3.x - v1.x, v3.y - v1.y, v3.z - v1.z};
-        Vec3 normal = {
-            U.y * V.z - U.z * V.y,
-            U.z * V.x - U.x * V.z,
-            U.x * V.y - U.y * V.x
-        };
-
-        glBegin(GL_TRIANGLES);
-            glNormal3f(normal.x, normal.y, normal.z); // 在顶点前指定法线
-            glVertex3f(v1.x, v1.y, v1.z);
-            glVertex3f(v2.x, v2.y, v2.z);
-            glVertex3f(v3.x, v3.y, v3.z);
-        glEnd();
+        // 5. 绘制模型
+        glColor3f(0.5f, 0.7f, 1.0f); // 设置物体颜色
+        for (size_t i = 0; i < faces.size(); ++i) {
+            const Face& face = faces[i];
+            const Vec3& v1 = vertices[face.v1];
+            const Vec3& v2 = vertices[face.v2];
+            const Vec3& v3 = vertices[face.v3];
+
+            // 为了简单的光照, 我们即时计算面法线 (Flat Shading)
+            Vec3 U = {v2.x - v1.x, v2.y - v1.y, v2.z - v1.z};
+            Vec3 V = {v3.x - v1.x, v3.y - v1.y, v3.z - v1.z};
+            Vec3 normal = {
+                U.y * V.z - U.z * V.y,
+                U.z * V.x - U.x * V.z,
+                U.x * V.y - U.y * V.x
+            };
+
+            glBegin(GL_TRIANGLES);
+                glNormal3f(normal.x, normal.y, normal.z); // 在顶点前指定法线
+                glVertex3f(v1.x, v1.y, v1.z);
+                glVertex3f(v2.x, v2.y, v2.z);
+                glVertex3f(v3.x, v3.y, v3.z);
+            glEnd();
+        }
     }
+    gpuTimer.end(lineCount);
+    wireTimer.addTimed(gpuTimer, wireMode, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count(), lineCount);
 
     // 6. 交换前后缓冲区, 显示图像
     glutSwapBuffers();
+    replayFrameDone();
+}
+
+/**
+ * @brief 用一个 GL_LINES 索引数组画唯一边 / 折痕边 / 轮廓边, 返回线段数
+ */
+size_t drawEdges() {
+    TRACE_FUNCTION();
+    const std::vector<unsigned>* lines = &edgeTable.lineIndices;
+    if (wireMode == WIRE_CREASES) {
+        lines = &edgeTable.creaseIndices;
+    } else if (wireMode == WIRE_SILHOUETTE) {
+        // 轮廓边随视点变化: 求出模型空间中的视点后重新筛选
+        GLfloat modelView[16];
+        float eye[3];
+        glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+        eyeFromModelView(modelView, eye);
+        silhouetteEdges(edgeTable, eye, silhouetteIndices);
+        lines = &silhouetteIndices;
+    }
+    if (lines->empty()) return 0;
+
+    glDisable(GL_LIGHTING);
+    glColor3f(0.5f, 0.7f, 1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, edgePositions);
+    glDrawElements(GL_LINES, (GLsizei)lines->size(), GL_UNSIGNED_INT, &(*lines)[0]);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+    return lines->size() / 2;
 }
 
 /**
  * @brief 窗口大小改变时的回调函数
  */
 void reshape(int w, int h) {
+    TRACE_FUNCTION();
     if (h == 0) h = 1;
     float ratio = 1.0f * w / h;
 
@@ -200,6 +350,7 @@ void reshape(int w, int h) {
  * @brief 鼠标点击事件
  */
 void mouseButton(int button, int state, int x, int y) {
+    TRACE_FUNCTION();
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) {
             isDragging = true;
@@ -215,6 +366,7 @@ void mouseButton(int button, int state, int x, int y) {
  * @brief 鼠标拖动事件
  */
 void mouseMove(int x, int y) {
+    TRACE_FUNCTION();
     if (isDragging) {
         rotateY += (x - lastMouseX) * 0.5f;
         rotateX += (y - lastMouseY) * 0.5f;
@@ -228,15 +380,20 @@ void mouseMove(int x, int y) {
  * @brief 键盘输入事件
  */
 void keyboard(unsigned char key, int x, int y) {
+    TRACE_FUNCTION();
     switch (key) {
         case 27: // ESC键
         case 'q':
             exit(0);
             break;
-        case 'w': // 'w' 键切换线框模式
-            isWireframe = !isWireframe;
-            std::cout << "显示模式切换: " << (isWireframe ? "线框" : "填充") << std::endl;
+        case 'w': // 'w' 键循环切换显示模式
+            wireMode = (wireMode + 1) % WIRE_MODE_COUNT;
+            std::cout << "显示模式切换: " << wireModeName(wireMode) << std::endl;
             glutPostRedisplay(); // 请求重绘
             break;
+        case '+': case '=': case '-': // 提高 / 降低细分级别
+            setSubdivisionLevel(subdivLevel + (key == '-' ? -1 : 1));
+            glutPostRedisplay();
+            break;
     }
 }
\ No newline at end of file
@@ -0,0 +1,358 @@
+#ifndef SCENE_H
+#define SCENE_H
+
+// 场景图 + 实例包围盒层次结构 (BVH)
+// - 节点按深度优先顺序存放, 子树是一段连续区间 [i, subtreeEnd[i])
+// - 局部/世界变换都以 SoA (structure-of-arrays) 形式保存, 只重新计算脏子树
+// - 带网格的节点即为实例, 其世界包围盒组织成 BVH 用于视锥体剔除
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include "math3d.h"
+#include "trace.h"
+
+struct SceneGraph {
+    // --- 层级 ---
+    std::vector<std::string> name;
+    std::vector<int> parent;       // -1 表示根节点; 总有 parent[i] < i
+    std::vector<int> subtreeEnd;   // 子树区间的末尾 (不含)
+    std::vector<int> meshId;       // -1 表示纯变换节点
+
+    // --- 局部变换 (SoA) ---
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> rotX, rotY, rotZ; // 欧拉角, 角度制
+    std::vector<float> scale;
+
+    // --- 世界变换 (SoA, 仿射矩阵的 12 个分量, 第 k 个流对应列主序的 m[k]) ---
+    std::vector<float> world[12];
+
+    // --- 脏标记 ---
+    std::vector<unsigned char> dirty;
+    std::vector<int> dirtyRoots;
+
+    size_t size() const { return parent.size(); }
+
+    /**
+     * @brief 添加节点 (父节点必须已经存在), 返回节点编号
+     * 添加完成后需要调用 finalize() 整理为深度优先顺序
+     */
+    int addNode(const std::string& nodeName, int parentId, int mesh,
+                float tx, float ty, float tz, float rx, float ry, float rz, float s) {
+        int id = (int)parent.size();
+        name.push_back(nodeName);
+        parent.push_back(parentId);
+        subtreeEnd.push_back(id + 1);
+        meshId.push_back(mesh);
+        posX.push_back(tx); posY.push_back(ty); posZ.push_back(tz);
+        rotX.push_back(rx); rotY.push_back(ry); rotZ.push_back(rz);
+        scale.push_back(s);
+        for (int k = 0; k < 12; ++k) world[k].push_back(0.0f);
+        dirty.push_back(1);
+        return id;
+    }
+
+    /**
+     * @brief 把节点重排为深度优先顺序, 并计算每个子树的区间
+     */
+    void finalize() {
+        int n = (int)size();
+        std::vector<std::vector<int> > children(n);
+        std::vector<int> roots;
+        for (int i = 0; i < n; ++i) {
+            if (parent[i] < 0) roots.push_back(i);
+            else children[parent[i]].push_back(i);
+        }
+
+        std::vector<int> order;       // order[新编号] = 旧编号
+        order.reserve(n);
+        std::vector<int> stack(roots.rbegin(), roots.rend());
+        while (!stack.empty()) {
+            int node = stack.back();
+            stack.pop_back();
+            order.push_back(node);
+            for (size_t c = children[node].size(); c-- > 0;) stack.push_back(children[node][c]);
+        }
+
+        std::vector<int> newIndex(n);
+        for (int i = 0; i < n; ++i) newIndex[order[i]] = i;
+
+        permute(name, order);
+        permute(meshId, order);
+        permute(posX, order); permute(posY, order); permute(posZ, order);
+        permute(rotX, order); permute(rotY, order); permute(rotZ, order);
+        permute(scale, order);
+        std::vector<int> oldParent = parent;
+        for (int i = 0; i < n; ++i) {
+            int p = oldParent[order[i]];
+            parent[i] = p < 0 ? -1 : newIndex[p];
+        }
+
+        // 逆序累积子树末尾
+        for (int i = 0; i < n; ++i) subtreeEnd[i] = i + 1;
+        for (int i = n - 1; i >= 0; --i)
+            if (parent[i] >= 0) subtreeEnd[parent[i]] = std::max(subtreeEnd[parent[i]], subtreeEnd[i]);
+
+        std::fill(dirty.begin(), dirty.end(), 1);
+        dirtyRoots = roots;
+        for (size_t r = 0; r < dirtyRoots.size(); ++r) dirtyRoots[r] = newIndex[dirtyRoots[r]];
+    }
+
+    void setLocal(int node, float tx, float ty, float tz, float rx, float ry, float rz, float s) {
+        posX[node] = tx; posY[node] = ty; posZ[node] = tz;
+        rotX[node] = rx; rotY[node] = ry; rotZ[node] = rz;
+        scale[node] = s;
+        markDirty(node);
+    }
+
+    void markDirty(int node) {
+        if (!dirty[node]) { dirty[node] = 1; dirtyRoots.push_back(node); }
+    }
+
+    Mat4 localMatrix(int i) const {
+        return mat4Translate(posX[i], posY[i], posZ[i]) * mat4RotateXYZ(rotX[i], rotY[i], rotZ[i]) * mat4Scale(scale[i]);
+    }
+
+    Mat4 worldMatrix(int i) const {
+        Mat4 r = mat4Identity();
+        for (int k = 0; k < 12; ++k) r.m[(k / 3) * 4 + k % 3] = world[k][i];
+        return r;
+    }
+
+    /**
+     * @brief 只重新计算脏子树的世界矩阵
+     * 被更靠上的脏节点覆盖的子树会被跳过; 返回本次更新的节点数
+     * 若传入 updated, 则把更新过的节点区间 [first, last) 依次追加进去
+     */
+    size_t updateWorld(std::vector<int>* updated = 0) {
+        TRACE_ZONE("SceneGraph::updateWorld");
+        std::sort(dirtyRoots.begin(), dirtyRoots.end());
+        size_t count = 0;
+        int coveredEnd = 0;
+        for (size_t r = 0; r < dirtyRoots.size(); ++r) {
+            int root = dirtyRoots[r];
+            if (root < coveredEnd) continue; // 已在祖先的子树中更新
+            int end = subtreeEnd[root];
+            for (int i = root; i < end; ++i) {
+                Mat4 local = localMatrix(i);
+                Mat4 w = parent[i] >= 0 ? worldMatrix(parent[i]) * local : local;
+                for (int k = 0; k < 12; ++k) world[k][i] = w.m[(k / 3) * 4 + k % 3];
+                dirty[i] = 0;
+            }
+            if (updated) { updated->push_back(root); updated->push_back(end); }
+            count += end - root;
+            coveredEnd = end;
+        }
+        dirtyRoots.clear();
+        return count;
+    }
+
+private:
+    template <typename T>
+    static void permute(std::vector<T>& v, const std::vector<int>& order) {
+        std::vector<T> tmp(v.size());
+        for (size_t i = 0; i < order.size(); ++i) tmp[i] = v[order[i]];
+        v.swap(tmp);
+    }
+};
+
+// --- 实例包围盒层次结构 ---
+struct BVHNode {
+    AABB bounds;
+    int left;   // 内部节点: 左孩子编号 (右孩子为 left + 1); 叶子节点: -1
+    int first;  // 叶子节点: 在 items 中的起始位置
+    int count;  // 叶子节点: 实例数量; 内部节点为 0
+};
+
+struct InstanceBVH {
+    std::vector<BVHNode> nodes;
+    std::vector<int> items;        // 叶子引用的实例编号 (按叶子分组)
+    std::vector<AABB> instanceBounds;
+    std::vector<int> leafOf;       // 实例所在的叶子, 用于增量 refit
+    static const int LEAF_SIZE = 4;
+
+    /**
+     * @brief 以中位数划分最长轴的方式自顶向下构建
+     */
+    void build(const std::vector<AABB>& bounds) {
+        TRACE_ZONE("InstanceBVH::build");
+        instanceBounds = bounds;
+        nodes.clear();
+        items.resize(bounds.size());
+        for (size_t i = 0; i < items.size(); ++i) items[i] = (int)i;
+        leafOf.assign(bounds.size(), -1);
+        if (items.empty()) return;
+
+        nodes.reserve(2 * items.size() / LEAF_SIZE + 1);
+        BVHNode root = { aabbEmpty(), -1, 0, (int)items.size() };
+        nodes.push_back(root);
+
+        std::vector<int> stack(1, 0);
+        while (!stack.empty()) {
+            int ni = stack.back();
+            stack.pop_back();
+            int first = nodes[ni].first, count = nodes[ni].count;
+
+            AABB box = aabbEmpty(), centers = aabbEmpty();
+            for (int i = first; i < first + count; ++i) {
+                aabbMerge(box, instanceBounds[items[i]]);
+                aabbExpand(centers, aabbCenter(instanceBounds[items[i]]));
+            }
+            nodes[ni].bounds = box;
+            if (count <= LEAF_SIZE) {
+                for (int i = first; i < first + count; ++i) leafOf[items[i]] = ni;
+                continue;
+            }
+
+            Vec3 ext = centers.max - centers.min;
+            int axis = (ext.y > ext.x) ? 1 : 0;
+            if (ext.z > (&ext.x)[axis]) axis = 2;
+            int mid = first + count / 2;
+            const std::vector<AABB>& ib = instanceBounds;
+            std::nth_element(items.begin() + first, items.begin() + mid, items.begin() + first + count,
+                             [&ib, axis](int a, int b) {
+                                 return (&ib[a].min.x)[axis] + (&ib[a].max.x)[axis] < (&ib[b].min.x)[axis] + (&ib[b].max.x)[axis];
+                             });
+
+            int left = (int)nodes.size();
+            BVHNode l = { aabbEmpty(), -1, first, mid - first };
+            BVHNode r = { aabbEmpty(), -1, mid, first + count - mid };
+            nodes.push_back(l);
+            nodes.push_back(r);
+            nodes[ni].left = left;
+            nodes[ni].count = 0;
+            stack.push_back(left + 1);
+            stack.push_back(left);
+        }
+    }
+
+    /**
+     * @brief 实例包围盒变化后自底向上重新拟合 (拓扑不变)
+     * 子节点编号总是大于父节点, 因此逆序遍历即可
+     */
+    void refit() {
+        TRACE_ZONE("InstanceBVH::refit");
+        for (size_t n = nodes.size(); n-- > 0;) {
+            BVHNode& node = nodes[n];
+            if (node.left < 0) {
+                node.bounds = aabbEmpty();
+                for (int i = node.first; i < node.first + node.count; ++i) aabbMerge(node.bounds, instanceBounds[items[i]]);
+            } else {
+                node.bounds = nodes[node.left].bounds;
+                aabbMerge(node.bounds, nodes[node.left + 1].bounds);
+            }
+        }
+    }
+
+    /**
+     * @brief 视锥体剔除, 可见实例追加到 visible; 返回访问过的节点数
+     * 完全位于视锥体内的子树不再逐个检测
+     */
+    size_t cull(const Frustum& frustum, std::vector<int>& visible) const {
+        TRACE_ZONE("InstanceBVH::cull");
+        if (nodes.empty()) return 0;
+        size_t visited = 0;
+        struct Entry { int node; unsigned mask; };
+        Entry stack[64];
+        int sp = 0;
+        stack[sp].node = 0; stack[sp].mask = 0x3f; ++sp;
+        while (sp > 0) {
+            Entry e = stack[--sp];
+            const BVHNode& node = nodes[e.node];
+            ++visited;
+            unsigned mask = e.mask;
+            CullResult res = mask ? frustumTestAABB(frustum, node.bounds, mask) : CULL_INSIDE;
+            if (res == CULL_OUTSIDE) continue;
+            if (node.left < 0) {
+                for (int i = node.first; i < node.first + node.count; ++i) {
+                    unsigned m = mask;
+                    if (res == CULL_INSIDE || frustumTestAABB(frustum, instanceBounds[items[i]], m) != CULL_OUTSIDE)
+                        visible.push_back(items[i]);
+                }
+            } else {
+                stack[sp].node = node.left + 1; stack[sp].mask = mask; ++sp;
+                stack[sp].node = node.left;     stack[sp].mask = mask; ++sp;
+            }
+        }
+        return visited;
+    }
+};
+
+// --- 场景描述文件 ---
+// 每行一条指令, '#' 开头为注释:
+//   mesh <网格名> <obj文件>
+//   node <节点名> <父节点名|-> <网格名|-> tx ty tz rx ry rz s
+//   grid <父节点名> <网格名> nx ny nz 间距 缩放     (批量生成实例, 便于构造上万物体的场景)
+
+struct SceneDescription {
+    std::vector<std::string> meshNames;
+    std::vector<std::string> meshFiles;
+};
+
+/**
+ * @brief 读取场景描述文件, 填充场景图并返回需要加载的网格列表
+ */
+inline bool loadSceneFile(const std::string& filename, SceneGraph& scene, SceneDescription& desc) {
+    TRACE_FUNCTION();
+    std::ifstream file(filename.c_str());
+    if (!file) { std::cerr << "错误: 无法打开场景文件 " << filename << std::endl; return false; }
+
+    std::map<std::string, int> meshByName, nodeByName;
+    std::string line;
+    int lineNo = 0;
+    while (std::getline(file, line)) {
+        ++lineNo;
+        std::stringstream ss(line);
+        std::string cmd;
+        if (!(ss >> cmd) || cmd[0] == '#') continue;
+
+        if (cmd == "mesh") {
+            std::string meshName, meshFile;
+            ss >> meshName >> meshFile;
+            meshByName[meshName] = (int)desc.meshNames.size();
+            desc.meshNames.push_back(meshName);
+            desc.meshFiles.push_back(meshFile);
+        } else if (cmd == "node") {
+            std::string nodeName, parentName, meshName;
+            float t[7] = { 0, 0, 0, 0, 0, 0, 1 };
+            ss >> nodeName >> parentName >> meshName >> t[0] >> t[1] >> t[2] >> t[3] >> t[4] >> t[5] >> t[6];
+            int p = parentName == "-" ? -1 : (nodeByName.count(parentName) ? nodeByName[parentName] : -2);
+            int m = meshName == "-" ? -1 : (meshByName.count(meshName) ? meshByName[meshName] : -2);
+            if (p == -2 || m == -2) {
+                std::cerr << "错误: " << filename << ":" << lineNo << " 引用了未定义的节点或网格" << std::endl;
+                return false;
+            }
+            nodeByName[nodeName] = scene.addNode(nodeName, p, m, t[0], t[1], t[2], t[3], t[4], t[5], t[6]);
+        } else if (cmd == "grid") {
+            std::string parentName, meshName;
+            int nx = 1, ny = 1, nz = 1;
+            float spacing = 1.0f, s = 1.0f;
+            ss >> parentName >> meshName >> nx >> ny >> nz >> spacing >> s;
+            if (!nodeByName.count(parentName) || !meshByName.count(meshName)) {
+                std::cerr << "错误: " << filename << ":" << lineNo << " 引用了未定义的节点或网格" << std::endl;
+                return false;
+            }
+            int p = nodeByName[parentName], m = meshByName[meshName];
+            // 每一行 (固定 z) 挂在一个分组节点下, 方便整体移动
+            for (int z = 0; z < nz; ++z) {
+                std::stringstream rowName;
+                rowName << parentName << "/" << meshName << "_row" << z;
+                int row = scene.addNode(rowName.str(), p, -1, 0, 0, z * spacing, 0, 0, 0, 1);
+                for (int y = 0; y < ny; ++y)
+                    for (int x = 0; x < nx; ++x)
+                        scene.addNode("", row, m, x * spacing, y * spacing, 0, 0, (float)((x * 37 + y * 11 + z * 7) % 360), 0, s);
+            }
+        } else {
+            std::cerr << "警告: " << filename << ":" << lineNo << " 未知指令 " << cmd << std::endl;
+        }
+    }
+    scene.finalize();
+    return true;
+}
+
+#endif
@@ -0,0 +1,492 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+#include "math3d.h"
+#include "obj_loader.h"
+#include "scene.h"
+#include "occlusion.h"
+#include "multi_draw.h"
+#include "frame_pipeline.h"
+#include "input_replay.h"
+#include "trace.h"
+
+// --- 场景数据 ---
+SceneGraph scene;
+InstanceBVH bvh;
+std::vector<Mesh> meshes;
+std::vector<AABB> meshBounds;
+std::vector<int> instanceNode;   // 实例 -> 场景节点
+std::vector<int> nodeInstance;   // 场景节点 -> 实例 (-1 表示不是实例)
+std::vector<int> visibleInstances;
+
+// --- 提交 ---
+// 所有网格共享一对 VBO/IBO (见 multi_draw.h), 'i' 键在可用的提交方式之间切换
+MultiDrawBatch batch;
+int submitMode = SUBMIT_PER_OBJECT;
+
+// --- 遮挡剔除 ---
+// 上传后网格的 CPU 数据会被释放, 三角形较少的网格额外保留一份位置和索引作为遮挡体
+struct OccluderMesh {
+    std::vector<float> positions;
+    std::vector<unsigned> indices;
+    std::vector<int> neighbours;   // 相邻边 (buildOccluderNeighbours), 拓扑不变, 加载时建立
+};
+std::vector<OccluderMesh> occluderMeshes;
+OcclusionBuffer occlusion;
+std::vector<int> occluderCandidates;
+
+// --- 相机 ---
+float camX = 0.0f, camY = 10.0f, camZ = 40.0f;
+float yaw = 0.0f, pitch = -15.0f;
+float moveSpeed = 2.0f;
+int windowWidth = 1024, windowHeight = 768;
+
+// 交互控制
+int lastMouseX, lastMouseY;
+bool isDragging = false, isWireframe = false;
+bool useCulling = true;   // 'c' 键切换: BVH 剔除 / 全部提交
+bool animateRows = false; // 'm' 键切换: 让部分分组节点旋转, 用于观察脏子树更新
+bool useOcclusion = true; // 'o' 键切换: 软件 HiZ 遮挡剔除
+
+// --- 统计 ---
+struct FrameStats {
+    double updateMs, cullMs, occlusionMs, packMs;   // 工作线程上的各阶段
+    double prepareMs, waitMs, drawMs;               // 准备总耗时, GL 线程的等待与提交
+    double submitMs;                                // 其中发出绘制调用的 CPU 时间
+    size_t updatedNodes, visitedNodes, occludedInstances, occluderTriangles, calls;
+    int frames;
+};
+FrameStats stats = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+
+// --- 帧流水线 ---
+// GL 线程在 display() 中采集输入快照; 工作线程据此更新场景、剔除并生成下一帧的命令列表.
+// 场景图、BVH、遮挡缓冲和 visibleInstances 在启动流水线后只由工作线程访问
+struct FrameInput {
+    Mat4 view, proj;
+    Vec3 eye;
+    float time;
+    bool culling, occlusion, animate;
+};
+
+struct FrameCommands {
+    Mat4 view, proj;
+    std::vector<DrawCommand> draws;   // 已按网格排序
+    size_t updatedNodes, visitedNodes, occludedInstances, occluderTriangles;
+    double updateMs, cullMs, occlusionMs, packMs;
+};
+FramePipeline<FrameInput, FrameCommands> pipeline;
+
+// --- 函数声明 ---
+void init();
+void display();
+void idle();
+void reshape(int w, int h);
+void mouseButton(int button, int state, int x, int y);
+void mouseMove(int x, int y);
+void keyboard(unsigned char key, int x, int y);
+void uploadMeshes();
+void refreshInstanceBounds(const std::vector<int>& ranges);
+void occlusionCull(const Mat4& viewProj, const Vec3& eye, FrameCommands& out);
+FrameInput captureInput();
+void prepareFrame(const FrameInput& in, FrameCommands& out);
+
+
+int main(int argc, char** argv) {
+    TRACE_INIT("scene_viewer_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+    glutInitWindowSize(windowWidth, windowHeight);
+    glutInitWindowPosition(100, 100);
+    glutCreateWindow("OBJ Scene Viewer");
+
+    std::string sceneFile = argc > 1 ? argv[1] : "demo.scene";
+    SceneDescription desc;
+    if (!loadSceneFile(sceneFile, scene, desc)) exit(1);
+
+    meshes.resize(desc.meshFiles.size());
+    meshBounds.resize(desc.meshFiles.size());
+    for (size_t i = 0; i < desc.meshFiles.size(); ++i) {
+        if (!loadMesh(desc.meshFiles[i], meshes[i])) exit(1);
+        meshBounds[i] = meshes[i].bounds;
+    }
+
+    // 建立实例表
+    nodeInstance.assign(scene.size(), -1);
+    for (size_t n = 0; n < scene.size(); ++n) {
+        if (scene.meshId[n] < 0) continue;
+        nodeInstance[n] = (int)instanceNode.size();
+        instanceNode.push_back((int)n);
+    }
+
+    // 首次更新全部世界矩阵并构建 BVH
+    std::vector<int> ranges;
+    scene.updateWorld(&ranges);
+    std::vector<AABB> bounds(instanceNode.size());
+    for (size_t i = 0; i < instanceNode.size(); ++i) {
+        int node = instanceNode[i];
+        bounds[i] = aabbTransform(scene.worldMatrix(node), meshBounds[scene.meshId[node]]);
+    }
+    bvh.build(bounds);
+    std::cout << "场景加载成功: " << scene.size() << " 个节点, " << instanceNode.size() << " 个实例, "
+              << bvh.nodes.size() << " 个 BVH 节点." << std::endl;
+
+    init();
+    uploadMeshes();
+    occlusion.resize(OCC_WIDTH, OCC_HEIGHT);
+    pipeline.start(prepareFrame);
+    pipeline.submit(captureInput()); // 第一帧的准备
+    glutDisplayFunc(display);
+    replayInstallIdle(idle);
+    glutReshapeFunc(reshape);
+    replayInstallInput(mouseButton, mouseMove, keyboard);
+    glutMainLoop();
+    return 0;
+}
+
+/**
+ * @brief 把所有网格上传到共享的 VBO/IBO, 所有实例共享 (见 multi_draw.h)
+ * 上传完成后 CPU 端只需要包围盒, 网格的常驻内存随即整块归还
+ */
+void uploadMeshes() {
+    TRACE_FUNCTION();
+    static const float colors[][3] = { { 1.0f, 1.0f, 0.3f }, { 1.0f, 0.5f, 0.2f }, { 0.5f, 0.7f, 1.0f } };
+    std::vector<MultiDrawMesh> sources(meshes.size());
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const Mesh& m = meshes[i];
+        MultiDrawMesh& src = sources[i];
+        src.positions = m.positions;
+        src.normals = m.normals;
+        src.indices = m.indices;
+        src.vertexCount = m.vertexCount;
+        src.indexCount = m.indexCount;
+        std::copy(colors[i % 3], colors[i % 3] + 3, src.color);
+    }
+    std::vector<int> instanceMesh(instanceNode.size());
+    for (size_t i = 0; i < instanceNode.size(); ++i) instanceMesh[i] = scene.meshId[instanceNode[i]];
+    batch.init(sources, instanceMesh);
+
+    occluderMeshes.resize(meshes.size());
+    size_t peakBytes = 0, residentBytes = 0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        Mesh& m = meshes[i];
+        if (m.indexCount / 3 <= (size_t)OCC_MAX_MESH_TRIANGLES) {
+            occluderMeshes[i].positions.assign(m.positions, m.positions + m.vertexCount * 3);
+            occluderMeshes[i].indices.assign(m.indices, m.indices + m.indexCount);
+            buildOccluderNeighbours(m.indices, m.indexCount, occluderMeshes[i].neighbours);
+        }
+        peakBytes = std::max(peakBytes, m.peakBytes);
+        residentBytes += m.residentBytes;
+        m.releaseCPUData();
+    }
+    std::cout << "网格内存: 加载峰值 " << peakBytes / 1024.0 << " KB, 上传前常驻 " << residentBytes / 1024.0
+              << " KB, 上传后 CPU 端只保留简单网格的遮挡体副本." << std::endl;
+}
+
+/**
+ * @brief 根据 updateWorld 返回的节点区间, 重新计算受影响实例的世界包围盒
+ */
+void refreshInstanceBounds(const std::vector<int>& ranges) {
+    TRACE_FUNCTION();
+    for (size_t r = 0; r + 1 < ranges.size(); r += 2) {
+        for (int n = ranges[r]; n < ranges[r + 1]; ++n) {
+            int inst = nodeInstance[n];
+            if (inst < 0) continue;
+            bvh.instanceBounds[inst] = aabbTransform(scene.worldMatrix(n), meshBounds[scene.meshId[n]]);
+        }
+    }
+}
+
+/**
+ * @brief 软件 HiZ 遮挡剔除, 从 visibleInstances 中移除被遮挡的实例
+ * 遮挡体: 视锥体内、网格足够简单、屏幕上最大的 OCC_MAX_OCCLUDERS 个实例
+ */
+void occlusionCull(const Mat4& viewProj, const Vec3& eye, FrameCommands& out) {
+    TRACE_FUNCTION();
+    occlusion.clear();
+    occluderCandidates.clear();
+    for (size_t v = 0; v < visibleInstances.size(); ++v) {
+        int node = instanceNode[visibleInstances[v]];
+        if (!occluderMeshes[scene.meshId[node]].indices.empty()) occluderCandidates.push_back(visibleInstances[v]);
+    }
+    // 屏幕大小的估计: (包围盒对角线 / 距离)^2
+    auto screenSize = [&](int inst) {
+        const AABB& b = bvh.instanceBounds[inst];
+        Vec3 d = b.max - b.min;
+        Vec3 c = aabbCenter(b) - eye;
+        return dot(d, d) / std::max(dot(c, c), 1e-4f);
+    };
+    size_t count = std::min(occluderCandidates.size(), (size_t)OCC_MAX_OCCLUDERS);
+    std::partial_sort(occluderCandidates.begin(), occluderCandidates.begin() + count, occluderCandidates.end(),
+                      [&](int a, int b) { return screenSize(a) > screenSize(b); });
+    for (size_t i = 0; i < count; ++i) {
+        int node = instanceNode[occluderCandidates[i]];
+        const OccluderMesh& om = occluderMeshes[scene.meshId[node]];
+        occlusion.addOccluder(viewProj * scene.worldMatrix(node), &om.positions[0], om.positions.size() / 3,
+                              &om.indices[0], om.indices.size(), &om.neighbours[0]);
+    }
+    occlusion.rasterize(0);
+    occlusion.buildPyramid();
+
+    size_t kept = 0;
+    for (size_t v = 0; v < visibleInstances.size(); ++v) {
+        if (occlusion.testAABB(viewProj, bvh.instanceBounds[visibleInstances[v]]))
+            visibleInstances[kept++] = visibleInstances[v];
+    }
+    out.occludedInstances = visibleInstances.size() - kept;
+    out.occluderTriangles = occlusion.occluderTriangles;
+    visibleInstances.resize(kept);
+}
+
+Mat4 viewMatrix() {
+    return mat4RotateXYZ(-pitch, 0, 0) * mat4RotateXYZ(0, -yaw, 0) * mat4Translate(-camX, -camY, -camZ);
+}
+
+Mat4 projectionMatrix() {
+    return mat4Perspective(45.0f, (float)windowWidth / windowHeight, 0.1f, 2000.0f);
+}
+
+/**
+ * @brief 在 GL 线程上采集本帧输入的快照, 工作线程只读这份快照
+ */
+FrameInput captureInput() {
+    TRACE_FUNCTION();
+    FrameInput in;
+    in.view = viewMatrix();
+    in.proj = projectionMatrix();
+    in.eye = vec3(camX, camY, camZ);
+    in.time = (float)replayTime();
+    in.culling = useCulling;
+    in.occlusion = useOcclusion;
+    in.animate = animateRows;
+    return in;
+}
+
+/**
+ * @brief 准备一帧的绘制列表 (在工作线程上运行, 不调用 GL)
+ * 1. 更新脏子树的世界矩阵并 refit BVH
+ * 2. 用 BVH 做视锥体剔除, 再用软件 HiZ 做遮挡剔除
+ * 3. 按网格排序, 把 view * world 打包进命令列表 (三种提交方式共用)
+ */
+void prepareFrame(const FrameInput& in, FrameCommands& out) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    out.view = in.view;
+    out.proj = in.proj;
+    out.updatedNodes = out.visitedNodes = out.occludedInstances = out.occluderTriangles = 0;
+
+    // --- 1. 动画 + 脏子树更新 ---
+    if (in.animate) {
+        float angle = in.time * 20.0f;
+        int row = 0;
+        for (size_t n = 0; n < scene.size(); ++n) {
+            // 只动一部分分组节点, 其余子树保持干净
+            if (scene.meshId[n] >= 0 || scene.parent[n] < 0) continue;
+            if (row++ % 8 == 0) scene.setLocal((int)n, scene.posX[n], scene.posY[n], scene.posZ[n], 0, angle, 0, scene.scale[n]);
+        }
+    }
+    std::vector<int> ranges;
+    out.updatedNodes = scene.updateWorld(&ranges);
+    if (!ranges.empty()) {
+        refreshInstanceBounds(ranges);
+        bvh.refit();
+    }
+    Clock::time_point t1 = Clock::now();
+
+    // --- 2. 剔除 ---
+    Mat4 viewProj = in.proj * in.view;
+    visibleInstances.clear();
+    if (in.culling) {
+        out.visitedNodes = bvh.cull(frustumFromMatrix(viewProj), visibleInstances);
+    } else {
+        for (size_t i = 0; i < instanceNode.size(); ++i) visibleInstances.push_back((int)i);
+    }
+    Clock::time_point t2 = Clock::now();
+    if (in.occlusion) occlusionCull(viewProj, in.eye, out);
+    Clock::time_point t3 = Clock::now();
+
+    // --- 3. 按网格排序 (减少 VBO 切换), 打包模型视图矩阵 ---
+    std::sort(visibleInstances.begin(), visibleInstances.end(), [](int a, int b) {
+        return scene.meshId[instanceNode[a]] < scene.meshId[instanceNode[b]];
+    });
+    out.draws.resize(visibleInstances.size());
+    parallelFor(out.draws.size(), out.draws.size() >= 4096 ? 0 : 1, [&](size_t begin, size_t end, int) {
+        for (size_t v = begin; v < end; ++v) {
+            int node = instanceNode[visibleInstances[v]];
+            DrawCommand& cmd = out.draws[v];
+            cmd.mesh = scene.meshId[node];
+            cmd.instance = visibleInstances[v];
+            Mat4 modelView = in.view * scene.worldMatrix(node);
+            std::copy(modelView.m, modelView.m + 16, cmd.modelView);
+        }
+    });
+    Clock::time_point t4 = Clock::now();
+
+    out.updateMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    out.cullMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    out.occlusionMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    out.packMs = std::chrono::duration<double, std::milli>(t4 - t3).count();
+}
+
+/**
+ * @brief 核心渲染函数
+ * 取出工作线程准备好的第 N 帧, 立即让它开始准备第 N+1 帧, 然后提交第 N 帧的命令列表
+ */
+void display() {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    double prepareMs = 0.0;
+    FrameCommands* frame = pipeline.wait(&prepareMs);
+    pipeline.submit(captureInput());
+    if (!frame) return;
+    Clock::time_point t0 = Clock::now();
+
+    // --- 提交 ---
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glMatrixMode(GL_PROJECTION);
+    glLoadMatrixf(frame->proj.m);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadMatrixf(frame->view.m);
+
+    GLfloat light_pos[] = { 0.3f, 1.0f, 0.5f, 0.0f };
+    glLightfv(GL_LIGHT0, GL_POSITION, light_pos);
+    glPolygonMode(GL_FRONT_AND_BACK, isWireframe ? GL_LINE : GL_FILL);
+
+    Clock::time_point submitStart = Clock::now();
+    batch.submit(submitMode, frame->draws.empty() ? 0 : &frame->draws[0], frame->draws.size());
+    Clock::time_point submitEnd = Clock::now();
+
+    glutSwapBuffers();
+    replayFrameDone();
+    Clock::time_point t1 = Clock::now();
+
+    // --- 统计 (每 60 帧输出一次) ---
+    stats.updateMs += frame->updateMs;
+    stats.cullMs += frame->cullMs;
+    stats.occlusionMs += frame->occlusionMs;
+    stats.packMs += frame->packMs;
+    stats.prepareMs += prepareMs;
+    stats.waitMs += pipeline.lastWaitMs();
+    stats.drawMs += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    stats.submitMs += std::chrono::duration<double, std::milli>(submitEnd - submitStart).count();
+    stats.calls += batch.lastCalls();
+    stats.updatedNodes += frame->updatedNodes;
+    stats.visitedNodes += frame->visitedNodes;
+    stats.occludedInstances += frame->occludedInstances;
+    stats.occluderTriangles += frame->occluderTriangles;
+    if (++stats.frames == 60) {
+        char title[256];
+        snprintf(title, sizeof(title), "OBJ Scene Viewer - 可见 %d / %d 实例", (int)frame->draws.size(), (int)instanceNode.size());
+        glutSetWindowTitle(title);
+        // 流水线模式下准备与提交并行, GL 线程只在准备比提交慢时才需要等待
+        double hidden = pipeline.async() && stats.prepareMs > 0 ? 100.0 * std::max(0.0, 1.0 - stats.waitMs / stats.prepareMs) : 0.0;
+        std::cout << "可见实例: " << frame->draws.size() << " / " << instanceNode.size()
+                  << (useCulling ? " [BVH剔除]" : " [不剔除]")
+                  << ", 更新: " << stats.updateMs / 60 << " ms (" << stats.updatedNodes / 60 << " 节点/帧)"
+                  << ", 剔除: " << stats.cullMs / 60 << " ms (" << stats.visitedNodes / 60 << " BVH节点/帧)"
+                  << ", 遮挡: " << stats.occlusionMs / 60 << " ms (" << stats.occludedInstances / 60 << " 实例被遮挡, "
+                  << stats.occluderTriangles / 60 << " 遮挡三角形/帧)"
+                  << ", 排序/打包: " << stats.packMs / 60 << " ms" << std::endl;
+        std::cout << (pipeline.async() ? "  [流水线]" : "  [串行]") << " 准备: " << stats.prepareMs / 60
+                  << " ms, GL 线程等待: " << stats.waitMs / 60 << " ms, 提交: " << stats.drawMs / 60
+                  << " ms, 准备时间被隐藏 " << hidden << "%" << std::endl;
+        std::cout << "  [" << submitModeName(submitMode) << "] 发出绘制调用: " << stats.submitMs / 60 << " ms ("
+                  << stats.calls / 60 << " 次调用/帧)" << std::endl;
+        FrameStats zero = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+        stats = zero;
+    }
+}
+
+void idle() {
+    TRACE_FUNCTION();
+    glutPostRedisplay();
+}
+
+// --- 其他函数 ---
+void init() {
+    TRACE_FUNCTION();
+    glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_NORMALIZE);
+
+    glEnable(GL_LIGHTING);
+    glEnable(GL_LIGHT0);
+    GLfloat white_light[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glLightfv(GL_LIGHT0, GL_DIFFUSE, white_light);
+    glLightfv(GL_LIGHT0, GL_SPECULAR, white_light);
+    glEnable(GL_COLOR_MATERIAL);
+    glColorMaterial(GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE);
+}
+
+void reshape(int w, int h) {
+    TRACE_FUNCTION();
+    if (h == 0) h = 1;
+    windowWidth = w;
+    windowHeight = h;
+    glViewport(0, 0, w, h);
+}
+
+void mouseButton(int button, int state, int x, int y) {
+    TRACE_FUNCTION();
+    if (button == GLUT_LEFT_BUTTON) {
+        if (state == GLUT_DOWN) { isDragging = true; lastMouseX = x; lastMouseY = y; }
+        else { isDragging = false; }
+    }
+}
+
+void mouseMove(int x, int y) {
+    TRACE_FUNCTION();
+    if (isDragging) {
+        yaw -= (x - lastMouseX) * 0.3f;
+        pitch -= (y - lastMouseY) * 0.3f;
+        pitch = std::max(-89.0f, std::min(89.0f, pitch));
+        lastMouseX = x; lastMouseY = y;
+        glutPostRedisplay();
+    }
+}
+
+/**
+ * @brief 键盘: w/s 前后移动, a/d 左右平移, r/f 升降, 'l' 线框, 'c' 切换剔除, 'o' 切换遮挡剔除, 'm' 切换动画, 'p' 切换流水线/串行,
+ *        'i' 切换提交方式 (逐个 / glMultiDrawElements / 间接绘制, 跳过不可用的)
+ */
+void keyboard(unsigned char key, int /*x*/, int /*y*/) {
+    TRACE_FUNCTION();
+    const float k = 3.14159265359f / 180.0f;
+    float fx = -std::sin(yaw * k), fz = -std::cos(yaw * k);
+    switch (key) {
+        case 27: case 'q': exit(0); break;
+        case 'w': camX += fx * moveSpeed; camZ += fz * moveSpeed; break;
+        case 's': camX -= fx * moveSpeed; camZ -= fz * moveSpeed; break;
+        case 'a': camX += fz * moveSpeed; camZ -= fx * moveSpeed; break;
+        case 'd': camX -= fz * moveSpeed; camZ += fx * moveSpeed; break;
+        case 'r': camY += moveSpeed; break;
+        case 'f': camY -= moveSpeed; break;
+        case 'l': isWireframe = !isWireframe; break;
+        case 'c':
+            useCulling = !useCulling;
+            std::cout << "视锥体剔除: " << (useCulling ? "开启" : "关闭") << std::endl;
+            break;
+        case 'o':
+            useOcclusion = !useOcclusion;
+            std::cout << "遮挡剔除: " << (useOcclusion ? "开启" : "关闭") << std::endl;
+            break;
+        case 'm': animateRows = !animateRows; break;
+        case 'p':
+            pipeline.setAsync(!pipeline.async());
+            std::cout << "帧准备: " << (pipeline.async() ? "流水线 (工作线程)" : "串行 (GL 线程)") << std::endl;
+            break;
+        case 'i':
+            submitMode = batch.nextSupported(submitMode);
+            std::cout << "提交方式: " << submitModeName(submitMode) << std::endl;
+            break;
+    }
+    glutPostRedisplay();
+}
@@ -0,0 +1,160 @@
+// SoA + SIMD 几何核函数的基准测试 (不需要窗口)
+//
+//   ./soa_bench             合成网格: 1000 x 1000 个四边形 (约 100 万个顶点, 200 万个三角形)
+//   ./soa_bench 2000        合成网格: 2000 x 2000 个四边形
+//   ./soa_bench model.obj   使用 OBJ 文件的顶点位置和三角形
+//
+// 对比 AoS (std::vector<Vec3> + math3d.h 的标量函数) 与 SoA 的标量 / SSE2 / AVX2 核函数:
+// 批量变换、包围盒、归一化、面法线; 每项取多次运行中的最短时间, 并与 AoS 的结果比较最大误差
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "obj_reader.h"
+#include "mesh_soa.h"
+#include "trace.h"
+
+const int BENCH_RUNS = 15;
+
+/**
+ * @brief 运行 BENCH_RUNS 次, 返回最短耗时 (毫秒); prepare 在计时之外执行 (用于恢复原地修改的输入)
+ */
+template <typename Prepare, typename Fn>
+double bestMs(Prepare prepare, Fn fn) {
+    double best = 1e30;
+    for (int r = 0; r < BENCH_RUNS; ++r) {
+        prepare();
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        fn();
+        best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+    return best;
+}
+
+inline void noPrepare() {}
+
+/**
+ * @brief 合成 n x n 个四边形的起伏网格
+ */
+void makeGrid(int n, std::vector<Vec3>& positions, std::vector<unsigned>& indices) {
+    TRACE_FUNCTION();
+    size_t side = (size_t)n + 1;
+    positions.resize(side * side);
+    for (size_t y = 0; y < side; ++y)
+        for (size_t x = 0; x < side; ++x)
+            positions[y * side + x] = vec3((float)x / n, (float)y / n, 0.05f * std::sin(x * 0.1f) * std::cos(y * 0.07f));
+    indices.clear();
+    indices.reserve((size_t)n * n * 6);
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            unsigned a = (unsigned)(y * side + x), b = a + 1, c = a + (unsigned)side, d = c + 1;
+            unsigned quad[6] = { a, b, d, a, d, c };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+}
+
+float maxDiff(const std::vector<Vec3>& aos, const SoaPositions& soa) {
+    float err = 0.0f;
+    for (size_t i = 0; i < aos.size(); ++i) {
+        err = std::max(err, std::fabs(aos[i].x - soa.x[i]));
+        err = std::max(err, std::fabs(aos[i].y - soa.y[i]));
+        err = std::max(err, std::fabs(aos[i].z - soa.z[i]));
+    }
+    return err;
+}
+
+void printRow(const char* kernel, const char* variant, double ms, double baseMs, size_t elements, float err) {
+    std::cout << "  " << kernel << " [" << variant << "]: " << ms << " ms, " << elements / (ms * 1000.0) << " M/秒, "
+              << baseMs / ms << " 倍";
+    if (err >= 0.0f) std::cout << ", 最大误差 " << err;
+    std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("soa_bench_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    std::vector<Vec3> positions;
+    std::vector<unsigned> indices;
+    if (argc >= 2 && strstr(argv[1], ".obj")) {
+        ObjModel model;
+        if (!readObj(argv[1], model)) return 1;
+        positions.resize(model.vertexCount());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const float* v = &model.vertices[i * OBJ_VERTEX_STRIDE];
+            positions[i] = vec3(v[0], v[1], v[2]);
+        }
+        indices.swap(model.indices);
+    } else {
+        int n = argc >= 2 ? atoi(argv[1]) : 1000;
+        if (n <= 0) { std::cerr << "错误: 网格大小必须为正数" << std::endl; return 1; }
+        makeGrid(n, positions, indices);
+    }
+    size_t count = positions.size(), triangles = indices.size() / 3;
+    std::cout << count << " 个顶点, " << triangles << " 个三角形; 当前 CPU 默认使用 " << soaKernels().name << " 核函数" << std::endl;
+
+    Mat4 m = mat4Translate(0.5f, -1.0f, 2.0f) * mat4RotateXYZ(30.0f, 45.0f, 10.0f) * mat4Scale(1.5f);
+
+    // --- AoS 标量基准 ---
+    std::vector<Vec3> aosOut(count), aosNormals(triangles), aosUnit;
+    AABB aosBounds = aabbEmpty();
+    double aosTransform = bestMs(noPrepare, [&]() {
+        for (size_t i = 0; i < count; ++i) aosOut[i] = transformPoint(m, positions[i]);
+    });
+    double aosBoundsMs = bestMs(noPrepare, [&]() {
+        AABB b = aabbEmpty();
+        for (size_t i = 0; i < count; ++i) aabbExpand(b, positions[i]);
+        aosBounds = b;
+    });
+    double aosNormalize = bestMs([&]() { aosUnit = aosOut; }, [&]() {
+        for (size_t i = 0; i < count; ++i) {
+            float len = length(aosUnit[i]);
+            aosUnit[i] = len > 0.0f ? aosUnit[i] * (1.0f / len) : vec3(0.0f, 0.0f, 0.0f);
+        }
+    });
+    double aosFace = bestMs(noPrepare, [&]() {
+        for (size_t t = 0; t < triangles; ++t) {
+            const Vec3& a = positions[indices[t * 3]];
+            Vec3 c = cross(positions[indices[t * 3 + 1]] - a, positions[indices[t * 3 + 2]] - a);
+            float len = length(c);
+            aosNormals[t] = len > 0.0f ? c * (1.0f / len) : vec3(0.0f, 0.0f, 0.0f);
+        }
+    });
+
+    std::cout << "AoS (std::vector<Vec3>):" << std::endl;
+    printRow("变换", "AoS", aosTransform, aosTransform, count, -1.0f);
+    printRow("包围盒", "AoS", aosBoundsMs, aosBoundsMs, count, -1.0f);
+    printRow("归一化", "AoS", aosNormalize, aosNormalize, count, -1.0f);
+    printRow("面法线", "AoS", aosFace, aosFace, triangles, -1.0f);
+
+    // --- SoA (倍数相对于 AoS) ---
+    SoaPositions in, out(count), unit(count), normals(triangles);
+    in.assign(&positions[0].x, count, 3);
+    for (int level = 0; level < SOA_LEVEL_COUNT; ++level) {
+        const SoaKernels* k = soaKernelSet((SoaLevel)level);
+        if (!k) continue;
+        std::cout << k->name << ":" << std::endl;
+        double ms = bestMs(noPrepare, [&]() { k->transform(m.m, in.x, in.y, in.z, out.x, out.y, out.z, in.paddedSize()); });
+        printRow("变换", k->name, ms, aosTransform, count, maxDiff(aosOut, out));
+
+        float bmin[3], bmax[3];
+        ms = bestMs(noPrepare, [&]() { k->bounds(in.x, in.y, in.z, count, bmin, bmax); });
+        float err = std::max(std::fabs(bmin[0] - aosBounds.min.x), std::fabs(bmax[2] - aosBounds.max.z));
+        printRow("包围盒", k->name, ms, aosBoundsMs, count, err);
+
+        ms = bestMs([&]() {
+            memcpy(unit.x, out.x, count * sizeof(float));
+            memcpy(unit.y, out.y, count * sizeof(float));
+            memcpy(unit.z, out.z, count * sizeof(float));
+        }, [&]() { k->normalize(unit.x, unit.y, unit.z, unit.paddedSize()); });
+        printRow("归一化", k->name, ms, aosNormalize, count, maxDiff(aosUnit, unit));
+
+        ms = bestMs(noPrepare, [&]() { k->faceNormals(in.x, in.y, in.z, &indices[0], triangles, normals.x, normals.y, normals.z); });
+        printRow("面法线", k->name, ms, aosFace, triangles, maxDiff(aosNormals, normals));
+    }
+    return 0;
+}
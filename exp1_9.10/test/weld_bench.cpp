@@ -0,0 +1,87 @@
+// 顶点焊接的基准测试 (不需要窗口)
+//
+//   ./weld_bench                  合成网格: 1000 x 1000 个四边形, 每个四边形独立的 4 个顶点 (共 400 万个)
+//   ./weld_bench 2000             合成网格: 2000 x 2000 个四边形 (1600 万个顶点)
+//   ./weld_bench model.obj 1e-4   读取 OBJ 文件并以给定 epsilon 焊接
+//
+// 分别用 1 个线程和全部硬件线程运行, 输出顶点数变化和各阶段耗时
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+
+#include "mesh_weld.h"
+#include "trace.h"
+
+/**
+ * @brief 生成 n x n 个四边形的平面网格, 相邻四边形不共享顶点, 位置加上小于 epsilon 的扰动
+ * 模拟扫描/导出工具输出的 "三角形汤"; 正确焊接后应剩下 (n + 1)^2 个顶点
+ */
+void makeTriangleSoup(int n, float jitter, std::vector<float>& vertices, std::vector<unsigned>& indices) {
+    TRACE_FUNCTION();
+    vertices.resize((size_t)n * n * 4 * OBJ_VERTEX_STRIDE);
+    indices.resize((size_t)n * n * 6);
+    unsigned seed = 12345;
+    for (int y = 0; y < n; ++y) {
+        for (int x = 0; x < n; ++x) {
+            size_t q = (size_t)y * n + x;
+            for (int c = 0; c < 4; ++c) {
+                int cx = x + (c & 1), cy = y + (c >> 1);
+                float* v = &vertices[(q * 4 + c) * OBJ_VERTEX_STRIDE];
+                seed = seed * 1664525u + 1013904223u;
+                float r = ((seed >> 8) / 16777216.0f - 0.5f) * jitter;
+                v[0] = (float)cx + r; v[1] = (float)cy - r; v[2] = r;
+                v[3] = 0.0f; v[4] = 0.0f; v[5] = 1.0f;
+                v[6] = (float)cx / n; v[7] = (float)cy / n;
+            }
+            unsigned b = (unsigned)(q * 4);
+            unsigned* t = &indices[q * 6];
+            t[0] = b; t[1] = b + 1; t[2] = b + 3;
+            t[3] = b; t[4] = b + 3; t[5] = b + 2;
+        }
+    }
+}
+
+void runOnce(const std::vector<float>& srcVertices, const std::vector<unsigned>& srcIndices, WeldOptions opt, int threads) {
+    TRACE_FUNCTION();
+    std::vector<float> vertices = srcVertices;
+    std::vector<unsigned> indices = srcIndices;
+    opt.threads = threads;
+    WeldResult r = weldVertices(vertices, OBJ_VERTEX_STRIDE, 3, 6, indices, opt);
+    double mverts = r.verticesBefore / (r.totalMs * 1000.0);
+    std::cout << threads << " 线程: " << r.verticesBefore << " -> " << r.verticesAfter << " 个顶点 ("
+              << 100.0 * (1.0 - (double)r.verticesAfter / r.verticesBefore) << "% 减少), 总计 " << r.totalMs << " ms ["
+              << "量化 " << r.keyMs << ", 排序/建表 " << r.sortMs << ", 合并 " << r.mergeMs << ", 压缩/重映射 " << r.compactMs
+              << "], " << mverts << " M 顶点/秒" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("weld_bench_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    std::vector<float> vertices;
+    std::vector<unsigned> indices;
+    WeldOptions opt;
+    opt.matchNormals = true;
+    opt.matchTexcoords = true;
+
+    if (argc >= 2 && strstr(argv[1], ".obj")) {
+        ObjModel model;
+        if (!readObj(argv[1], model)) return 1;
+        vertices.swap(model.vertices);
+        indices.swap(model.indices);
+        opt.epsilon = argc >= 3 ? (float)atof(argv[2]) : 1e-5f;
+    } else {
+        int n = argc >= 2 ? atoi(argv[1]) : 1000;
+        if (n <= 0) { std::cerr << "错误: 网格大小必须为正数" << std::endl; return 1; }
+        opt.epsilon = 0.01f;
+        opt.texcoordEpsilon = 1e-3f;
+        makeTriangleSoup(n, opt.epsilon * 0.2f, vertices, indices);
+        std::cout << "合成网格 " << n << " x " << n << ", 期望焊接后 " << (size_t)(n + 1) * (n + 1) << " 个顶点" << std::endl;
+    }
+
+    runOnce(vertices, indices, opt, 1);
+    int hw = hardwareThreads();
+    if (hw > 1) runOnce(vertices, indices, opt, hw);
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <vector>
+#include <string>
 #include <cmath>
+#include <cstring>
+#include <chrono>
 #include <OpenGL/gl.h> // 使用 macOS 的 OpenGL 头文件
 #include <GLUT/glut.h>  // 使用 macOS 的 GLUT 头文件
 
@@ -12,6 +15,18 @@
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
 
+#include "tiled_lights.h"
+#include "stream_ring.h"
+#include "input_replay.h"
+#include "frame_capture.h"
+#include "gpu_timer.h"
+#include "parallel_for.h"
+#include "trace.h"
+
+#ifndef GL_RGBA32F_ARB
+#define GL_RGBA32F_ARB 0x8814
+#endif
+
 // --- 设置 ---
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 800;
@@ -30,6 +45,49 @@ glm::vec3 auto_rotate_axis = glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f));
 GLuint shaderProgram;
 GLuint VAO, VBO;
 int sphere_vertex_count;
+const float SPHERE_RADIUS = 0.6f;
+int sphere_sectors = 50, sphere_stacks = 50;   // '['/']' 调整细分
+const int MIN_SPHERE_SECTORS = 3, MAX_SPHERE_SECTORS = 1024;
+
+// --- 顶点拉取 ('v' 键切换) ---
+// 不使用任何顶点属性缓冲, 顶点着色器由 gl_VertexID 和细分参数重建位置与法线;
+// GLSL 120 中 gl_VertexID 需要 EXT_gpu_shader4, 不支持时此模式不可用
+bool vertex_pulling = false;
+GLuint pullProgram = 0, pullTiledProgram = 0;
+// GL 2.1 兼容上下文中启动每个顶点的是 0 号属性 (gl_Vertex), 没有启用的数组时结果未定义 (旧版 Apple 驱动什么也不画);
+// 所以 pullVAO 只启用 0 号属性, 指向每顶点 1 字节的占位缓冲, 着色器并不读取它
+GLuint pullVAO, pullDummyVBO;
+
+// 绘制耗时统计 (不变形时, 每 60 帧输出一次): CPU 提交时间 + 计时查询得到的 GPU 时间 (几帧之后才读取, 不等待 GPU)
+double sphere_draw_ms_sum = 0.0, sphere_gpu_ms_sum = 0.0;
+int sphere_stat_frames = 0, sphere_gpu_samples = 0;
+GpuTimer sphere_timer;
+std::chrono::steady_clock::time_point sphere_stat_start;
+
+// --- 多光源分块渲染 ('t' 键切换, '+'/'-' 调整灯光数量) ---
+bool tiled_lighting = false;
+int light_count = 256;
+std::vector<PointLight> lights;
+TiledLightGrid light_grid;
+GLuint tiledProgram;
+GLuint lightTex, gridTex, indexTex;
+int window_width = SCR_WIDTH, window_height = SCR_HEIGHT;
+int grid_tex_w = 0, grid_tex_h = 0, index_tex_rows = 0;
+
+// 分块统计 (每 60 帧输出一次)
+double bin_ms_sum = 0.0, upload_ms_sum = 0.0;
+int stat_frames = 0;
+
+// --- 每帧变形的球体 ('d' 键切换, 'b' 键切换三缓冲环 / 缓冲孤立) ---
+// 顶点每帧在 CPU 上重新计算, 直接写入流式缓冲的映射内存
+bool deform_sphere = false;
+StreamRing stream_ring;
+GLuint streamVAO;
+std::vector<float> sphere_dirs;         // 网格顶点的单位方向, (stacks + 1) * (sectors + 1) 个
+std::vector<unsigned> sphere_indices;   // 三角形顶点编号, 顺序与 generate_sphere 相同
+std::vector<float> deform_grid;         // 变形后的网格顶点 (位置 + 法线)
+double deform_ms_sum = 0.0;
+std::chrono::steady_clock::time_point stream_stat_start;
 
 // --- 函数声明 ---
 void display();
@@ -37,8 +95,22 @@ void reshape(int w, int h);
 void mouse(int button, int state, int x, int y);
 void motion(int x, int y);
 void idle();
+void keyboard(unsigned char key, int x, int y);
 void initShader();
 void initSphere();
+void uploadPullDummy();
+void initTiledLighting();
+void initStreaming();
+void buildDeformGrid();
+void uploadSphere();
+void setTessellation(int sectors, int stacks);
+void drawSphere();
+void deformSphere(float time, float* out);
+void drawDeformedSphere();
+void initLights(int count);
+void updateLights(float time);
+void uploadTiledLighting();
+GLuint buildProgram(const char* vsSource, const char* fsSource);
 glm::vec3 map_to_arcball(glm::vec2 point);
 std::vector<float> generate_sphere(float radius, int sectors, int stacks);
 
@@ -98,6 +170,119 @@ void main()
 }
 )glsl";
 
+// --- 顶点拉取的顶点着色器 ---
+// 顶点顺序与 generate_sphere 完全相同: 第 0 行每格一个三角形 (类型 1), 中间各行每格两个 (类型 0, 1),
+// 最后一行每格一个 (类型 0); 共 sectors * (2 * stacks - 2) 个三角形, 要求 stacks >= 2
+// 类型 0: (i, j), (i + 1, j), (i, j + 1); 类型 1: (i, j + 1), (i + 1, j), (i + 1, j + 1)
+const char *pullVertexShaderSource = R"glsl(
+#version 120
+#extension GL_EXT_gpu_shader4 : require
+varying vec3 FragPos;
+varying vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform float radius;
+uniform int sectors;
+uniform int stacks;
+
+void main()
+{
+    int tri = gl_VertexID / 3;
+    int corner = gl_VertexID - tri * 3;
+    int middle = (stacks - 2) * 2 * sectors;
+    int i, j, type;
+    if (tri < sectors) {
+        i = 0; j = tri; type = 1;
+    } else if (tri - sectors < middle) {
+        int t = tri - sectors;
+        i = 1 + t / (2 * sectors);
+        int r = t - (i - 1) * 2 * sectors;
+        j = r / 2;
+        type = r - j * 2;
+    } else {
+        i = stacks - 1; j = tri - sectors - middle; type = 0;
+    }
+
+    ivec2 g; // (行, 列)
+    if (type == 0) g = corner == 0 ? ivec2(i, j) : (corner == 1 ? ivec2(i + 1, j) : ivec2(i, j + 1));
+    else g = corner == 0 ? ivec2(i, j + 1) : (corner == 1 ? ivec2(i + 1, j) : ivec2(i + 1, j + 1));
+
+    const float PI = 3.14159265359;
+    float stackAngle = PI / 2.0 - float(g.x) * PI / float(stacks);
+    float sectorAngle = float(g.y) * 2.0 * PI / float(sectors);
+    vec3 dir = vec3(cos(stackAngle) * cos(sectorAngle), cos(stackAngle) * sin(sectorAngle), sin(stackAngle));
+
+    vec3 pos = radius * dir;
+    FragPos = vec3(model * vec4(pos, 1.0));
+    Normal = mat3(model) * dir;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
+}
+)glsl";
+
+// --- 分块多光源片元着色器 ---
+// 每个片元根据 gl_FragCoord 找到所在的块, 只遍历该块的灯光列表
+// 灯光编号纹理中每个 texel 存 4 个编号; 循环上界必须是常量, 由 MAX_LIGHTS_PER_TILE 宏给出
+const char *tiledFragmentShaderBody = R"glsl(
+varying vec3 FragPos;
+varying vec3 Normal;
+
+uniform vec3 viewPos;
+uniform vec3 objectColor;
+
+uniform sampler2D lightTex;   // 第0行: 位置 + 半径, 第1行: 颜色
+uniform sampler2D gridTex;    // 每块一个 texel: (编号起始位置, 灯光数)
+uniform sampler2D indexTex;   // 每个 texel 存 4 个灯光编号
+uniform float lightTexWidth;
+uniform vec2 gridSize;
+uniform vec2 indexTexSize;
+uniform float tileSize;
+
+vec3 shade(float index, vec3 norm, vec3 viewDir)
+{
+    float u = (index + 0.5) / lightTexWidth;
+    vec4 posRadius = texture2D(lightTex, vec2(u, 0.25));
+    vec3 color = texture2D(lightTex, vec2(u, 0.75)).rgb;
+
+    vec3 toLight = posRadius.xyz - FragPos;
+    float dist = length(toLight);
+    float att = clamp(1.0 - dist / posRadius.w, 0.0, 1.0);
+    att *= att;
+
+    vec3 lightDir = toLight / max(dist, 0.0001);
+    float diff = max(dot(norm, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, norm);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32.0);
+    return (diff + 0.8 * spec) * color * att;
+}
+
+void main()
+{
+    vec3 norm = normalize(Normal);
+    vec3 viewDir = normalize(viewPos - FragPos);
+
+    vec2 tile = floor(gl_FragCoord.xy / tileSize);
+    vec4 cell = texture2D(gridTex, (tile + 0.5) / gridSize);
+    float start = cell.r;
+    int count = int(cell.g + 0.5);
+
+    vec3 lighting = vec3(0.05);
+    for (int i = 0; i < MAX_LIGHTS_PER_TILE; i += 4) {
+        if (i >= count) break;
+        float texel = (start + float(i)) / 4.0;
+        vec2 uv = vec2((mod(texel, indexTexSize.x) + 0.5) / indexTexSize.x,
+                       (floor(texel / indexTexSize.x) + 0.5) / indexTexSize.y);
+        vec4 ids = texture2D(indexTex, uv);
+        lighting += shade(ids.x, norm, viewDir);
+        if (i + 1 < count) lighting += shade(ids.y, norm, viewDir);
+        if (i + 2 < count) lighting += shade(ids.z, norm, viewDir);
+        if (i + 3 < count) lighting += shade(ids.w, norm, viewDir);
+    }
+    gl_FragColor = vec4(lighting * objectColor, 1.0);
+}
+)glsl";
+
 // 在 main 函数或任何其他函数之前添加这个新函数
 void drawAxes() {
     // 关闭着色器，使用 OpenGL 的固定管线功能来画简单的带颜色的线
@@ -127,11 +312,13 @@ void drawAxes() {
 
 void idle()
 {
+    TRACE_FUNCTION();
     // 使用静态变量来记录上一帧的时间
-    static float lastTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+    // 回放输入轨迹时 replayTime() 返回固定步长的模拟时间, 保证自动旋转可复现
+    static float lastTime = (float)replayTime();
     
     // 获取当前时间
-    float currentTime = glutGet(GLUT_ELAPSED_TIME) / 1000.0f;
+    float currentTime = (float)replayTime();
     // 计算时间差 (delta time)
     float deltaTime = currentTime - lastTime;
     // 更新上一帧的时间
@@ -154,8 +341,11 @@ void idle()
 
 int main(int argc, char** argv)
 {
+    TRACE_INIT("arcball_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
     // --- 初始化GLUT ---
     glutInit(&argc, argv);
+    replayParseArgs(argc, argv); // --record / --replay <输入轨迹>
+    captureParseArgs(argc, argv); // --capture <前缀>: 录制画面为图像序列
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA | GLUT_DEPTH);
     glutInitWindowSize(SCR_WIDTH, SCR_HEIGHT);
     glutCreateWindow("GLUT Arcball Demo");
@@ -163,13 +353,14 @@ int main(int argc, char** argv)
     // --- 注册回调函数 ---
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
-    glutMouseFunc(mouse);
-    glutMotionFunc(motion);
-    glutIdleFunc(idle);
+    replayInstallInput(mouse, motion, keyboard);
+    replayInstallIdle(idle);
 
     // --- 初始化 ---
     initShader();
     initSphere();
+    initTiledLighting();
+    initStreaming();
     glEnable(GL_DEPTH_TEST);
 
     // --- 进入主循环 ---
@@ -179,6 +370,7 @@ int main(int argc, char** argv)
 
 void display()
 {
+    TRACE_FUNCTION();
     // --- 1. 清理屏幕 ---
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -203,38 +395,136 @@ void display()
     drawAxes();
 
     // --- 4. 绘制球体 (使用着色器) ---
-    // 激活我们的着色器程序
-    glUseProgram(shaderProgram);
+    if (tiled_lighting) {
+        // 多光源: CPU 把灯光分到屏幕块中, 上传后由分块着色器只遍历本块的灯光
+        updateLights((float)replayTime());
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        binLights(light_grid, lights, view, projection, window_width, window_height, 0.1f, 100.0f);
+        std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+        uploadTiledLighting();
+        std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+        bin_ms_sum += std::chrono::duration<double, std::milli>(t1 - t0).count();
+        upload_ms_sum += std::chrono::duration<double, std::milli>(t2 - t1).count();
+        if (++stat_frames == 60) {
+            int tiles = light_grid.tilesX * light_grid.tilesY;
+            std::cout << "灯光数: " << lights.size() << ", 分块 " << light_grid.tilesX << "x" << light_grid.tilesY
+                      << ", 平均每块 " << (double)light_grid.totalRefs / tiles << " 个, 最多 " << light_grid.maxInTile
+                      << " 个 (截断 " << light_grid.overflowTiles << " 块), 分块耗时: " << bin_ms_sum / 60
+                      << " ms, 上传: " << upload_ms_sum / 60 << " ms" << std::endl;
+            bin_ms_sum = upload_ms_sum = 0.0;
+            stat_frames = 0;
+        }
 
-    // 将矩阵作为 uniform 变量传递给着色器
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-    
-    // 将光照相关的 uniform 变量传递给着色器
-    glm::vec3 lightPos(5.0f, 5.0f, 2.0f); // 使用一个更偏的光源位置
-    glUniform3fv(glGetUniformLocation(shaderProgram, "lightPos"), 1, &lightPos[0]);
-    glUniform3fv(glGetUniformLocation(shaderProgram, "viewPos"), 1, &camera_pos[0]);
-    glUniform3f(glGetUniformLocation(shaderProgram, "objectColor"), 0.8f, 0.3f, 0.31f);
-    glUniform3f(glGetUniformLocation(shaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
-
-    // 绑定球体的顶点数组对象(VAO)并绘制
-    glBindVertexArrayAPPLE(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, sphere_vertex_count);
-    glBindVertexArrayAPPLE(0); // 解绑VAO
+        GLuint program = vertex_pulling ? pullTiledProgram : tiledProgram;
+        glUseProgram(program);
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+        glUniform3fv(glGetUniformLocation(program, "viewPos"), 1, &camera_pos[0]);
+        glUniform3f(glGetUniformLocation(program, "objectColor"), 0.8f, 0.8f, 0.8f);
+        glUniform1f(glGetUniformLocation(program, "lightTexWidth"), (float)MAX_LIGHTS);
+        glUniform2f(glGetUniformLocation(program, "gridSize"), (float)grid_tex_w, (float)grid_tex_h);
+        glUniform2f(glGetUniformLocation(program, "indexTexSize"), (float)INDEX_TEX_WIDTH, (float)index_tex_rows);
+        glUniform1f(glGetUniformLocation(program, "tileSize"), (float)TILE_SIZE);
+        glUniform1i(glGetUniformLocation(program, "lightTex"), 0);
+        glUniform1i(glGetUniformLocation(program, "gridTex"), 1);
+        glUniform1i(glGetUniformLocation(program, "indexTex"), 2);
+    } else {
+        // 激活我们的着色器程序
+        GLuint program = vertex_pulling ? pullProgram : shaderProgram;
+        glUseProgram(program);
+
+        // 将矩阵作为 uniform 变量传递给着色器
+        glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+        glUniformMatrix4fv(glGetUniformLocation(program, "view"), 1, GL_FALSE, glm::value_ptr(view));
+        glUniformMatrix4fv(glGetUniformLocation(program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+
+        // 将光照相关的 uniform 变量传递给着色器
+        glm::vec3 lightPos(5.0f, 5.0f, 2.0f); // 使用一个更偏的光源位置
+        glUniform3fv(glGetUniformLocation(program, "lightPos"), 1, &lightPos[0]);
+        glUniform3fv(glGetUniformLocation(program, "viewPos"), 1, &camera_pos[0]);
+        glUniform3f(glGetUniformLocation(program, "objectColor"), 0.8f, 0.3f, 0.31f);
+        glUniform3f(glGetUniformLocation(program, "lightColor"), 1.0f, 1.0f, 1.0f);
+    }
 
-    // --- 5. 交换前后缓冲区，显示画面 ---
+    if (deform_sphere) drawDeformedSphere();
+    else drawSphere();
+
+    // --- 5. 交换前后缓冲区，显示画面 (录制时先把后台缓冲的回读排入 PBO) ---
+    captureFrame();
     glutSwapBuffers();
+    replayFrameDone();
 }
 
 
 void reshape(int w, int h)
 {
+    TRACE_FUNCTION();
+    window_width = w;
+    window_height = h > 0 ? h : 1;
     glViewport(0, 0, w, h);
 }
 
+void keyboard(unsigned char key, int x, int y)
+{
+    TRACE_FUNCTION();
+    switch (key) {
+        case 27: case 'q': exit(0); break;
+        case 't':
+            tiled_lighting = !tiled_lighting;
+            std::cout << "光照模式: " << (tiled_lighting ? "分块多光源" : "单光源") << std::endl;
+            break;
+        case '+': case '=':
+            initLights(std::min(light_count * 2, MAX_LIGHTS));
+            break;
+        case '-':
+            initLights(std::max(light_count / 2, 1));
+            break;
+        case 'd':
+            deform_sphere = !deform_sphere;
+            if (deform_sphere) vertex_pulling = false;
+            stream_ring.stats.reset();
+            deform_ms_sum = 0.0;
+            stream_stat_start = std::chrono::steady_clock::now();
+            std::cout << "球体: " << (deform_sphere ? "每帧变形 (流式上传)" : "静态 (GL_STATIC_DRAW)") << std::endl;
+            break;
+        case 'v':
+            if (!pullProgram) {
+                std::cout << "不支持 GL_EXT_gpu_shader4 (gl_VertexID), 无法使用顶点拉取" << std::endl;
+                break;
+            }
+            vertex_pulling = !vertex_pulling;
+            if (vertex_pulling && deform_sphere) deform_sphere = false;
+            sphere_stat_frames = sphere_gpu_samples = 0;
+            sphere_draw_ms_sum = sphere_gpu_ms_sum = 0.0;
+            std::cout << "球体顶点来源: " << (vertex_pulling ? "顶点拉取 (无顶点缓冲)" : "顶点缓冲") << std::endl;
+            break;
+        case '[':
+            setTessellation(sphere_sectors / 2, sphere_stacks / 2);
+            break;
+        case ']':
+            setTessellation(sphere_sectors * 2, sphere_stacks * 2);
+            break;
+        case 'b':
+            if (!stream_ring.fencesSupported()) {
+                std::cout << "不支持栅栏同步, 只能使用缓冲孤立" << std::endl;
+                break;
+            }
+            stream_ring.setMode(stream_ring.mode() == STREAM_RING ? STREAM_ORPHAN : STREAM_RING);
+            stream_ring.stats.reset();
+            deform_ms_sum = 0.0;
+            stream_stat_start = std::chrono::steady_clock::now();
+            std::cout << "流式上传方式: " << stream_ring.modeName() << std::endl;
+            break;
+        case 'c':
+            captureToggle();
+            break;
+    }
+}
+
 void mouse(int button, int state, int x, int y)
 {
+    TRACE_FUNCTION();
     if (button == GLUT_LEFT_BUTTON) {
         if (state == GLUT_DOWN) {
             arcball_on = true;
@@ -247,6 +537,7 @@ void mouse(int button, int state, int x, int y)
 
 void motion(int x, int y)
 {
+    TRACE_FUNCTION();
     if (arcball_on) {
         glm::vec2 current_mouse_pos = glm::vec2(x, y);
 
@@ -281,44 +572,168 @@ glm::vec3 map_to_arcball(glm::vec2 point) {
 
 // --- 初始化和几何体生成函数 ---
 
-void initShader() {
-    // 为了适配 macOS 上 GLUT 默认的旧版 GLSL，版本号改为 120
-    // 并将 in/out/layout 关键字改为 attribute/varying
+/**
+ * @brief 编译并链接一个着色器程序, 出错时打印日志
+ */
+GLuint buildProgram(const char* vsSource, const char* fsSource) {
+    TRACE_FUNCTION();
+    GLint ok = 0;
+    char log[1024];
+
     GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
+    glShaderSource(vertexShader, 1, &vsSource, NULL);
     glCompileShader(vertexShader);
-    // ... 应该添加错误检查 ...
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &ok);
+    if (!ok) { glGetShaderInfoLog(vertexShader, sizeof(log), NULL, log); std::cerr << "顶点着色器编译失败:\n" << log << std::endl; }
 
     GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
+    glShaderSource(fragmentShader, 1, &fsSource, NULL);
     glCompileShader(fragmentShader);
-    // ... 应该添加错误检查 ...
+    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &ok);
+    if (!ok) { glGetShaderInfoLog(fragmentShader, sizeof(log), NULL, log); std::cerr << "片元着色器编译失败:\n" << log << std::endl; }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
 
-    shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    
     // GLSL 120 中，我们需要手动绑定 attribute 位置
-    glBindAttribLocation(shaderProgram, 0, "aPos");
-    glBindAttribLocation(shaderProgram, 1, "aNormal");
+    glBindAttribLocation(program, 0, "aPos");
+    glBindAttribLocation(program, 1, "aNormal");
 
-    glLinkProgram(shaderProgram);
-    // ... 应该添加错误检查 ...
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) { glGetProgramInfoLog(program, sizeof(log), NULL, log); std::cerr << "着色器链接失败:\n" << log << std::endl; }
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+    return program;
 }
 
-void initSphere() {
-    std::vector<float> sphere_vertices = generate_sphere(0.6f, 50, 50);
-    sphere_vertex_count = sphere_vertices.size() / 6;
+void initShader() {
+    TRACE_FUNCTION();
+    // 为了适配 macOS 上 GLUT 默认的旧版 GLSL，版本号改为 120
+    // 并将 in/out/layout 关键字改为 attribute/varying
+    shaderProgram = buildProgram(vertexShaderSource, fragmentShaderSource);
+    if (glutExtensionSupported("GL_EXT_gpu_shader4"))
+        pullProgram = buildProgram(pullVertexShaderSource, fragmentShaderSource);
+    else
+        std::cerr << "警告: 不支持 GL_EXT_gpu_shader4, 顶点拉取模式不可用" << std::endl;
+}
+
+/**
+ * @brief 初始化分块多光源: 编译着色器, 创建三张浮点纹理
+ * - lightTex:  MAX_LIGHTS x 2, 第0行位置+半径, 第1行颜色
+ * - gridTex:   每块一个 texel, (编号起始位置, 灯光数)
+ * - indexTex:  INDEX_TEX_WIDTH 宽, 每个 texel 存 4 个灯光编号, 高度按最坏情况分配
+ */
+void initTiledLighting() {
+    TRACE_FUNCTION();
+    std::string fs = std::string("#version 120\n#define MAX_LIGHTS_PER_TILE ") + std::to_string(MAX_LIGHTS_PER_TILE)
+                   + "\n" + tiledFragmentShaderBody;
+    tiledProgram = buildProgram(vertexShaderSource, fs.c_str());
+    if (pullProgram) pullTiledProgram = buildProgram(pullVertexShaderSource, fs.c_str());
+
+    GLuint textures[3];
+    glGenTextures(3, textures);
+    lightTex = textures[0];
+    gridTex = textures[1];
+    indexTex = textures[2];
+    for (int i = 0; i < 3; ++i) {
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+    glBindTexture(GL_TEXTURE_2D, lightTex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, MAX_LIGHTS, 2, 0, GL_RGBA, GL_FLOAT, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    initLights(light_count);
+}
+
+/**
+ * @brief 生成 count 个绕球体运动的彩色点光源 (固定随机种子, 每次结果相同)
+ */
+void initLights(int count) {
+    TRACE_FUNCTION();
+    light_count = count;
+    lights.resize(count);
+    unsigned seed = 12345u;
+    for (int i = 0; i < count; ++i) {
+        float r[3];
+        for (int k = 0; k < 3; ++k) { seed = seed * 1664525u + 1013904223u; r[k] = (seed >> 8) / 16777216.0f; }
+        lights[i].position = glm::vec3(0.0f); // 位置由 updateLights 每帧计算
+        lights[i].radius = 0.3f + 0.4f * r[0];
+        lights[i].color = glm::vec3(0.3f + 0.7f * r[1], 0.3f + 0.7f * r[2], 0.3f + 0.7f * r[0]) * (4.0f / std::sqrt((float)count));
+    }
+    std::cout << "灯光数量: " << count << std::endl;
+}
+
+/**
+ * @brief 让灯光在半径 0.7 ~ 1.1 的球壳上沿各自的轨道运动
+ */
+void updateLights(float time) {
+    TRACE_FUNCTION();
+    const float PI = 3.14159265359f;
+    for (int i = 0; i < light_count; ++i) {
+        unsigned h = (unsigned)i * 2654435761u;
+        float phase = (h & 0xffff) / 65536.0f * 2.0f * PI;
+        float incline = ((h >> 16) & 0xffff) / 65536.0f * PI;
+        float speed = 0.3f + 0.7f * ((h >> 8) & 0xff) / 256.0f;
+        float orbit = 0.7f + 0.4f * ((h >> 4) & 0xf) / 16.0f;
+        float a = phase + time * speed;
+        glm::vec3 p(std::cos(a) * orbit, std::sin(a) * orbit * std::cos(incline), std::sin(a) * orbit * std::sin(incline));
+        lights[i].position = p;
+    }
+}
 
+/**
+ * @brief 把灯光数据和分块结果上传到纹理
+ */
+void uploadTiledLighting() {
+    TRACE_FUNCTION();
+    std::vector<float> lightData(MAX_LIGHTS * 2 * 4, 0.0f);
+    for (size_t i = 0; i < lights.size(); ++i) {
+        float* row0 = &lightData[i * 4];
+        float* row1 = &lightData[(MAX_LIGHTS + i) * 4];
+        row0[0] = lights[i].position.x; row0[1] = lights[i].position.y; row0[2] = lights[i].position.z;
+        row0[3] = lights[i].radius;
+        row1[0] = lights[i].color.x; row1[1] = lights[i].color.y; row1[2] = lights[i].color.z;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, lightTex);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, MAX_LIGHTS, 2, GL_RGBA, GL_FLOAT, &lightData[0]);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, gridTex);
+    if (grid_tex_w != light_grid.tilesX || grid_tex_h != light_grid.tilesY) {
+        // 窗口大小变化后重新分配块纹理和编号纹理
+        grid_tex_w = light_grid.tilesX;
+        grid_tex_h = light_grid.tilesY;
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, grid_tex_w, grid_tex_h, 0, GL_RGBA, GL_FLOAT, NULL);
+        index_tex_rows = (grid_tex_w * grid_tex_h * MAX_LIGHTS_PER_TILE / 4 + INDEX_TEX_WIDTH - 1) / INDEX_TEX_WIDTH;
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D, indexTex);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F_ARB, INDEX_TEX_WIDTH, index_tex_rows, 0, GL_RGBA, GL_FLOAT, NULL);
+        glActiveTexture(GL_TEXTURE1);
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, grid_tex_w, grid_tex_h, GL_RGBA, GL_FLOAT, &light_grid.gridData[0]);
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, indexTex);
+    if (light_grid.indexRows > 0)
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, INDEX_TEX_WIDTH, light_grid.indexRows, GL_RGBA, GL_FLOAT, &light_grid.indexData[0]);
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void initSphere() {
+    TRACE_FUNCTION();
     // 在 macOS 的 GLUT 环境中，VAO 需要使用 APPLE 扩展
     glGenVertexArraysAPPLE(1, &VAO);
     glGenBuffers(1, &VBO);
 
     glBindVertexArrayAPPLE(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sphere_vertices.size() * sizeof(float), sphere_vertices.data(), GL_STATIC_DRAW);
+    uploadSphere();
 
     GLuint pos_attrib = glGetAttribLocation(shaderProgram, "aPos");
     glEnableVertexAttribArray(pos_attrib);
@@ -329,58 +744,269 @@ void initSphere() {
     glVertexAttribPointer(normal_attrib, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
 
     glBindVertexArrayAPPLE(0);
+
+    // 顶点拉取: 只有 0 号属性的占位数组 (见 pullVAO 的说明)
+    glGenVertexArraysAPPLE(1, &pullVAO);
+    glGenBuffers(1, &pullDummyVBO);
+    glBindVertexArrayAPPLE(pullVAO);
+    uploadPullDummy();
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 1, GL_UNSIGNED_BYTE, GL_FALSE, 0, (void*)0);
+    glBindVertexArrayAPPLE(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    sphere_timer.init();
+    if (!sphere_timer.supported()) std::cout << "不支持 GL_EXT_timer_query, 球体绘制只统计 CPU 提交时间" << std::endl;
 }
 
-// generate_sphere 函数与之前的版本完全相同，这里省略以节省空间
-// 如果需要，我可以再次提供
-std::vector<float> generate_sphere(float radius, int sectors, int stacks) {
-    std::vector<float> vertices;
-    float x, y, z, xy;
-    float nx, ny, nz, length_inv = 1.0f / radius;
-    const float PI = 3.14159265359f;
+/**
+ * @brief 按当前细分重新分配顶点拉取的占位缓冲 (每个顶点 1 字节, 内容为 0)
+ */
+void uploadPullDummy() {
+    TRACE_FUNCTION();
+    std::vector<unsigned char> zeros((size_t)sphere_sectors * (2 * sphere_stacks - 2) * 3, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, pullDummyVBO);
+    glBufferData(GL_ARRAY_BUFFER, zeros.size(), zeros.data(), GL_STATIC_DRAW);
+}
+
+/**
+ * @brief 按当前细分生成球体并上传到 VBO (VAO 中的属性指针仍然有效)
+ */
+void uploadSphere() {
+    TRACE_FUNCTION();
+    std::vector<float> sphere_vertices = generate_sphere(SPHERE_RADIUS, sphere_sectors, sphere_stacks);
+    sphere_vertex_count = sphere_vertices.size() / 6;
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, sphere_vertices.size() * sizeof(float), sphere_vertices.data(), GL_STATIC_DRAW);
+}
+
+/**
+ * @brief 修改细分: 顶点缓冲和变形网格需要重新生成并上传, 顶点拉取只改 uniform
+ */
+void setTessellation(int sectors, int stacks) {
+    TRACE_FUNCTION();
+    sectors = std::max(MIN_SPHERE_SECTORS, std::min(sectors, MAX_SPHERE_SECTORS));
+    stacks = std::max(2, std::min(stacks, MAX_SPHERE_SECTORS / 2));
+    if (sectors == sphere_sectors && stacks == sphere_stacks) return;
+    sphere_sectors = sectors;
+    sphere_stacks = stacks;
+
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    uploadSphere();
+    uploadPullDummy();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    double upload_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    buildDeformGrid();
+    std::cout << "细分 " << sphere_sectors << " x " << sphere_stacks << ": " << sphere_vertex_count
+              << " 个顶点, 顶点缓冲重新生成并上传 " << sphere_vertex_count * 6 * sizeof(float) / 1024.0 << " KB 耗时 "
+              << upload_ms << " ms (顶点拉取: 只有每顶点 1 字节的占位缓冲, 位置和法线由 uniform 计算)" << std::endl;
+    sphere_stat_frames = sphere_gpu_samples = 0;
+    sphere_draw_ms_sum = sphere_gpu_ms_sum = 0.0;
+}
+
+/**
+ * @brief 绘制静态球体 (顶点缓冲或顶点拉取); 每 60 帧输出顶点内存和绘制耗时
+ * GPU 时间来自计时查询, 只包含球体本身, 不需要在绘制前后 glFinish
+ */
+void drawSphere() {
+    TRACE_FUNCTION();
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    if (sphere_stat_frames == 0) sphere_stat_start = t0;
+    sphere_timer.begin();
+    if (vertex_pulling) {
+        GLint program = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+        glUniform1f(glGetUniformLocation(program, "radius"), SPHERE_RADIUS);
+        glUniform1i(glGetUniformLocation(program, "sectors"), sphere_sectors);
+        glUniform1i(glGetUniformLocation(program, "stacks"), sphere_stacks);
+        glBindVertexArrayAPPLE(pullVAO);
+        glDrawArrays(GL_TRIANGLES, 0, sphere_sectors * (2 * sphere_stacks - 2) * 3);
+        glBindVertexArrayAPPLE(0);
+    } else {
+        // 绑定球体的顶点数组对象(VAO)并绘制
+        glBindVertexArrayAPPLE(VAO);
+        glDrawArrays(GL_TRIANGLES, 0, sphere_vertex_count);
+        glBindVertexArrayAPPLE(0); // 解绑VAO
+    }
+    sphere_timer.end();
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    sphere_draw_ms_sum += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double gpu_ms = 0.0;
+    sphere_gpu_samples += sphere_timer.collect(gpu_ms);
+    sphere_gpu_ms_sum += gpu_ms;
+
+    if (++sphere_stat_frames == 60) {
+        double window_ms = std::chrono::duration<double, std::milli>(t1 - sphere_stat_start).count();
+        size_t buffer_bytes = vertex_pulling ? sphere_vertex_count : sphere_vertex_count * 6 * sizeof(float);
+        std::cout << "[" << (vertex_pulling ? "顶点拉取" : "顶点缓冲") << "] 细分 " << sphere_sectors << " x " << sphere_stacks
+                  << ", " << sphere_vertex_count << " 个顶点, 顶点缓冲 " << buffer_bytes / 1024.0 << " KB, 球体提交 "
+                  << sphere_draw_ms_sum / sphere_stat_frames << " ms";
+        if (sphere_gpu_samples > 0) std::cout << ", GPU " << sphere_gpu_ms_sum / sphere_gpu_samples << " ms";
+        std::cout << ", 平均帧时间 " << window_ms / sphere_stat_frames << " ms" << std::endl;
+        sphere_stat_frames = sphere_gpu_samples = 0;
+        sphere_draw_ms_sum = sphere_gpu_ms_sum = 0.0;
+    }
+}
+
+/**
+ * @brief 初始化变形球体的流式上传: 网格、流式缓冲和它的 VAO
+ * 顶点指针的偏移每帧不同, 在 drawDeformedSphere 中重新设置
+ */
+void initStreaming() {
+    TRACE_FUNCTION();
+    buildDeformGrid();
+
+    glGenVertexArraysAPPLE(1, &streamVAO);
+    glBindVertexArrayAPPLE(streamVAO);
+    glEnableVertexAttribArray(0); // buildProgram 把 aPos 绑定到 0, aNormal 绑定到 1
+    glEnableVertexAttribArray(1);
+    glBindVertexArrayAPPLE(0);
+}
 
-    float sector_step = 2 * PI / sectors;
-    float stack_step = PI / stacks;
-    float sector_angle, stack_angle;
-
-    for(int i = 0; i <= stacks; ++i) {
-        stack_angle = PI / 2 - i * stack_step;
-        xy = radius * cosf(stack_angle);
-        z = radius * sinf(stack_angle);
-
-        for(int j = 0; j <= sectors; ++j) {
-            sector_angle = j * sector_step;
-            x = xy * cosf(sector_angle);
-            y = xy * sinf(sector_angle);
-            vertices.push_back(x);
-            vertices.push_back(y);
-            vertices.push_back(z);
-            nx = x * length_inv;
-            ny = y * length_inv;
-            nz = z * length_inv;
-            vertices.push_back(nx);
-            vertices.push_back(ny);
-            vertices.push_back(nz);
+/**
+ * @brief 按当前细分生成变形用的网格方向和三角形编号, 并按新的大小重建流式缓冲
+ */
+void buildDeformGrid() {
+    TRACE_FUNCTION();
+    const float PI = 3.14159265359f;
+    sphere_dirs.clear();
+    for (int i = 0; i <= sphere_stacks; ++i) {
+        float stack_angle = PI / 2 - i * PI / sphere_stacks;
+        for (int j = 0; j <= sphere_sectors; ++j) {
+            float sector_angle = j * 2 * PI / sphere_sectors;
+            sphere_dirs.push_back(cosf(stack_angle) * cosf(sector_angle));
+            sphere_dirs.push_back(cosf(stack_angle) * sinf(sector_angle));
+            sphere_dirs.push_back(sinf(stack_angle));
         }
     }
-    
-    std::vector<float> sphere_data;
-    int k1, k2;
-    for(int i = 0; i < stacks; ++i) {
-        k1 = i * (sectors + 1);
-        k2 = k1 + sectors + 1;
-        for(int j = 0; j < sectors; ++j, ++k1, ++k2) {
-            if(i != 0) {
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[k1*6+k]);
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[k2*6+k]);
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[(k1+1)*6+k]);
+    sphere_indices.clear();
+    for (int i = 0; i < sphere_stacks; ++i) {
+        unsigned k1 = i * (sphere_sectors + 1), k2 = k1 + sphere_sectors + 1;
+        for (int j = 0; j < sphere_sectors; ++j, ++k1, ++k2) {
+            if (i != 0) { sphere_indices.push_back(k1); sphere_indices.push_back(k2); sphere_indices.push_back(k1 + 1); }
+            if (i != sphere_stacks - 1) { sphere_indices.push_back(k1 + 1); sphere_indices.push_back(k2); sphere_indices.push_back(k2 + 1); }
+        }
+    }
+    deform_grid.resize(sphere_dirs.size() * 2);
+
+    stream_ring.init(sphere_indices.size() * 6 * sizeof(float));
+    std::cout << "流式上传方式: " << stream_ring.modeName() << ", 每帧 "
+              << sphere_indices.size() * 6 * sizeof(float) / 1024.0 << " KB" << std::endl;
+}
+
+/**
+ * @brief 计算变形后的球体, 按三角形顺序写出 (位置 + 法线) 到 out
+ * 半径 r(u) = R * (1 + a * f(u)), f 为单位方向 u 的三维波函数;
+ * 曲面 r(u) * u 的法线与 u - a / (1 + a f) * grad_s(f) 同向 (grad_s 为 f 在球面上的梯度), 两极处也没有奇点
+ */
+void deformSphere(float time, float* out) {
+    TRACE_FUNCTION();
+    const float a = 0.12f, k = 4.0f;
+    size_t grid_count = sphere_dirs.size() / 3;
+    for (size_t v = 0; v < grid_count; ++v) {
+        const float* u = &sphere_dirs[v * 3];
+        float px = k * u[0] + time, py = k * u[1] + 1.3f * time, pz = k * u[2] + 0.7f * time;
+        float sx = sinf(px), sy = sinf(py), sz = sinf(pz);
+        float f = sx * sy * sz;
+        float gx = k * cosf(px) * sy * sz, gy = k * sx * cosf(py) * sz, gz = k * sx * sy * cosf(pz);
+        float gu = gx * u[0] + gy * u[1] + gz * u[2];
+        float s = a / (1.0f + a * f);
+        float nx = u[0] - s * (gx - gu * u[0]), ny = u[1] - s * (gy - gu * u[1]), nz = u[2] - s * (gz - gu * u[2]);
+        float inv = 1.0f / sqrtf(nx * nx + ny * ny + nz * nz);
+        float r = SPHERE_RADIUS * (1.0f + a * f);
+        float* g = &deform_grid[v * 6];
+        g[0] = r * u[0]; g[1] = r * u[1]; g[2] = r * u[2];
+        g[3] = nx * inv; g[4] = ny * inv; g[5] = nz * inv;
+    }
+    // 映射内存可能是写合并的显存映射: 只按顺序写, 不回读
+    for (size_t i = 0; i < sphere_indices.size(); ++i) {
+        const float* g = &deform_grid[sphere_indices[i] * 6];
+        for (int c = 0; c < 6; ++c) *out++ = g[c];
+    }
+}
+
+/**
+ * @brief 变形并流式上传球体, 然后绘制; 每 60 帧输出上传带宽和同步等待时间
+ */
+void drawDeformedSphere() {
+    TRACE_FUNCTION();
+    size_t bytes = sphere_indices.size() * 6 * sizeof(float);
+    float* dst = (float*)stream_ring.begin(bytes);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    deformSphere((float)replayTime(), dst);
+    deform_ms_sum += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    size_t offset = stream_ring.end();
+
+    glBindVertexArrayAPPLE(streamVAO);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 3 * sizeof(float)));
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)sphere_indices.size());
+    glBindVertexArrayAPPLE(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    stream_ring.fence();
+
+    StreamStats& s = stream_ring.stats;
+    if (s.frames == 60) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double wall_ms = std::chrono::duration<double, std::milli>(now - stream_stat_start).count();
+        std::cout << "流式上传 [" << stream_ring.modeName() << "]: 每帧 " << s.bytes / s.frames / 1024.0 << " KB, 带宽 "
+                  << s.bytes / (wall_ms * 1000.0) << " MB/s, 变形+写入 " << deform_ms_sum / s.frames
+                  << " ms/帧, 映射/上传调用 " << s.uploadMs / s.frames << " ms/帧, 等待栅栏 " << s.stallMs / s.frames
+                  << " ms/帧 (" << s.stalls << "/" << s.frames << " 帧需要等待)" << std::endl;
+        s.reset();
+        deform_ms_sum = 0.0;
+        stream_stat_start = now;
+    }
+}
+
+/**
+ * @brief 生成球体的非索引三角形 (每个顶点 6 个 float: 位置 + 法线)
+ * 网格点按纬线行、三角形按行在共用的任务调度器上并行生成; 每行的输出位置由行前缀和确定, 结果与逐行顺序生成相同
+ */
+std::vector<float> generate_sphere(float radius, int sectors, int stacks) {
+    TRACE_FUNCTION();
+    const float length_inv = 1.0f / radius;
+    const float PI = 3.14159265359f;
+    const float sector_step = 2 * PI / sectors;
+    const float stack_step = PI / stacks;
+    const int columns = sectors + 1;
+
+    std::vector<float> vertices((size_t)(stacks + 1) * columns * 6);
+    parallelFor((size_t)(stacks + 1), 0, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            float stack_angle = PI / 2 - (int)i * stack_step;
+            float xy = radius * cosf(stack_angle);
+            float z = radius * sinf(stack_angle);
+            float* v = &vertices[i * columns * 6];
+            for (int j = 0; j <= sectors; ++j, v += 6) {
+                float sector_angle = j * sector_step;
+                float x = xy * cosf(sector_angle);
+                float y = xy * sinf(sector_angle);
+                v[0] = x; v[1] = y; v[2] = z;
+                v[3] = x * length_inv; v[4] = y * length_inv; v[5] = z * length_inv;
             }
-            if(i != (stacks-1)) {
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[(k1+1)*6+k]);
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[k2*6+k]);
-                for(int k=0; k<6; ++k) sphere_data.push_back(vertices[(k2+1)*6+k]);
+        }
+    });
+
+    // 第 0 行每格只有下三角形, 最后一行只有上三角形, 其余每格两个
+    std::vector<size_t> row_start(stacks + 1, 0);
+    for (int i = 0; i < stacks; ++i)
+        row_start[i + 1] = row_start[i] + (size_t)sectors * ((i != 0) + (i != stacks - 1));
+    std::vector<float> sphere_data(row_start[stacks] * 3 * 6);
+    parallelFor((size_t)stacks, 0, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i) {
+            float* out = sphere_data.empty() ? 0 : &sphere_data[row_start[i] * 3 * 6];
+            int k1 = (int)i * columns;
+            int k2 = k1 + columns;
+            for (int j = 0; j < sectors; ++j, ++k1, ++k2) {
+                const int corners[2][3] = { { k1, k2, k1 + 1 }, { k1 + 1, k2, k2 + 1 } };
+                for (int t = 0; t < 2; ++t) {
+                    if ((t == 0 && i == 0) || (t == 1 && (int)i == stacks - 1)) continue;
+                    for (int c = 0; c < 3; ++c, out += 6)
+                        memcpy(out, &vertices[corners[t][c] * 6], 6 * sizeof(float));
+                }
             }
         }
-    }
+    });
     return sphere_data;
 }
\ No newline at end of file
@@ -0,0 +1,236 @@
+#ifndef STREAM_RING_H
+#define STREAM_RING_H
+
+// 每帧变化的顶点数据的流式上传 (变形、程序化几何体等)
+//
+//   void* p = ring.begin(bytes);   // 取得本帧可写的内存, 必要时等待 GPU 用完这一段
+//   ... 写入顶点 ...
+//   size_t offset = ring.end();    // 提交, 返回数据在缓冲中的字节偏移
+//   ... glVertexAttribPointer(..., offset) + 绘制 ...
+//   ring.fence();                  // 在使用这一段的绘制命令之后插入栅栏
+//
+// 两种模式:
+// - STREAM_RING:   一个缓冲分成 STREAM_RING_SEGMENTS 段轮流写入, 每段一个栅栏;
+//                  写第 N 帧时 GPU 还可以读第 N-1、N-2 帧的段, 只有 GPU 落后三帧时才需要等待
+// - STREAM_ORPHAN: 每帧 glBufferData(NULL) 丢弃旧存储再 glBufferSubData, 同步交给驱动;
+//                  不支持栅栏时自动使用
+//
+// 持久映射 (ARB_buffer_storage) 只在非 macOS 且驱动支持时使用;
+// macOS 的 GL 2.1 环境没有它, 改用 APPLE_flush_buffer_range 关闭映射时的隐式同步,
+// 每帧映射后只刷新本帧写入的区间, 由 APPLE_fence 保证不会覆盖 GPU 正在读的段
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+
+#include <GLUT/glut.h>
+#include <OpenGL/gl.h>
+
+const int STREAM_RING_SEGMENTS = 3;      // 三缓冲
+const size_t STREAM_RING_ALIGN = 256;    // 每段起始地址对齐
+
+enum StreamMode { STREAM_RING, STREAM_ORPHAN };
+
+// 统计 (由调用者定期输出并清零)
+struct StreamStats {
+    size_t bytes;        // 上传的字节数
+    int frames;
+    int stalls;          // 需要等待栅栏的帧数
+    double stallMs;      // 等待栅栏的时间
+    double uploadMs;     // 映射/解除映射或 glBufferData + glBufferSubData 的时间
+
+    StreamStats() { reset(); }
+    void reset() { bytes = 0; frames = 0; stalls = 0; stallMs = 0.0; uploadMs = 0.0; }
+};
+
+class StreamRing {
+public:
+    StreamRing() : buffer_(0), segmentBytes_(0), segment_(0), pending_(0), mode_(STREAM_ORPHAN),
+                   fencesSupported_(false), persistentSupported_(false), mapped_(0), persistent_(0) {
+        for (int i = 0; i < STREAM_RING_SEGMENTS; ++i) { fences_[i] = 0; fenceSet_[i] = false; }
+    }
+
+    /**
+     * @brief 创建缓冲; segmentBytes 为每帧最多写入的字节数. 必须在 GL 上下文创建之后调用, 可以重复调用以改变大小
+     */
+    void init(size_t segmentBytes) {
+        segmentBytes_ = (segmentBytes + STREAM_RING_ALIGN - 1) / STREAM_RING_ALIGN * STREAM_RING_ALIGN;
+        staging_.resize(segmentBytes_);
+#if defined(__APPLE__)
+        fencesSupported_ = glutExtensionSupported("GL_APPLE_fence") && glutExtensionSupported("GL_APPLE_flush_buffer_range");
+        if (fencesSupported_ && !fences_[0]) glGenFencesAPPLE(STREAM_RING_SEGMENTS, fences_);
+#else
+        fencesSupported_ = glutExtensionSupported("GL_ARB_sync") && glutExtensionSupported("GL_ARB_map_buffer_range");
+        persistentSupported_ = fencesSupported_ && glutExtensionSupported("GL_ARB_buffer_storage");
+#endif
+        if (!fencesSupported_) std::cerr << "警告: 不支持栅栏同步, 流式上传只能使用缓冲孤立 (orphaning)" << std::endl;
+        setMode(fencesSupported_ ? STREAM_RING : STREAM_ORPHAN);
+    }
+
+    /**
+     * @brief 切换模式并重新分配缓冲 (持久映射的存储不可变, 不能孤立)
+     */
+    void setMode(StreamMode mode) {
+        if (mode == STREAM_RING && !fencesSupported_) mode = STREAM_ORPHAN;
+        release();
+        mode_ = mode;
+        glGenBuffers(1, &buffer_);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        if (mode_ == STREAM_ORPHAN) {
+            glBufferData(GL_ARRAY_BUFFER, segmentBytes_, NULL, GL_STREAM_DRAW);
+        } else {
+            GLsizeiptr total = (GLsizeiptr)(segmentBytes_ * STREAM_RING_SEGMENTS);
+#if defined(__APPLE__)
+            glBufferData(GL_ARRAY_BUFFER, total, NULL, GL_STREAM_DRAW);
+            // 映射时不再等待 GPU, 解除映射时不再刷新整个缓冲; 两者都由栅栏和显式刷新代替
+            glBufferParameteriAPPLE(GL_ARRAY_BUFFER, GL_BUFFER_SERIALIZED_MODIFY_APPLE, GL_FALSE);
+            glBufferParameteriAPPLE(GL_ARRAY_BUFFER, GL_BUFFER_FLUSHING_UNMAP_APPLE, GL_FALSE);
+#else
+            if (persistentSupported_) {
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+                glBufferStorage(GL_ARRAY_BUFFER, total, NULL, flags);
+                persistent_ = (char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+                if (!persistent_) std::cerr << "警告: 持久映射失败, 改为每帧映射" << std::endl;
+            }
+            if (!persistent_) glBufferData(GL_ARRAY_BUFFER, total, NULL, GL_STREAM_DRAW);
+#endif
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        segment_ = 0;
+    }
+
+    StreamMode mode() const { return mode_; }
+    bool fencesSupported() const { return fencesSupported_; }
+    GLuint buffer() const { return buffer_; }
+
+    const char* modeName() const {
+        if (mode_ == STREAM_ORPHAN) return "缓冲孤立";
+        return persistent_ ? "三缓冲环 + 栅栏 (持久映射)" : "三缓冲环 + 栅栏";
+    }
+
+    /**
+     * @brief 取得本帧可写的内存 (只写, 按顺序写入最快); bytes 不能超过 init 时给出的大小
+     */
+    void* begin(size_t bytes) {
+        pending_ = bytes < segmentBytes_ ? bytes : segmentBytes_;
+        if (mode_ == STREAM_ORPHAN) return &staging_[0];
+
+        waitSegment(segment_);
+        size_t offset = segment_ * segmentBytes_;
+        if (persistent_) return persistent_ + offset;
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+#if defined(__APPLE__)
+        mapped_ = (char*)glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY) + offset;
+#else
+        mapped_ = (char*)glMapBufferRange(GL_ARRAY_BUFFER, offset, pending_,
+                                          GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+#endif
+        stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return mapped_;
+    }
+
+    /**
+     * @brief 提交本帧写入的数据, 返回它在缓冲中的字节偏移; 返回时 GL_ARRAY_BUFFER 绑定为本缓冲
+     */
+    size_t end() {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        size_t offset = 0;
+        glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+        if (mode_ == STREAM_ORPHAN) {
+            glBufferData(GL_ARRAY_BUFFER, segmentBytes_, NULL, GL_STREAM_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, pending_, &staging_[0]);
+        } else {
+            offset = segment_ * segmentBytes_;
+            if (!persistent_) {
+#if defined(__APPLE__)
+                glFlushMappedBufferRangeAPPLE(GL_ARRAY_BUFFER, offset, pending_);
+#endif
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+                mapped_ = 0;
+            }
+        }
+        stats.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        stats.bytes += pending_;
+        ++stats.frames;
+        return offset;
+    }
+
+    /**
+     * @brief 在使用本帧数据的绘制命令之后调用, 然后切换到下一段
+     */
+    void fence() {
+        if (mode_ == STREAM_ORPHAN) return;
+#if defined(__APPLE__)
+        glSetFenceAPPLE(fences_[segment_]);
+#else
+        if (fences_[segment_]) glDeleteSync(fences_[segment_]);
+        fences_[segment_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+#endif
+        fenceSet_[segment_] = true;
+        segment_ = (segment_ + 1) % STREAM_RING_SEGMENTS;
+    }
+
+    StreamStats stats;
+
+private:
+#if defined(__APPLE__)
+    typedef GLuint Fence;
+#else
+    typedef GLsync Fence;
+#endif
+
+    // 等待 GPU 读完这一段; 先不阻塞地查询一次, 只有确实未完成时才计入等待
+    void waitSegment(int segment) {
+        if (!fenceSet_[segment]) return;
+#if defined(__APPLE__)
+        if (!glTestFenceAPPLE(fences_[segment])) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            glFinishFenceAPPLE(fences_[segment]);
+            stats.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            ++stats.stalls;
+        }
+#else
+        GLenum state = glClientWaitSync(fences_[segment], 0, 0);
+        if (state == GL_TIMEOUT_EXPIRED) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            do {
+                state = glClientWaitSync(fences_[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            } while (state == GL_TIMEOUT_EXPIRED);
+            stats.stallMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            ++stats.stalls;
+        }
+        glDeleteSync(fences_[segment]);
+        fences_[segment] = 0;
+#endif
+        fenceSet_[segment] = false;
+    }
+
+    void release() {
+        if (!buffer_) return;
+        for (int i = 0; i < STREAM_RING_SEGMENTS; ++i) waitSegment(i);
+        if (persistent_) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer_);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            persistent_ = 0;
+        }
+        glDeleteBuffers(1, &buffer_);
+        buffer_ = 0;
+    }
+
+    GLuint buffer_;
+    size_t segmentBytes_;
+    int segment_;                 // 本帧写入的段
+    size_t pending_;              // 本帧写入的字节数
+    StreamMode mode_;
+    bool fencesSupported_, persistentSupported_;
+    char* mapped_;                // 每帧映射得到的地址
+    char* persistent_;            // 持久映射的起始地址
+    Fence fences_[STREAM_RING_SEGMENTS];
+    bool fenceSet_[STREAM_RING_SEGMENTS];
+    std::vector<char> staging_;   // 孤立模式下先写到这里
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef TILED_LIGHTS_H
+#define TILED_LIGHTS_H
+
+// 分块前向渲染 (tiled forward) 的 CPU 端灯光分块
+// 屏幕被划分为 TILE_SIZE x TILE_SIZE 的小块, 每帧把点光源 (球体) 分配到与之相交的块中
+//
+// 块视锥体的左右平面只与列有关, 上下平面只与行有关, 因此先对每一列、每一行
+// 用 SIMD 一次测试 4 个灯光, 得到灯光位掩码; 块的灯光集合就是所在列与所在行掩码的按位与
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "trace.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TILED_LIGHTS_SSE 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TILED_LIGHTS_NEON 1
+#endif
+
+const int TILE_SIZE = 16;               // 块大小 (像素)
+const int MAX_LIGHTS = 1024;            // 灯光数据纹理的宽度
+const int MAX_LIGHTS_PER_TILE = 128;    // 每块最多的灯光数, 必须是 4 的倍数, 与着色器一致
+const int INDEX_TEX_WIDTH = 1024;       // 灯光编号纹理每行的 texel 数 (每个 texel 存 4 个编号)
+
+struct PointLight {
+    glm::vec3 position;   // 世界坐标
+    float radius;         // 影响半径, 超出后衰减为 0
+    glm::vec3 color;
+};
+
+// --- 4 路 SIMD 的最小封装 ---
+#if defined(TILED_LIGHTS_SSE)
+typedef __m128 f4;
+inline f4 f4_load(const float* p) { return _mm_loadu_ps(p); }
+inline f4 f4_set1(float v) { return _mm_set1_ps(v); }
+inline f4 f4_add(f4 a, f4 b) { return _mm_add_ps(a, b); }
+inline f4 f4_mul(f4 a, f4 b) { return _mm_mul_ps(a, b); }
+inline int f4_ge_mask(f4 a, f4 b) { return _mm_movemask_ps(_mm_cmpge_ps(a, b)); }
+#elif defined(TILED_LIGHTS_NEON)
+typedef float32x4_t f4;
+inline f4 f4_load(const float* p) { return vld1q_f32(p); }
+inline f4 f4_set1(float v) { return vdupq_n_f32(v); }
+inline f4 f4_add(f4 a, f4 b) { return vaddq_f32(a, b); }
+inline f4 f4_mul(f4 a, f4 b) { return vmulq_f32(a, b); }
+inline int f4_ge_mask(f4 a, f4 b) {
+    uint32x4_t c = vcgeq_f32(a, b);
+    return (vgetq_lane_u32(c, 0) & 1) | (vgetq_lane_u32(c, 1) & 2) | (vgetq_lane_u32(c, 2) & 4) | (vgetq_lane_u32(c, 3) & 8);
+}
+#else
+struct f4 { float v[4]; };
+inline f4 f4_load(const float* p) { f4 r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+inline f4 f4_set1(float s) { f4 r; for (int i = 0; i < 4; ++i) r.v[i] = s; return r; }
+inline f4 f4_add(f4 a, f4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+inline f4 f4_mul(f4 a, f4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+inline int f4_ge_mask(f4 a, f4 b) { int m = 0; for (int i = 0; i < 4; ++i) m |= (a.v[i] >= b.v[i]) << i; return m; }
+#endif
+
+struct TiledLightGrid {
+    int tilesX, tilesY;
+    int words;                        // 每个位掩码占用的 64 位字数
+
+    // 视图空间中的灯光 (SoA, 补齐到 4 的倍数)
+    std::vector<float> lx, ly, lz, lr;
+
+    std::vector<uint64_t> colMask;    // tilesX * words
+    std::vector<uint64_t> rowMask;    // tilesY * words
+
+    // 上传给着色器的数据
+    std::vector<float> gridData;      // 每块 RGBA: (编号起始位置, 数量, 0, 0)
+    std::vector<float> indexData;     // 每 4 个 float 为一个 texel, 存 4 个灯光编号
+    int indexRows;                    // indexData 实际使用的行数
+
+    // 统计
+    size_t totalRefs;                 // 所有块的灯光引用总数
+    int maxInTile;                    // 单块中最多的灯光数
+    int overflowTiles;                // 超过 MAX_LIGHTS_PER_TILE 被截断的块数
+
+    TiledLightGrid() : tilesX(0), tilesY(0), words(0), indexRows(0), totalRefs(0), maxInTile(0), overflowTiles(0) {}
+};
+
+/**
+ * @brief 对一组平面 n = (a, 0, b) 或 (0, a, b) 做球体测试, 结果写入位掩码
+ * 平面经过原点, 球心 (u, z) 在内侧的条件为 a*u + b*z >= -r * |n|
+ */
+inline void binPlanePair(const std::vector<float>& coord, const std::vector<float>& z, const std::vector<float>& r,
+                         int lightCount, float scaleA, float edgeLo, float edgeHi, uint64_t* mask) {
+    // 下边界平面: scaleA * u + edgeLo * z >= 0; 上边界平面: -scaleA * u - edgeHi * z >= 0
+    float invLo = 1.0f / std::sqrt(scaleA * scaleA + edgeLo * edgeLo);
+    float invHi = 1.0f / std::sqrt(scaleA * scaleA + edgeHi * edgeHi);
+    f4 aLo = f4_set1(scaleA * invLo), bLo = f4_set1(edgeLo * invLo);
+    f4 aHi = f4_set1(-scaleA * invHi), bHi = f4_set1(-edgeHi * invHi);
+    f4 minusOne = f4_set1(-1.0f);
+    for (int i = 0; i < lightCount; i += 4) {
+        f4 u = f4_load(&coord[i]);
+        f4 zz = f4_load(&z[i]);
+        f4 negR = f4_mul(f4_load(&r[i]), minusOne);
+        int inLo = f4_ge_mask(f4_add(f4_mul(aLo, u), f4_mul(bLo, zz)), negR);
+        int inHi = f4_ge_mask(f4_add(f4_mul(aHi, u), f4_mul(bHi, zz)), negR);
+        mask[i >> 6] |= (uint64_t)(inLo & inHi) << (i & 63);
+    }
+}
+
+/**
+ * @brief 把灯光分配到屏幕块中
+ * view/projection 为当前帧的矩阵 (对称透视投影), width/height 为视口大小
+ */
+inline void binLights(TiledLightGrid& grid, const std::vector<PointLight>& lights,
+                      const glm::mat4& view, const glm::mat4& projection,
+                      int width, int height, float zNear, float zFar) {
+    TRACE_FUNCTION();
+    int n = (int)lights.size();
+    int padded = (n + 3) & ~3;
+    grid.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+    grid.tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+    grid.words = (padded + 63) / 64;
+
+    // --- 1. 灯光变换到视图空间 (SoA), 并剔除完全在近/远平面之外的灯光 ---
+    grid.lx.assign(padded, 0.0f);
+    grid.ly.assign(padded, 0.0f);
+    grid.lz.assign(padded, 1.0f);
+    grid.lr.assign(padded, -1.0f);  // 补齐的灯光半径为负, 永远不会通过测试
+    std::vector<uint64_t> depthMask(grid.words, 0);
+    for (int i = 0; i < n; ++i) {
+        glm::vec4 p = view * glm::vec4(lights[i].position, 1.0f);
+        grid.lx[i] = p.x; grid.ly[i] = p.y; grid.lz[i] = p.z;
+        grid.lr[i] = lights[i].radius;
+        float depth = -p.z;
+        if (depth + lights[i].radius >= zNear && depth - lights[i].radius <= zFar)
+            depthMask[i >> 6] |= (uint64_t)1 << (i & 63);
+    }
+
+    // --- 2. 列掩码 (左右平面) 与行掩码 (上下平面) ---
+    float p00 = projection[0][0], p11 = projection[1][1];
+    grid.colMask.assign(grid.tilesX * grid.words, 0);
+    grid.rowMask.assign(grid.tilesY * grid.words, 0);
+    for (int tx = 0; tx < grid.tilesX; ++tx) {
+        float x0 = 2.0f * tx * TILE_SIZE / width - 1.0f;
+        float x1 = 2.0f * std::min((tx + 1) * TILE_SIZE, width) / width - 1.0f;
+        uint64_t* mask = &grid.colMask[tx * grid.words];
+        binPlanePair(grid.lx, grid.lz, grid.lr, padded, p00, x0, x1, mask);
+        for (int w = 0; w < grid.words; ++w) mask[w] &= depthMask[w];
+    }
+    for (int ty = 0; ty < grid.tilesY; ++ty) {
+        float y0 = 2.0f * ty * TILE_SIZE / height - 1.0f;
+        float y1 = 2.0f * std::min((ty + 1) * TILE_SIZE, height) / height - 1.0f;
+        binPlanePair(grid.ly, grid.lz, grid.lr, padded, p11, y0, y1, &grid.rowMask[ty * grid.words]);
+    }
+
+    // --- 3. 块 = 列 & 行, 展开为编号列表 (每块起始位置按 4 对齐) ---
+    int tileCount = grid.tilesX * grid.tilesY;
+    grid.gridData.assign(tileCount * 4, 0.0f);
+    grid.indexData.resize((size_t)tileCount * MAX_LIGHTS_PER_TILE);
+    grid.totalRefs = 0;
+    grid.maxInTile = 0;
+    grid.overflowTiles = 0;
+    size_t cursor = 0;
+    for (int ty = 0; ty < grid.tilesY; ++ty) {
+        const uint64_t* row = &grid.rowMask[ty * grid.words];
+        for (int tx = 0; tx < grid.tilesX; ++tx) {
+            const uint64_t* col = &grid.colMask[tx * grid.words];
+            int count = 0, total = 0;
+            size_t start = cursor;
+            // 所有字都要统计 popcount: 上限恰好在字的边界用完时, 后面的字里可能还有灯光
+            for (int w = 0; w < grid.words; ++w) {
+                uint64_t bits = row[w] & col[w];
+                total += __builtin_popcountll(bits);
+                while (bits && count < MAX_LIGHTS_PER_TILE) {
+                    int bit = __builtin_ctzll(bits);
+                    bits &= bits - 1;
+                    grid.indexData[cursor++] = (float)(w * 64 + bit);
+                    ++count;
+                }
+            }
+            if (total > MAX_LIGHTS_PER_TILE) ++grid.overflowTiles;
+            // 补齐到 4 的倍数, 保证下一块从新的 texel 开始
+            while (cursor & 3) grid.indexData[cursor++] = 0.0f;
+
+            float* cell = &grid.gridData[(ty * grid.tilesX + tx) * 4];
+            cell[0] = (float)start;
+            cell[1] = (float)count;
+            grid.totalRefs += count;
+            if (count > grid.maxInTile) grid.maxInTile = count;
+        }
+    }
+    size_t texels = cursor / 4;
+    grid.indexRows = (int)((texels + INDEX_TEX_WIDTH - 1) / INDEX_TEX_WIDTH);
+    if (grid.indexData.size() < (size_t)grid.indexRows * INDEX_TEX_WIDTH * 4)
+        grid.indexData.resize((size_t)grid.indexRows * INDEX_TEX_WIDTH * 4, 0.0f);
+}
+
+#endif
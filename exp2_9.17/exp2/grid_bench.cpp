@@ -0,0 +1,100 @@
+// 油漆桶填充与连通分量标记的基准测试 (不需要窗口)
+//
+//   ./grid_bench              网格边长 20, 64, 256, 1024, 4096, 16384
+//   ./grid_bench 4096         只测到边长 4096
+//   ./grid_bench 4096 0.4     并指定前景格子的比例 (默认 0.35)
+//
+// 随机网格中前景格子 (值 1) 形成大量小分量, 背景 (值 0) 连成一片:
+// - 标记: 分别用 1 个线程和全部硬件线程运行, 边长不超过 2048 时与逐分量扫描线填充的结果逐格比较
+// - 填充: 从网格中心开始对背景区域做油漆桶填充
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+
+#include "grid_ccl.h"
+#include "trace.h"
+
+void makeRandomGrid(CellGrid& grid, int size, float density) {
+    TRACE_FUNCTION();
+    grid.resize(size, size);
+    unsigned threshold = (unsigned)(density * 16777216.0f);
+    parallelFor((size_t)size, 0, [&](size_t begin, size_t end, int) {
+        for (size_t y = begin; y < end; ++y) {
+            unsigned seed = 12345u + (unsigned)y * 2654435761u;   // 每行独立的种子, 结果与线程数无关
+            for (int x = 0; x < size; ++x) {
+                seed = seed * 1664525u + 1013904223u;
+                grid.cells[y * size + x] = (seed >> 8) < threshold ? 1 : 0;
+            }
+        }
+    });
+}
+
+void printCcl(const char* name, const CclResult& r, size_t cells) {
+    std::cout << "  " << name << ": " << r.components << " 个分量, 总计 " << r.totalMs << " ms [块内 " << r.localMs
+              << ", 边界合并 " << r.mergeMs << ", 重新编号 " << r.relabelMs << "], " << cells / (r.totalMs * 1000.0)
+              << " M 格/秒" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    TRACE_INIT("grid_bench_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
+    int maxSize = argc >= 2 ? atoi(argv[1]) : 16384;
+    float density = argc >= 3 ? (float)atof(argv[2]) : 0.35f;
+    if (maxSize <= 0 || density < 0.0f || density > 1.0f) {
+        std::cerr << "错误: 用法 grid_bench [最大边长] [前景比例 0~1]" << std::endl;
+        return 1;
+    }
+    int hw = hardwareThreads();
+    const int sizes[] = { 20, 64, 256, 1024, 4096, 16384 };
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) && sizes[s] <= maxSize; ++s) {
+        int size = sizes[s];
+        size_t cells = (size_t)size * size;
+        CellGrid grid;
+        makeRandomGrid(grid, size, density);
+        std::cout << "网格 " << size << " x " << size << " (" << cells << " 格, 前景 " << density * 100 << "%)" << std::endl;
+
+        std::vector<unsigned> labels, labelsMT;
+        CclResult single = labelComponents(grid, labels, 1);
+        printCcl("标记 1 线程", single, cells);
+        if (hw > 1) {
+            CclResult multi = labelComponents(grid, labelsMT, hw);
+            std::string name = "标记 " + std::to_string(hw) + " 线程";
+            printCcl(name.c_str(), multi, cells);
+            if (labelsMT != labels) { std::cerr << "错误: 多线程标记结果与单线程不同" << std::endl; return 1; }
+            std::cout << "  加速比 " << single.totalMs / multi.totalMs << std::endl;
+        }
+        // 与硬件线程数无关: 行数不能被线程数整除时 (会出现空块) 结果也必须与单线程相同
+        if (size <= 2048) {
+            const int oddThreads[] = { 3, 7, 8 };
+            for (size_t t = 0; t < sizeof(oddThreads) / sizeof(oddThreads[0]); ++t) {
+                labelComponents(grid, labelsMT, oddThreads[t]);
+                if (labelsMT != labels) {
+                    std::cerr << "错误: " << oddThreads[t] << " 线程标记结果与单线程不同" << std::endl;
+                    return 1;
+                }
+            }
+            std::cout << "  3 / 7 / 8 线程标记: 结果一致" << std::endl;
+        }
+        if (size <= 2048) {
+            std::vector<unsigned> reference;
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            size_t count = labelComponentsFlood(grid, reference);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (count != single.components || reference != labels) {
+                std::cerr << "错误: 与扫描线填充的参考结果不同" << std::endl;
+                return 1;
+            }
+            std::cout << "  逐分量扫描线填充: " << count << " 个分量, " << ms << " ms, 结果一致" << std::endl;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        size_t filled = floodFill(grid, size / 2, size / 2, 2);
+        double fillMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "  油漆桶 (中心): 填充 " << filled << " 格, " << fillMs << " ms";
+        if (fillMs > 0.0) std::cout << ", " << filled / (fillMs * 1000.0) << " M 格/秒";
+        std::cout << std::endl;
+    }
+    return 0;
+}
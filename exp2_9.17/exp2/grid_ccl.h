@@ -0,0 +1,240 @@
+#ifndef GRID_CCL_H
+#define GRID_CCL_H
+
+// 格子数组上的油漆桶填充与连通分量标记 (4 连通, 值相同的相邻格子属于同一分量)
+// - 扫描线填充: 栈中存放种子点, 每次向左右延伸填满一整段, 再在上下两行为每一段连续的目标格子压入一个种子
+// - 并行标记: 按行分块, 每个线程先在自己的块内用并查集合并左邻和上邻 (块之间没有共享数据);
+//   然后并行合并相邻块边界上的两行 (无锁并查集); 最后按块计数根节点, 前缀和后给根分配连续编号
+//   并查集总是把较大的根挂到较小的根下, 根就是分量中按行优先顺序的第一个格子,
+//   因此分量编号与线程数无关, 与逐个分量做扫描线填充得到的编号完全相同
+// 值为 0 的格子是背景, 标记为 0; 分量编号从 1 开始
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "parallel_for.h"
+#include "trace.h"
+
+struct CellGrid {
+    int width, height;
+    std::vector<uint8_t> cells;   // 行优先, 第 0 行在最下方
+
+    CellGrid() : width(0), height(0) {}
+    void resize(int w, int h) { width = w; height = h; cells.assign((size_t)w * h, 0); }
+    uint8_t& at(int x, int y) { return cells[(size_t)y * width + x]; }
+    uint8_t at(int x, int y) const { return cells[(size_t)y * width + x]; }
+};
+
+struct CclResult {
+    size_t components;
+    double localMs, mergeMs, relabelMs, totalMs;
+};
+
+/**
+ * @brief 通用扫描线填充
+ * inside(x, y): 格子是否需要填充 (填充后必须变为 false)
+ * paint(y, x0, x1): 填充第 y 行的 [x0, x1]
+ * 返回填充的格子数
+ */
+template <typename Inside, typename Paint>
+size_t scanlineFill(int width, int height, int x, int y, Inside inside, Paint paint) {
+    if (x < 0 || x >= width || y < 0 || y >= height || !inside(x, y)) return 0;
+    size_t filled = 0;
+    std::vector<int> stack;
+    stack.push_back(x);
+    stack.push_back(y);
+    while (!stack.empty()) {
+        int sy = stack.back(); stack.pop_back();
+        int sx = stack.back(); stack.pop_back();
+        if (!inside(sx, sy)) continue;   // 同一段可能被压入多次
+        int x0 = sx, x1 = sx;
+        while (x0 > 0 && inside(x0 - 1, sy)) --x0;
+        while (x1 < width - 1 && inside(x1 + 1, sy)) ++x1;
+        paint(sy, x0, x1);
+        filled += x1 - x0 + 1;
+        for (int ny = sy - 1; ny <= sy + 1; ny += 2) {
+            if (ny < 0 || ny >= height) continue;
+            bool inRun = false;
+            for (int nx = x0; nx <= x1; ++nx) {
+                bool in = inside(nx, ny);
+                if (in && !inRun) { stack.push_back(nx); stack.push_back(ny); }
+                inRun = in;
+            }
+        }
+    }
+    return filled;
+}
+
+/**
+ * @brief 油漆桶: 把 (x, y) 所在的同值区域改为 value, 返回改变的格子数
+ */
+inline size_t floodFill(CellGrid& grid, int x, int y, uint8_t value) {
+    TRACE_FUNCTION();
+    if (x < 0 || x >= grid.width || y < 0 || y >= grid.height) return 0;
+    uint8_t target = grid.at(x, y);
+    if (target == value) return 0;
+    return scanlineFill(grid.width, grid.height, x, y,
+                        [&](int cx, int cy) { return grid.at(cx, cy) == target; },
+                        [&](int cy, int x0, int x1) { for (int cx = x0; cx <= x1; ++cx) grid.at(cx, cy) = value; });
+}
+
+/**
+ * @brief 参考实现: 按行优先顺序对每个未标记的格子做一次扫描线填充 (单线程, 用于校验)
+ */
+inline size_t labelComponentsFlood(const CellGrid& grid, std::vector<unsigned>& labels) {
+    TRACE_FUNCTION();
+    labels.assign(grid.cells.size(), 0);
+    unsigned next = 0;
+    for (int y = 0; y < grid.height; ++y) {
+        for (int x = 0; x < grid.width; ++x) {
+            size_t i = (size_t)y * grid.width + x;
+            uint8_t v = grid.cells[i];
+            if (v == 0 || labels[i] != 0) continue;
+            unsigned id = ++next;
+            scanlineFill(grid.width, grid.height, x, y,
+                         [&](int cx, int cy) {
+                             size_t c = (size_t)cy * grid.width + cx;
+                             return grid.cells[c] == v && labels[c] == 0;
+                         },
+                         [&](int cy, int x0, int x1) {
+                             for (int cx = x0; cx <= x1; ++cx) labels[(size_t)cy * grid.width + cx] = id;
+                         });
+        }
+    }
+    return next;
+}
+
+// --- 无锁并查集 (较大的根挂到较小的根下) ---
+inline unsigned cclFind(std::atomic<unsigned>* parent, unsigned v) {
+    unsigned p = parent[v].load(std::memory_order_relaxed);
+    while (p != v) {
+        unsigned gp = parent[p].load(std::memory_order_relaxed);
+        if (gp != p) parent[v].compare_exchange_weak(p, gp, std::memory_order_relaxed); // 路径减半
+        v = p;
+        p = parent[v].load(std::memory_order_relaxed);
+    }
+    return v;
+}
+
+inline void cclUnion(std::atomic<unsigned>* parent, unsigned a, unsigned b) {
+    for (;;) {
+        a = cclFind(parent, a);
+        b = cclFind(parent, b);
+        if (a == b) return;
+        if (a < b) std::swap(a, b);
+        unsigned expected = a;
+        if (parent[a].compare_exchange_strong(expected, b, std::memory_order_relaxed)) return;
+    }
+}
+
+/**
+ * @brief 并行连通分量标记; labels 输出每个格子的分量编号, threads <= 0 表示全部硬件线程
+ */
+inline CclResult labelComponents(const CellGrid& grid, std::vector<unsigned>& labels, int threads) {
+    TRACE_FUNCTION();
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point t0 = Clock::now();
+    CclResult result = { 0, 0.0, 0.0, 0.0, 0.0 };
+    const int w = grid.width, h = grid.height;
+    const size_t n = grid.cells.size();
+    labels.resize(n);   // 第 3 步会写入每个格子
+    if (n == 0) return result;
+    if (threads <= 0) threads = hardwareThreads();
+    if (threads > h) threads = h;
+    const uint8_t* cells = &grid.cells[0];
+
+    // --- 1. 块内合并: 每个线程处理连续的若干行, 只访问自己的格子 ---
+    std::vector<std::atomic<unsigned> > parent(n);
+    parallelFor((size_t)h, threads, [&](size_t rowBegin, size_t rowEnd, int) {
+        for (size_t y = rowBegin; y < rowEnd; ++y) {
+            for (int x = 0; x < w; ++x) {
+                size_t i = y * w + x;
+                parent[i].store((unsigned)i, std::memory_order_relaxed);
+                uint8_t v = cells[i];
+                if (v == 0) continue;
+                bool up = y > rowBegin && cells[i - w] == v;
+                bool left = x > 0 && cells[i - 1] == v;
+                if (left) {
+                    // 左邻刚处理过, 它的父节点就是 (当时的) 根; 左上角也相同时上邻与左邻已经连通, 不必再合并
+                    parent[i].store(parent[i - 1].load(std::memory_order_relaxed), std::memory_order_relaxed);
+                    if (up && cells[i - w - 1] != v) cclUnion(&parent[0], (unsigned)i, (unsigned)(i - w));
+                } else if (up) {
+                    parent[i].store(cclFind(&parent[0], (unsigned)(i - w)), std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    Clock::time_point t1 = Clock::now();
+
+    // --- 2. 合并块边界: 每个块的第一行与上一块的最后一行 (与第 1 步相同的分块) ---
+    // 行数不能被线程数整除时, 最后几块可能为空 (rowBegin == h), 必须跳过
+    parallelFor((size_t)h, threads, [&](size_t rowBegin, size_t rowEnd, int) {
+        if (rowBegin == 0 || rowBegin >= rowEnd) return;
+        size_t row = rowBegin * w;
+        for (int x = 0; x < w; ++x) {
+            size_t i = row + x;
+            uint8_t v = cells[i];
+            if (v != 0 && cells[i - w] == v) cclUnion(&parent[0], (unsigned)i, (unsigned)(i - w));
+        }
+    });
+    Clock::time_point t2 = Clock::now();
+
+    // --- 3. 重新编号: 各块统计根的个数, 前缀和得到起始编号; 根先取得编号, 其余格子再查询所在的根 ---
+    std::vector<size_t> blockRoots(threads + 1, 0);
+    size_t chunk = (n + threads - 1) / threads;
+    parallelFor((size_t)threads, threads, [&](size_t begin, size_t end, int) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t lo = std::min(n, b * chunk), hi = std::min(n, lo + chunk), roots = 0;
+            for (size_t i = lo; i < hi; ++i)   // 随机网格上分支几乎无法预测, 用无分支的写法
+                roots += (cells[i] != 0) & (parent[i].load(std::memory_order_relaxed) == i);
+            blockRoots[b + 1] = roots;
+        }
+    });
+    for (int b = 0; b < threads; ++b) blockRoots[b + 1] += blockRoots[b];
+    parallelFor((size_t)threads, threads, [&](size_t begin, size_t end, int) {
+        for (size_t b = begin; b < end; ++b) {
+            size_t lo = std::min(n, b * chunk), hi = std::min(n, lo + chunk);
+            unsigned next = (unsigned)blockRoots[b];
+            for (size_t i = lo; i < hi; ++i) {
+                unsigned root = (cells[i] != 0) & (parent[i].load(std::memory_order_relaxed) == i);
+                next += root;
+                labels[i] = root ? next : 0;
+            }
+        }
+    });
+    parallelFor(n, threads, [&](size_t begin, size_t end, int) {
+        for (size_t i = begin; i < end; ++i)
+            if (cells[i] != 0) {
+                // 并查集已经不再变化, 只读查找即可, 不必压缩路径
+                unsigned r = (unsigned)i, p;
+                while ((p = parent[r].load(std::memory_order_relaxed)) != r) r = p;
+                labels[i] = labels[r];
+            }
+    });
+    Clock::time_point t3 = Clock::now();
+
+    result.components = blockRoots[threads];
+    result.localMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    result.mergeMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    result.relabelMs = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    result.totalMs = std::chrono::duration<double, std::milli>(t3 - t0).count();
+    return result;
+}
+
+/**
+ * @brief 分量编号 -> 颜色 (整数哈希, 颜色分量在 [64, 255] 之间, 避免与白色背景混淆)
+ */
+inline void componentColor(unsigned label, uint8_t* rgb) {
+    unsigned h = label * 2654435761u;
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    rgb[0] = (uint8_t)(64 + (h & 0xff) * 160 / 255);
+    rgb[1] = (uint8_t)(64 + ((h >> 8) & 0xff) * 160 / 255);
+    rgb[2] = (uint8_t)(64 + ((h >> 16) & 0xff) * 160 / 255);
+}
+
+#endif
@@ -1,28 +1,87 @@
 #include <iostream>
 #include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <OpenGL/gl.h>
 #include <GLUT/glut.h>
 #include <glm/glm.hpp>
 
-// --- 网格配置 ---
+#include "grid_ccl.h"
+#include "sparse_canvas.h"
+#include "trace.h"
+
+// --- 视图配置 ---
+// 画布没有边界 (见 sparse_canvas.h); 视图由窗口左下角对应的格子坐标和每格的像素数决定
+// 滚轮以鼠标位置为中心缩放, 右键 (或中键) 拖动平移; 初始时 20 x 20 格铺满窗口
 int windowWidth = 800;
 int windowHeight = 800;
-const int NUM_COLS = 20; // 20列
-const int NUM_ROWS = 20; // 20行
+glm::dvec2 viewOrigin(0.0, 0.0);        // 窗口左下角的格子坐标 (double: 平移到很远处也不丢精度)
+double cellPixels = 40.0;               // 每格的像素数
+const double MIN_CELL_PIXELS = 0.25;
+const double MAX_CELL_PIXELS = 200.0;
+const int MAX_VISIBLE_CELLS = 4096;     // 每个方向最多可见的格子数 (连通分量纹理的边长上限)
+const double WHEEL_ZOOM = 1.25;         // 滚轮一格的缩放倍数
 const float LINE_WIDTH = 2.0f; // 线条粗细
+const float MIN_LINE_SPACING = 4.0f; // 格子小于这个像素数时不再画网格线
 
 // --- 状态管理 ---
-// 使用 glm::ivec2 存储选中的格子坐标 (列, 行)
-// 初始化为 (-1, -1) 表示没有格子被选中
-glm::ivec2 selectedCell(-1, -1);
+// 使用 glm::ivec2 存储选中的格子坐标 (列, 行); 画布坐标可以是负数, 是否有选中的格子单独记录
+glm::ivec2 selectedCell(0, 0);
+bool hasSelection = false;
+
+// --- 格子数据与工具 ---
+// 格子值: 0 白色 (背景), 1 黑色 (画笔), 2 以上为油漆桶的颜色
+// '1' 选择, '2' 画笔 (拖动连续绘制), '3' 油漆桶; 'l' 显示连通分量, 'r' 随机填充, 'c' 清空
+// 油漆桶、连通分量和随机填充只作用于可见区域 (画布无限大, 背景区域没有边界)
+enum Tool { TOOL_SELECT, TOOL_PAINT, TOOL_FILL };
+const char* TOOL_NAMES[] = { "选择", "画笔", "油漆桶" };
+const unsigned char PALETTE[][3] = {
+    { 255, 255, 255 }, { 0, 0, 0 }, { 230, 80, 70 }, { 70, 160, 230 }, { 90, 190, 90 },
+    { 240, 190, 60 }, { 160, 100, 210 }, { 60, 200, 190 }, { 240, 130, 180 },
+};
+const int PALETTE_SIZE = sizeof(PALETTE) / sizeof(PALETTE[0]);
+
+Tool tool = TOOL_SELECT;
+SparseCanvas canvas;
+uint8_t paintValue = 1;             // 画笔本次拖动写入的值 (按下时根据所点格子决定画还是擦)
+uint8_t fillValue = 2;              // 油漆桶的下一种颜色
+bool showComponents = false;        // 按连通分量着色 (只标记可见区域)
+bool isPanning = false;
+int lastMouseX, lastMouseY;
+
+// 每个已分配的块一张 64 x 64 的纹理, 块内容改变 (dirty) 后在下一次可见时重新上传
+std::unordered_map<uint64_t, GLuint> chunkTextures;
+std::vector<unsigned char> texels;
+
+// 连通分量模式: 可见区域复制到 regionGrid 后标记, 整个区域一张纹理
+CellGrid regionGrid;
+int regionX = 0, regionY = 0;       // regionGrid 的 (0, 0) 对应的画布坐标
+std::vector<unsigned> labels;
+bool labelsDirty = true;
+GLuint regionTexture = 0;
+int textureCols = 0, textureRows = 0;
 
 // --- 函数声明 ---
 void display();
 void reshape(int w, int h);
 void mouse(int button, int state, int x, int y);
+void motion(int x, int y);
+void keyboard(unsigned char key, int x, int y);
+void visibleCells(int& x0, int& y0, int& x1, int& y1);
+void zoomAt(int x, int y, double factor);
+void randomizeVisible(float density);
+void drawChunks(int x0, int y0, int x1, int y1);
+void updateRegionTexture(int x0, int y0, int x1, int y1);
+void releaseStaleTextures();
+void printCanvasStats();
+bool cellAt(int x, int y, int& col, int& row);
+void cellsChanged();
 
 int main(int argc, char** argv)
 {
+    TRACE_INIT("pixel_grid_trace.json"); // make TRACE=1 时记录时间线, 退出时写出
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGBA);
     glutInitWindowSize(windowWidth, windowHeight);
@@ -31,13 +90,27 @@ int main(int argc, char** argv)
     glutDisplayFunc(display);
     glutReshapeFunc(reshape);
     glutMouseFunc(mouse);
+    glutMotionFunc(motion);
+    glutKeyboardFunc(keyboard);
+
+    // 连通分量模式下可见区域的颜色存放在一张每格一个 texel 的纹理中, 只需画一个四边形
+    glGenTextures(1, &regionTexture);
+    glBindTexture(GL_TEXTURE_2D, regionTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
+    std::cout << "工具: '1' 选择, '2' 画笔, '3' 油漆桶; 'l' 连通分量着色, 'r' 随机填充可见区域, 'c' 清空" << std::endl;
+    std::cout << "视图: 滚轮或 '+'/'-' 缩放, 右键拖动平移, 'h' 回到原点" << std::endl;
     glutMainLoop();
     return 0;
 }
 
 void reshape(int w, int h)
 {
+    TRACE_FUNCTION();
     // 当窗口大小改变时，更新全局变量
     windowWidth = w;
     windowHeight = h;
@@ -53,90 +126,408 @@ void reshape(int w, int h)
 
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
+    zoomAt(w / 2, h / 2, 1.0);   // 窗口变大后保证可见格子数不超过上限
+    labelsDirty = true;
+}
+
+/**
+ * @brief 可见的格子范围 [x0, x1) x [y0, y1)
+ */
+void visibleCells(int& x0, int& y0, int& x1, int& y1)
+{
+    x0 = (int)std::floor(viewOrigin.x);
+    y0 = (int)std::floor(viewOrigin.y);
+    x1 = (int)std::ceil(viewOrigin.x + windowWidth / cellPixels);
+    y1 = (int)std::ceil(viewOrigin.y + windowHeight / cellPixels);
 }
 
 void display()
 {
+    TRACE_FUNCTION();
     // --- 1. 清屏 ---
-    // 使用一个浅灰色作为背景，以和白色格子区分
-    glClearColor(0.8f, 0.8f, 0.8f, 1.0f);
+    // 没有分配的块都是背景 (白色), 直接用背景色清屏
+    glClearColor(PALETTE[0][0] / 255.0f, PALETTE[0][1] / 255.0f, PALETTE[0][2] / 255.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    // 计算每个格子的宽高
-    float cellWidth = (float)windowWidth / NUM_COLS;
-    float cellHeight = (float)windowHeight / NUM_ROWS;
+    int x0, y0, x1, y1;
+    visibleCells(x0, y0, x1, y1);
+    float cell = (float)cellPixels;
 
-    // --- 2. 绘制所有格子的白色背景 ---
-    glColor3f(1.0f, 1.0f, 1.0f); // 设置颜色为白色
-    glRectf(0.0f, 0.0f, windowWidth, windowHeight); // 画一个覆盖全屏的矩形
+    // --- 2. 绘制格子: 只枚举与窗口相交的块 ---
+    if (showComponents) updateRegionTexture(x0, y0, x1, y1);
+    else drawChunks(x0, y0, x1, y1);
 
     // --- 3. 绘制被选中的红色格子 ---
-    // 检查 selectedCell 的坐标是否有效
-    if (selectedCell.x >= 0 && selectedCell.y >= 0)
+    if (tool == TOOL_SELECT && hasSelection)
     {
         // 计算红色格子的左下角坐标
-        float x_start = selectedCell.x * cellWidth;
-        float y_start = selectedCell.y * cellHeight;
-        
+        float x_start = (float)((selectedCell.x - viewOrigin.x) * cellPixels);
+        float y_start = (float)((selectedCell.y - viewOrigin.y) * cellPixels);
+
         glColor3f(1.0f, 0.0f, 0.0f); // 设置颜色为红色
-        glRectf(x_start, y_start, x_start + cellWidth, y_start + cellHeight);
+        glRectf(x_start, y_start, x_start + cell, y_start + cell);
     }
 
-    // --- 4. 绘制网格线 ---
-    glColor3f(0.0f, 0.0f, 0.0f); // 设置颜色为黑色
-    glLineWidth(LINE_WIDTH);     // 设置线宽
-
-    glBegin(GL_LINES);
-    // 绘制所有竖直线
-    for (int i = 0; i <= NUM_COLS; ++i)
+    // --- 4. 绘制网格线 (格子太小时省略), 只画可见范围内的 ---
+    if (cell >= MIN_LINE_SPACING)
     {
-        float x = i * cellWidth;
-        glVertex2f(x, 0);
-        glVertex2f(x, windowHeight);
+        glColor3f(0.0f, 0.0f, 0.0f); // 设置颜色为黑色
+        glLineWidth(cell >= 4.0f * LINE_WIDTH ? LINE_WIDTH : 1.0f); // 设置线宽
+
+        glBegin(GL_LINES);
+        // 绘制所有竖直线
+        for (int i = x0; i <= x1; ++i)
+        {
+            float x = (float)((i - viewOrigin.x) * cellPixels);
+            glVertex2f(x, 0);
+            glVertex2f(x, windowHeight);
+        }
+        // 绘制所有水平线
+        for (int i = y0; i <= y1; ++i)
+        {
+            float y = (float)((i - viewOrigin.y) * cellPixels);
+            glVertex2f(0, y);
+            glVertex2f(windowWidth, y);
+        }
+        glEnd();
     }
-    // 绘制所有水平线
-    for (int i = 0; i <= NUM_ROWS; ++i)
+
+    // --- 5. 交换缓冲区 ---
+    glutSwapBuffers();
+    releaseStaleTextures();
+}
+
+/**
+ * @brief 每个可见的已分配块画一个贴了块纹理的四边形; 内容改变过的块先重新上传
+ */
+void drawChunks(int x0, int y0, int x1, int y1)
+{
+    TRACE_FUNCTION();
+    texels.resize(CANVAS_CHUNK_SIZE * CANVAS_CHUNK_SIZE * 3);
+    glEnable(GL_TEXTURE_2D);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    canvas.forEachChunkIn(x0, y0, x1, y1, [&](CanvasChunk& c)
     {
-        float y = i * cellHeight;
-        glVertex2f(0, y);
-        glVertex2f(windowWidth, y);
+        uint64_t key = SparseCanvas::chunkKey(c.cx, c.cy);
+        GLuint& texture = chunkTextures[key];
+        bool created = texture == 0;
+        if (created)
+        {
+            glGenTextures(1, &texture);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+        }
+        if (created || c.dirty)
+        {
+            for (int i = 0; i < CANVAS_CHUNK_SIZE * CANVAS_CHUNK_SIZE; ++i)
+            {
+                uint8_t v = c.cells[i];
+                const unsigned char* rgb = PALETTE[v < PALETTE_SIZE ? v : 1];
+                texels[i * 3] = rgb[0]; texels[i * 3 + 1] = rgb[1]; texels[i * 3 + 2] = rgb[2];
+            }
+            if (created)
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, CANVAS_CHUNK_SIZE, CANVAS_CHUNK_SIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, &texels[0]);
+            else
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, CANVAS_CHUNK_SIZE, CANVAS_CHUNK_SIZE, GL_RGB, GL_UNSIGNED_BYTE, &texels[0]);
+            c.dirty = false;
+        }
+
+        float sx = (float)((c.cx * CANVAS_CHUNK_SIZE - viewOrigin.x) * cellPixels);
+        float sy = (float)((c.cy * CANVAS_CHUNK_SIZE - viewOrigin.y) * cellPixels);
+        float size = (float)(CANVAS_CHUNK_SIZE * cellPixels);
+        glBegin(GL_QUADS);
+        glTexCoord2f(0.0f, 0.0f); glVertex2f(sx, sy);
+        glTexCoord2f(1.0f, 0.0f); glVertex2f(sx + size, sy);
+        glTexCoord2f(1.0f, 1.0f); glVertex2f(sx + size, sy + size);
+        glTexCoord2f(0.0f, 1.0f); glVertex2f(sx, sy + size);
+        glEnd();
+    });
+    glDisable(GL_TEXTURE_2D);
+}
+
+/**
+ * @brief 连通分量模式: 标记可见区域 (需要时), 写入区域纹理并画出
+ */
+void updateRegionTexture(int x0, int y0, int x1, int y1)
+{
+    TRACE_FUNCTION();
+    int cols = x1 - x0, rows = y1 - y0;
+    if (labelsDirty || x0 != regionX || y0 != regionY || cols != regionGrid.width || rows != regionGrid.height)
+    {
+        regionX = x0;
+        regionY = y0;
+        canvas.copyRegion(x0, y0, cols, rows, regionGrid);
+        CclResult r = labelComponents(regionGrid, labels, 0);
+        std::cout << "连通分量 (可见的 " << cols << " x " << rows << " 格): " << r.components << " 个, " << r.totalMs
+                  << " ms (" << hardwareThreads() << " 线程)" << std::endl;
+        labelsDirty = false;
+
+        size_t count = regionGrid.cells.size();
+        texels.resize(count * 3);
+        for (size_t i = 0; i < count; ++i)
+        {
+            unsigned char* rgb = &texels[i * 3];
+            uint8_t v = regionGrid.cells[i];
+            if (v != 0) componentColor(labels[i], rgb);
+            else
+            {
+                const unsigned char* c = PALETTE[0];
+                rgb[0] = c[0]; rgb[1] = c[1]; rgb[2] = c[2];
+            }
+        }
+        glBindTexture(GL_TEXTURE_2D, regionTexture);
+        if (textureCols != cols || textureRows != rows)
+        {
+            textureCols = cols;
+            textureRows = rows;
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, cols, rows, 0, GL_RGB, GL_UNSIGNED_BYTE, &texels[0]);
+        }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, cols, rows, GL_RGB, GL_UNSIGNED_BYTE, &texels[0]);
+        }
     }
+
+    float sx = (float)((x0 - viewOrigin.x) * cellPixels), sy = (float)((y0 - viewOrigin.y) * cellPixels);
+    float ex = (float)((x1 - viewOrigin.x) * cellPixels), ey = (float)((y1 - viewOrigin.y) * cellPixels);
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, regionTexture);
+    glColor3f(1.0f, 1.0f, 1.0f);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f); glVertex2f(sx, sy);
+    glTexCoord2f(1.0f, 0.0f); glVertex2f(ex, sy);
+    glTexCoord2f(1.0f, 1.0f); glVertex2f(ex, ey);
+    glTexCoord2f(0.0f, 1.0f); glVertex2f(sx, ey);
     glEnd();
+    glDisable(GL_TEXTURE_2D);
+}
 
-    // --- 5. 交换缓冲区 ---
-    glutSwapBuffers();
+/**
+ * @brief 删除已经被释放的块 (擦成全白或清空) 的纹理
+ */
+void releaseStaleTextures()
+{
+    if (chunkTextures.size() <= canvas.chunkCount() + 64) return;
+    for (std::unordered_map<uint64_t, GLuint>::iterator it = chunkTextures.begin(); it != chunkTextures.end();)
+    {
+        if (!canvas.findChunk((int)(it->first >> 32), (int)(uint32_t)it->first))
+        {
+            glDeleteTextures(1, &it->second);
+            it = chunkTextures.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void printCanvasStats()
+{
+    int x0, y0, x1, y1;
+    visibleCells(x0, y0, x1, y1);
+    size_t visible = 0;
+    size_t enumerated = canvas.forEachChunkIn(x0, y0, x1, y1, [&](CanvasChunk&) { ++visible; });
+    std::cout << "画布: 每格 " << cellPixels << " 像素, 可见 " << x1 - x0 << " x " << y1 - y0 << " 格 (从 (" << x0 << ", " << y0
+              << ") 开始), 可见块 " << visible << " / " << enumerated << "; 已分配 " << canvas.chunkCount() << " 块, "
+              << canvas.memoryBytes() / 1024.0 << " KB" << std::endl;
+}
+
+/**
+ * @brief 窗口坐标 -> 格子坐标 (画布没有边界, 只要在窗口内就返回 true)
+ */
+bool cellAt(int x, int y, int& col, int& row)
+{
+    // --- 坐标转换 ---
+    // GLUT的y坐标原点在左上角，而我们的OpenGL坐标原点在左下角
+    // 所以需要用窗口高度减去y; 再按视图的平移和缩放换算, 向下取整 (负数坐标也正确)
+    col = (int)std::floor(viewOrigin.x + x / cellPixels);
+    row = (int)std::floor(viewOrigin.y + (windowHeight - y) / cellPixels);
+
+    // 检查点击是否在窗口内
+    return x >= 0 && x < windowWidth && y >= 0 && y < windowHeight;
+}
+
+/**
+ * @brief 以窗口坐标 (x, y) 为中心缩放, 该位置下的格子保持不动
+ */
+void zoomAt(int x, int y, double factor)
+{
+    double minPixels = std::max(MIN_CELL_PIXELS, (double)std::max(windowWidth, windowHeight) / MAX_VISIBLE_CELLS);
+    double next = std::min(MAX_CELL_PIXELS, std::max(minPixels, cellPixels * factor));
+    double fx = x, fy = windowHeight - y;
+    viewOrigin.x += fx / cellPixels - fx / next;
+    viewOrigin.y += fy / cellPixels - fy / next;
+    cellPixels = next;
+    labelsDirty = true;
 }
 
 void mouse(int button, int state, int x, int y)
 {
-    // 我们只关心鼠标左键按下的事件
+    TRACE_FUNCTION();
+    // 滚轮 (GLUT 报告为 3 / 4 号按键): 以鼠标位置为中心缩放
+    if ((button == 3 || button == 4) && state == GLUT_DOWN)
+    {
+        zoomAt(x, y, button == 3 ? WHEEL_ZOOM : 1.0 / WHEEL_ZOOM);
+        printCanvasStats();
+        glutPostRedisplay();
+        return;
+    }
+    // 右键 / 中键拖动: 平移
+    if (button == GLUT_RIGHT_BUTTON || button == GLUT_MIDDLE_BUTTON)
+    {
+        isPanning = state == GLUT_DOWN;
+        lastMouseX = x;
+        lastMouseY = y;
+        if (!isPanning) printCanvasStats();
+        return;
+    }
+    // 左键按下: 使用当前工具
     if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
     {
-        // 计算每个格子的宽高
-        float cellWidth = (float)windowWidth / NUM_COLS;
-        float cellHeight = (float)windowHeight / NUM_ROWS;
-        
-        // --- 坐标转换 ---
-        // 将鼠标的窗口坐标 (x, y) 转换为网格坐标 (col, row)
-        // x -> col: 直接除以格子宽度
-        int col = x / cellWidth;
-        
-        // y -> row: GLUT的y坐标原点在左上角，而我们的OpenGL坐标原点在左下角
-        // 所以需要用窗口高度减去y，再进行计算
-        int row = (windowHeight - y) / cellHeight;
-        
-        // 检查点击是否在有效范围内
-        if (col >= 0 && col < NUM_COLS && row >= 0 && row < NUM_ROWS)
+        int col, row;
+        if (!cellAt(x, y, col, row)) return;
+
+        if (tool == TOOL_SELECT)
         {
             // 更新选中的格子
             selectedCell.x = col;
             selectedCell.y = row;
-            
+            hasSelection = true;
+
             // 打印信息到控制台，方便调试
-            std::cout << "Clicked Cell: (" << col << ", " << row << ")" << std::endl;
-            
-            // 请求重绘窗口，这样display()函数就会被调用，颜色变化会显示出来
-            glutPostRedisplay();
+            std::cout << "Clicked Cell: (" << col << ", " << row << ")";
+            int lx = col - regionX, ly = row - regionY;
+            if (showComponents && canvas.get(col, row) != 0 && lx >= 0 && lx < regionGrid.width && ly >= 0 && ly < regionGrid.height)
+                std::cout << ", 连通分量 #" << labels[(size_t)ly * regionGrid.width + lx];
+            std::cout << std::endl;
+        }
+        else if (tool == TOOL_PAINT)
+        {
+            // 点在空白格上开始画, 点在已有颜色的格子上开始擦
+            paintValue = canvas.get(col, row) == 0 ? 1 : 0;
+            canvas.set(col, row, paintValue);
+            cellsChanged();
+        }
+        else
+        {
+            // 只在可见区域内填充: 坐标换算到以可见区域左下角为原点
+            int x0, y0, x1, y1;
+            visibleCells(x0, y0, x1, y1);
+            uint8_t target = canvas.get(col, row);
+            size_t filled = 0;
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            if (target != fillValue)
+            {
+                filled = scanlineFill(x1 - x0, y1 - y0, col - x0, row - y0,
+                                      [&](int cx, int cy) { return canvas.get(x0 + cx, y0 + cy) == target; },
+                                      [&](int cy, int cx0, int cx1) { for (int cx = cx0; cx <= cx1; ++cx) canvas.set(x0 + cx, y0 + cy, fillValue); });
+            }
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            std::cout << "油漆桶: 从 (" << col << ", " << row << ") 填充 " << filled << " 格, " << ms << " ms" << std::endl;
+            if (filled > 0)
+            {
+                fillValue = fillValue + 1 < PALETTE_SIZE ? fillValue + 1 : 2;
+                cellsChanged();
+                printCanvasStats();
+            }
         }
+
+        // 请求重绘窗口，这样display()函数就会被调用，颜色变化会显示出来
+        glutPostRedisplay();
+    }
+}
+
+void motion(int x, int y)
+{
+    TRACE_FUNCTION();
+    if (isPanning)
+    {
+        // 拖动方向与画布移动方向相同 (窗口 y 向下)
+        viewOrigin.x -= (x - lastMouseX) / cellPixels;
+        viewOrigin.y += (y - lastMouseY) / cellPixels;
+        lastMouseX = x;
+        lastMouseY = y;
+        labelsDirty = true;
+        glutPostRedisplay();
+        return;
+    }
+    // 画笔工具: 按住左键拖动时连续绘制
+    int col, row;
+    if (tool != TOOL_PAINT || !cellAt(x, y, col, row) || !canvas.set(col, row, paintValue)) return;
+    cellsChanged();
+    glutPostRedisplay();
+}
+
+void keyboard(unsigned char key, int x, int y)
+{
+    TRACE_FUNCTION();
+    switch (key)
+    {
+        case 27: case 'q': exit(0); break;
+        case '1': case '2': case '3':
+            tool = (Tool)(key - '1');
+            std::cout << "工具: " << TOOL_NAMES[tool] << std::endl;
+            break;
+        case 'l':
+            showComponents = !showComponents;
+            labelsDirty = true;
+            std::cout << "显示: " << (showComponents ? "连通分量" : "格子颜色") << std::endl;
+            break;
+        case 'r':
+            randomizeVisible(0.45f);
+            break;
+        case 'c':
+            canvas.clear();
+            cellsChanged();
+            printCanvasStats();
+            break;
+        case '+': case '=': case '-': // 以窗口中心缩放 2 倍
+            zoomAt(windowWidth / 2, windowHeight / 2, key == '-' ? 0.5 : 2.0);
+            printCanvasStats();
+            break;
+        case 'h': // 回到初始视图
+            viewOrigin = glm::dvec2(0.0, 0.0);
+            cellPixels = 40.0;
+            zoomAt(windowWidth / 2, windowHeight / 2, 1.0);
+            printCanvasStats();
+            break;
+        default:
+            return;
     }
-}
\ No newline at end of file
+    glutPostRedisplay();
+}
+
+/**
+ * @brief 按给定比例随机涂黑可见区域的格子, 用来生成大量连通分量
+ */
+void randomizeVisible(float density)
+{
+    TRACE_FUNCTION();
+    int x0, y0, x1, y1;
+    visibleCells(x0, y0, x1, y1);
+    unsigned seed = (unsigned)rand();
+    unsigned threshold = (unsigned)(density * 16777216.0f);
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            canvas.set(x, y, (seed >> 8) < threshold ? 1 : 0);
+        }
+    }
+    cellsChanged();
+    printCanvasStats();
+}
+
+void cellsChanged()
+{
+    labelsDirty = true;
+}
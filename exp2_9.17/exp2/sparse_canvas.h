@@ -0,0 +1,113 @@
+#ifndef SPARSE_CANVAS_H
+#define SPARSE_CANVAS_H
+
+// 无限画布: 格子坐标可以是任意 int (包括负数), 按 64 x 64 的块稀疏存储
+// - 块以块坐标为键放在哈希表中, 第一次写入非 0 值时才分配; 块中非 0 格子数降为 0 时释放
+//   内存只与画过的面积成正比, 与画布 "大小" 无关
+// - 读取没有分配的块得到 0 (背景); 向没有分配的块写 0 什么也不做
+// - 每块记录 dirty 标志, 查看器据此只重新上传改变过的块的纹理
+// - forEachChunkIn 只按坐标枚举给定矩形覆盖的块, 代价与矩形 (可见区域) 的大小成正比
+// 格子值与 CellGrid 相同 (0 背景, 1 画笔, 2 以上为油漆桶颜色), 所以每格一个字节, 不是位图;
+// copyRegion 把一块矩形复制到 CellGrid, 以便在可见区域上复用 grid_ccl.h 的连通分量标记
+
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstring>
+#include <cstdint>
+
+#include "grid_ccl.h"
+
+const int CANVAS_CHUNK_SHIFT = 6;
+const int CANVAS_CHUNK_SIZE = 1 << CANVAS_CHUNK_SHIFT;   // 64
+const int CANVAS_CHUNK_MASK = CANVAS_CHUNK_SIZE - 1;
+
+struct CanvasChunk {
+    int cx, cy;                  // 块坐标: 覆盖格子 [cx * 64, cx * 64 + 64) x [cy * 64, cy * 64 + 64)
+    uint8_t cells[CANVAS_CHUNK_SIZE * CANVAS_CHUNK_SIZE];   // 行优先
+    unsigned painted;            // 非 0 格子数
+    bool dirty;                  // 内容改变后还没有被查看器上传
+
+    CanvasChunk(int x, int y) : cx(x), cy(y), painted(0), dirty(true) { memset(cells, 0, sizeof(cells)); }
+    uint8_t& at(int lx, int ly) { return cells[ly * CANVAS_CHUNK_SIZE + lx]; }
+};
+
+class SparseCanvas {
+public:
+    // 块坐标 = 格子坐标按 64 向下取整 (负数也成立, 算术右移)
+    static int chunkCoord(int v) { return v >> CANVAS_CHUNK_SHIFT; }
+    static uint64_t chunkKey(int cx, int cy) { return ((uint64_t)(uint32_t)cx << 32) | (uint32_t)cy; }
+
+    uint8_t get(int x, int y) const {
+        const CanvasChunk* c = findChunk(chunkCoord(x), chunkCoord(y));
+        return c ? c->cells[(y & CANVAS_CHUNK_MASK) * CANVAS_CHUNK_SIZE + (x & CANVAS_CHUNK_MASK)] : 0;
+    }
+
+    /**
+     * @brief 写一个格子; 返回值是否改变
+     */
+    bool set(int x, int y, uint8_t value) {
+        int cx = chunkCoord(x), cy = chunkCoord(y);
+        uint64_t key = chunkKey(cx, cy);
+        std::unordered_map<uint64_t, std::unique_ptr<CanvasChunk> >::iterator it = chunks_.find(key);
+        if (it == chunks_.end()) {
+            if (value == 0) return false;
+            it = chunks_.insert(std::make_pair(key, std::unique_ptr<CanvasChunk>(new CanvasChunk(cx, cy)))).first;
+        }
+        CanvasChunk& c = *it->second;
+        uint8_t& cell = c.at(x & CANVAS_CHUNK_MASK, y & CANVAS_CHUNK_MASK);
+        if (cell == value) return false;
+        c.painted += (value != 0) - (cell != 0);
+        cell = value;
+        c.dirty = true;
+        if (c.painted == 0) chunks_.erase(it);
+        return true;
+    }
+
+    CanvasChunk* findChunk(int cx, int cy) {
+        std::unordered_map<uint64_t, std::unique_ptr<CanvasChunk> >::iterator it = chunks_.find(chunkKey(cx, cy));
+        return it == chunks_.end() ? 0 : it->second.get();
+    }
+    const CanvasChunk* findChunk(int cx, int cy) const {
+        std::unordered_map<uint64_t, std::unique_ptr<CanvasChunk> >::const_iterator it = chunks_.find(chunkKey(cx, cy));
+        return it == chunks_.end() ? 0 : it->second.get();
+    }
+
+    /**
+     * @brief 对覆盖格子矩形 [x0, x1) x [y0, y1) 的每个已分配的块调用 fn(chunk), 返回枚举的块坐标数
+     */
+    template <typename Fn>
+    size_t forEachChunkIn(int x0, int y0, int x1, int y1, Fn fn) {
+        if (x1 <= x0 || y1 <= y0) return 0;
+        int cx0 = chunkCoord(x0), cx1 = chunkCoord(x1 - 1), cy0 = chunkCoord(y0), cy1 = chunkCoord(y1 - 1);
+        for (int cy = cy0; cy <= cy1; ++cy)
+            for (int cx = cx0; cx <= cx1; ++cx)
+                if (CanvasChunk* c = findChunk(cx, cy)) fn(*c);
+        return (size_t)(cx1 - cx0 + 1) * (cy1 - cy0 + 1);
+    }
+
+    /**
+     * @brief 把格子矩形 [x0, x0 + w) x [y0, y0 + h) 复制到 out (out 的 (0, 0) 对应 (x0, y0))
+     * 按块复制, 没有分配的块保持为 0
+     */
+    void copyRegion(int x0, int y0, int w, int h, CellGrid& out) {
+        TRACE_FUNCTION();
+        out.resize(w, h);
+        forEachChunkIn(x0, y0, x0 + w, y0 + h, [&](CanvasChunk& c) {
+            int bx = c.cx * CANVAS_CHUNK_SIZE, by = c.cy * CANVAS_CHUNK_SIZE;
+            int sx = std::max(bx, x0), ex = std::min(bx + CANVAS_CHUNK_SIZE, x0 + w);
+            int sy = std::max(by, y0), ey = std::min(by + CANVAS_CHUNK_SIZE, y0 + h);
+            for (int y = sy; y < ey; ++y)
+                memcpy(&out.cells[(size_t)(y - y0) * w + (sx - x0)], &c.cells[(y - by) * CANVAS_CHUNK_SIZE + (sx - bx)], ex - sx);
+        });
+    }
+
+    void clear() { chunks_.clear(); }
+    size_t chunkCount() const { return chunks_.size(); }
+    size_t memoryBytes() const { return chunks_.size() * sizeof(CanvasChunk); }
+
+private:
+    std::unordered_map<uint64_t, std::unique_ptr<CanvasChunk> > chunks_;
+};
+
+#endif